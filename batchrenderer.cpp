@@ -0,0 +1,266 @@
+// batchrenderer.cpp
+#include "batchrenderer.h"
+#include "scenebuilder.h"
+#include "layoutengine.h"
+#include "setupparser.h"
+#include "snapshotcache.h"
+#include "timeseriesstore.h"
+#include "statparser.h"
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QGraphicsScene>
+#include <QImage>
+#include <QPainter>
+#include <QRegularExpression>
+#include <QSvgGenerator>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentRun>
+#include <cstring>
+
+namespace {
+
+QTextStream& out() {
+    static QTextStream stream(stdout);
+    return stream;
+}
+
+double elapsedMs(QElapsedTimer& timer) {
+    const double ms = timer.nsecsElapsed() / 1e6;
+    timer.restart();
+    return ms;
+}
+
+// 命令行里的一个运行：setup.txt 文件或包含它的目录
+bool addRun(QVector<BatchRenderer::Run>& runs, const QString& setupArg, const QString& statArg) {
+    QFileInfo info(setupArg);
+    if (info.isDir())
+        info = QFileInfo(QDir(setupArg).filePath("setup.txt"));
+    if (!info.isFile())
+        return false;
+    BatchRenderer::Run run;
+    run.setupPath = info.filePath();
+    if (!statArg.isEmpty()) {
+        run.statPath = statArg;
+    } else {
+        const QString sibling = info.dir().filePath("statistic.txt");
+        if (QFileInfo::exists(sibling))
+            run.statPath = sibling;
+    }
+    runs.append(run);
+    return true;
+}
+
+// 输出文件名：序号加运行名（setup.txt 取所在目录名，否则取文件名），序号保证不重名
+QString outputName(int index, const QString& setupPath) {
+    const QFileInfo info(setupPath);
+    QString name = info.fileName() == "setup.txt" ? info.dir().dirName() : info.completeBaseName();
+    name.replace(QRegularExpression("[^A-Za-z0-9_.-]"), "_");
+    return QString("%1_%2").arg(index, 4, 10, QChar('0')).arg(name);
+}
+
+} // namespace
+
+bool BatchRenderer::wantsHeadless(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--render") == 0)
+            return true;
+    }
+    return false;
+}
+
+struct BatchRenderer::Loaded {
+    Topology topology;
+    CounterStore stats;
+    Layout layout;
+};
+
+std::shared_ptr<BatchRenderer::Loaded> BatchRenderer::loadRun(Run& run) {
+    QElapsedTimer timer;
+    timer.start();
+
+    // 与界面加载相同：源文件没变时读快照；不写快照，批量出图不在运行目录里留下文件
+    std::shared_ptr<Loaded> loaded = std::make_shared<Loaded>();
+    Topology& topology = loaded->topology;
+    CounterStore& stats = loaded->stats;
+    const SourceStamp setupStamp = SnapshotCache::stampFile(run.setupPath);
+    const SourceStamp statStamp = SnapshotCache::stampFile(run.statPath);
+    const QString cachePath = SnapshotCache::cachePathFor(run.setupPath, run.statPath);
+    if (!SnapshotCache::load(cachePath, setupStamp, statStamp, topology, stats)) {
+        if (!SetupParser::parseFile(run.setupPath, topology, &run.error))
+            return nullptr;
+        TimeSeriesStore series;
+        EpochSplitter splitter;
+        if (!run.statPath.isEmpty()
+            && !TimeSeriesStore::parseFile(run.statPath, stats, series, splitter, &run.error))
+            return nullptr;
+    }
+    run.loadMs = elapsedMs(timer);
+
+    // 各运行已经并行，布局内部不再分线程
+    QThreadPool layoutPool;
+    layoutPool.setMaxThreadCount(1);
+    loaded->layout = LayoutEngine::layout(topology, nullptr, &layoutPool);
+    run.layoutMs = elapsedMs(timer);
+    return loaded;
+}
+
+void BatchRenderer::renderRun(Run& run, const Loaded& loaded, const Options& options) {
+    QElapsedTimer timer;
+    timer.start();
+    QGraphicsScene scene;
+    BuiltScene built = SceneBuilder::build(&scene, loaded.topology, &loaded.stats, &loaded.layout);
+    const QRectF source = scene.itemsBoundingRect().adjusted(-50, -50, 50, 50);
+    scene.setSceneRect(source);
+    run.buildMs = elapsedMs(timer);
+
+    if (options.png) {
+        // 按输出尺寸选细节层级，与界面缩放到同样比例时看到的一致
+        const qreal scale = options.width / source.width();
+        SceneBuilder::setDetailLevel(built, SceneBuilder::detailLevelFor(scale));
+        QImage image(QSize(options.width, qMax(1, qRound(source.height() * scale))),
+                     QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::white);
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::Antialiasing, built.detail != DetailLevel::Overview);
+        scene.render(&painter, QRectF(image.rect()), source);
+        painter.end();
+        if (!image.save(run.outputBase + ".png")) {
+            run.error = QString("无法写入 %1.png").arg(run.outputBase);
+            return;
+        }
+    }
+    if (options.svg) {
+        // 矢量图可以任意放大，总是带全部细节
+        SceneBuilder::setDetailLevel(built, DetailLevel::Full);
+        QSvgGenerator generator;
+        generator.setFileName(run.outputBase + ".svg");
+        generator.setSize(source.size().toSize());
+        generator.setViewBox(QRectF(QPointF(0, 0), source.size()));
+        generator.setTitle(QFileInfo(run.setupPath).filePath());
+        QPainter painter;
+        if (!painter.begin(&generator)) {
+            run.error = QString("无法写入 %1.svg").arg(run.outputBase);
+            return;
+        }
+        scene.render(&painter, QRectF(QPointF(0, 0), source.size()), source);
+        painter.end();
+    }
+    run.renderMs = elapsedMs(timer);
+    run.ok = true;
+}
+
+int BatchRenderer::run(const QStringList& arguments) {
+    QCommandLineParser parser;
+    parser.setApplicationDescription("无窗口批量渲染拓扑图");
+    parser.addHelpOption();
+    const QCommandLineOption renderOption("render", "输出目录", "dir");
+    const QCommandLineOption threadsOption("threads", "并行读取与布局的运行数，默认为 CPU 核数", "n");
+    const QCommandLineOption widthOption("width", "PNG 宽度（像素）", "px", "2400");
+    const QCommandLineOption formatOption("format", "输出格式，逗号分隔", "png,svg", "png,svg");
+    const QCommandLineOption listOption("list", "运行列表文件，每行 setup.txt [statistic.txt]", "file");
+    parser.addOptions({renderOption, threadsOption, widthOption, formatOption, listOption});
+    parser.addPositionalArgument("runs", "setup.txt 或包含它的目录", "[runs...]");
+    parser.process(arguments);
+
+    Options options;
+    options.outputDir = parser.value(renderOption);
+    options.threads = parser.value(threadsOption).toInt();
+    options.width = qBound(16, parser.value(widthOption).toInt(), 32768);
+    const QStringList formats = parser.value(formatOption).split(',', Qt::SkipEmptyParts);
+    options.png = formats.contains("png");
+    options.svg = formats.contains("svg");
+
+    QVector<Run> runs;
+    for (const QString& arg : parser.positionalArguments()) {
+        if (!addRun(runs, arg, QString()))
+            out() << QString("跳过 %1：找不到 setup.txt\n").arg(arg);
+    }
+    if (parser.isSet(listOption)) {
+        QFile list(parser.value(listOption));
+        if (!list.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            out() << QString("无法打开 %1\n").arg(list.fileName());
+            return 2;
+        }
+        QTextStream lines(&list);
+        while (!lines.atEnd()) {
+            const QStringList fields = lines.readLine().split(QRegularExpression("\\s+"),
+                                                              Qt::SkipEmptyParts);
+            if (fields.isEmpty() || fields[0].startsWith('#'))
+                continue;
+            if (!addRun(runs, fields[0], fields.value(1)))
+                out() << QString("跳过 %1：找不到 setup.txt\n").arg(fields[0]);
+        }
+    }
+    if (runs.isEmpty() || (!options.png && !options.svg)) {
+        out() << parser.helpText();
+        return 2;
+    }
+    if (!QDir().mkpath(options.outputDir)) {
+        out() << QString("无法创建输出目录 %1\n").arg(options.outputDir);
+        return 2;
+    }
+    const QDir outputDir(options.outputDir);
+    for (int i = 0; i < runs.size(); ++i)
+        runs[i].outputBase = outputDir.filePath(outputName(i, runs[i].setupPath));
+
+    // 读取与布局在池中进行，只碰本运行自己的数据；场景、图元和画家只在主线程上按顺序使用。
+    // 池中最多领先主线程两轮，读好未画的运行不会全部堆在内存里
+    QThreadPool pool;
+    pool.setMaxThreadCount(options.threads > 0 ? options.threads : QThread::idealThreadCount());
+    const int ahead = 2 * pool.maxThreadCount();
+    QVector<QFuture<std::shared_ptr<Loaded>>> loads(runs.size());
+    int started = 0;
+    QElapsedTimer wall;
+    wall.start();
+    for (int i = 0; i < runs.size(); ++i) {
+        for (; started < runs.size() && started <= i + ahead; ++started) {
+            Run* run = &runs[started];
+            loads[started] = QtConcurrent::run(&pool, [run]() { return loadRun(*run); });
+        }
+        const std::shared_ptr<Loaded> loaded = loads[i].result();
+        loads[i] = QFuture<std::shared_ptr<Loaded>>();
+        if (loaded)
+            renderRun(runs[i], *loaded, options);
+    }
+    const double wallMs = wall.nsecsElapsed() / 1e6;
+
+    // 逐个运行的耗时写到输出目录的 timing.csv，同时打印到标准输出
+    QFile csv(outputDir.filePath("timing.csv"));
+    const bool writeCsv = csv.open(QIODevice::WriteOnly | QIODevice::Text);
+    QTextStream csvStream(&csv);
+    if (writeCsv)
+        csvStream << "output,setup,statistic,ok,load_ms,layout_ms,build_ms,render_ms,total_ms,error\n";
+    out() << QString("%1 %2 %3 %4 %5 %6  %7\n").arg("run", 6).arg("load", 9).arg("layout", 9)
+                 .arg("build", 9).arg("render", 9).arg("total", 9).arg("output");
+    int failed = 0;
+    double serialMs = 0;
+    for (int i = 0; i < runs.size(); ++i) {
+        const Run& r = runs[i];
+        const double total = r.loadMs + r.layoutMs + r.buildMs + r.renderMs;
+        serialMs += total;
+        if (!r.ok)
+            ++failed;
+        out() << QString("%1 %2 %3 %4 %5 %6  %7\n").arg(i, 6).arg(r.loadMs, 9, 'f', 1)
+                     .arg(r.layoutMs, 9, 'f', 1).arg(r.buildMs, 9, 'f', 1).arg(r.renderMs, 9, 'f', 1)
+                     .arg(total, 9, 'f', 1)
+                     .arg(r.ok ? QFileInfo(r.outputBase).fileName() : QString("失败: %1").arg(r.error));
+        if (writeCsv) {
+            QString error = r.error;
+            error.replace('"', "\"\"");
+            csvStream << QFileInfo(r.outputBase).fileName() << ',' << r.setupPath << ',' << r.statPath << ','
+                      << (r.ok ? 1 : 0) << ',' << r.loadMs << ',' << r.layoutMs << ',' << r.buildMs << ','
+                      << r.renderMs << ',' << total << ",\"" << error << "\"\n";
+        }
+    }
+    out() << QString("%1 runs, %2 failed, %3 threads: wall %4 ms (%5 runs/s), sum of runs %6 ms\n")
+                 .arg(runs.size()).arg(failed).arg(pool.maxThreadCount())
+                 .arg(wallMs, 0, 'f', 0).arg(runs.size() / wallMs * 1000, 0, 'f', 1)
+                 .arg(serialMs, 0, 'f', 0);
+    out().flush();
+    return failed > 0 ? 1 : 0;
+}
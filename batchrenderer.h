@@ -0,0 +1,50 @@
+// batchrenderer.h
+#ifndef BATCHRENDERER_H
+#define BATCHRENDERER_H
+#include <QString>
+#include <QStringList>
+#include <memory>
+
+// 无窗口批量出图：每组 setup.txt/statistic.txt 在离屏的 QGraphicsScene 中建场景，
+// 输出 PNG 与 SVG。读取与布局在线程池上并行；QGraphicsScene 和文字图元只能在主线程上使用，
+// 场景的创建与绘制按运行顺序在主线程上逐个进行，同时后面的运行已在池中读取。
+//   homework3_2 --render <输出目录> [--threads N] [--width 2400] [--format png,svg]
+//               [--list runs.txt] [setup.txt | 运行目录 ...]
+// runs.txt 每行一个运行：setup.txt 路径，可选地跟一个 statistic.txt 路径（空白分隔）。
+// 只给 setup.txt 或目录时，统计数据取同目录下的 statistic.txt（与界面打开时一致）。
+class BatchRenderer {
+public:
+    struct Run {
+        QString setupPath;
+        QString statPath;        // 为空表示没有统计数据
+        QString outputBase;      // 输出文件路径，不含扩展名
+
+        bool ok = false;
+        QString error;
+        double loadMs = 0;       // 读取快照或解析文本
+        double layoutMs = 0;
+        double buildMs = 0;      // 创建图元
+        double renderMs = 0;     // 绘制并写出所有格式
+    };
+
+    struct Options {
+        QString outputDir;
+        int threads = 0;         // 读取与布局的线程数，0 为 QThread::idealThreadCount()
+        int width = 2400;        // PNG 宽度（像素），高度按场景比例
+        bool png = true;
+        bool svg = true;
+    };
+
+    // 命令行里有 --render 时走无窗口模式；需要在创建 QApplication 之前判断，以便选择离屏平台
+    static bool wantsHeadless(int argc, char* argv[]);
+    // 解析命令行并处理全部运行，返回进程退出码（有任何运行失败时非 0）
+    static int run(const QStringList& arguments);
+
+    // 读取好并排好布局的一个运行，失败时 run.error 说明原因，返回空
+    struct Loaded;
+    static std::shared_ptr<Loaded> loadRun(Run& run);
+    // 在主线程上建场景并写出各格式
+    static void renderRun(Run& run, const Loaded& loaded, const Options& options);
+};
+
+#endif // BATCHRENDERER_H
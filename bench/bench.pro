@@ -0,0 +1,31 @@
+# 性能基准程序，与主程序共用数据层源码、图元、场景构建、场景视图与检查面板模型
+QT = core gui widgets
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = qtvis_bench
+
+include(../core.pri)
+
+SOURCES += \
+    bench_main.cpp \
+    ../edgelayer.cpp \
+    ../highlightlayer.cpp \
+    ../inspectorpanel.cpp \
+    ../latencybars.cpp \
+    ../moduleitem.cpp \
+    ../packetlayer.cpp \
+    ../scenebuilder.cpp \
+    ../scenewidget.cpp \
+    ../tilecache.cpp
+
+HEADERS += \
+    ../edgelayer.h \
+    ../highlightlayer.h \
+    ../inspectorpanel.h \
+    ../latencybars.h \
+    ../moduleitem.h \
+    ../packetlayer.h \
+    ../scenebuilder.h \
+    ../scenewidget.h \
+    ../tilecache.h
@@ -0,0 +1,1772 @@
+// bench_main.cpp
+// 用法:
+//   qtvis_bench parse-stat <statistic.txt> [--threads 1,2,4,8,16] [--repeat 3]
+//   qtvis_bench open-run <setup.txt> <statistic.txt> [--repeat 3]
+//   qtvis_bench scene-items [--modules 10000] [--repeat 3]
+//   qtvis_bench scene-edges [--mesh 32] [--attach 2] [--repeat 3]
+//   qtvis_bench layout [--mesh 71] [--threads 1,2,4,8] [--repeat 3]
+//   qtvis_bench metrics [--cpus 20000] [--changed 64] [--repeat 3]
+//   qtvis_bench heatmap [--ports 4096] [--fill 1.0] [--size 1024] [--repeat 3]
+//   qtvis_bench routes [--mesh 32] [--flows 256] [--changed 64] [--threads 1,2,4,8] [--repeat 3]
+//   qtvis_bench inspector [--ports 2048] [--repeat 3]
+//   qtvis_bench compare [--rows 1000000] [--threads 1,2,4,8] [--repeat 3]
+//   qtvis_bench sweep <目录> [--threads 1,2,4,8]
+//   qtvis_bench trace [--records 20000000] [--cores 64] [--threads 1,2,4,8] [--keep]
+//   qtvis_bench playback [--mesh 32] [--packets 100000] [--frames 120] [--events 20000000]
+//   qtvis_bench ingest [--updates 20000000] [--counters 100000] [--frame 4096] [--epochs 10]
+//   qtvis_bench tiles [--mesh 100] [--size 1920x1080] [--scale 1] [--frames 120]
+//   qtvis_bench search [--rows 5000000] [--cpus 20000] [--repeat 20]
+//   qtvis_bench generate <目录> [--mesh 16x16] [--cores 2] [--memory 4] [--fill 1] [--seed 1]
+//   qtvis_bench app [<setup.txt>] [--mesh 16x16] [--cores 2] [--fill 1] [--size 1920x1080] [--frames 120] [--json out.json]
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QGraphicsScene>
+#include <QGraphicsEllipseItem>
+#include <QGraphicsLineItem>
+#include <QGraphicsSimpleTextItem>
+#include <QGraphicsTextItem>
+#include <QImage>
+#include <QPainter>
+#include <QRandomGenerator>
+#include <QtMath>
+#include <functional>
+#include <QFileInfo>
+#include <QStringList>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QEventLoop>
+#include <QLocalSocket>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
+#include "counterstore.h"
+#include "derivedmetrics.h"
+#include "statparser.h"
+#include "parallelstatparser.h"
+#include "setupparser.h"
+#include "snapshotcache.h"
+#include "moduleitem.h"
+#include "edgelayer.h"
+#include "layoutengine.h"
+#include "trafficmatrix.h"
+#include "routeengine.h"
+#include "scenebuilder.h"
+#include "inspectorpanel.h"
+#include "runcomparison.h"
+#include "sweeptable.h"
+#include "cachetrace.h"
+#include "busevents.h"
+#include "packetlayer.h"
+#include "statingest.h"
+#include "tilecache.h"
+#include "searchindex.h"
+#include "syntheticrun.h"
+#include "framestats.h"
+#include "scenewidget.h"
+#include <QScrollBar>
+#include <QWheelEvent>
+#include <QJsonObject>
+#include <QStyleOptionGraphicsItem>
+#include <QDir>
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+namespace {
+
+QTextStream& out() {
+    static QTextStream stream(stdout);
+    return stream;
+}
+
+QString option(const QStringList& args, const QString& name, const QString& defaultValue) {
+    const int i = args.indexOf(name);
+    return i >= 0 && i + 1 < args.size() ? args[i + 1] : defaultValue;
+}
+
+bool sameContent(const CounterStore& a, const CounterStore& b) {
+    if (a.modules.size() != b.modules.size() || a.counters.size() != b.counters.size())
+        return false;
+    for (int i = 0; i < a.modules.size(); ++i) {
+        if (a.modules.at(i) != b.modules.at(i) || a.moduleLatency[i] != b.moduleLatency[i])
+            return false;
+    }
+    for (int i = 0; i < a.counters.size(); ++i) {
+        if (a.counters.at(i) != b.counters.at(i) || a.counterIsReal[i] != b.counterIsReal[i])
+            return false;
+    }
+    return a.rowModule == b.rowModule && a.rowCounter == b.rowCounter
+           && a.rowIndex0 == b.rowIndex0 && a.rowIndex1 == b.rowIndex1
+           && a.values == b.values;
+}
+
+// 顺序解析作为基线，再按不同线程数并行解析，校验结果一致并给出加速比
+int benchParseStat(const QStringList& args) {
+    if (args.size() < 3) {
+        out() << "usage: qtvis_bench parse-stat <statistic.txt> [--threads 1,2,4,8,16] [--repeat 3]\n";
+        return 2;
+    }
+    const QString path = args[2];
+    const double megabytes = QFileInfo(path).size() / 1e6;
+    const int repeat = qMax(1, option(args, "--repeat", "3").toInt());
+    QList<int> threadCounts;
+    for (const QString& t : option(args, "--threads", "1,2,4,8,16").split(','))
+        threadCounts << qMax(1, t.toInt());
+
+    QString error;
+    CounterStore baseline;
+    double sequentialMs = 1e300;
+    for (int i = 0; i < repeat; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        if (!StatParser::parseFile(path, baseline, &error)) {
+            out() << error << "\n";
+            return 1;
+        }
+        sequentialMs = qMin(sequentialMs, timer.nsecsElapsed() / 1e6);
+    }
+    out() << QString("file: %1 (%2 MB, %3 rows)\n").arg(path).arg(megabytes, 0, 'f', 1).arg(baseline.rowCount());
+    out() << QString("%1 %2 %3 %4 %5\n").arg("threads", 8).arg("ms", 10).arg("MB/s", 10)
+                 .arg("speedup", 8).arg("identical", 10);
+    out() << QString("%1 %2 %3 %4 %5\n").arg("seq", 8).arg(sequentialMs, 10, 'f', 1)
+                 .arg(megabytes / sequentialMs * 1000, 10, 'f', 1).arg(1.0, 8, 'f', 2).arg("-", 10);
+
+    for (int threads : threadCounts) {
+        QThreadPool pool;
+        pool.setMaxThreadCount(threads);
+        CounterStore store;
+        double best = 1e300;
+        for (int i = 0; i < repeat; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            if (!ParallelStatParser::parseFile(path, store, &error, &pool)) {
+                out() << error << "\n";
+                return 1;
+            }
+            best = qMin(best, timer.nsecsElapsed() / 1e6);
+        }
+        out() << QString("%1 %2 %3 %4 %5\n").arg(threads, 8).arg(best, 10, 'f', 1)
+                     .arg(megabytes / best * 1000, 10, 'f', 1).arg(sequentialMs / best, 8, 'f', 2)
+                     .arg(sameContent(baseline, store) ? "yes" : "NO", 10);
+        out().flush();
+    }
+    return 0;
+}
+
+// 对比完整解析与从 .qtcache 快照打开同一组运行结果的耗时
+int benchOpenRun(const QStringList& args) {
+    if (args.size() < 4) {
+        out() << "usage: qtvis_bench open-run <setup.txt> <statistic.txt> [--repeat 3]\n";
+        return 2;
+    }
+    const QString setupPath = args[2];
+    const QString statPath = args[3];
+    const int repeat = qMax(1, option(args, "--repeat", "3").toInt());
+    const QString cachePath = SnapshotCache::cachePathFor(setupPath, statPath);
+
+    QString error;
+    Topology topology;
+    CounterStore parsed;
+    double parseMs = 1e300;
+    for (int i = 0; i < repeat; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        if (!SetupParser::parseFile(setupPath, topology, &error)
+            || !ParallelStatParser::parseFile(statPath, parsed, &error)) {
+            out() << error << "\n";
+            return 1;
+        }
+        parseMs = qMin(parseMs, timer.nsecsElapsed() / 1e6);
+    }
+
+    QElapsedTimer saveTimer;
+    saveTimer.start();
+    const SourceStamp setupStamp = SnapshotCache::stampFile(setupPath);
+    const SourceStamp statStamp = SnapshotCache::stampFile(statPath);
+    if (!SnapshotCache::save(cachePath, setupStamp, statStamp, topology, parsed, &error)) {
+        out() << error << "\n";
+        return 1;
+    }
+    const double saveMs = saveTimer.nsecsElapsed() / 1e6;
+
+    // 重新打开：计算指纹 + 读快照，与程序启动时的路径一致
+    CounterStore cached;
+    double stampMs = 1e300, loadMs = 1e300;
+    for (int i = 0; i < repeat; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        const SourceStamp setupNow = SnapshotCache::stampFile(setupPath);
+        const SourceStamp statNow = SnapshotCache::stampFile(statPath);
+        const double stamped = timer.nsecsElapsed() / 1e6;
+        if (!SnapshotCache::load(cachePath, setupNow, statNow, topology, cached)) {
+            out() << "cache rejected: " << cachePath << "\n";
+            return 1;
+        }
+        stampMs = qMin(stampMs, stamped);
+        loadMs = qMin(loadMs, timer.nsecsElapsed() / 1e6 - stamped);
+    }
+
+    out() << QString("file: %1 (%2 MB, %3 rows)\n").arg(statPath)
+                 .arg(QFileInfo(statPath).size() / 1e6, 0, 'f', 1).arg(parsed.rowCount());
+    out() << QString("cache: %1 (%2 MB)\n").arg(cachePath)
+                 .arg(QFileInfo(cachePath).size() / 1e6, 0, 'f', 1);
+    out() << QString("parse %1 ms, write cache %2 ms\n").arg(parseMs, 0, 'f', 1).arg(saveMs, 0, 'f', 1);
+    out() << QString("reopen %1 ms (stamp %2 ms + load %3 ms), speedup %4, identical %5\n")
+                 .arg(stampMs + loadMs, 0, 'f', 1).arg(stampMs, 0, 'f', 1).arg(loadMs, 0, 'f', 1)
+                 .arg(parseMs / (stampMs + loadMs), 0, 'f', 1)
+                 .arg(sameContent(parsed, cached) ? "yes" : "NO");
+    return 0;
+}
+
+// 常驻内存字节数，只在 Linux 上可用，其他平台返回 -1
+qint64 residentBytes() {
+#ifdef Q_OS_LINUX
+    QFile statm("/proc/self/statm");
+    if (statm.open(QIODevice::ReadOnly)) {
+        const QList<QByteArray> fields = statm.readAll().split(' ');
+        if (fields.size() > 1)
+            return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+    }
+#endif
+    return -1;
+}
+
+// 改为自绘之前的模块图元：名称是 QGraphicsTextItem，每个端口是一个 QGraphicsEllipseItem
+class ChildItemModule : public QGraphicsRectItem {
+public:
+    ChildItemModule(const QString& name, qreal x, qreal y, qreal w, qreal h)
+        : QGraphicsRectItem(0, 0, w, h) {
+        setPos(x, y);
+        setBrush(QBrush(Qt::lightGray));
+        setAcceptHoverEvents(true);
+        label = new QGraphicsTextItem(name, this);
+        label->setPos(10, 10);
+        label->setDefaultTextColor(Qt::black);
+        addPort(ModuleItem::Right);
+        addPort(ModuleItem::Left);
+    }
+    void addPort(ModuleItem::PortPosition pos) {
+        QGraphicsEllipseItem* port = new QGraphicsEllipseItem(-4, -4, 8, 8, this);
+        port->setBrush(Qt::yellow);
+        ports.append({port, pos});
+        updatePortPositions();
+    }
+
+private:
+    struct Port {
+        QGraphicsEllipseItem* shape;
+        ModuleItem::PortPosition position;
+    };
+    void updatePortPositions() {
+        const QRectF rect = this->rect();
+        for (const Port& p : ports) {
+            switch (p.position) {
+            case ModuleItem::Left:   p.shape->setPos(0, rect.height()/2 - 4); break;
+            case ModuleItem::Right:  p.shape->setPos(rect.width(), rect.height()/2 - 4); break;
+            case ModuleItem::Top:    p.shape->setPos(rect.width()/2 - 4, 0); break;
+            case ModuleItem::Bottom: p.shape->setPos(rect.width()/2 - 4, rect.height()); break;
+            }
+        }
+    }
+    QVector<Port> ports;
+    QGraphicsTextItem* label;
+};
+
+struct SceneCost {
+    double buildMs = 1e300;
+    double residentMB = 0;
+    double paintFitMs = 1e300;    // 整个场景缩放到一帧内
+    double paintZoomMs = 1e300;   // 1:1 显示左上角一帧
+    double hitUs = 1e300;         // 每次 itemAt 命中查询
+};
+
+// 建场景并渲染到离屏图像，再在场景范围内随机做命中查询；各项取 repeat 轮中的最好成绩
+SceneCost measureScene(int repeat, const std::function<void(QGraphicsScene&)>& populate) {
+    SceneCost cost;
+    QImage frame(1600, 1000, QImage::Format_ARGB32_Premultiplied);
+    const int kHitQueries = 10000;
+    for (int i = 0; i < repeat; ++i) {
+        const qint64 before = residentBytes();
+        QElapsedTimer timer;
+        timer.start();
+        QGraphicsScene scene;
+        populate(scene);
+        const QRectF bounds = scene.itemsBoundingRect();   // 同时完成索引的建立
+        cost.buildMs = qMin(cost.buildMs, timer.nsecsElapsed() / 1e6);
+        if (i == 0 && before >= 0)   // 之后的轮次会复用已释放的堆
+            cost.residentMB = (residentBytes() - before) / 1e6;
+
+        for (const QRectF& source : {bounds, QRectF(0, 0, frame.width(), frame.height())}) {
+            frame.fill(Qt::white);
+            QPainter painter(&frame);
+            painter.setRenderHint(QPainter::Antialiasing);
+            timer.restart();
+            scene.render(&painter, QRectF(frame.rect()), source);
+            const double ms = timer.nsecsElapsed() / 1e6;
+            double& best = source == bounds ? cost.paintFitMs : cost.paintZoomMs;
+            best = qMin(best, ms);
+        }
+
+        QRandomGenerator random(7);
+        int hits = 0;
+        timer.restart();
+        for (int q = 0; q < kHitQueries; ++q) {
+            const QPointF p(bounds.left() + random.bounded(bounds.width()),
+                            bounds.top() + random.bounded(bounds.height()));
+            hits += scene.itemAt(p, QTransform()) != nullptr;
+        }
+        cost.hitUs = qMin(cost.hitUs, timer.nsecsElapsed() / 1e3 / kHitQueries);
+        Q_UNUSED(hits);
+    }
+    return cost;
+}
+
+void printSceneCosts(const QString& oldName, const SceneCost& before,
+                     const QString& newName, const SceneCost& after) {
+    out() << QString("%1 %2 %3 %4 %5 %6\n").arg("item", 14).arg("build ms", 10).arg("RSS MB", 10)
+                 .arg("fit ms", 10).arg("1:1 ms", 10).arg("hit us", 10);
+    const QList<QPair<QString, SceneCost>> rows = {{oldName, before}, {newName, after}};
+    for (const auto& row : rows) {
+        out() << QString("%1 %2 %3 %4 %5 %6\n").arg(row.first, 14)
+                     .arg(row.second.buildMs, 10, 'f', 1).arg(row.second.residentMB, 10, 'f', 1)
+                     .arg(row.second.paintFitMs, 10, 'f', 1).arg(row.second.paintZoomMs, 10, 'f', 1)
+                     .arg(row.second.hitUs, 10, 'f', 2);
+    }
+    out() << QString("speedup: build %1x, fit paint %2x, 1:1 paint %3x, hit %4x\n")
+                 .arg(before.buildMs / after.buildMs, 0, 'f', 1)
+                 .arg(before.paintFitMs / after.paintFitMs, 0, 'f', 1)
+                 .arg(before.paintZoomMs / after.paintZoomMs, 0, 'f', 1)
+                 .arg(before.hitUs / after.hitUs, 0, 'f', 1);
+}
+
+// 模块排成方阵，每个带四个端口（与路由器相同）
+template <class Item>
+void addModuleGrid(QGraphicsScene& scene, int modules) {
+    const int cols = qMax(1, int(qCeil(qSqrt(qreal(modules)))));
+    for (int m = 0; m < modules; ++m) {
+        Item* item = new Item(QString("Router%1").arg(m), (m % cols) * 200, (m / cols) * 120, 120, 60);
+        item->addPort(ModuleItem::Top);
+        item->addPort(ModuleItem::Bottom);
+        scene.addItem(item);
+    }
+}
+
+// 对比自绘的 ModuleItem 与子图元实现的建场景耗时、内存和绘制耗时
+int benchSceneItems(const QStringList& args) {
+    const int modules = qMax(1, option(args, "--modules", "10000").toInt());
+    const int repeat = qMax(1, option(args, "--repeat", "3").toInt());
+
+    // 先测新实现：后测的一方可能复用先释放的堆内存，内存数字对旧实现偏乐观
+    const SceneCost painted = measureScene(repeat, [=](QGraphicsScene& scene) {
+        addModuleGrid<ModuleItem>(scene, modules);
+    });
+    const SceneCost children = measureScene(repeat, [=](QGraphicsScene& scene) {
+        addModuleGrid<ChildItemModule>(scene, modules);
+    });
+    out() << QString("modules: %1 (4 ports each)\n").arg(modules);
+    printSceneCosts("child-items", children, "self-painting", painted);
+    return 0;
+}
+
+// mesh x mesh 个路由器，相邻路由器之间双向各一条带使用率标签的连线，
+// 每个路由器再挂一条 CPU→L1→L2→路由器 的链和 attach 个下方模块
+struct MeshLink {
+    QLineF line;
+    int pen;          // 下标见 meshPens()
+    QString label;    // 路由器之间的连线才有
+};
+
+QVector<QPen> meshPens() {
+    return {QPen(Qt::darkBlue, 2), QPen(QColor(220, 20, 60), 4),
+            QPen(Qt::black, 2, Qt::SolidLine, Qt::RoundCap),
+            QPen(Qt::darkGray, 2, Qt::SolidLine, Qt::RoundCap),
+            QPen(Qt::darkGreen, 2, Qt::SolidLine, Qt::RoundCap)};
+}
+
+QVector<MeshLink> meshLinks(int mesh, int attach) {
+    QVector<MeshLink> links;
+    QRandomGenerator random(11);
+    auto router = [](int r, int c) { return QPointF(800 + c * 300, 300 + r * 500); };
+    for (int r = 0; r < mesh; ++r) {
+        for (int c = 0; c < mesh; ++c) {
+            const QPointF p = router(r, c);
+            for (const QPoint d : {QPoint(1, 0), QPoint(0, 1)}) {
+                if (r + d.y() >= mesh || c + d.x() >= mesh)
+                    continue;
+                const QPointF q = router(r + d.y(), c + d.x());
+                const QLineF line(p, q);
+                const QPointF offset = QPointF(-line.dy(), line.dx()) / line.length() * 4;
+                for (const QLineF& l : {QLineF(p + offset, q + offset), QLineF(q - offset, p - offset)}) {
+                    const double usage = random.generateDouble() * 0.05;
+                    links.append({l, usage > 0.01 ? 1 : 0, QString("%1%").arg(usage * 100, 0, 'f', 2)});
+                }
+            }
+            const QPointF cpu = p - QPointF(600, 0);
+            links.append({QLineF(cpu, cpu + QPointF(150, 0)), 2, QString()});
+            links.append({QLineF(cpu + QPointF(250, 0), cpu + QPointF(300, 0)), 3, QString()});
+            links.append({QLineF(cpu + QPointF(420, 0), p), 2, QString()});
+            for (int a = 0; a < attach; ++a)
+                links.append({QLineF(p + QPointF(0, 110 + a * 90), p), 4, QString()});
+        }
+    }
+    return links;
+}
+
+// 对比每条连线一个 QGraphicsLineItem（外加标签文字图元）与整层 EdgeLayer
+int benchSceneEdges(const QStringList& args) {
+    const int mesh = qMax(2, option(args, "--mesh", "32").toInt());
+    const int attach = qMax(0, option(args, "--attach", "2").toInt());
+    const int repeat = qMax(1, option(args, "--repeat", "3").toInt());
+    const QVector<MeshLink> links = meshLinks(mesh, attach);
+    const QVector<QPen> pens = meshPens();
+
+    const SceneCost layered = measureScene(repeat, [&](QGraphicsScene& scene) {
+        EdgeLayer* layer = new EdgeLayer();
+        QVector<int> styles;
+        for (const QPen& pen : pens)
+            styles.append(layer->addStyle(pen));
+        for (const MeshLink& link : links) {
+            const int edge = layer->addEdge(link.line, styles[link.pen]);
+            if (!link.label.isEmpty())
+                layer->setLabel(edge, link.label, link.pen == 1 ? Qt::red : Qt::darkBlue);
+        }
+        scene.addItem(layer);
+    });
+    const SceneCost items = measureScene(repeat, [&](QGraphicsScene& scene) {
+        for (const MeshLink& link : links) {
+            QGraphicsLineItem* item = new QGraphicsLineItem(link.line);
+            item->setPen(pens[link.pen]);
+            item->setZValue(-1);
+            scene.addItem(item);
+            if (link.label.isEmpty())
+                continue;
+            QGraphicsSimpleTextItem* label = new QGraphicsSimpleTextItem(link.label);
+            label->setFont(QFont("Arial", 8, QFont::Bold));
+            label->setBrush(link.pen == 1 ? Qt::red : Qt::darkBlue);
+            label->setPos(link.line.center() - QPointF(16, 11));
+            scene.addItem(label);
+        }
+    });
+    out() << QString("mesh: %1x%1, %2 links\n").arg(mesh).arg(links.size());
+    printSceneCosts("line-items", items, "edge-layer", layered);
+    return 0;
+}
+
+// mesh x mesh 个路由器的双向网格，只有总线节点和互连表
+Topology meshTopology(int mesh) {
+    Topology t;
+    t.nodeCount = mesh * mesh;
+    for (int r = 0; r < mesh; ++r) {
+        for (int c = 0; c < mesh; ++c) {
+            const int node = r * mesh + c;
+            if (c + 1 < mesh) {
+                t.edges.append({node, node + 1});
+                t.edges.append({node + 1, node});
+            }
+            if (r + 1 < mesh) {
+                t.edges.append({node, node + mesh});
+                t.edges.append({node + mesh, node});
+            }
+        }
+    }
+    return t;
+}
+
+// 相连路由器之间的平均距离（场景坐标），用来粗看布局是否把相邻节点放在一起
+double meanEdgeLength(const Topology& t, const Layout& layout) {
+    double sum = 0;
+    for (const BusEdge& e : t.edges)
+        sum += QLineF(layout.routers[e.from], layout.routers[e.to]).length();
+    return t.edges.isEmpty() ? 0 : sum / t.edges.size();
+}
+
+// 冷启动与热启动的布局耗时，按不同线程数重复，校验结果与线程数无关
+int benchLayout(const QStringList& args) {
+    const int mesh = qMax(2, option(args, "--mesh", "71").toInt());
+    const int repeat = qMax(1, option(args, "--repeat", "3").toInt());
+    QList<int> threadCounts;
+    for (const QString& t : option(args, "--threads", "1,2,4,8").split(','))
+        threadCounts << qMax(1, t.toInt());
+    const Topology t = meshTopology(mesh);
+
+    out() << QString("mesh: %1x%1, %2 nodes, %3 edges\n").arg(mesh).arg(t.nodeCount).arg(t.edges.size());
+    out() << QString("%1 %2 %3 %4 %5\n").arg("threads", 8).arg("cold ms", 10).arg("warm ms", 10)
+                 .arg("edge len", 10).arg("identical", 10);
+    Layout baseline;
+    for (int threads : threadCounts) {
+        QThreadPool pool;
+        pool.setMaxThreadCount(threads);
+        Layout cold, warm;
+        double coldMs = 1e300, warmMs = 1e300;
+        for (int i = 0; i < repeat; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            cold = LayoutEngine::layout(t, nullptr, &pool);
+            coldMs = qMin(coldMs, timer.nsecsElapsed() / 1e6);
+            timer.restart();
+            warm = LayoutEngine::layout(t, &cold, &pool);
+            warmMs = qMin(warmMs, timer.nsecsElapsed() / 1e6);
+        }
+        if (baseline.isEmpty())
+            baseline = cold;
+        out() << QString("%1 %2 %3 %4 %5\n").arg(threads, 8).arg(coldMs, 10, 'f', 1).arg(warmMs, 10, 'f', 1)
+                     .arg(meanEdgeLength(t, cold), 10, 'f', 0)
+                     .arg(cold.routers == baseline.routers ? "yes" : "NO", 10);
+        out().flush();
+    }
+    return 0;
+}
+
+// cpus 个 CPU 与同样多的 L2Cache，计数器名与 statistic.txt 一致，数值随机
+void addCacheHierarchy(CounterStore& store, int cpus) {
+    static const char* const cpuCounters[] = {
+        "total_tick_processed", "finished_inst_count", "ld_cache_miss_count", "ld_cache_hit_count",
+        "ld_inst_cnt", "ld_mem_tick_sum", "st_cache_miss_count", "st_cache_hit_count",
+        "st_inst_cnt", "st_mem_tick_sum"};
+    static const char* const l2Counters[] = {
+        "l1i_hit_count", "l1i_miss_count", "l1d_hit_count", "l1d_miss_count",
+        "l2_hit_count", "l2_miss_count"};
+    QRandomGenerator random(14);
+    for (int i = 0; i < cpus; ++i) {
+        const QByteArray cpu = "CPU" + QByteArray::number(i);
+        const QByteArray l2 = "L2Cache" + QByteArray::number(i);
+        const int cpuModule = store.addModule(cpu.constData(), cpu.size(), 1);
+        for (const char* name : cpuCounters)
+            store.setValue(cpuModule, store.addCounter(name, qstrlen(name)), -1, -1, random.bounded(1, 100000));
+        const int l2Module = store.addModule(l2.constData(), l2.size(), 1);
+        for (const char* name : l2Counters)
+            store.setValue(l2Module, store.addCounter(name, qstrlen(name)), -1, -1, random.bounded(1, 100000));
+    }
+}
+
+// 派生指标：逐模块查表计算（原先标签的做法）与按列计算全部指标，
+// 以及实时模式下少量计数器变化后只重算过期的列
+int benchMetrics(const QStringList& args) {
+    const int cpus = qMax(1, option(args, "--cpus", "20000").toInt());
+    const int changedCount = qMax(1, option(args, "--changed", "64").toInt());
+    const int repeat = qMax(1, option(args, "--repeat", "3").toInt());
+    CounterStore store;
+    addCacheHierarchy(store, cpus);
+    const int modules = store.modules.size();
+
+    double lookupMs = 1e300, columnMs = 1e300, dirtyMs = 1e300;
+    double checksumLookup = 0, checksumColumn = 0;
+    int dirtyEvaluations = 0;
+    QRandomGenerator random(7);
+    for (int i = 0; i < repeat; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        checksumLookup = 0;
+        for (int m = 0; m < modules; ++m) {
+            const double ld = store.value(m, "ld_inst_cnt", -1, -1, -1);
+            const double st = store.value(m, "st_inst_cnt", -1, -1, -1);
+            if (ld + st > 0) {
+                checksumLookup += (store.value(m, "ld_mem_tick_sum") + store.value(m, "st_mem_tick_sum"))
+                                  / (ld + st);
+            }
+        }
+        lookupMs = qMin(lookupMs, timer.nsecsElapsed() / 1e6);
+
+        DerivedMetrics metrics;
+        timer.restart();
+        metrics.reset(&store);
+        for (int metric = 0; metric < metrics.metricCount(); ++metric)
+            metrics.column(metric);
+        columnMs = qMin(columnMs, timer.nsecsElapsed() / 1e6);
+        checksumColumn = 0;
+        for (const double v : metrics.column(DerivedMetrics::Amat)) {
+            if (!qIsNaN(v))
+                checksumColumn += v;
+        }
+
+        // 只改 L2 的命中计数：CPU 侧的指标不应重算
+        const int l2Hit = store.findCounter("l2_hit_count");
+        QVector<qint32> changed;
+        for (int c = 0; c < changedCount; ++c) {
+            const int r = store.findRow(2 * int(random.bounded(cpus)) + 1, l2Hit);
+            store.values[r] += 1;
+            changed.append(r);
+        }
+        const int before = metrics.evaluations();
+        timer.restart();
+        metrics.markDirty(changed);
+        for (int metric = 0; metric < metrics.metricCount(); ++metric)
+            metrics.column(metric);
+        dirtyMs = qMin(dirtyMs, timer.nsecsElapsed() / 1e6);
+        dirtyEvaluations = metrics.evaluations() - before;
+    }
+    out() << QString("modules: %1, metrics: %2\n").arg(modules).arg(DerivedMetrics().metricCount());
+    out() << QString("per-module lookup (amat only): %1 ms\n").arg(lookupMs, 0, 'f', 2);
+    out() << QString("all metrics by column:        %1 ms  (amat %2)\n").arg(columnMs, 0, 'f', 2)
+                 .arg(qAbs(checksumLookup - checksumColumn) < 1e-6 * qAbs(checksumLookup) ? "matches" : "DIFFERS");
+    out() << QString("%1 changed rows, dirty only:  %2 ms, %3 columns recomputed\n")
+                 .arg(changedCount).arg(dirtyMs, 0, 'f', 3).arg(dirtyEvaluations);
+    return 0;
+}
+
+// ports×ports 的流量矩阵，fill 为有流量的格子比例；整张矩阵画进 size×size 的图（按块），
+// 以及切换排序后重画，对应热力图停靠窗适配窗口时的一帧
+int benchHeatmap(const QStringList& args) {
+    const int ports = qMax(2, option(args, "--ports", "4096").toInt());
+    const double fill = qBound(0.0, option(args, "--fill", "1.0").toDouble(), 1.0);
+    const int size = qMax(256, option(args, "--size", "1024").toInt());
+    const int repeat = qMax(1, option(args, "--repeat", "3").toInt());
+
+    CounterStore store;
+    const int bus = store.addModule("Bus", 3, 1);
+    const QByteArray name = "transmit_package_number_from_#_to_#";
+    const int counter = store.addCounter(name.constData(), name.size());
+    QRandomGenerator random(15);
+    const qint64 cells = qint64(ports) * ports;
+    const qint64 wanted = qint64(cells * fill);
+    store.reserveRows(int(wanted));
+    for (qint64 i = 0; i < wanted; ++i) {
+        // 填满时逐格排列，否则随机撒点（重复的格子由索引重建去掉）
+        const qint64 cell = fill >= 1.0 ? i : qint64(random.bounded(quint64(cells)));
+        store.rowModule.append(bus);
+        store.rowCounter.append(counter);
+        store.rowIndex0.append(int(cell / ports));
+        store.rowIndex1.append(int(cell % ports));
+        store.values.append(1 + random.bounded(100000));
+    }
+    QVector<qint32> duplicateOf(store.rowCount(), -1);
+    for (int shard = 0; shard < CounterStore::kIndexShards; ++shard)
+        store.rebuildIndexShard(shard, duplicateOf.data());
+    store.removeDuplicateRows(duplicateOf.data());
+    store.rebuildIndex();
+
+    TrafficMatrix matrix;
+    QElapsedTimer timer;
+    timer.start();
+    matrix.build(store, ports);
+    const double buildMs = timer.nsecsElapsed() / 1e6;
+
+    // 与 HeatmapView::fitToView 相同：能放进 size 像素的最大一级
+    int zoom = 6;
+    while (zoom > -24 && (zoom >= 0 ? ports << zoom : (ports + (1 << -zoom) - 1) >> -zoom) > size)
+        --zoom;
+    const QVector<quint32> palette = [] {
+        QVector<quint32> p(256);
+        for (int i = 0; i < 256; ++i)
+            p[i] = qRgb(255, 255 - i, 255 - i);
+        return p;
+    }();
+    const int tile = 256;
+    QImage image(tile, tile, QImage::Format_RGB32);
+    auto renderAll = [&]() {
+        for (int y = 0; y < size; y += tile) {
+            for (int x = 0; x < size; x += tile)
+                matrix.render(reinterpret_cast<quint32*>(image.bits()), image.bytesPerLine(), x, y,
+                              tile, tile, zoom, palette.constData());
+        }
+    };
+    double renderMs = 1e300, sortMs = 1e300;
+    for (int i = 0; i < repeat; ++i) {
+        timer.restart();
+        renderAll();
+        renderMs = qMin(renderMs, timer.nsecsElapsed() / 1e6);
+        timer.restart();
+        matrix.setSortByTotal(!matrix.sortByTotal());
+        renderAll();
+        sortMs = qMin(sortMs, timer.nsecsElapsed() / 1e6);
+    }
+    out() << QString("ports: %1, non-zero cells: %2, %3\n").arg(ports).arg(matrix.nonZeroCount())
+                 .arg(matrix.isDense() ? "dense" : "sparse");
+    out() << QString("build: %1 ms\n").arg(buildMs, 0, 'f', 1);
+    out() << QString("render %1x%1 at zoom %2: %3 ms\n").arg(size).arg(zoom).arg(renderMs, 0, 'f', 1);
+    out() << QString("toggle sort + render: %1 ms\n").arg(sortMs, 0, 'f', 1);
+    return 0;
+}
+
+// mesh×mesh 网格上每个路由器一个端口、各发往 flows 个随机端口的流量，连线使用率随机；
+// 按不同线程数投射到连线上，校验结果与线程数无关，且各连线包数之和等于 包数×跳数 之和；
+// 再改动 changed 个流量行，比较按差额增量更新与重新投射的耗时与结果
+int benchRoutes(const QStringList& args) {
+    const int mesh = qMax(2, option(args, "--mesh", "32").toInt());
+    const int flowsPerPort = qMax(1, option(args, "--flows", "256").toInt());
+    const int changedFlows = qMax(1, option(args, "--changed", "64").toInt());
+    const int repeat = qMax(1, option(args, "--repeat", "3").toInt());
+    QList<int> threadCounts;
+    for (const QString& t : option(args, "--threads", "1,2,4,8").split(','))
+        threadCounts << qMax(1, t.toInt());
+    Topology t = meshTopology(mesh);
+    for (int node = 0; node < t.nodeCount; ++node)
+        t.nodeOfPort.append(node);
+
+    CounterStore store;
+    const int bus = store.addModule("Bus", 3, 1);
+    const QByteArray flowName = "transmit_package_number_from_#_to_#";
+    const QByteArray busyName = "edge_#_to_#_busy_rate";
+    const int flowCounter = store.addCounter(flowName.constData(), flowName.size());
+    const int busyCounter = store.addCounter(busyName.constData(), busyName.size());
+    QRandomGenerator random(16);
+    for (int from = 0; from < t.nodeCount; ++from) {
+        for (int i = 0; i < flowsPerPort; ++i)
+            store.setValue(bus, flowCounter, from, random.bounded(t.nodeCount), 1 + random.bounded(1000));
+    }
+    for (const BusEdge& e : t.edges)
+        store.setValue(bus, busyCounter, e.from, e.to, random.generateDouble() * 0.05);
+
+    out() << QString("mesh: %1x%1, %2 edges, %3 flows\n").arg(mesh).arg(t.edges.size())
+                 .arg(store.rowCount() - t.edges.size());
+    out() << QString("%1 %2 %3 %4\n").arg("threads", 8).arg("ms", 10).arg("hotspots", 10)
+                 .arg("identical", 10);
+    RouteEngine engine;
+    engine.setTopology(t);
+    RouteLoad baseline;
+    for (int threads : threadCounts) {
+        QThreadPool pool;
+        pool.setMaxThreadCount(threads);
+        RouteLoad load;
+        double best = 1e300;
+        for (int i = 0; i < repeat; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            load = engine.project(store, &pool);
+            best = qMin(best, timer.nsecsElapsed() / 1e6);
+        }
+        if (baseline.isEmpty())
+            baseline = load;
+        const bool identical = load.edgeLoad == baseline.edgeLoad && load.hotspots == baseline.hotspots;
+        out() << QString("%1 %2 %3 %4\n").arg(threads, 8).arg(best, 10, 'f', 1)
+                     .arg(load.hotspots.size(), 10).arg(identical ? "yes" : "NO", 10);
+        out().flush();
+    }
+    double linkPackets = 0;
+    for (const double v : baseline.edgeLoad)
+        linkPackets += v;
+    const double hopPackets = baseline.routedPackets * baseline.meanHops;
+    out() << QString("routed: %1 packets, mean hops %2, link total %3\n")
+                 .arg(qint64(baseline.routedPackets)).arg(baseline.meanHops, 0, 'f', 2)
+                 .arg(qAbs(linkPackets - hopPackets) < 1e-6 * hopPackets ? "matches" : "DIFFERS");
+
+    // 像逐个 epoch 拖动时那样，每次只有少数流量行变化
+    QVector<qint32> flowRows;
+    for (int r = 0; r < store.rowCount(); ++r) {
+        if (store.rowCounter[r] == flowCounter)
+            flowRows.append(r);
+    }
+    RouteLoad load = baseline;
+    double incrementalMs = 0, fullMs = 0;
+    bool identical = true;
+    for (int i = 0; i < repeat; ++i) {
+        QVector<qint32> rows;
+        for (int k = 0; k < changedFlows; ++k) {
+            const qint32 r = flowRows[random.bounded(int(flowRows.size()))];
+            store.values[r] = random.bounded(4) == 0 ? 0 : 1 + random.bounded(2000);
+            rows.append(r);
+        }
+        std::sort(rows.begin(), rows.end());
+        rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+        QElapsedTimer timer;
+        timer.start();
+        engine.applyFlowChanges(load, store, rows);
+        engine.rank(load);
+        incrementalMs += timer.nsecsElapsed() / 1e6;
+        timer.restart();
+        const RouteLoad full = engine.project(store);
+        fullMs += timer.nsecsElapsed() / 1e6;
+        identical = identical && load.edgeLoad == full.edgeLoad && load.hotspots == full.hotspots
+                    && load.routedPackets == full.routedPackets;
+    }
+    out() << QString("%1 changed flows: incremental %2 ms, full %3 ms, identical %4\n").arg(changedFlows)
+                 .arg(incrementalMs / repeat, 0, 'f', 2).arg(fullMs / repeat, 0, 'f', 2)
+                 .arg(identical ? "yes" : "NO");
+    return 0;
+}
+
+// 带 ports×ports 流量矩阵的总线（每个端口一个节点）：检查面板打开总线和单个路由器的耗时，
+// 以及滚动时每屏（40 行）取文字的耗时
+int benchInspector(const QStringList& args) {
+    const int ports = qMax(2, option(args, "--ports", "2048").toInt());
+    const int repeat = qMax(1, option(args, "--repeat", "3").toInt());
+    Topology t;
+    TopologyModule bus;
+    bus.name = "Bus";
+    bus.kind = ModuleKind::Bus;
+    t.modules.append(bus);
+    t.busModule = 0;
+    t.nodeCount = ports;
+    t.nodeOfPort.resize(ports);
+    t.moduleOfPort.fill(-1, ports);
+    for (int p = 0; p < ports; ++p)
+        t.nodeOfPort[p] = p;
+    t.rebuildLookup();
+
+    CounterStore store;
+    const int busModule = store.addModule("Bus", 3, 1);
+    const QByteArray name = "transmit_package_number_from_#_to_#";
+    const int counter = store.addCounter(name.constData(), name.size());
+    QRandomGenerator random(17);
+    store.reserveRows(ports * ports);
+    for (int from = 0; from < ports; ++from) {
+        for (int to = 0; to < ports; ++to) {
+            store.rowModule.append(busModule);
+            store.rowCounter.append(counter);
+            store.rowIndex0.append(from);
+            store.rowIndex1.append(to);
+            store.values.append(random.bounded(100000));
+        }
+    }
+    store.rebuildIndex();
+    StatsView view;
+    view.reset(t, &store);
+
+    InspectorModel model;
+    model.setRun(&t, &view);
+    const int kPage = 40;
+    double openMs = 1e300, routerMs = 1e300, pageMs = 1e300;
+    qint64 characters = 0;
+    int routerRows = 0;
+    for (int i = 0; i < repeat; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        model.inspect({SceneTarget::Router, random.bounded(ports)});
+        routerMs = qMin(routerMs, timer.nsecsElapsed() / 1e6);
+        routerRows = model.rowCount();
+
+        timer.restart();
+        model.inspectBus();
+        openMs = qMin(openMs, timer.nsecsElapsed() / 1e6);
+
+        // 随机跳到 100 个位置，各取一屏
+        timer.restart();
+        for (int jump = 0; jump < 100; ++jump) {
+            const int top = random.bounded(qMax(1, model.rowCount() - kPage));
+            for (int row = top; row < top + kPage && row < model.rowCount(); ++row) {
+                for (int column = 0; column < model.columnCount(); ++column)
+                    characters += model.data(model.index(row, column)).toString().size();
+            }
+        }
+        pageMs = qMin(pageMs, timer.nsecsElapsed() / 1e6 / 100);
+    }
+    out() << QString("rows: %1 (%2 counters)\n").arg(model.rowCount()).arg(store.rowCount());
+    out() << QString("open bus: %1 ms\n").arg(openMs, 0, 'f', 1);
+    out() << QString("open router: %1 ms (%2 rows)\n").arg(routerMs, 0, 'f', 3).arg(routerRows);
+    out() << QString("one page (%1 rows): %2 ms  (%3 chars formatted)\n").arg(kPage)
+                 .arg(pageMs, 0, 'f', 3).arg(characters);
+    return 0;
+}
+
+// 两份约 rows 行的统计数据：名称按相反顺序驻留、行也倒序，对比运行少了每 16 行中的一行，
+// 另有一个只在对比运行中的模块。按不同线程数对齐，校验结果与线程数无关且每行的值正确
+int benchCompare(const QStringList& args) {
+    const int kCounters = 50;
+    const int kIndices = 4;
+    const int modules = qMax(1, option(args, "--rows", "1000000").toInt() / (kCounters * kIndices));
+    const int repeat = qMax(1, option(args, "--repeat", "3").toInt());
+    QList<int> threadCounts;
+    for (const QString& t : option(args, "--threads", "1,2,4,8").split(','))
+        threadCounts << qMax(1, t.toInt());
+
+    auto fill = [&](CounterStore& store, bool other) {
+        QVector<int> moduleIds(modules), counterIds(kCounters);
+        for (int i = 0; i < modules; ++i) {
+            const int m = other ? modules - 1 - i : i;
+            const QByteArray name = "CPU" + QByteArray::number(m);
+            moduleIds[m] = store.addModule(name.constData(), name.size(), 1);
+        }
+        for (int i = 0; i < kCounters; ++i) {
+            const int c = other ? kCounters - 1 - i : i;
+            const QByteArray name = "counter_" + QByteArray::number(c) + "_#";
+            counterIds[c] = store.addCounter(name.constData(), name.size());
+        }
+        const int rows = modules * kCounters * kIndices;
+        store.reserveRows(rows + kCounters);
+        for (int i = 0; i < rows; ++i) {
+            const int r = other ? rows - 1 - i : i;
+            if (other && r % 16 == 0)
+                continue;
+            store.rowModule.append(moduleIds[r / (kCounters * kIndices)]);
+            store.rowCounter.append(counterIds[r / kIndices % kCounters]);
+            store.rowIndex0.append(r % kIndices);
+            store.rowIndex1.append(-1);
+            store.values.append(other ? r + 0.5 : r);
+        }
+        if (other) {
+            const int extra = store.addModule("Extra", 5, 1);
+            for (int c = 0; c < kCounters; ++c) {
+                store.rowModule.append(extra);
+                store.rowCounter.append(counterIds[c]);
+                store.rowIndex0.append(0);
+                store.rowIndex1.append(-1);
+                store.values.append(c);
+            }
+        }
+        store.rebuildIndex();
+    };
+    CounterStore base, other;
+    fill(base, false);
+    fill(other, true);
+
+    out() << QString("rows: %1 base, %2 other\n").arg(base.rowCount()).arg(other.rowCount());
+    out() << QString("%1 %2 %3 %4\n").arg("threads", 8).arg("ms", 10).arg("matched", 10)
+                 .arg("correct", 10);
+    QVector<double> baseline;
+    for (int threads : threadCounts) {
+        QThreadPool pool;
+        pool.setMaxThreadCount(threads);
+        RunComparison comparison;
+        double best = 1e300;
+        for (int i = 0; i < repeat; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            comparison.align(base, other, &pool);
+            best = qMin(best, timer.nsecsElapsed() / 1e6);
+        }
+        bool correct = comparison.onlyInOther == kCounters
+                       && comparison.matchedRows + comparison.onlyInBase == base.rowCount();
+        for (int r = 0; r < base.rowCount() && correct; ++r) {
+            const double v = comparison.otherValue(r);
+            correct = r % 16 == 0 ? qIsNaN(v) : v == r + 0.5;
+        }
+        if (baseline.isEmpty())
+            baseline = comparison.aligned.values;
+        correct = correct && comparison.aligned.values.size() == baseline.size();
+        out() << QString("%1 %2 %3 %4\n").arg(threads, 8).arg(best, 10, 'f', 1)
+                     .arg(comparison.matchedRows, 10).arg(correct ? "yes" : "NO", 10);
+        out().flush();
+    }
+    return 0;
+}
+
+// 目录下的全部运行按不同线程数加载成扫描表，校验各线程数的结果一致
+int benchSweep(const QStringList& args) {
+    if (args.size() < 3) {
+        out() << "usage: qtvis_bench sweep <dir> [--threads 1,2,4,8]\n";
+        return 2;
+    }
+    QList<int> threadCounts;
+    for (const QString& t : option(args, "--threads", "1,2,4,8").split(','))
+        threadCounts << qMax(1, t.toInt());
+    const QVector<SweepColumn> columns = SweepTable::defaultColumns();
+    const QVector<SweepRun> runs = SweepTable::discover(args[2]);
+    out() << QString("runs: %1, columns: %2\n").arg(runs.size()).arg(columns.size());
+    out() << QString("%1 %2 %3 %4 %5\n").arg("threads", 8).arg("ms", 10).arg("runs/s", 10)
+                 .arg("failed", 8).arg("identical", 10);
+    QVector<SweepRun> baseline;
+    for (int threads : threadCounts) {
+        QThreadPool pool;
+        pool.setMaxThreadCount(threads);
+        QElapsedTimer timer;
+        timer.start();
+        const QList<SweepRun> loaded = QtConcurrent::blockingMapped(&pool, runs,
+                                                                    [&](const SweepRun& run) {
+            SweepRun result = run;
+            SweepTable::loadRun(result, columns);
+            return result;
+        });
+        const double ms = timer.nsecsElapsed() / 1e6;
+        int failed = 0;
+        bool identical = true;
+        for (int i = 0; i < loaded.size(); ++i) {
+            if (!loaded[i].ok)
+                ++failed;
+            if (!baseline.isEmpty()) {
+                // NaN 与自身不相等，逐项比较时视为相同
+                for (int c = 0; c < columns.size(); ++c) {
+                    const double a = loaded[i].values[c], b = baseline[i].values[c];
+                    identical = identical && (a == b || (qIsNaN(a) && qIsNaN(b)));
+                }
+            }
+        }
+        if (baseline.isEmpty())
+            baseline = QVector<SweepRun>(loaded.begin(), loaded.end());
+        out() << QString("%1 %2 %3 %4 %5\n").arg(threads, 8).arg(ms, 10, 'f', 1)
+                     .arg(runs.size() * 1000.0 / qMax(ms, 1e-3), 10, 'f', 1).arg(failed, 8)
+                     .arg(identical ? "yes" : "NO", 10);
+        out().flush();
+    }
+    return 0;
+}
+
+// 写一个合成的事件跟踪文件，先测顺序读文件的速度作为参照，再按不同线程数归约，
+// 校验各线程数的直方图一致。文件刚写完多半还在页缓存里，参照值是内存带宽而不是磁盘带宽
+int benchTrace(const QStringList& args) {
+    const qint64 records = option(args, "--records", "20000000").toLongLong();
+    const int cores = qBound(1, option(args, "--cores", "64").toInt(), 0xffff);
+    const int slices = qBound(1, cores / 16, int(CacheTrace::kNoSlice) - 1);
+    QList<int> threadCounts;
+    for (const QString& t : option(args, "--threads", "1,2,4,8").split(','))
+        threadCounts << qMax(1, t.toInt());
+    const QString path = QDir(QDir::tempPath()).filePath("qtvis_bench.qtrace");
+
+    QString error;
+    CacheTraceWriter writer;
+    if (!writer.open(path, cores, slices, &error)) {
+        out() << error << "\n";
+        return 1;
+    }
+    QRandomGenerator random(20);
+    QElapsedTimer timer;
+    timer.start();
+    for (qint64 i = 0; i < records; ++i) {
+        TraceRecord r = {};
+        r.core = quint16(random.bounded(cores));
+        r.eventClass = quint8(random.bounded(int(CacheTrace::EventClassCount)));
+        r.slice = r.eventClass >= CacheTrace::L3Hit ? quint8(random.bounded(slices)) : CacheTrace::kNoSlice;
+        for (int hop = 0; hop < CacheTrace::hopCount(r.eventClass); ++hop) {
+            // 经过内存的两段长，其余为十几到几十个周期
+            const bool memory = CacheTrace::hopAt(r.eventClass, hop) >= CacheTrace::L3ToMem;
+            r.hopTicks[hop] = quint16((memory ? 150 : 8) + random.bounded(memory ? 400 : 40));
+        }
+        writer.append(r);
+    }
+    if (!writer.close(&error)) {
+        out() << error << "\n";
+        return 1;
+    }
+    const double bytes = double(QFileInfo(path).size());
+    out() << QString("records: %1, cores: %2, slices: %3, %4 MB, write %5 ms\n").arg(records)
+                 .arg(cores).arg(slices).arg(bytes / (1 << 20), 0, 'f', 1)
+                 .arg(timer.nsecsElapsed() / 1e6, 0, 'f', 1);
+
+    // 参照：只把文件顺序读一遍
+    {
+        QFile file(path);
+        file.open(QIODevice::ReadOnly);
+        QByteArray chunk(8 << 20, Qt::Uninitialized);
+        timer.start();
+        while (file.read(chunk.data(), chunk.size()) > 0) {
+        }
+        const double ms = timer.nsecsElapsed() / 1e6;
+        out() << QString("sequential read: %1 ms, %2 GB/s\n").arg(ms, 0, 'f', 1)
+                     .arg(bytes / ms / 1e6, 0, 'f', 2);
+    }
+
+    out() << QString("%1 %2 %3 %4\n").arg("threads", 8).arg("ms", 10).arg("GB/s", 8)
+                 .arg("identical", 10);
+    LatencyHistograms baseline;
+    for (int threads : threadCounts) {
+        QThreadPool pool;
+        pool.setMaxThreadCount(threads);
+        LatencyHistograms h;
+        timer.start();
+        if (!CacheTraceReader::reduce(path, h, &error, &pool)) {
+            out() << error << "\n";
+            return 1;
+        }
+        const double ms = timer.nsecsElapsed() / 1e6;
+        if (baseline.isEmpty())
+            baseline = h;
+        const bool identical = h.records == baseline.records && h.coreBins == baseline.coreBins
+                               && h.coreTicks == baseline.coreTicks && h.sliceBins == baseline.sliceBins
+                               && h.sliceTicks == baseline.sliceTicks && h.records == quint64(records);
+        out() << QString("%1 %2 %3 %4\n").arg(threads, 8).arg(ms, 10, 'f', 1)
+                     .arg(bytes / ms / 1e6, 8, 'f', 2).arg(identical ? "yes" : "NO", 10);
+        out().flush();
+    }
+    if (!args.contains("--keep"))
+        QFile::remove(path);
+    return 0;
+}
+
+// 两部分：事件流经环形缓冲的吞吐与常驻内存（与事件数无关），
+// 以及 packets 个在途的包每帧推进位置、只画包图层、整幅场景重绘的耗时（1920x1080）
+int benchPlayback(const QStringList& args) {
+    const int mesh = qMax(2, option(args, "--mesh", "32").toInt());
+    const int packetCount = qMax(1, option(args, "--packets", "100000").toInt());
+    const int frames = qMax(1, option(args, "--frames", "120").toInt());
+    const qint64 eventCount = option(args, "--events", "20000000").toLongLong();
+    Topology t = meshTopology(mesh);
+    for (int node = 0; node < t.nodeCount; ++node)
+        t.nodeOfPort.append(node);
+    QRandomGenerator random(21);
+
+    // ============== 事件流 ==============
+    const QString path = QDir(QDir::tempPath()).filePath("qtvis_bench.qbus");
+    QString error;
+    BusEventWriter writer;
+    if (!writer.open(path, &error)) {
+        out() << error << "\n";
+        return 1;
+    }
+    for (qint64 i = 0; i < eventCount; ++i) {
+        writer.append({quint64(i / 8), quint16(random.bounded(t.nodeCount)),
+                       quint16(random.bounded(t.nodeCount)), 20, 0});
+    }
+    if (!writer.close(&error)) {
+        out() << error << "\n";
+        return 1;
+    }
+    const qint64 rssBefore = residentBytes();
+    qint64 peakRss = rssBefore;
+    BusEventStream stream;
+    QElapsedTimer timer;
+    timer.start();
+    if (!stream.open(path, &error)) {
+        out() << error << "\n";
+        return 1;
+    }
+    QVector<BusEvent> batch;
+    quint64 received = 0;
+    bool ordered = true;
+    quint64 lastTick = 0;
+    for (quint64 until = 0; !stream.ring().atEnd(); until += 1 << 14) {
+        batch.clear();
+        stream.ring().popUntil(until, batch, 1 << 20);
+        for (const BusEvent& e : batch) {
+            ordered = ordered && e.tick >= lastTick;
+            lastTick = e.tick;
+        }
+        received += batch.size();
+        if ((until >> 14) % 64 == 0)
+            peakRss = qMax(peakRss, residentBytes());
+    }
+    const double streamMs = timer.nsecsElapsed() / 1e6;
+    out() << QString("stream: %1 events (%2 MB) in %3 ms, %4 M events/s, ring %5 MB, "
+                     "rss growth %6 MB, complete %7, ordered %8\n")
+                 .arg(received).arg(eventCount * 16.0 / (1 << 20), 0, 'f', 0).arg(streamMs, 0, 'f', 1)
+                 .arg(received / streamMs / 1e3, 0, 'f', 1)
+                 .arg(BusEventStream::kRingCapacity * 16.0 / (1 << 20), 0, 'f', 0)
+                 .arg((peakRss - rssBefore) / double(1 << 20), 0, 'f', 1)
+                 .arg(received == quint64(eventCount) ? "yes" : "NO").arg(ordered ? "yes" : "NO");
+    stream.stop();
+    QFile::remove(path);
+
+    // ============== 在途的包 ==============
+    QGraphicsScene scene;
+    BuiltScene built = SceneBuilder::build(&scene, t);
+    scene.setSceneRect(scene.itemsBoundingRect());
+    PacketLayer* layer = new PacketLayer();
+    layer->setZValue(2);
+    layer->setBounds(scene.sceneRect());
+    layer->setRouteFunction([&](int fromPort, int toPort, QVector<QPointF>& points) {
+        return SceneBuilder::packetRoute(built, t, fromPort, toPort, points);
+    });
+    scene.addItem(layer);
+    // 注入时刻分布在 [0, 1000)，每跳 1000 tick：回放的几百 tick 里几乎没有包到达
+    timer.restart();
+    int added = 0;
+    for (int i = 0; i < packetCount; ++i) {
+        const BusEvent e = {quint64(random.bounded(1000)), quint16(random.bounded(t.nodeCount)),
+                            quint16(random.bounded(t.nodeCount)), 1000, 0};
+        added += layer->add(e) ? 1 : 0;
+    }
+    const double addMs = timer.nsecsElapsed() / 1e6;
+
+    QImage image(1920, 1080, QImage::Format_ARGB32_Premultiplied);
+    QStyleOptionGraphicsItem option;
+    option.exposedRect = scene.sceneRect();
+    double advanceMs = 0, layerMs = 0, frameMs = 0;
+    for (int f = 0; f < frames; ++f) {
+        timer.restart();
+        layer->advance(1000 + quint64(f) * 2);
+        advanceMs += timer.nsecsElapsed() / 1e6;
+
+        image.fill(Qt::white);
+        QPainter painter(&image);
+        const QRectF source = scene.sceneRect();
+        const qreal scale = qMin(image.width() / source.width(), image.height() / source.height());
+        painter.scale(scale, scale);
+        painter.translate(-source.topLeft());
+        timer.restart();
+        layer->paint(&painter, &option);
+        layerMs += timer.nsecsElapsed() / 1e6;
+        painter.resetTransform();
+        timer.restart();
+        scene.render(&painter, QRectF(image.rect()), source);
+        frameMs += timer.nsecsElapsed() / 1e6;
+    }
+    out() << QString("packets: %1 in flight on %2x%2 mesh, add %3 ms, routes cached for each pair\n")
+                 .arg(layer->inFlight()).arg(mesh).arg(addMs, 0, 'f', 1);
+    out() << QString("%1 %2 %3\n").arg("advance ms", 12).arg("layer ms", 12).arg("frame ms", 12);
+    out() << QString("%1 %2 %3\n").arg(advanceMs / frames, 12, 'f', 2).arg(layerMs / frames, 12, 'f', 2)
+                 .arg(frameMs / frames, 12, 'f', 2);
+    return added == packetCount ? 0 : 1;
+}
+
+// 本进程内的一个线程扮演模拟器，经本地套接字推送 updates 条更新（counters 个不同的计数器轮流更新），
+// 界面线程照常按 16 ms 一帧写入存储；给出端到端吞吐、反压次数，并校验最终值与 epoch 数
+int benchIngest(const QStringList& args) {
+    const qint64 updates = qMax<qint64>(1, option(args, "--updates", "20000000").toLongLong());
+    const int counters = qMax(1, option(args, "--counters", "100000").toInt());
+    const int frame = qMax(1, option(args, "--frame", "4096").toInt());
+    const int epochs = qMax(1, option(args, "--epochs", "10").toInt());
+    const int modules = 64;
+    const QString name = QString("qtvis-bench-%1").arg(QCoreApplication::applicationPid());
+
+    CounterStore store;
+    StatIngestServer server;
+    QString error;
+    if (!server.listen(name, &store, &error)) {
+        out() << error << "\n";
+        return 1;
+    }
+    int epochCount = 0;
+    quint64 changedRows = 0;
+    QObject::connect(&server, &StatIngestServer::epochCompleted, [&]() { ++epochCount; });
+    QObject::connect(&server, &StatIngestServer::rowsChanged,
+                     [&](const QVector<qint32>& rows) { changedRows += rows.size(); });
+    QEventLoop loop;
+    QObject::connect(&server, &StatIngestServer::clientDisconnected, &loop,
+                     [&](const QString& message) {
+        error = message;
+        loop.quit();
+    });
+
+    // 计数器 c 属于模块 c % 64，下标为 c / 64；第 u 条更新写计数器 u % counters，值为 u
+    QThread* client = QThread::create([&]() {
+        QLocalSocket socket;
+        socket.connectToServer(name);
+        if (!socket.waitForConnected(5000))
+            return;
+        QByteArray bytes;
+        for (int m = 0; m < modules; ++m)
+            IngestFrame::appendDefineModule(bytes, quint32(m), QByteArray("L2Cache") + QByteArray::number(m), 1);
+        IngestFrame::appendDefineCounter(bytes, 0, "hit_count_#");
+        QVector<IngestFrame::Update> batch(frame);
+        const qint64 perEpoch = (updates + epochs - 1) / epochs;
+        for (qint64 u = 0; u < updates;) {
+            const qint64 epochEnd = qMin(updates, (u / perEpoch + 1) * perEpoch);
+            const int n = int(qMin<qint64>(frame, epochEnd - u));
+            for (int i = 0; i < n; ++i, ++u) {
+                const int c = int(u % counters);
+                batch[i] = {quint32(c % modules), 0, c / modules, -1, double(u)};
+            }
+            IngestFrame::appendUpdates(bytes, batch.constData(), quint32(n));
+            if (u == epochEnd)
+                IngestFrame::appendEndEpoch(bytes);
+            socket.write(bytes);
+            bytes.clear();
+            // 对方不读时写缓冲会堆积，等它写出去（反压传到这里）
+            while (socket.bytesToWrite() > (8 << 20))
+                socket.waitForBytesWritten(-1);
+        }
+        while (socket.bytesToWrite() > 0)
+            socket.waitForBytesWritten(-1);
+        socket.disconnectFromServer();
+        if (socket.state() != QLocalSocket::UnconnectedState)
+            socket.waitForDisconnected(-1);
+    });
+    QElapsedTimer timer;
+    timer.start();
+    client->start();
+    loop.exec();
+    const double ms = timer.nsecsElapsed() / 1e6;
+    client->wait();
+    delete client;
+
+    // 最终值：计数器 c 最后一次更新的 u
+    bool correct = store.rowCount() == qMin<qint64>(counters, updates);
+    const int counter = store.findCounter("hit_count_#");
+    for (int c = 0; correct && c < counters && c < updates; ++c) {
+        const qint64 last = c + (updates - 1 - c) / counters * counters;
+        const int module = store.findModule(QByteArray("L2Cache") + QByteArray::number(c % modules));
+        const int row = store.findRow(module, counter, c / modules, -1);
+        correct = row >= 0 && store.values[row] == double(last);
+    }
+    out() << QString("updates: %1, counters: %2, frame: %3, epochs: %4\n").arg(updates).arg(counters)
+                 .arg(frame).arg(epochs);
+    out() << QString("%1 %2 %3 %4 %5 %6 %7\n").arg("ms", 10).arg("M upd/s", 10).arg("applied", 10)
+                 .arg("rows", 10).arg("stalls", 8).arg("epochs", 8).arg("correct", 8);
+    out() << QString("%1 %2 %3 %4 %5 %6 %7\n").arg(ms, 10, 'f', 1).arg(updates / ms / 1e3, 10, 'f', 2)
+                 .arg(server.appliedUpdates(), 10).arg(changedRows, 10).arg(server.backpressureStalls(), 8)
+                 .arg(epochCount, 8).arg(correct && epochCount == epochs ? "yes" : "NO", 8);
+    if (!error.isEmpty())
+        out() << error << "\n";
+    return correct ? 0 : 1;
+}
+
+// mesh×mesh 个路由器排成方阵（mesh 100 即一万个模块），视口每帧向右下平移几个像素：
+// 比较逐个绘制整个场景，与贴静态图层的缓存块再画其余图元的每帧耗时
+int benchTiles(const QStringList& args) {
+    const int mesh = qMax(2, option(args, "--mesh", "100").toInt());
+    const QStringList size = option(args, "--size", "1920x1080").split('x');
+    const QSize viewport(qMax(64, size.value(0).toInt()), qMax(64, size.value(1).toInt()));
+    const qreal scale = qBound(0.01, option(args, "--scale", "1").toDouble(), 8.0);
+    const int frames = qMax(2, option(args, "--frames", "120").toInt());
+    const Topology t = meshTopology(mesh);
+    Layout layout;
+    for (int node = 0; node < t.nodeCount; ++node)
+        layout.routers.append(QPointF((node % mesh) * 260, (node / mesh) * 200));
+
+    QElapsedTimer timer;
+    timer.start();
+    QGraphicsScene scene;
+    BuiltScene built = SceneBuilder::build(&scene, t, nullptr, &layout);
+    const QRectF bounds = scene.itemsBoundingRect();
+    scene.setSceneRect(bounds);
+    const double buildMs = timer.nsecsElapsed() / 1e6;
+    const DetailLevel level = SceneBuilder::detailLevelFor(scale);
+    SceneBuilder::setDetailLevel(built, level);
+
+    QImage frame(viewport, QImage::Format_ARGB32_Premultiplied);
+    auto source = [&](int f, qreal s) {
+        return QRectF(bounds.topLeft() + QPointF(f * 8, f * 4) / s, QSizeF(viewport) / s);
+    };
+    auto sceneToView = [](const QRectF& source, qreal s) {
+        QTransform transform;
+        transform.scale(s, s);
+        transform.translate(-source.left(), -source.top());
+        return transform;
+    };
+    auto begin = [&](QPainter& painter) {
+        frame.fill(Qt::white);
+        painter.begin(&frame);
+        painter.setRenderHint(QPainter::Antialiasing, level != DetailLevel::Overview);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    };
+
+    // 原来的做法：每帧逐个绘制
+    double liveMs = 0;
+    for (int f = 0; f < frames; ++f) {
+        QPainter painter;
+        begin(painter);
+        timer.restart();
+        scene.render(&painter, QRectF(frame.rect()), source(f, scale));
+        liveMs += timer.nsecsElapsed() / 1e6;
+    }
+
+    // 静态图层抄成绘图列表，由缓存的块绘制；第一帧画满视口的块，之后只补新露出的
+    timer.restart();
+    StaticLayer layer = StaticLayer::capture(built);
+    const int shapes = layer.shapeCount();
+    TileCache cache;
+    cache.setLayer(std::move(layer));
+    SceneBuilder::setStaticCached(built, true);
+    const double captureMs = timer.nsecsElapsed() / 1e6;
+    // 缺的块在后台画，draw 只计界面线程上的耗时；每帧之后等后台画完（fill），下一帧即可贴上
+    double firstMs = 0, firstFillMs = 0, tileMs = 0, fillMs = 0, overlayMs = 0;
+    int rendered = 0;
+    for (int f = 0; f < frames; ++f) {
+        const QRectF view = source(f, scale);
+        QPainter painter;
+        begin(painter);
+        timer.restart();
+        const int n = cache.draw(&painter, sceneToView(view, scale), frame.rect(), 1.0, level);
+        const double ms = timer.nsecsElapsed() / 1e6;
+        timer.restart();
+        cache.finish();
+        const double fill = timer.nsecsElapsed() / 1e6;
+        if (f == 0) {
+            firstMs = ms;
+            firstFillMs = fill;
+        } else {
+            tileMs += ms;
+            fillMs += fill;
+            rendered += n;
+        }
+        timer.restart();
+        scene.render(&painter, QRectF(frame.rect()), view);
+        overlayMs += timer.nsecsElapsed() / 1e6;
+    }
+    // 缩放一级（滚轮一格）后整个视口的块都要重画，画好之前用原来一级的块缩放后顶上
+    double zoomMs = 0, zoomFillMs = 0;
+    {
+        const qreal zoomed = scale * 1.15;
+        QPainter painter;
+        begin(painter);
+        timer.restart();
+        cache.draw(&painter, sceneToView(source(0, zoomed), zoomed), frame.rect(), 1.0,
+                   SceneBuilder::detailLevelFor(zoomed));
+        zoomMs = timer.nsecsElapsed() / 1e6;
+        timer.restart();
+        cache.finish();
+        zoomFillMs = timer.nsecsElapsed() / 1e6;
+    }
+
+    out() << QString("mesh: %1x%1, %2 modules, %3 links, viewport %4x%5 at scale %6, build %7 ms\n")
+                 .arg(mesh).arg(t.nodeCount).arg(built.links->edgeCount()).arg(viewport.width())
+                 .arg(viewport.height()).arg(scale).arg(buildMs, 0, 'f', 1);
+    out() << QString("static layer: %1 shapes, capture %2 ms, first frame %3 ms (+%4 ms in background), "
+                     "zoom step %5 ms (+%6 ms), %7 tiles (%8 MB) cached\n")
+                 .arg(shapes).arg(captureMs, 0, 'f', 1)
+                 .arg(firstMs, 0, 'f', 1).arg(firstFillMs, 0, 'f', 1)
+                 .arg(zoomMs, 0, 'f', 1).arg(zoomFillMs, 0, 'f', 1).arg(cache.tileCount())
+                 .arg(cache.usedBytes() / double(1 << 20), 0, 'f', 1);
+    out() << QString("%1 %2 %3 %4 %5 %6\n").arg("live ms", 10).arg("tiles ms", 10).arg("fill ms", 10)
+                 .arg("overlay ms", 12).arg("cached ms", 10).arg("new tiles", 10);
+    const double cachedMs = tileMs / (frames - 1) + overlayMs / frames;
+    out() << QString("%1 %2 %3 %4 %5 %6\n").arg(liveMs / frames, 10, 'f', 2).arg(tileMs / (frames - 1), 10, 'f', 2)
+                 .arg(fillMs / (frames - 1), 10, 'f', 2).arg(overlayMs / frames, 12, 'f', 2)
+                 .arg(cachedMs, 10, 'f', 2).arg(rendered, 10);
+    out() << QString("speedup per pan frame: %1x\n").arg(liveMs / frames / cachedMs, 0, 'f', 1);
+    return 0;
+}
+
+// cpus 组 CPU/L2Cache，总线上 4096 个节点相邻两两之间的边使用率，其余行数由 ports×ports 的流量补足。
+// 建索引的耗时，以及几条典型条件用索引查询与逐行扫描的耗时（各取 repeat 次中最好的），校验两者命中的行相同
+int benchSearch(const QStringList& args) {
+    const int rows = qMax(1, option(args, "--rows", "5000000").toInt());
+    const int cpus = qMax(1, option(args, "--cpus", "20000").toInt());
+    const int repeat = qMax(1, option(args, "--repeat", "20").toInt());
+    const int kNodes = 4096;
+    CounterStore store;
+    addCacheHierarchy(store, cpus);
+    const int bus = store.addModule("Bus", 3, 1);
+    const int edgeCounter = store.addCounter("edge_#_to_#_busy_rate", 21);
+    const int flowCounter = store.addCounter("transmit_package_number_from_#_to_#", 35);
+    QRandomGenerator random(24);
+    for (int n = 0; n + 1 < kNodes; ++n) {
+        store.setValue(bus, edgeCounter, n, n + 1, random.generateDouble() * 0.05);
+        store.setValue(bus, edgeCounter, n + 1, n, random.generateDouble() * 0.05);
+    }
+    const int ports = int(qSqrt(qMax(0, rows - store.rowCount())));
+    store.reserveRows(store.rowCount() + ports * ports);
+    for (int i = 0; i < ports; ++i) {
+        for (int j = 0; j < ports; ++j) {
+            store.rowModule.append(bus);
+            store.rowCounter.append(flowCounter);
+            store.rowIndex0.append(i);
+            store.rowIndex1.append(j);
+            store.values.append(random.bounded(100000));
+        }
+    }
+    store.rebuildIndex();
+
+    QElapsedTimer timer;
+    timer.start();
+    SearchIndex index;
+    index.build(store);
+    out() << QString("rows: %1, modules: %2, counters: %3\n").arg(store.rowCount())
+                 .arg(store.modules.size()).arg(store.counters.size());
+    out() << QString("build index: %1 ms\n").arg(timer.nsecsElapsed() / 1e6, 0, 'f', 1);
+    out() << QString("%1 %2 %3 %4 %5\n").arg("query", -40).arg("index ms", 10).arg("scan ms", 10)
+                 .arg("rows", 10).arg("correct", 8);
+
+    // 逐行扫描：与索引同样的条件，名称匹配先查好，只比较每行的模块、计数器、下标与值
+    auto scan = [&](const SearchQuery& query) {
+        QVector<quint8> moduleOk(store.modules.size(), query.module.isEmpty() ? 1 : 0);
+        for (const qint32 m : index.modulesWithPrefix(query.module))
+            moduleOk[m] = 1;
+        QVector<quint8> counterOk(store.counters.size(), 0);
+        for (const qint32 c : index.countersMatching(query.counter))
+            counterOk[c] = 1;
+        QVector<qint32> hits;
+        for (int r = 0; r < store.rowCount(); ++r) {
+            const double v = store.values[r];
+            bool ok = moduleOk[store.rowModule[r]] && counterOk[store.rowCounter[r]]
+                      && (query.index0 < 0 || store.rowIndex0[r] == query.index0)
+                      && (query.index1 < 0 || store.rowIndex1[r] == query.index1);
+            switch (query.compare) {
+            case SearchQuery::Any: break;
+            case SearchQuery::Less: ok = ok && v < query.value; break;
+            case SearchQuery::LessEqual: ok = ok && v <= query.value; break;
+            case SearchQuery::Equal: ok = ok && v == query.value; break;
+            case SearchQuery::GreaterEqual: ok = ok && v >= query.value; break;
+            case SearchQuery::Greater: ok = ok && v > query.value; break;
+            }
+            if (ok)
+                hits.append(r);
+        }
+        return hits;
+    };
+
+    const QStringList queries = {
+        "L2Cache l2_miss_count > 99000", "busy_rate > 4.9%", "edge_100_to_101_busy_rate",
+        "ld_cache_miss_count <= 100", "transmit_package >= 99995", "CPU1 finished_inst_count < 5000"};
+    for (const QString& text : queries) {
+        SearchQuery query;
+        QString error;
+        if (!index.parse(text, query, &error)) {
+            out() << QString("%1 %2\n").arg(text, -40).arg(error);
+            continue;
+        }
+        SearchResult result;
+        double indexMs = 1e300, scanMs = 1e300;
+        QVector<qint32> hits;
+        for (int i = 0; i < repeat; ++i) {
+            timer.restart();
+            result = index.run(query);
+            indexMs = qMin(indexMs, timer.nsecsElapsed() / 1e6);
+        }
+        for (int i = 0; i < qMin(repeat, 3); ++i) {
+            timer.restart();
+            hits = scan(query);
+            scanMs = qMin(scanMs, timer.nsecsElapsed() / 1e6);
+        }
+        QVector<qint32> found = result.rows;
+        std::sort(found.begin(), found.end());
+        out() << QString("%1 %2 %3 %4 %5\n").arg(text, -40).arg(indexMs, 10, 'f', 3)
+                     .arg(scanMs, 10, 'f', 1).arg(found.size(), 10).arg(found == hits ? "yes" : "NO", 8);
+        out().flush();
+    }
+    return 0;
+}
+
+SyntheticSpec syntheticSpec(const QStringList& args) {
+    SyntheticSpec spec;
+    const QStringList mesh = option(args, "--mesh", "16x16").split('x');
+    spec.rows = qMax(1, mesh.value(0).toInt());
+    spec.cols = qMax(1, mesh.value(1, mesh.value(0)).toInt());
+    spec.coresPerNode = qMax(1, option(args, "--cores", "2").toInt());
+    spec.memoryNodes = qBound(1, option(args, "--memory", "4").toInt(), spec.nodeCount());
+    spec.fill = qBound(0.0, option(args, "--fill", "1").toDouble(), 1.0);
+    spec.seed = option(args, "--seed", "1").toUInt();
+    return spec;
+}
+
+// 生成一对合成的 setup.txt / statistic.txt，供 app 命令或主程序打开
+int benchGenerate(const QStringList& args) {
+    if (args.size() < 3 || args[2].startsWith("--")) {
+        out() << "usage: qtvis_bench generate <dir> [--mesh 16x16] [--cores 2] [--memory 4] [--fill 1] [--seed 1]\n";
+        return 2;
+    }
+    const QDir dir(args[2]);
+    if (!dir.mkpath(".")) {
+        out() << "cannot create " << args[2] << "\n";
+        return 1;
+    }
+    const SyntheticSpec spec = syntheticSpec(args);
+    const QString setupPath = dir.filePath("setup.txt");
+    const QString statPath = dir.filePath("statistic.txt");
+    QElapsedTimer timer;
+    timer.start();
+    QString error;
+    if (!SyntheticRun::write(spec, setupPath, statPath, &error)) {
+        out() << error << "\n";
+        return 1;
+    }
+    out() << QString("mesh %1x%2, %3 cores, %4 ports, written in %5 ms\n")
+                 .arg(spec.rows).arg(spec.cols).arg(spec.coreCount()).arg(spec.portCount())
+                 .arg(timer.nsecsElapsed() / 1e6, 0, 'f', 0);
+    out() << QString("%1 (%2 MB)\n%3 (%4 MB)\n")
+                 .arg(setupPath).arg(QFileInfo(setupPath).size() / 1e6, 0, 'f', 1)
+                 .arg(statPath).arg(QFileInfo(statPath).size() / 1e6, 0, 'f', 1);
+    return 0;
+}
+
+// 整个程序的各阶段：解析、布局、建场景分开计时，再用 SceneWidget 按程序的路径加载，
+// 记录第一帧、平移与缩放各帧的绘制耗时（FrameStats，含各类图元的份额）。没有给出 setup.txt 时现场生成
+int benchApp(const QStringList& args) {
+    QString setupPath = args.size() > 2 && !args[2].startsWith("--") ? args[2] : QString();
+    QString statPath;
+    const QStringList size = option(args, "--size", "1920x1080").split('x');
+    const QSize viewport(qMax(64, size.value(0).toInt()), qMax(64, size.value(1).toInt()));
+    const int frames = qBound(2, option(args, "--frames", "120").toInt(), int(FrameStats::kWindow));
+    const QString jsonPath = option(args, "--json", QString());
+    QJsonObject report;
+
+    QElapsedTimer timer;
+    QString error;
+    if (setupPath.isEmpty()) {
+        const SyntheticSpec spec = syntheticSpec(args);
+        const QDir dir(QDir(QDir::tempPath()).filePath("qtvis_bench_run"));
+        dir.mkpath(".");
+        setupPath = dir.filePath("setup.txt");
+        statPath = dir.filePath("statistic.txt");
+        // 上次留下的快照与这次生成的文件对不上，删掉以免误读
+        QFile::remove(SnapshotCache::cachePathFor(setupPath, statPath));
+        timer.start();
+        if (!SyntheticRun::write(spec, setupPath, statPath, &error)) {
+            out() << error << "\n";
+            return 1;
+        }
+        out() << QString("generated mesh %1x%2, %3 cores, %4 ports in %5 ms\n")
+                     .arg(spec.rows).arg(spec.cols).arg(spec.coreCount()).arg(spec.portCount())
+                     .arg(timer.nsecsElapsed() / 1e6, 0, 'f', 0);
+    } else {
+        statPath = QFileInfo(setupPath).dir().filePath("statistic.txt");
+        if (!QFileInfo::exists(statPath))
+            statPath.clear();
+    }
+    report["setup"] = setupPath;
+    report["stat_mb"] = statPath.isEmpty() ? 0.0 : QFileInfo(statPath).size() / 1e6;
+
+    // 各阶段单独计时，顺序与加载流水线一致（不读快照）
+    Topology topology;
+    CounterStore stats;
+    timer.restart();
+    if (!SetupParser::parseFile(setupPath, topology, &error)) {
+        out() << error << "\n";
+        return 1;
+    }
+    const double setupMs = timer.nsecsElapsed() / 1e6;
+    timer.restart();
+    if (!statPath.isEmpty() && !ParallelStatParser::parseFile(statPath, stats, &error)) {
+        out() << error << "\n";
+        return 1;
+    }
+    const double statMs = timer.nsecsElapsed() / 1e6;
+    timer.restart();
+    const Layout layout = LayoutEngine::layout(topology);
+    const double layoutMs = timer.nsecsElapsed() / 1e6;
+    double buildMs = 0;
+    int sceneItems = 0;
+    {
+        QGraphicsScene scene;
+        timer.restart();
+        SceneBuilder::build(&scene, topology, statPath.isEmpty() ? nullptr : &stats, &layout);
+        buildMs = timer.nsecsElapsed() / 1e6;
+        sceneItems = int(scene.items().size());
+    }
+    out() << QString("%1 modules, %2 rows: parse setup %3 ms, statistic %4 ms, layout %5 ms, "
+                     "scene build %6 ms (%7 items)\n")
+                 .arg(topology.modules.size()).arg(stats.rowCount()).arg(setupMs, 0, 'f', 1)
+                 .arg(statMs, 0, 'f', 1).arg(layoutMs, 0, 'f', 1).arg(buildMs, 0, 'f', 1).arg(sceneItems);
+    QJsonObject phases;
+    phases["parse_setup_ms"] = setupMs;
+    phases["parse_stat_ms"] = statMs;
+    phases["layout_ms"] = layoutMs;
+    phases["scene_build_ms"] = buildMs;
+    phases["scene_items"] = sceneItems;
+
+    // 程序的路径：后台加载、分批建场景后换上，显示时适配视图
+    SceneWidget widget;
+    widget.resize(viewport);
+    widget.setFrameTiming(true);
+    widget.show();
+    bool loaded = false;
+    QEventLoop loop;
+    QObject::connect(&widget, &SceneWidget::loadFinished, &loop, [&](bool ok, const QString& message) {
+        loaded = ok;
+        error = message;
+        loop.quit();
+    });
+    timer.restart();
+    widget.loadRun(setupPath, statPath);
+    loop.exec();
+    if (!loaded) {
+        out() << error << "\n";
+        return 1;
+    }
+    phases["widget_load_ms"] = timer.nsecsElapsed() / 1e6;
+    report["phases"] = phases;
+    widget.updateFrameCounts();
+
+    FrameStats& frameStats = widget.frameStats();
+    // 处理完排队的重画；没有触发绘制时整体重画一次，保证每一步都是一帧
+    auto paintFrame = [&]() {
+        const qint64 before = frameStats.totalFrameCount();
+        QApplication::processEvents();
+        if (frameStats.totalFrameCount() == before)
+            widget.viewport()->repaint();
+    };
+    auto wheel = [&](int steps) {
+        const QPointF center = QRectF(widget.viewport()->rect()).center();
+        QWheelEvent event(center, widget.viewport()->mapToGlobal(center), QPoint(),
+                          QPoint(0, 120 * steps), Qt::NoButton, Qt::NoModifier, Qt::NoScrollPhase, false);
+        QApplication::sendEvent(widget.viewport(), &event);
+    };
+    auto record = [&](const QString& name) {
+        report[name] = frameStats.toJson();
+        out() << QString("%1 %2 %3 %4 %5").arg(name, -8).arg(frameStats.frameCount(), 7)
+                     .arg(frameStats.meanFrameMs(), 9, 'f', 2)
+                     .arg(frameStats.percentileFrameMs(95), 9, 'f', 2)
+                     .arg(frameStats.maxFrameMs(), 9, 'f', 2);
+        for (int s = 0; s < FrameStats::SectionCount; ++s)
+            out() << QString(" %1").arg(frameStats.meanSectionMs(FrameStats::Section(s)), 9, 'f', 2);
+        out() << QString(" %1\n").arg(frameStats.meanOtherMs(), 9, 'f', 2);
+        out().flush();
+        frameStats.clear();
+    };
+    out() << QString("viewport %1x%2\n").arg(viewport.width()).arg(viewport.height());
+    out() << QString("%1 %2 %3 %4 %5").arg("phase", -8).arg("frames", 7).arg("mean ms", 9)
+                 .arg("p95 ms", 9).arg("max ms", 9);
+    for (int s = 0; s < FrameStats::SectionCount; ++s)
+        out() << QString(" %1").arg(FrameStats::sectionName(FrameStats::Section(s)), 9);
+    out() << QString(" %1\n").arg("other", 9);
+
+    // 第一帧：适配整个场景，瓦片都还没有画过
+    frameStats.clear();
+    widget.viewport()->repaint();
+    record("first");
+
+    // 放大几级后左右来回平移，每帧移动视口宽度的 1/40，与拖动时相近
+    wheel(4);
+    paintFrame();
+    frameStats.clear();
+    QScrollBar* bar = widget.horizontalScrollBar();
+    const int step = qMax(1, viewport.width() / 40);
+    int direction = 1;
+    for (int f = 0; f < frames; ++f) {
+        const int next = bar->value() + direction * step;
+        if (next > bar->maximum() || next < bar->minimum())
+            direction = -direction;
+        bar->setValue(bar->value() + direction * step);
+        paintFrame();
+    }
+    record("pan");
+
+    // 以视口中心缩放，每帧一格，放大与缩小交替成组，缩放级别在原地附近来回
+    for (int f = 0; f < frames; ++f) {
+        wheel(f / 8 % 2 == 0 ? 1 : -1);
+        paintFrame();
+    }
+    record("zoom");
+
+    widget.updateFrameCounts();
+    QJsonObject counts;
+    for (auto it = frameStats.counts().cbegin(); it != frameStats.counts().cend(); ++it)
+        counts[it.key()] = double(it.value());
+    report["counts"] = counts;
+    report["viewport"] = QString("%1x%2").arg(viewport.width()).arg(viewport.height());
+    if (!jsonPath.isEmpty()) {
+        if (!FrameStats::writeJson(jsonPath, report, &error)) {
+            out() << error << "\n";
+            return 1;
+        }
+        out() << "report: " << jsonPath << "\n";
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    // 只离屏渲染，不需要显示器
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    const QString command = args.value(1);
+    if (command == "parse-stat")
+        return benchParseStat(args);
+    if (command == "open-run")
+        return benchOpenRun(args);
+    if (command == "scene-items")
+        return benchSceneItems(args);
+    if (command == "scene-edges")
+        return benchSceneEdges(args);
+    if (command == "layout")
+        return benchLayout(args);
+    if (command == "metrics")
+        return benchMetrics(args);
+    if (command == "heatmap")
+        return benchHeatmap(args);
+    if (command == "routes")
+        return benchRoutes(args);
+    if (command == "inspector")
+        return benchInspector(args);
+    if (command == "compare")
+        return benchCompare(args);
+    if (command == "sweep")
+        return benchSweep(args);
+    if (command == "trace")
+        return benchTrace(args);
+    if (command == "playback")
+        return benchPlayback(args);
+    if (command == "ingest")
+        return benchIngest(args);
+    if (command == "tiles")
+        return benchTiles(args);
+    if (command == "search")
+        return benchSearch(args);
+    if (command == "generate")
+        return benchGenerate(args);
+    if (command == "app")
+        return benchApp(args);
+
+    out() << "usage: qtvis_bench <command> ...\n"
+             "  parse-stat <statistic.txt> [--threads 1,2,4,8,16] [--repeat 3]\n"
+             "  open-run <setup.txt> <statistic.txt> [--repeat 3]\n"
+             "  scene-items [--modules 10000] [--repeat 3]\n"
+             "  scene-edges [--mesh 32] [--attach 2] [--repeat 3]\n"
+             "  layout [--mesh 71] [--threads 1,2,4,8] [--repeat 3]\n"
+             "  metrics [--cpus 20000] [--changed 64] [--repeat 3]\n"
+             "  heatmap [--ports 4096] [--fill 1.0] [--size 1024] [--repeat 3]\n"
+             "  routes [--mesh 32] [--flows 256] [--changed 64] [--threads 1,2,4,8] [--repeat 3]\n"
+             "  inspector [--ports 2048] [--repeat 3]\n"
+             "  compare [--rows 1000000] [--threads 1,2,4,8] [--repeat 3]\n"
+             "  sweep <dir> [--threads 1,2,4,8]\n"
+             "  trace [--records 20000000] [--cores 64] [--threads 1,2,4,8] [--keep]\n"
+             "  playback [--mesh 32] [--packets 100000] [--frames 120] [--events 20000000]\n"
+             "  ingest [--updates 20000000] [--counters 100000] [--frame 4096] [--epochs 10]\n"
+             "  tiles [--mesh 100] [--size 1920x1080] [--scale 1] [--frames 120]\n"
+             "  search [--rows 5000000] [--cpus 20000] [--repeat 20]\n"
+             "  generate <dir> [--mesh 16x16] [--cores 2] [--memory 4] [--fill 1] [--seed 1]\n"
+             "  app [<setup.txt>] [--mesh 16x16] [--cores 2] [--fill 1] [--size 1920x1080] [--frames 120]"
+             " [--json out.json]\n";
+    return 2;
+}
@@ -0,0 +1,233 @@
+// busevents.cpp
+#include "busevents.h"
+#include <QMutexLocker>
+#include <QThread>
+#include <cstddef>
+#include <cstring>
+
+namespace {
+
+const char kMagic[8] = {'Q', 'T', 'V', 'B', 'U', 'S', 'E', 'V'};
+const quint32 kVersion = 1;
+const quint32 kByteOrderMark = 0x01020304;
+const int kWriteBuffer = 1 << 16;     // 写出时每次缓冲的事件数（1 MB）
+
+struct Header {
+    char magic[8];
+    quint32 version;
+    quint32 byteOrder;
+    quint64 eventCount;      // 0 表示写入方还没有关闭文件
+    quint64 lastTick;
+};
+static_assert(sizeof(Header) == 32, "Header 必须为 32 字节");
+
+void setError(QString* errorMessage, const QString& message) {
+    if (errorMessage)
+        *errorMessage = message;
+}
+
+} // namespace
+
+// ============== BusEventRing ==============
+BusEventRing::BusEventRing(int capacity)
+    : buffer(qMax(1, capacity))
+{
+}
+
+bool BusEventRing::push(const BusEvent* events, int n) {
+    QMutexLocker lock(&mutex);
+    while (n > 0) {
+        while (count == buffer.size() && !closed)
+            notFull.wait(&mutex);
+        if (closed)
+            return false;
+        // 一次拷贝到缓冲区末尾或空位用完为止
+        const int tail = (head + count) % buffer.size();
+        const int room = qMin(int(buffer.size()) - count, int(buffer.size()) - tail);
+        const int step = qMin(room, n);
+        memcpy(buffer.data() + tail, events, size_t(step) * sizeof(BusEvent));
+        count += step;
+        events += step;
+        n -= step;
+    }
+    return true;
+}
+
+void BusEventRing::finish() {
+    QMutexLocker lock(&mutex);
+    finished = true;
+}
+
+int BusEventRing::popUntil(quint64 untilTick, QVector<BusEvent>& out, int maxCount) {
+    QMutexLocker lock(&mutex);
+    int taken = 0;
+    while (taken < maxCount && count > 0 && buffer[head].tick <= untilTick) {
+        out.append(buffer[head]);
+        head = (head + 1) % buffer.size();
+        --count;
+        ++taken;
+    }
+    if (taken > 0)
+        notFull.wakeOne();
+    return taken;
+}
+
+bool BusEventRing::nextTick(quint64& tick) const {
+    QMutexLocker lock(&mutex);
+    if (count == 0)
+        return false;
+    tick = buffer[head].tick;
+    return true;
+}
+
+void BusEventRing::close() {
+    QMutexLocker lock(&mutex);
+    closed = true;
+    notFull.wakeAll();
+}
+
+bool BusEventRing::atEnd() const {
+    QMutexLocker lock(&mutex);
+    return finished && count == 0;
+}
+
+int BusEventRing::size() const {
+    QMutexLocker lock(&mutex);
+    return count;
+}
+
+// ============== BusEventStream ==============
+BusEventStream::BusEventStream()
+    : eventRing(new BusEventRing(1))
+{
+}
+
+BusEventStream::~BusEventStream() {
+    stop();
+}
+
+bool BusEventStream::open(const QString& path, QString* errorMessage, int ringCapacity) {
+    stop();
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        setError(errorMessage, QString("无法打开 %1").arg(path));
+        return false;
+    }
+    Header header;
+    if (file.read(reinterpret_cast<char*>(&header), sizeof(Header)) != qint64(sizeof(Header))
+        || memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        setError(errorMessage, QString("%1 不是总线事件文件").arg(path));
+        return false;
+    }
+    if (header.version != kVersion || header.byteOrder != kByteOrderMark) {
+        setError(errorMessage, QString("%1 的版本或字节序不受支持").arg(path));
+        return false;
+    }
+    filePath = path;
+    events = header.eventCount;
+    last = header.lastTick;
+    readError.clear();
+    eventRing.reset(new BusEventRing(ringCapacity));
+    thread = QThread::create([this]() { read(); });
+    thread->start();
+    return true;
+}
+
+void BusEventStream::stop() {
+    if (!thread)
+        return;
+    eventRing->close();
+    thread->wait();
+    delete thread;
+    thread = nullptr;
+}
+
+QString BusEventStream::error() const {
+    QMutexLocker lock(&errorMutex);
+    return readError;
+}
+
+void BusEventStream::read() {
+    QFile file(filePath);
+    QVector<BusEvent> chunk(kReadChunk);
+    const qint64 chunkBytes = qint64(kReadChunk) * qint64(sizeof(BusEvent));
+    if (file.open(QIODevice::ReadOnly) && file.seek(sizeof(Header))) {
+        // 写入方异常退出时文件末尾可能有半条记录，只交出完整的部分
+        qint64 pending = 0;   // chunk 中上次剩下的不完整记录的字节数
+        quint64 pushed = 0;
+        char* bytes = reinterpret_cast<char*>(chunk.data());
+        qint64 n = 0;
+        for (;;) {
+            n = file.read(bytes + pending, chunkBytes - pending);
+            if (n <= 0)
+                break;
+            pending += n;
+            const int whole = int(pending / qint64(sizeof(BusEvent)));
+            if (!eventRing->push(chunk.constData(), whole))
+                return;   // 读方已停止
+            pushed += quint64(whole);
+            pending -= qint64(whole) * qint64(sizeof(BusEvent));
+            memmove(bytes, bytes + qint64(whole) * qint64(sizeof(BusEvent)), size_t(pending));
+        }
+        // 文件头给出了事件数（写入方已关闭文件）时，读到的少于它说明文件被截断
+        if (n < 0) {
+            QMutexLocker lock(&errorMutex);
+            readError = QString("读取 %1 失败：%2").arg(filePath, file.errorString());
+        } else if (events > 0 && pushed < events) {
+            QMutexLocker lock(&errorMutex);
+            readError = QString("%1 不完整：应有 %2 个事件，只读到 %3 个").arg(filePath).arg(events).arg(pushed);
+        }
+    } else {
+        QMutexLocker lock(&errorMutex);
+        readError = QString("无法读取 %1").arg(filePath);
+    }
+    eventRing->finish();
+}
+
+// ============== BusEventWriter ==============
+bool BusEventWriter::open(const QString& path, QString* errorMessage) {
+    file.setFileName(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        setError(errorMessage, QString("无法写入 %1").arg(path));
+        return good = false;
+    }
+    written = 0;
+    last = 0;
+    buffer.clear();
+    buffer.reserve(kWriteBuffer);
+    // 事件数先写 0，读取方据此知道文件还没写完
+    Header header = {};
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byteOrder = kByteOrderMark;
+    good = file.write(reinterpret_cast<const char*>(&header), sizeof(Header)) == qint64(sizeof(Header));
+    return good;
+}
+
+void BusEventWriter::append(const BusEvent& event) {
+    buffer.append(event);
+    ++written;
+    last = event.tick;
+    if (buffer.size() >= kWriteBuffer)
+        flush();
+}
+
+bool BusEventWriter::flush() {
+    const qint64 bytes = qint64(buffer.size()) * qint64(sizeof(BusEvent));
+    if (good && bytes > 0)
+        good = file.write(reinterpret_cast<const char*>(buffer.constData()), bytes) == bytes;
+    buffer.clear();
+    return good;
+}
+
+bool BusEventWriter::close(QString* errorMessage) {
+    flush();
+    // 补上事件数与最后的 tick（两者在文件头中相邻）
+    const quint64 tail[2] = {written, last};
+    good = good && file.seek(offsetof(Header, eventCount))
+           && file.write(reinterpret_cast<const char*>(tail), sizeof(tail)) == qint64(sizeof(tail));
+    file.close();
+    if (!good)
+        setError(errorMessage, QString("写入 %1 失败").arg(file.fileName()));
+    return good;
+}
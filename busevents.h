@@ -0,0 +1,106 @@
+// busevents.h
+#ifndef BUSEVENTS_H
+#define BUSEVENTS_H
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+#include <memory>
+
+class QThread;
+
+// 总线事件流（.qbus）：每个包注入总线时一条定长记录，按 tick 从小到大排列
+// 文件为 32 字节文件头加若干条 16 字节记录，字段按小端存放，读取时直接按内存布局解释
+struct BusEvent {
+    quint64 tick;          // 注入的时刻
+    quint16 fromPort;      // 源端口与目的端口，与 transmit_package_number_from_X_to_Y 的下标一致
+    quint16 toPort;
+    quint16 hopTicks;      // 每经过一条连线所用的周期，0 按 1 处理
+    quint16 reserved;
+};
+static_assert(sizeof(BusEvent) == 16, "BusEvent 必须为 16 字节");
+
+// 定长的环形缓冲：一个线程写入，一个线程读出
+// 写方在缓冲区满时等待；读方从不等待，每次取走已经到时的一批
+class BusEventRing {
+public:
+    explicit BusEventRing(int capacity);
+
+    // 写入 count 个事件，空间不够时等待读方取走；读方已 close 时返回 false
+    bool push(const BusEvent* events, int count);
+    // 写方：没有更多事件了
+    void finish();
+
+    // 取出 tick 不超过 untilTick 的事件追加到 out，最多 maxCount 个，返回取出的个数
+    int popUntil(quint64 untilTick, QVector<BusEvent>& out, int maxCount);
+    // 下一个事件的 tick，缓冲区为空时返回 false
+    bool nextTick(quint64& tick) const;
+    // 读方：不再读取，唤醒等待中的写方
+    void close();
+    // 写方已结束且事件已全部取走
+    bool atEnd() const;
+    int size() const;
+    int capacity() const { return int(buffer.size()); }
+
+private:
+    mutable QMutex mutex;
+    QWaitCondition notFull;
+    QVector<BusEvent> buffer;
+    int head = 0;            // 下一个读出的位置
+    int count = 0;
+    bool finished = false;
+    bool closed = false;
+};
+
+// 在独立线程上把事件文件顺序读进环形缓冲；常驻内存只有环形缓冲与一块读取缓冲，与文件长短无关
+class BusEventStream {
+public:
+    static const int kRingCapacity = 1 << 18;   // 4 MB，按每秒百万事件的回放也够几百毫秒
+    static const int kReadChunk = 1 << 12;      // 每次读取的事件数（64 KB）
+
+    BusEventStream();
+    ~BusEventStream();
+
+    // 读取文件头并启动读取线程；再次调用先停止前一个
+    bool open(const QString& path, QString* errorMessage = nullptr, int ringCapacity = kRingCapacity);
+    void stop();
+    BusEventRing& ring() { return *eventRing; }
+    // 文件头中的事件数与最后一个事件的 tick，写入方没有关闭文件时为 0
+    quint64 eventCount() const { return events; }
+    quint64 lastTick() const { return last; }
+    // 读取线程遇到的错误（读到一半文件被截断等），没有为空
+    QString error() const;
+
+private:
+    void read();
+
+    QString filePath;
+    std::unique_ptr<BusEventRing> eventRing;
+    QThread* thread = nullptr;
+    quint64 events = 0;
+    quint64 last = 0;
+    mutable QMutex errorMutex;
+    QString readError;
+};
+
+// 写事件文件：先写占位的文件头，事件经缓冲顺序写出，close 时补上事件数与最后的 tick
+// 事件必须按 tick 从小到大追加
+class BusEventWriter {
+public:
+    bool open(const QString& path, QString* errorMessage = nullptr);
+    void append(const BusEvent& event);
+    bool close(QString* errorMessage = nullptr);
+    quint64 eventCount() const { return written; }
+
+private:
+    bool flush();
+
+    QFile file;
+    QVector<BusEvent> buffer;
+    quint64 written = 0;
+    quint64 last = 0;
+    bool good = false;
+};
+
+#endif // BUSEVENTS_H
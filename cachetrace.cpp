@@ -0,0 +1,319 @@
+// cachetrace.cpp
+#include "cachetrace.h"
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentMap>
+#include <cstddef>
+#include <cstring>
+
+namespace {
+
+const char kMagic[8] = {'Q', 'T', 'V', 'T', 'R', 'A', 'C', 'E'};
+const quint32 kByteOrderMark = 0x01020304;
+const int kWriteBuffer = 1 << 16;     // 写出时每次缓冲的记录数（1 MB）
+
+struct Header {
+    char magic[8];
+    quint32 version;
+    quint32 byteOrder;
+    quint64 recordCount;     // 0 表示写入方还没有关闭文件，按文件大小推算
+    quint16 cores;
+    quint16 slices;
+    quint32 recordSize;
+};
+static_assert(sizeof(Header) == 32, "Header 必须为 32 字节");
+
+// 各事件类经过的段，与 statistic.txt 中 *_avg 的顺序一致
+const CacheTrace::Hop kHops[CacheTrace::EventClassCount][CacheTrace::kMaxHops] = {
+    {CacheTrace::L1ToL2, CacheTrace::L2ToL1},
+    {CacheTrace::L1ToL2, CacheTrace::L2ToOtherL1, CacheTrace::OtherL1ToL1},
+    {CacheTrace::L1ToL2, CacheTrace::L2ToL3, CacheTrace::L3ToL2, CacheTrace::L2ToL1},
+    {CacheTrace::L1ToL2, CacheTrace::L2ToL3, CacheTrace::L3ToOtherL2, CacheTrace::OtherL2ToL2,
+     CacheTrace::L2ToL1},
+    {CacheTrace::L1ToL2, CacheTrace::L2ToL3, CacheTrace::L3ToMem, CacheTrace::MemToL2,
+     CacheTrace::L2ToL1},
+};
+const int kHopCounts[CacheTrace::EventClassCount] = {2, 3, 4, 5, 5};
+
+struct Range {
+    const TraceRecord* records;
+    qint64 count;
+    LatencyHistograms* partial;
+};
+
+// 热循环：每条记录 2-5 段，每段一次桶计数与一次周期累加，按核心和按分片各一份
+void accumulate(const Range& s) {
+    LatencyHistograms& h = *s.partial;
+    quint64* coreBins = h.coreBins.data();
+    quint64* coreTicks = h.coreTicks.data();
+    quint64* sliceBins = h.sliceBins.data();
+    quint64* sliceTicks = h.sliceTicks.data();
+    quint64 records = 0, skipped = 0;
+    for (qint64 i = 0; i < s.count; ++i) {
+        TraceRecord r;
+        memcpy(&r, s.records + i, sizeof(TraceRecord));
+        if (r.eventClass >= CacheTrace::EventClassCount || r.core >= h.cores) {
+            ++skipped;
+            continue;
+        }
+        const int hops = kHopCounts[r.eventClass];
+        const int coreBase = LatencyHistograms::tickIndex(r.core, r.eventClass, 0);
+        const bool hasSlice = r.slice < h.slices;
+        const int sliceBase = hasSlice ? LatencyHistograms::tickIndex(r.slice, r.eventClass, 0) : 0;
+        for (int hop = 0; hop < hops; ++hop) {
+            const quint32 ticks = r.hopTicks[hop];
+            const int bucket = CacheTrace::bucketOf(ticks);
+            coreTicks[coreBase + hop] += ticks;
+            ++coreBins[(coreBase + hop) * CacheTrace::kBuckets + bucket];
+            if (hasSlice) {
+                sliceTicks[sliceBase + hop] += ticks;
+                ++sliceBins[(sliceBase + hop) * CacheTrace::kBuckets + bucket];
+            }
+        }
+        ++records;
+    }
+    h.records += records;
+    h.skipped += skipped;
+}
+
+void setError(QString* errorMessage, const QString& message) {
+    if (errorMessage)
+        *errorMessage = message;
+}
+
+} // namespace
+
+// ============== CacheTrace ==============
+int CacheTrace::hopCount(int eventClass) {
+    return eventClass >= 0 && eventClass < EventClassCount ? kHopCounts[eventClass] : 0;
+}
+
+CacheTrace::Hop CacheTrace::hopAt(int eventClass, int i) {
+    return kHops[eventClass][i];
+}
+
+const char* CacheTrace::className(int eventClass) {
+    static const char* const names[EventClassCount] = {
+        "l1miss_l2hit", "l1miss_l2forward", "l1miss_l2miss_l3hit", "l1miss_l2miss_l3forward",
+        "l1miss_l2miss_l3miss"
+    };
+    return names[eventClass];
+}
+
+QString CacheTrace::classLabel(int eventClass) {
+    switch (eventClass) {
+    case L2Hit: return QString("L2命中");
+    case L2Forward: return QString("L2转发");
+    case L3Hit: return QString("L3命中");
+    case L3Forward: return QString("L3转发");
+    case L3Miss: return QString("L3缺失");
+    default: return QString();
+    }
+}
+
+QString CacheTrace::hopLabel(int hop) {
+    switch (hop) {
+    case L1ToL2: return QString("L1→L2");
+    case L2ToL1: return QString("L2→L1");
+    case L2ToOtherL1: return QString("L2→其他L1");
+    case OtherL1ToL1: return QString("其他L1→L1");
+    case L2ToL3: return QString("L2→L3");
+    case L3ToL2: return QString("L3→L2");
+    case L3ToOtherL2: return QString("L3→其他L2");
+    case OtherL2ToL2: return QString("其他L2→L2");
+    case L3ToMem: return QString("L3→内存");
+    case MemToL2: return QString("内存→L2");
+    default: return QString();
+    }
+}
+
+// ============== LatencyHistograms ==============
+void LatencyHistograms::resize(int cores, int slices) {
+    this->cores = cores;
+    this->slices = slices;
+    records = 0;
+    skipped = 0;
+    coreTicks.fill(0, tickIndex(cores, 0, 0));
+    coreBins.fill(0, binIndex(cores, 0, 0, 0));
+    sliceTicks.fill(0, tickIndex(slices, 0, 0));
+    sliceBins.fill(0, binIndex(slices, 0, 0, 0));
+}
+
+qint64 LatencyHistograms::byteSize(int cores, int slices) {
+    return (qint64(cores) + slices) * (tickIndex(1, 0, 0) + binIndex(1, 0, 0, 0)) * qint64(sizeof(quint64));
+}
+
+void LatencyHistograms::merge(const LatencyHistograms& other) {
+    records += other.records;
+    skipped += other.skipped;
+    auto add = [](QVector<quint64>& to, const QVector<quint64>& from) {
+        quint64* p = to.data();
+        for (qsizetype i = 0; i < from.size(); ++i)
+            p[i] += from[i];
+    };
+    add(coreBins, other.coreBins);
+    add(coreTicks, other.coreTicks);
+    add(sliceBins, other.sliceBins);
+    add(sliceTicks, other.sliceTicks);
+}
+
+quint64 LatencyHistograms::bin(Scope scope, int owner, int eventClass, int hop, int bucket) const {
+    const QVector<quint64>& bins = scope == Core ? coreBins : sliceBins;
+    if (owner >= 0)
+        return bins[binIndex(owner, eventClass, hop, bucket)];
+    quint64 sum = 0;
+    for (int o = 0; o < owners(scope); ++o)
+        sum += bins[binIndex(o, eventClass, hop, bucket)];
+    return sum;
+}
+
+quint64 LatencyHistograms::count(Scope scope, int owner, int eventClass) const {
+    // 每个事件至少经过一段，第一段的计数之和就是事件数
+    quint64 sum = 0;
+    for (int b = 0; b < CacheTrace::kBuckets; ++b)
+        sum += bin(scope, owner, eventClass, 0, b);
+    return sum;
+}
+
+double LatencyHistograms::meanTicks(Scope scope, int owner, int eventClass, int hop) const {
+    const quint64 n = count(scope, owner, eventClass);
+    if (n == 0)
+        return 0;
+    const QVector<quint64>& ticks = scope == Core ? coreTicks : sliceTicks;
+    const int begin = owner >= 0 ? owner : 0;
+    const int end = owner >= 0 ? owner + 1 : owners(scope);
+    quint64 sum = 0;
+    for (int o = begin; o < end; ++o)
+        sum += ticks[tickIndex(o, eventClass, hop)];
+    return double(sum) / n;
+}
+
+quint32 LatencyHistograms::percentile(Scope scope, int owner, int eventClass, int hop,
+                                      double p) const {
+    const quint64 n = count(scope, owner, eventClass);
+    if (n == 0)
+        return 0;
+    const quint64 target = quint64(p * (n - 1));
+    quint64 seen = 0;
+    for (int b = 0; b < CacheTrace::kBuckets; ++b) {
+        seen += bin(scope, owner, eventClass, hop, b);
+        if (seen > target)
+            return CacheTrace::bucketLow(b);
+    }
+    return CacheTrace::bucketLow(CacheTrace::kBuckets - 1);
+}
+
+// ============== CacheTraceReader ==============
+bool CacheTraceReader::reduce(const QString& path, LatencyHistograms& out, QString* errorMessage,
+                              QThreadPool* pool, qint64 windowBytes) {
+    if (!pool)
+        pool = QThreadPool::globalInstance();
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        setError(errorMessage, QString("无法打开 %1").arg(path));
+        return false;
+    }
+    Header header;
+    if (file.read(reinterpret_cast<char*>(&header), sizeof(Header)) != qint64(sizeof(Header))
+        || memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        setError(errorMessage, QString("%1 不是事件跟踪文件").arg(path));
+        return false;
+    }
+    if (header.version != CacheTrace::kVersion || header.byteOrder != kByteOrderMark
+        || header.recordSize != sizeof(TraceRecord)) {
+        setError(errorMessage, QString("%1 的版本或字节序不受支持").arg(path));
+        return false;
+    }
+    if (header.cores > CacheTrace::kMaxCores || header.slices > CacheTrace::kNoSlice) {
+        setError(errorMessage, QString("%1 的核心数或 L3 分片数超出范围").arg(path));
+        return false;
+    }
+    // 写入方异常退出时文件末尾可能有半条记录，只处理完整的部分
+    const quint64 available = quint64(file.size() - qint64(sizeof(Header))) / sizeof(TraceRecord);
+    const quint64 total = header.recordCount > 0 ? qMin(header.recordCount, available) : available;
+
+    const qint64 partialBytes = LatencyHistograms::byteSize(header.cores, header.slices);
+    const int threads = int(qBound<qint64>(1, kPartialBytes / qMax<qint64>(1, partialBytes),
+                                           qMax(1, pool->maxThreadCount())));
+    QVector<LatencyHistograms> partials(threads);
+    for (LatencyHistograms& h : partials)
+        h.resize(header.cores, header.slices);
+    const qint64 windowRecords = qMax<qint64>(threads, windowBytes / qint64(sizeof(TraceRecord)));
+    for (quint64 first = 0; first < total; first += windowRecords) {
+        const qint64 count = qint64(qMin<quint64>(windowRecords, total - first));
+        uchar* window = file.map(qint64(sizeof(Header)) + qint64(first) * qint64(sizeof(TraceRecord)),
+                                 count * qint64(sizeof(TraceRecord)));
+        if (!window) {
+            setError(errorMessage, QString("无法映射 %1").arg(path));
+            return false;
+        }
+        const TraceRecord* records = reinterpret_cast<const TraceRecord*>(window);
+        QVector<Range> ranges;
+        for (int t = 0; t < threads; ++t) {
+            const qint64 begin = count * t / threads;
+            const qint64 end = count * (t + 1) / threads;
+            ranges.append({records + begin, end - begin, &partials[t]});
+        }
+        QtConcurrent::blockingMap(pool, ranges, accumulate);
+        file.unmap(window);
+    }
+
+    out.resize(header.cores, header.slices);
+    for (const LatencyHistograms& h : partials)
+        out.merge(h);
+    return true;
+}
+
+// ============== CacheTraceWriter ==============
+bool CacheTraceWriter::open(const QString& path, int cores, int slices, QString* errorMessage) {
+    if (cores < 0 || cores > CacheTrace::kMaxCores || slices < 0 || slices > CacheTrace::kNoSlice) {
+        setError(errorMessage, QString("核心数或 L3 分片数超出范围"));
+        return good = false;
+    }
+    file.setFileName(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        setError(errorMessage, QString("无法写入 %1").arg(path));
+        return good = false;
+    }
+    this->cores = cores;
+    this->slices = slices;
+    written = 0;
+    buffer.clear();
+    buffer.reserve(kWriteBuffer);
+    // 记录数先写 0，读取方据此知道文件还没写完
+    Header header = {};
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = CacheTrace::kVersion;
+    header.byteOrder = kByteOrderMark;
+    header.cores = quint16(cores);
+    header.slices = quint16(slices);
+    header.recordSize = sizeof(TraceRecord);
+    good = file.write(reinterpret_cast<const char*>(&header), sizeof(Header)) == qint64(sizeof(Header));
+    return good;
+}
+
+void CacheTraceWriter::append(const TraceRecord& record) {
+    buffer.append(record);
+    ++written;
+    if (buffer.size() >= kWriteBuffer)
+        flush();
+}
+
+bool CacheTraceWriter::flush() {
+    const qint64 bytes = qint64(buffer.size()) * qint64(sizeof(TraceRecord));
+    if (good && bytes > 0)
+        good = file.write(reinterpret_cast<const char*>(buffer.constData()), bytes) == bytes;
+    buffer.clear();
+    return good;
+}
+
+bool CacheTraceWriter::close(QString* errorMessage) {
+    flush();
+    // 补上记录数
+    const qint64 countOffset = offsetof(Header, recordCount);
+    good = good && file.seek(countOffset)
+           && file.write(reinterpret_cast<const char*>(&written), sizeof(written)) == qint64(sizeof(written));
+    file.close();
+    if (!good)
+        setError(errorMessage, QString("写入 %1 失败").arg(file.fileName()));
+    return good;
+}
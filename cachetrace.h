@@ -0,0 +1,123 @@
+// cachetrace.h
+#ifndef CACHETRACE_H
+#define CACHETRACE_H
+#include <QFile>
+#include <QtAlgorithms>
+#include <QString>
+#include <QVector>
+
+class QThreadPool;
+
+// 逐事件的 Cache 访问跟踪（.qtrace）
+// statistic.txt 的 cache_event_trace 只有每类事件的总次数、总周期和各段的时间占比；
+// 模拟器另外输出的跟踪文件每个事件一条定长记录，记下各段的实际周期数，可以得到分布而不只是平均。
+// 文件为 32 字节文件头加若干条 16 字节记录，字段按小端存放，读取时直接按内存布局解释（与快照缓存一致）。
+struct TraceRecord {
+    quint16 core;            // 发起访问的核心（CPUn / L2Cachen 的 n）
+    quint8 eventClass;       // CacheTrace::EventClass
+    quint8 slice;            // 经过的 L3 分片（nuca_index），没有经过 L3 为 CacheTrace::kNoSlice
+    quint16 hopTicks[6];     // 依 CacheTrace::hopAt 的顺序，各段消耗的周期（超过 65535 记为 65535）
+};
+static_assert(sizeof(TraceRecord) == 16, "TraceRecord 必须为 16 字节");
+
+class CacheTrace {
+public:
+    // 与 cache_event_trace 中的事件类一一对应
+    enum EventClass { L2Hit, L2Forward, L3Hit, L3Forward, L3Miss, EventClassCount };
+    // 事件经过的各段
+    enum Hop {
+        L1ToL2, L2ToL1,
+        L2ToOtherL1, OtherL1ToL1,
+        L2ToL3, L3ToL2,
+        L3ToOtherL2, OtherL2ToL2,
+        L3ToMem, MemToL2,
+        HopCount
+    };
+    static const int kMaxHops = 6;
+    static const int kBuckets = 17;       // 按 2 的幂分桶：0、1、2-3、4-7 ... 32768-65535
+    static const quint8 kNoSlice = 0xff;    // 分片数因此不超过 kNoSlice
+    static const int kMaxCores = 16384;     // 文件头中核心数的上限，超出的视为文件有误
+    static const quint32 kVersion = 1;
+    static constexpr const char* kFileName = "cache_event_trace.qtrace";  // 与 setup.txt 同目录时自动加载
+
+    static int hopCount(int eventClass);
+    static Hop hopAt(int eventClass, int i);
+    static const char* className(int eventClass);   // 如 "l1miss_l2miss_l3miss"
+    static QString classLabel(int eventClass);       // 如 "L3缺失"
+    static QString hopLabel(int hop);                // 如 "L3→内存"
+    static int bucketOf(quint32 ticks) { return ticks == 0 ? 0 : 32 - qCountLeadingZeroBits(ticks); }
+    static quint32 bucketLow(int bucket) { return bucket == 0 ? 0 : 1u << (bucket - 1); }
+};
+
+// 各段周期的直方图，按核心和按 L3 分片各一份：[所属][事件类][段序号][桶]
+// 另记各段周期之和，用来求平均
+class LatencyHistograms {
+public:
+    enum Scope { Core, Slice };
+
+    int cores = 0;
+    int slices = 0;
+    quint64 records = 0;
+    quint64 skipped = 0;             // 核心、分片或事件类超出文件头所给范围的记录
+    QVector<quint64> coreBins;
+    QVector<quint64> coreTicks;
+    QVector<quint64> sliceBins;
+    QVector<quint64> sliceTicks;
+
+    void resize(int cores, int slices);
+    // resize(cores, slices) 之后各数组所占的字节数
+    static qint64 byteSize(int cores, int slices);
+    bool isEmpty() const { return records == 0; }
+    void merge(const LatencyHistograms& other);
+
+    int owners(Scope scope) const { return scope == Core ? cores : slices; }
+    // owner 为 -1 时合计该范围内的全部核心/分片
+    quint64 count(Scope scope, int owner, int eventClass) const;
+    quint64 bin(Scope scope, int owner, int eventClass, int hop, int bucket) const;
+    double meanTicks(Scope scope, int owner, int eventClass, int hop) const;
+    // 按桶估计的分位数（桶的下界），没有事件为 0
+    quint32 percentile(Scope scope, int owner, int eventClass, int hop, double p) const;
+
+    static int binIndex(int owner, int eventClass, int hop, int bucket) {
+        return ((owner * CacheTrace::EventClassCount + eventClass) * CacheTrace::kMaxHops + hop)
+                   * CacheTrace::kBuckets + bucket;
+    }
+    static int tickIndex(int owner, int eventClass, int hop) {
+        return (owner * CacheTrace::EventClassCount + eventClass) * CacheTrace::kMaxHops + hop;
+    }
+};
+
+// 流式读取：每次映射一个窗口（默认 256 MB），窗口按线程数等分后并行归约，处理完即解除映射；
+// 常驻内存只有一个窗口与每个线程一份直方图，文件再大也不会整体读入。
+// 核心很多时直方图较大，并行的份数减少到合计不超过 kPartialBytes。
+// 整数计数的合并与顺序无关，结果与线程数无关。
+class CacheTraceReader {
+public:
+    static const qint64 kWindowBytes = qint64(256) << 20;
+    static const qint64 kPartialBytes = qint64(256) << 20;
+
+    // pool 为空时使用 QThreadPool::globalInstance()
+    static bool reduce(const QString& path, LatencyHistograms& out, QString* errorMessage = nullptr,
+                       QThreadPool* pool = nullptr, qint64 windowBytes = kWindowBytes);
+};
+
+// 写跟踪文件：先写占位的文件头，记录经缓冲顺序写出，close 时补上记录数
+class CacheTraceWriter {
+public:
+    bool open(const QString& path, int cores, int slices, QString* errorMessage = nullptr);
+    void append(const TraceRecord& record);
+    bool close(QString* errorMessage = nullptr);
+    quint64 recordCount() const { return written; }
+
+private:
+    bool flush();
+
+    QFile file;
+    QVector<TraceRecord> buffer;
+    quint64 written = 0;
+    int cores = 0;
+    int slices = 0;
+    bool good = false;
+};
+
+#endif // CACHETRACE_H
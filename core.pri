@@ -0,0 +1,50 @@
+# 不依赖界面的数据层：setup.txt / statistic.txt 解析、计数器存储与派生指标、名称与数值的搜索索引、流量矩阵与路由归因、运行对比、参数扫描表、事件跟踪归约、总线事件流、本地套接字推送、时序存储、快照缓存与自动布局，以及帧时间统计与合成运行生成（性能基准用）
+# 主程序与 bench 共用
+QT += concurrent network
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/busevents.cpp \
+    $$PWD/cachetrace.cpp \
+    $$PWD/counterstore.cpp \
+    $$PWD/derivedmetrics.cpp \
+    $$PWD/framestats.cpp \
+    $$PWD/layoutengine.cpp \
+    $$PWD/parallelstatparser.cpp \
+    $$PWD/routeengine.cpp \
+    $$PWD/runcomparison.cpp \
+    $$PWD/searchindex.cpp \
+    $$PWD/setupparser.cpp \
+    $$PWD/snapshotcache.cpp \
+    $$PWD/statingest.cpp \
+    $$PWD/statparser.cpp \
+    $$PWD/stattailer.cpp \
+    $$PWD/sweeptable.cpp \
+    $$PWD/syntheticrun.cpp \
+    $$PWD/timeseriesstore.cpp \
+    $$PWD/topology.cpp \
+    $$PWD/trafficmatrix.cpp
+
+HEADERS += \
+    $$PWD/busevents.h \
+    $$PWD/cachetrace.h \
+    $$PWD/counterstore.h \
+    $$PWD/derivedmetrics.h \
+    $$PWD/framestats.h \
+    $$PWD/layoutengine.h \
+    $$PWD/parallelstatparser.h \
+    $$PWD/routeengine.h \
+    $$PWD/runcomparison.h \
+    $$PWD/searchindex.h \
+    $$PWD/setupparser.h \
+    $$PWD/snapshotcache.h \
+    $$PWD/statingest.h \
+    $$PWD/statparser.h \
+    $$PWD/stattailer.h \
+    $$PWD/sweeptable.h \
+    $$PWD/syntheticrun.h \
+    $$PWD/textscan.h \
+    $$PWD/timeseriesstore.h \
+    $$PWD/topology.h \
+    $$PWD/trafficmatrix.h
@@ -0,0 +1,276 @@
+// counterstore.cpp
+#include "counterstore.h"
+#include <cstring>
+
+int StringTable::intern(const char* s, qsizetype n) {
+    // fromRawData 不复制，只有新名称才真正分配
+    const int existing = index.value(QByteArray::fromRawData(s, n), -1);
+    if (existing >= 0)
+        return existing;
+    const int id = int(names.size());
+    names.append(QByteArray(s, n));
+    index.insert(names.last(), id);
+    return id;
+}
+
+int StringTable::find(const char* s, qsizetype n) const {
+    return index.value(QByteArray::fromRawData(s, n), -1);
+}
+
+void StringTable::clear() {
+    names.clear();
+    index.clear();
+}
+
+void CounterStore::clear() {
+    modules.clear();
+    counters.clear();
+    moduleLatency.clear();
+    counterIsReal.clear();
+    rowModule.clear();
+    rowCounter.clear();
+    rowIndex0.clear();
+    rowIndex1.clear();
+    values.clear();
+    for (int i = 0; i < kIndexShards; ++i) {
+        hashSlots[i].clear();
+        shardRows[i] = 0;
+    }
+}
+
+void CounterStore::reserveRows(int rows) {
+    rowModule.reserve(rows);
+    rowCounter.reserve(rows);
+    rowIndex0.reserve(rows);
+    rowIndex1.reserve(rows);
+    values.reserve(rows);
+    // 每个分片按平均行数的两倍预留槽位
+    int capacity = 16;
+    while (capacity < rows * 2 / kIndexShards)
+        capacity *= 2;
+    for (int i = 0; i < kIndexShards; ++i) {
+        if (capacity > hashSlots[i].size())
+            rehashShard(i, capacity);
+    }
+}
+
+void CounterStore::resizeRows(int rows) {
+    rowModule.resize(rows);
+    rowCounter.resize(rows);
+    rowIndex0.resize(rows);
+    rowIndex1.resize(rows);
+    values.resize(rows);
+}
+
+int CounterStore::addModule(const char* name, qsizetype n, qint32 latency) {
+    const int id = modules.intern(name, n);
+    if (id >= moduleLatency.size())
+        moduleLatency.resize(id + 1, 0);
+    moduleLatency[id] = latency;
+    return id;
+}
+
+int CounterStore::addCounter(const char* name, qsizetype n) {
+    const int id = counters.intern(name, n);
+    if (id >= counterIsReal.size())
+        counterIsReal.resize(id + 1, 0);
+    return id;
+}
+
+int CounterStore::findCounter(const char* name) const {
+    return counters.find(name, qsizetype(strlen(name)));
+}
+
+quint32 CounterStore::hashKey(int module, int counter, int index0, int index1) {
+    // index1 的低3位直接作为槽内偏移：流量矩阵按 to 连续出现时，
+    // 相邻的行落在同一条缓存行里，批量插入时访存基本是顺序的
+    quint64 h = quint64(quint32(module)) * 0x9E3779B97F4A7C15ull;
+    h ^= quint64(quint32(counter)) * 0xC2B2AE3D27D4EB4Full + (h >> 29);
+    h ^= quint64(quint32(index0)) * 0x165667B19E3779F9ull + (h >> 31);
+    h ^= quint64(quint32(index1) >> 3) * 0x27D4EB2F165667C5ull + (h >> 27);
+    h ^= h >> 32;
+    return (quint32(h) & 0xF0000000u) | ((quint32(h) << 3) & 0x0FFFFFF8u) | (quint32(index1) & 7);
+}
+
+// 分片由哈希的最高4位决定，槽位由低位决定，两者互不影响
+static inline int shardOf(quint32 h) { return int(h >> 28); }
+
+void CounterStore::rehashShard(int shard, int capacity) {
+    QVector<qint32>& table = hashSlots[shard];
+    table.fill(0);
+    table.resize(capacity, 0);
+    const quint32 mask = quint32(capacity - 1);
+    const int rows = rowCount();
+    for (int r = 0; r < rows; ++r) {
+        const quint32 h = hashKey(rowModule[r], rowCounter[r], rowIndex0[r], rowIndex1[r]);
+        if (shardOf(h) != shard)
+            continue;
+        quint32 slot = h & mask;
+        while (table[slot] != 0)
+            slot = (slot + 1) & mask;
+        table[slot] = r + 1;
+    }
+}
+
+bool CounterStore::rebuildIndexShard(int shard, qint32* duplicateOf, const quint32* rowHashes) {
+    const int rows = rowCount();
+    const qint32* modulesCol = rowModule.constData();
+    const qint32* countersCol = rowCounter.constData();
+    const qint32* index0Col = rowIndex0.constData();
+    const qint32* index1Col = rowIndex1.constData();
+    double* valuesCol = values.data();
+    auto hashOf = [&](int r) {
+        return rowHashes ? rowHashes[r]
+                         : hashKey(modulesCol[r], countersCol[r], index0Col[r], index1Col[r]);
+    };
+
+    // 先数出本分片的行数，按负载因子 1/2 定容量
+    int count = 0;
+    for (int r = 0; r < rows; ++r) {
+        if (shardOf(hashOf(r)) == shard)
+            ++count;
+    }
+    int capacity = 16;
+    while (capacity < count * 2)
+        capacity *= 2;
+
+    QVector<qint32>& table = hashSlots[shard];
+    table.fill(0);
+    table.resize(capacity, 0);
+    qint32* cells = table.data();
+    const quint32 mask = quint32(capacity - 1);
+    bool duplicates = false;
+    shardRows[shard] = 0;
+
+    for (int r = 0; r < rows; ++r) {
+        const quint32 h = hashOf(r);
+        if (shardOf(h) != shard)
+            continue;
+        if (duplicateOf)
+            duplicateOf[r] = -1;
+        quint32 slot = h & mask;
+        bool found = false;
+        while (cells[slot] != 0) {
+            const int q = cells[slot] - 1;
+            if (modulesCol[q] == modulesCol[r] && countersCol[q] == countersCol[r]
+                && index0Col[q] == index0Col[r] && index1Col[q] == index1Col[r]) {
+                found = true;
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+        if (!found) {
+            cells[slot] = r + 1;
+            ++shardRows[shard];
+            continue;
+        }
+        // 重复键：保留首次出现的行，值取最后一次出现的
+        const int first = cells[slot] - 1;
+        duplicates = true;
+        valuesCol[first] = valuesCol[r];
+        if (duplicateOf)
+            duplicateOf[r] = first;
+    }
+    return duplicates;
+}
+
+void CounterStore::rebuildIndex() {
+    for (int i = 0; i < kIndexShards; ++i)
+        rebuildIndexShard(i);
+}
+
+void CounterStore::removeDuplicateRows(const qint32* duplicateOf) {
+    const int rows = rowCount();
+    int out = 0;
+    for (int r = 0; r < rows; ++r) {
+        if (duplicateOf[r] >= 0)
+            continue;
+        if (out != r) {
+            rowModule[out] = rowModule[r];
+            rowCounter[out] = rowCounter[r];
+            rowIndex0[out] = rowIndex0[r];
+            rowIndex1[out] = rowIndex1[r];
+            values[out] = values[r];
+        }
+        ++out;
+    }
+    resizeRows(out);
+}
+
+int CounterStore::findRow(int module, int counter, int index0, int index1) const {
+    const quint32 h = hashKey(module, counter, index0, index1);
+    const QVector<qint32>& table = hashSlots[shardOf(h)];
+    if (table.isEmpty())
+        return -1;
+    const quint32 mask = quint32(table.size() - 1);
+    quint32 slot = h & mask;
+    const qint32* cells = table.constData();
+    while (cells[slot] != 0) {
+        const int r = cells[slot] - 1;
+        if (rowModule[r] == module && rowCounter[r] == counter
+            && rowIndex0[r] == index0 && rowIndex1[r] == index1)
+            return r;
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
+
+int CounterStore::setValue(int module, int counter, int index0, int index1, double value,
+                           bool* changed) {
+    const quint32 h = hashKey(module, counter, index0, index1);
+    const int shard = shardOf(h);
+    // 负载因子保持在 1/2 以下
+    if ((shardRows[shard] + 1) * 2 > hashSlots[shard].size())
+        rehashShard(shard, qMax(16, int(hashSlots[shard].size()) * 2));
+
+    const quint32 mask = quint32(hashSlots[shard].size() - 1);
+    quint32 slot = h & mask;
+    qint32* cells = hashSlots[shard].data();
+    while (cells[slot] != 0) {
+        const int r = cells[slot] - 1;
+        if (rowModule[r] == module && rowCounter[r] == counter
+            && rowIndex0[r] == index0 && rowIndex1[r] == index1) {
+            if (changed)
+                *changed = values[r] != value;
+            values[r] = value;
+            return r;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    if (changed)
+        *changed = true;
+    const int row = rowCount();
+    cells[slot] = row + 1;
+    ++shardRows[shard];
+    rowModule.append(module);
+    rowCounter.append(counter);
+    rowIndex0.append(index0);
+    rowIndex1.append(index1);
+    values.append(value);
+    return row;
+}
+
+double CounterStore::value(int module, const char* counter, int index0, int index1,
+                           double defaultValue) const {
+    const int c = findCounter(counter);
+    if (module < 0 || c < 0)
+        return defaultValue;
+    const int r = findRow(module, c, index0, index1);
+    return r >= 0 ? values[r] : defaultValue;
+}
+
+QByteArray CounterStore::counterName(int row) const {
+    const QByteArray& pattern = counters.at(rowCounter[row]);
+    const qint32 indices[2] = {rowIndex0[row], rowIndex1[row]};
+    int used = 0;
+    QByteArray name;
+    name.reserve(pattern.size() + 16);
+    for (char c : pattern) {
+        if (c == '#' && used < 2 && indices[used] >= 0)
+            name += QByteArray::number(indices[used++]);
+        else
+            name += c;
+    }
+    return name;
+}
@@ -0,0 +1,92 @@
+// counterstore.h
+#ifndef COUNTERSTORE_H
+#define COUNTERSTORE_H
+#include <QByteArray>
+#include <QHash>
+#include <QVector>
+
+// 名称驻留表：每个不同的名称只保存一次，之后都用连续的整数ID引用
+class StringTable {
+public:
+    int intern(const char* s, qsizetype n);
+    int intern(const QByteArray& s) { return intern(s.constData(), s.size()); }
+    int find(const char* s, qsizetype n) const;
+    int find(const QByteArray& s) const { return find(s.constData(), s.size()); }
+    const QByteArray& at(int id) const { return names[id]; }
+    int size() const { return int(names.size()); }
+    void clear();
+
+private:
+    QVector<QByteArray> names;
+    QHash<QByteArray, int> index;
+};
+
+// statistic.txt 的列式计数器存储
+// 每个计数器实例占一行：模块ID、计数器ID、最多两个下标、数值。
+// 计数器名中纯数字的段会被替换成 '#' 并作为下标保存，
+// 例如 edge_0_to_1_busy_rate -> "edge_#_to_#_busy_rate" (0, 1)，
+// 这样上百万条 transmit_package_number_from_X_to_Y 只占一个计数器ID。
+class CounterStore {
+public:
+    StringTable modules;            // 模块名，如 "L2Cache0"
+    StringTable counters;           // 计数器模板名
+    QVector<qint32> moduleLatency;  // 模块ID -> "Latency:N"
+    QVector<quint8> counterIsReal;  // 计数器ID -> 是否出现过小数
+
+    // 按行存放的各列
+    QVector<qint32> rowModule;
+    QVector<qint32> rowCounter;
+    QVector<qint32> rowIndex0;      // 没有下标为 -1
+    QVector<qint32> rowIndex1;
+    QVector<double> values;
+
+    int rowCount() const { return int(values.size()); }
+    bool isEmpty() const { return values.isEmpty(); }
+    void clear();
+    void reserveRows(int rows);
+
+    int addModule(const char* name, qsizetype n, qint32 latency);
+    int addCounter(const char* name, qsizetype n);
+
+    // 查找/写入一行；重复的行（样例中的重复 node 行）覆盖原值
+    // changed 不为空时报告是新增了行或原值确实发生了变化
+    int findRow(int module, int counter, int index0 = -1, int index1 = -1) const;
+    int setValue(int module, int counter, int index0, int index1, double value,
+                 bool* changed = nullptr);
+
+    // 便捷查询，找不到返回 defaultValue
+    int findModule(const QByteArray& name) const { return modules.find(name); }
+    int findCounter(const char* name) const;
+    double value(int module, const char* counter, int index0 = -1, int index1 = -1,
+                 double defaultValue = 0) const;
+
+    // 还原完整的计数器名，如 "edge_0_to_1_busy_rate"
+    QByteArray counterName(int row) const;
+
+    // 批量写入：直接改写各列之后重建索引
+    // 索引按键的哈希分成 kIndexShards 个互不相交的分片，每个分片可以由一个线程独立重建。
+    // duplicateOf 不为空时记录重复键：后出现的行 r 的 duplicateOf[r] 为首次出现的行，
+    // 首行的值被更新为最后一次出现的值；没有重复的行为 -1。返回该分片是否有重复。
+    static const int kIndexShards = 16;
+    void resizeRows(int rows);
+    // rowHashes 可传入预先（并行）算好的每行 rowHash()，避免每个分片重复计算
+    bool rebuildIndexShard(int shard, qint32* duplicateOf = nullptr,
+                           const quint32* rowHashes = nullptr);
+    quint32 rowHash(int row) const {
+        return hashKey(rowModule[row], rowCounter[row], rowIndex0[row], rowIndex1[row]);
+    }
+    void rebuildIndex();
+    // 删除 duplicateOf[r] >= 0 的行（保持其余行的先后顺序），之后需重建索引
+    void removeDuplicateRows(const qint32* duplicateOf);
+
+private:
+    friend class SnapshotCacheAccess;   // 快照缓存直接读写索引分片
+    static quint32 hashKey(int module, int counter, int index0, int index1);
+    void rehashShard(int shard, int capacity);
+
+    // 开放寻址哈希表分片，槽内存 行号+1，0 表示空槽
+    QVector<qint32> hashSlots[kIndexShards];
+    int shardRows[kIndexShards] = {};
+};
+
+#endif // COUNTERSTORE_H
@@ -0,0 +1,326 @@
+// derivedmetrics.cpp
+#include "derivedmetrics.h"
+#include "counterstore.h"
+#include <limits>
+
+namespace {
+
+const double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+bool isIdentifierChar(char c, bool first) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'
+           || (!first && c >= '0' && c <= '9');
+}
+
+} // namespace
+
+// 递归下降地把中缀表达式翻译成后缀操作序列
+//   expr   := term (('+' | '-') term)*
+//   term   := factor (('*' | '/') factor)*
+//   factor := 数字 | 名称 | '(' expr ')'
+class DerivedMetrics::Parser {
+public:
+    Parser(DerivedMetrics& owner, const QByteArray& text, Metric& metric)
+        : owner(owner), text(text), metric(metric) {}
+
+    bool parse() {
+        if (!expr())
+            return false;
+        skipSpaces();
+        return pos == text.size();
+    }
+    int errorPos() const { return int(pos); }
+
+private:
+    void skipSpaces() {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t'))
+            ++pos;
+    }
+    void push(Op::Kind kind, int arg = -1, double constant = 0) {
+        Op op;
+        op.kind = kind;
+        op.arg = arg;
+        op.constant = constant;
+        metric.program.append(op);
+        // 操作数入栈，二元运算出两个入一个
+        depth += kind <= Op::Constant ? 1 : -1;
+        metric.stackDepth = qMax(metric.stackDepth, depth);
+    }
+    bool expr() {
+        if (!term())
+            return false;
+        for (skipSpaces(); pos < text.size() && (text[pos] == '+' || text[pos] == '-'); skipSpaces()) {
+            const Op::Kind kind = text[pos++] == '+' ? Op::Add : Op::Sub;
+            if (!term())
+                return false;
+            push(kind);
+        }
+        return true;
+    }
+    bool term() {
+        if (!factor())
+            return false;
+        for (skipSpaces(); pos < text.size() && (text[pos] == '*' || text[pos] == '/'); skipSpaces()) {
+            const Op::Kind kind = text[pos++] == '*' ? Op::Mul : Op::Div;
+            if (!factor())
+                return false;
+            push(kind);
+        }
+        return true;
+    }
+    bool factor() {
+        skipSpaces();
+        if (pos >= text.size())
+            return false;
+        const char c = text[pos];
+        if (c == '(') {
+            ++pos;
+            if (!expr())
+                return false;
+            skipSpaces();
+            if (pos >= text.size() || text[pos] != ')')
+                return false;
+            ++pos;
+            return true;
+        }
+        if ((c >= '0' && c <= '9') || c == '.') {
+            const qsizetype begin = pos;
+            while (pos < text.size() && ((text[pos] >= '0' && text[pos] <= '9') || text[pos] == '.'))
+                ++pos;
+            bool ok = false;
+            const double v = text.mid(begin, pos - begin).toDouble(&ok);
+            if (ok)
+                push(Op::Constant, -1, v);
+            return ok;
+        }
+        if (!isIdentifierChar(c, true))
+            return false;
+        const qsizetype begin = pos;
+        while (pos < text.size() && isIdentifierChar(text[pos], false))
+            ++pos;
+        // 先找已声明的指标，否则视为计数器名
+        const QByteArray name = text.mid(begin, pos - begin);
+        const int dependency = owner.findMetric(name);
+        if (dependency >= 0)
+            push(Op::Metric, dependency);
+        else
+            push(Op::Counter, owner.inputFor(name));
+        return true;
+    }
+
+    DerivedMetrics& owner;
+    const QByteArray& text;
+    Metric& metric;
+    qsizetype pos = 0;
+    int depth = 0;
+};
+
+DerivedMetrics::DerivedMetrics() {
+    declare("l1i_hit_rate", "L1i命中率", "l1i_hit_count / (l1i_hit_count + l1i_miss_count)", Percent);
+    declare("l1d_hit_rate", "L1d命中率", "l1d_hit_count / (l1d_hit_count + l1d_miss_count)", Percent);
+    declare("l2_hit_rate", "L2命中率", "l2_hit_count / (l2_hit_count + l2_miss_count)", Percent);
+    declare("llc_hit_rate", "L3命中率", "llc_hit_count / (llc_hit_count + llc_miss_count)", Percent);
+    declare("cpu_l1_hit_rate", "L1命中率",
+            "(ld_cache_hit_count + st_cache_hit_count)"
+            " / (ld_cache_hit_count + st_cache_hit_count + ld_cache_miss_count + st_cache_miss_count)",
+            Percent);
+    declare("ipc", "IPC", "finished_inst_count / total_tick_processed");
+    declare("load_latency", "load平均周期", "ld_mem_tick_sum / ld_inst_cnt");
+    declare("store_latency", "store平均周期", "st_mem_tick_sum / st_inst_cnt");
+    declare("amat", "平均访存周期",
+            "(load_latency * ld_inst_cnt + store_latency * st_inst_cnt) / (ld_inst_cnt + st_inst_cnt)");
+}
+
+int DerivedMetrics::declare(const QByteArray& name, const QString& label, const QByteArray& expression,
+                            Unit unit, QString* errorMessage) {
+    if (name.isEmpty() || metricIndex.contains(name)) {
+        if (errorMessage)
+            *errorMessage = QString("指标名 %1 为空或重复").arg(QString::fromLatin1(name));
+        return -1;
+    }
+    // 先在副本上解析，出错时不留下半个指标；新建的输入即使用不上也无害
+    Metric metric;
+    metric.name = name;
+    metric.label = label;
+    metric.expression = expression;
+    metric.unit = unit;
+    Parser parser(*this, expression, metric);
+    if (!parser.parse()) {
+        if (errorMessage) {
+            *errorMessage = QString("指标 %1 的表达式在第%2个字符处有误")
+                                .arg(QString::fromLatin1(name)).arg(parser.errorPos() + 1);
+        }
+        return -1;
+    }
+
+    const int id = int(metrics.size());
+    for (const Op& op : metric.program) {
+        if (op.kind == Op::Metric && !metrics[op.arg].dependents.contains(id))
+            metrics[op.arg].dependents.append(id);
+        else if (op.kind == Op::Counter && !inputs[op.arg].readers.contains(id))
+            inputs[op.arg].readers.append(id);
+    }
+    metrics.append(metric);
+    metricIndex.insert(name, id);
+    columns.resize(metrics.size());
+    dirty.append(true);
+
+    // 已经有数据时，新的计数器输入要从头对应一遍行
+    if (store) {
+        inputOfCounter.clear();
+        indexedRows = 0;
+        catchUp();
+    }
+    return id;
+}
+
+int DerivedMetrics::inputFor(const QByteArray& counter) {
+    const int existing = inputIndex.value(counter, -1);
+    if (existing >= 0)
+        return existing;
+    Input input;
+    input.counter = counter;
+    inputs.append(input);
+    inputIndex.insert(counter, int(inputs.size()) - 1);
+    return int(inputs.size()) - 1;
+}
+
+void DerivedMetrics::reset(const CounterStore* store) {
+    this->store = store;
+    inputOfCounter.clear();
+    for (Input& input : inputs)
+        input.rows.clear();
+    moduleCount = 0;
+    indexedRows = 0;
+    markAllDirty();
+    catchUp();
+}
+
+void DerivedMetrics::catchUp() {
+    if (!store)
+        return;
+    // 模块变多时各列都要变长
+    if (store->modules.size() != moduleCount) {
+        moduleCount = store->modules.size();
+        markAllDirty();
+    }
+    for (Input& input : inputs)
+        input.rows.resize(moduleCount, -1);
+
+    // 新出现的计数器名：是否有指标读它
+    const int counters = store->counters.size();
+    for (int id = int(inputOfCounter.size()); id < counters; ++id)
+        inputOfCounter.append(inputIndex.value(store->counters.at(id), -1));
+
+    const int rows = store->rowCount();
+    for (int r = indexedRows; r < rows; ++r) {
+        if (store->rowIndex0[r] >= 0 || store->rowIndex1[r] >= 0)
+            continue;
+        const int input = inputOfCounter[store->rowCounter[r]];
+        if (input < 0)
+            continue;
+        qint32& row = inputs[input].rows[store->rowModule[r]];
+        if (row < 0)
+            row = r;
+        for (const int metric : inputs[input].readers)
+            invalidate(metric);
+    }
+    indexedRows = rows;
+}
+
+void DerivedMetrics::markDirty(const QVector<qint32>& rows) {
+    if (!store)
+        return;
+    for (const qint32 r : rows) {
+        if (r >= indexedRows || store->rowIndex0[r] >= 0 || store->rowIndex1[r] >= 0)
+            continue;
+        const int input = inputOfCounter[store->rowCounter[r]];
+        if (input < 0)
+            continue;
+        for (const int metric : inputs[input].readers)
+            invalidate(metric);
+    }
+}
+
+void DerivedMetrics::invalidate(int metric) {
+    // 过期的指标其下游必然也已过期（重新计算时先算上游），可以就此停下
+    if (dirty[metric])
+        return;
+    dirty[metric] = true;
+    for (const int dependent : metrics[metric].dependents)
+        invalidate(dependent);
+}
+
+void DerivedMetrics::markAllDirty() {
+    dirty.fill(true);
+}
+
+const QVector<double>& DerivedMetrics::column(int metric) const {
+    if (dirty[metric])
+        evaluate(metric);
+    return columns[metric];
+}
+
+double DerivedMetrics::value(int metric, int module) const {
+    const QVector<double>& values = column(metric);
+    return module >= 0 && module < values.size() ? values[module] : kNaN;
+}
+
+void DerivedMetrics::evaluate(int metric) const {
+    const Metric& m = metrics[metric];
+    for (const Op& op : m.program) {
+        if (op.kind == Op::Metric && dirty[op.arg])
+            evaluate(op.arg);
+    }
+
+    // 栈上每一层是一整列，每个操作对所有模块做同一件事
+    const int n = moduleCount;
+    if (stack.size() < m.stackDepth)
+        stack.resize(m.stackDepth);
+    const double* values = store ? store->values.constData() : nullptr;
+    int top = 0;
+    for (const Op& op : m.program) {
+        if (op.kind <= Op::Constant) {
+            QVector<double>& slot = stack[top++];
+            slot.resize(n);
+            double* out = slot.data();
+            if (op.kind == Op::Counter) {
+                const qint32* rows = inputs[op.arg].rows.constData();
+                for (int i = 0; i < n; ++i)
+                    out[i] = rows[i] >= 0 ? values[rows[i]] : kNaN;
+            } else if (op.kind == Op::Metric) {
+                const double* in = columns[op.arg].constData();
+                for (int i = 0; i < n; ++i)
+                    out[i] = in[i];
+            } else {
+                for (int i = 0; i < n; ++i)
+                    out[i] = op.constant;
+            }
+            continue;
+        }
+        --top;
+        double* a = stack[top - 1].data();
+        const double* b = stack[top].constData();
+        switch (op.kind) {
+        case Op::Add:
+            for (int i = 0; i < n; ++i)
+                a[i] += b[i];
+            break;
+        case Op::Sub:
+            for (int i = 0; i < n; ++i)
+                a[i] -= b[i];
+            break;
+        case Op::Mul:
+            for (int i = 0; i < n; ++i)
+                a[i] *= b[i];
+            break;
+        default:
+            for (int i = 0; i < n; ++i)
+                a[i] = b[i] != 0 ? a[i] / b[i] : kNaN;
+            break;
+        }
+    }
+    columns[metric].swap(stack[0]);
+    dirty[metric] = false;
+    ++evaluationCount;
+}
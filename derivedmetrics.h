@@ -0,0 +1,109 @@
+// derivedmetrics.h
+#ifndef DERIVEDMETRICS_H
+#define DERIVEDMETRICS_H
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+class CounterStore;
+
+// 由原始计数器派生的指标（命中率、IPC、平均访存延迟等）
+// 每个指标是一个四则运算表达式，操作数为模块自己的计数器（不带下标的行）或先前声明的指标，
+// 例如 "l2_hit_count / (l2_hit_count + l2_miss_count)"。
+// 指标按列保存：CounterStore 模块ID -> 值，一次对全部模块逐列计算；
+// 模块缺少某个计数器或除数为 0 时结果为 NaN，表示该模块没有这个指标。
+// 计算是惰性的：计数器变化只把读它的指标及其下游标记为过期，读取时才重新计算过期的列。
+class DerivedMetrics {
+public:
+    // 预先声明的指标，编号即声明顺序
+    enum Standard {
+        L1iHitRate,     // L2Cache 模块记录的 L1 指令/数据缓存
+        L1dHitRate,
+        L2HitRate,
+        LlcHitRate,
+        CpuL1HitRate,   // CPU 的 load/store 命中 L1 的比例
+        Ipc,
+        LoadLatency,    // 平均每条 load/store 指令消耗的周期
+        StoreLatency,
+        Amat,           // load 与 store 合计的平均访存时间
+        StandardCount
+    };
+
+    // 显示方式：比例按百分数显示
+    enum Unit { Plain, Percent };
+
+    DerivedMetrics();
+
+    // 声明一个指标，返回其编号；表达式有误或名称重复时返回 -1。表达式中不是已声明指标的名称都视为计数器
+    int declare(const QByteArray& name, const QString& label, const QByteArray& expression,
+                Unit unit = Plain, QString* errorMessage = nullptr);
+    int metricCount() const { return int(metrics.size()); }
+    int findMetric(const QByteArray& name) const { return metricIndex.value(name, -1); }
+    const QByteArray& name(int metric) const { return metrics[metric].name; }
+    const QString& label(int metric) const { return metrics[metric].label; }
+    const QByteArray& expression(int metric) const { return metrics[metric].expression; }
+    Unit unit(int metric) const { return metrics[metric].unit; }
+
+    // 换一份统计数据，全部指标过期
+    void reset(const CounterStore* store);
+    // 换成同源的另一份存储（如某个 epoch 的值），各ID与行号一致，不改变过期状态
+    void setStore(const CounterStore* store) { this->store = store; }
+    // 并入新增的模块、计数器与行；新行涉及的指标过期
+    void catchUp();
+    // rows 中的值发生了变化，可以有重复；调用前需已 catchUp
+    void markDirty(const QVector<qint32>& rows);
+    void markAllDirty();
+    bool isDirty(int metric) const { return dirty[metric]; }
+
+    // 某个模块（CounterStore 模块ID）的指标值，没有为 NaN；过期时先重新计算整列
+    double value(int metric, int module) const;
+    const QVector<double>& column(int metric) const;
+    // 累计重新计算过的列数
+    int evaluations() const { return evaluationCount; }
+
+private:
+    struct Op {
+        enum Kind { Counter, Metric, Constant, Add, Sub, Mul, Div };
+        Kind kind;
+        int arg = -1;           // Counter 为输入编号，Metric 为指标编号
+        double constant = 0;
+    };
+    struct Metric {
+        QByteArray name;
+        QString label;
+        QByteArray expression;
+        Unit unit = Plain;
+        QVector<Op> program;    // 后缀形式
+        int stackDepth = 0;
+        QVector<int> dependents;
+    };
+    // 指标读到的一个计数器，多个指标共用
+    struct Input {
+        QByteArray counter;
+        QVector<qint32> rows;   // 模块ID -> 行，没有为 -1
+        QVector<int> readers;   // 读它的指标
+    };
+    class Parser;
+
+    int inputFor(const QByteArray& counter);
+    void invalidate(int metric);
+    void evaluate(int metric) const;
+
+    QVector<Metric> metrics;
+    QHash<QByteArray, int> metricIndex;
+    QVector<Input> inputs;
+    QHash<QByteArray, int> inputIndex;
+
+    const CounterStore* store = nullptr;
+    QVector<int> inputOfCounter;        // CounterStore 计数器ID -> 输入，不是输入为 -1
+    int moduleCount = 0;
+    int indexedRows = 0;
+
+    mutable QVector<QVector<double>> columns;
+    mutable QVector<bool> dirty;
+    mutable QVector<QVector<double>> stack;
+    mutable int evaluationCount = 0;
+};
+
+#endif // DERIVEDMETRICS_H
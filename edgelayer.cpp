@@ -0,0 +1,261 @@
+// edgelayer.cpp
+#include "edgelayer.h"
+#include "framestats.h"
+#include "scenebuilder.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QGraphicsSceneHoverEvent>
+#include <QtMath>
+
+namespace {
+
+const qreal kCellSize = 256;       // 命中网格单元边长
+const qreal kLabelOffset = 8;      // 标签沿法线离开连线中点的距离
+const QPointF kLabelShift(16, 11); // 让标签大致以锚点为中心
+const qreal kLabelExtent = 48;     // 标签超出连线范围的最大尺寸，用于包围盒和重绘区域
+
+qint32 cellOf(qreal v) {
+    return qint32(qFloor(v / kCellSize));
+}
+
+quint64 cellKey(qint32 x, qint32 y) {
+    return (quint64(quint32(x)) << 32) | quint32(y);
+}
+
+// 沿线段按半个单元的步长取样，依次给出经过的网格单元（不重复）
+template <class F>
+void forEachCell(const QLineF& line, F f) {
+    const int steps = qMax(1, int(qCeil(line.length() / (kCellSize / 2))));
+    quint64 last = 0;
+    for (int i = 0; i <= steps; ++i) {
+        const QPointF p = line.pointAt(qreal(i) / steps);
+        const quint64 key = cellKey(cellOf(p.x()), cellOf(p.y()));
+        if (i == 0 || key != last)
+            f(key);
+        last = key;
+    }
+}
+
+qreal distanceToSegment(const QPointF& p, const QLineF& line) {
+    const QPointF d = line.p2() - line.p1();
+    const qreal len2 = d.x() * d.x() + d.y() * d.y();
+    qreal t = len2 > 0 ? QPointF::dotProduct(p - line.p1(), d) / len2 : 0;
+    t = qBound<qreal>(0, t, 1);
+    const QPointF q = line.p1() + d * t - p;
+    return qSqrt(q.x() * q.x() + q.y() * q.y());
+}
+
+QRectF lineRect(const QLineF& line) {
+    return QRectF(line.p1(), line.p2()).normalized();
+}
+
+} // namespace
+
+EdgeLayer::EdgeLayer(QGraphicsItem* parent) : QGraphicsItem(parent), labelFont("Arial", 8, QFont::Bold)
+{
+    setZValue(-1); // 确保连接线在模块下方
+    setAcceptHoverEvents(true);
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+}
+
+int EdgeLayer::addStyle(const QPen& pen) {
+    for (int i = 0; i < buckets.size(); ++i) {
+        if (buckets[i].pen == pen)
+            return i;
+    }
+    Bucket bucket;
+    bucket.pen = pen;
+    buckets.append(bucket);
+    if (pen.widthF() > maxPenWidth) {
+        prepareGeometryChange();
+        maxPenWidth = pen.widthF();
+    }
+    return int(buckets.size()) - 1;
+}
+
+int EdgeLayer::addEdge(const QLineF& line, int style) {
+    const int edge = int(edgeBucket.size());
+    Bucket& bucket = buckets[style];
+    edgeBucket.append(style);
+    edgeSlot.append(int(bucket.lines.size()));
+    bucket.lines.append(line);
+    bucket.edges.append(edge);
+    insertIntoGrid(edge, line);
+    growBounds(line);
+    update(lineRect(line).adjusted(-maxPenWidth, -maxPenWidth, maxPenWidth, maxPenWidth));
+    return edge;
+}
+
+void EdgeLayer::setLine(int edge, const QLineF& newLine) {
+    Bucket& bucket = buckets[edgeBucket[edge]];
+    QLineF& stored = bucket.lines[edgeSlot[edge]];
+    if (stored == newLine)
+        return;
+    const qreal margin = maxPenWidth + (labels.contains(edge) ? kLabelExtent : 0);
+    update(lineRect(stored).adjusted(-margin, -margin, margin, margin));
+    removeFromGrid(edge, stored);
+    stored = newLine;
+    insertIntoGrid(edge, newLine);
+    growBounds(newLine);
+    update(lineRect(newLine).adjusted(-margin, -margin, margin, margin));
+}
+
+void EdgeLayer::setStyle(int edge, int style) {
+    const int from = edgeBucket[edge];
+    if (from == style)
+        return;
+    // 用桶尾的连线填补空位
+    Bucket& old = buckets[from];
+    const int slot = edgeSlot[edge];
+    const QLineF line = old.lines[slot];
+    const int lastSlot = int(old.lines.size()) - 1;
+    old.lines[slot] = old.lines[lastSlot];
+    old.edges[slot] = old.edges[lastSlot];
+    edgeSlot[old.edges[slot]] = slot;
+    old.lines.removeLast();
+    old.edges.removeLast();
+
+    Bucket& target = buckets[style];
+    edgeBucket[edge] = style;
+    edgeSlot[edge] = int(target.lines.size());
+    target.lines.append(line);
+    target.edges.append(edge);
+    update(lineRect(line).adjusted(-maxPenWidth, -maxPenWidth, maxPenWidth, maxPenWidth));
+}
+
+void EdgeLayer::setLabel(int edge, const QString& text, const QColor& color) {
+    if (text.isEmpty()) {
+        if (labels.remove(edge) == 0)
+            return;
+    } else {
+        Label& label = labels[edge];
+        if (label.text.text() == text && label.color == color)
+            return;
+        label.text.setText(text);
+        label.text.setPerformanceHint(QStaticText::AggressiveCaching);
+        label.color = color;
+    }
+    const QPointF p = labelPos(edge);
+    update(QRectF(p, QSizeF(kLabelExtent, kLabelExtent)));
+}
+
+void EdgeLayer::setLabelsVisible(bool visible) {
+    if (labelsVisible == visible)
+        return;
+    labelsVisible = visible;
+    update();
+}
+
+void EdgeLayer::setLabelFont(const QFont& font) {
+    labelFont = font;
+    update();
+}
+
+QPointF EdgeLayer::labelPos(int edge) const {
+    const QLineF l = line(edge);
+    const qreal length = l.length();
+    const QPointF normal = length > 0 ? QPointF(-l.dy(), l.dx()) / length : QPointF();
+    return l.center() + normal * kLabelOffset - kLabelShift;
+}
+
+void EdgeLayer::insertIntoGrid(int edge, const QLineF& line) {
+    forEachCell(line, [&](quint64 key) { grid[key].append(edge); });
+}
+
+void EdgeLayer::removeFromGrid(int edge, const QLineF& line) {
+    forEachCell(line, [&](quint64 key) {
+        auto it = grid.find(key);
+        if (it == grid.end())
+            return;
+        QVector<int>& cell = it.value();
+        const int i = int(cell.indexOf(edge));
+        if (i < 0)
+            return;
+        cell[i] = cell.last();
+        cell.removeLast();
+        if (cell.isEmpty())
+            grid.erase(it);
+    });
+}
+
+void EdgeLayer::growBounds(const QLineF& line) {
+    const QRectF r = lineRect(line);
+    if (edgeBucket.size() > 1 && bounds.left() <= r.left() && bounds.top() <= r.top()
+        && bounds.right() >= r.right() && bounds.bottom() >= r.bottom())
+        return;
+    prepareGeometryChange();
+    if (edgeBucket.size() <= 1) {
+        bounds = r;
+        return;
+    }
+    bounds.setCoords(qMin(bounds.left(), r.left()), qMin(bounds.top(), r.top()),
+                     qMax(bounds.right(), r.right()), qMax(bounds.bottom(), r.bottom()));
+}
+
+int EdgeLayer::edgeAt(const QPointF& scenePos, qreal tolerance) const {
+    const QPointF p = mapFromScene(scenePos);
+    const qint32 cx = cellOf(p.x());
+    const qint32 cy = cellOf(p.y());
+    int best = -1;
+    qreal bestDistance = 0;
+    // 线段可能只擦过相邻单元的角，查询点周围 3x3 个单元都要看
+    for (qint32 dx = -1; dx <= 1; ++dx) {
+        for (qint32 dy = -1; dy <= 1; ++dy) {
+            auto it = grid.constFind(cellKey(cx + dx, cy + dy));
+            if (it == grid.constEnd())
+                continue;
+            for (const int edge : it.value()) {
+                const qreal reach = tolerance + buckets[edgeBucket[edge]].pen.widthF() / 2;
+                const qreal d = distanceToSegment(p, line(edge));
+                if (d <= reach && (best < 0 || d < bestDistance)) {
+                    best = edge;
+                    bestDistance = d;
+                }
+            }
+        }
+    }
+    return best;
+}
+
+QRectF EdgeLayer::boundingRect() const {
+    if (edgeBucket.isEmpty())
+        return QRectF();
+    const qreal margin = maxPenWidth / 2 + kLabelExtent;
+    return bounds.adjusted(-margin, -margin, margin, margin);
+}
+
+bool EdgeLayer::contains(const QPointF& point) const {
+    return edgeAt(mapToScene(point)) >= 0;
+}
+
+void EdgeLayer::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) {
+    Q_UNUSED(widget);
+    FrameStats::Timer timer(FrameStats::Links);
+    for (const Bucket& bucket : buckets) {
+        if (bucket.lines.isEmpty())
+            continue;
+        painter->setPen(bucket.pen);
+        painter->drawLines(bucket.lines.constData(), int(bucket.lines.size()));
+    }
+
+    if (!labelsVisible || labels.isEmpty()
+        || option->levelOfDetailFromTransform(painter->worldTransform()) < kFullScale)
+        return;
+    painter->setFont(labelFont);
+    for (auto it = labels.cbegin(); it != labels.cend(); ++it) {
+        const QPointF p = labelPos(it.key());
+        if (!option->exposedRect.intersects(QRectF(p, QSizeF(kLabelExtent, kLabelExtent))))
+            continue;
+        painter->setPen(it.value().color);
+        painter->drawStaticText(p, it.value().text);
+    }
+}
+
+void EdgeLayer::hoverMoveEvent(QGraphicsSceneHoverEvent* event) {
+    QGraphicsItem::hoverMoveEvent(event);
+    const int edge = edgeAt(event->scenePos());
+    if (edge == hoveredEdge)
+        return;
+    hoveredEdge = edge;
+    setToolTip(edge >= 0 && describer ? describer(edge) : QString());
+}
@@ -0,0 +1,77 @@
+// edgelayer.h
+#ifndef EDGELAYER_H
+#define EDGELAYER_H
+#include <QGraphicsItem>
+#include <QHash>
+#include <QPen>
+#include <QStaticText>
+#include <QVector>
+#include <functional>
+
+// 把大量连线画在同一个图元里
+// 连线按画笔分桶，每个桶的线段连续存放，绘制时一个桶只调用一次 drawLines；
+// 改变样式时把连线从一个桶挪到另一个桶（与桶尾交换），不重新分配其余连线。
+// 悬停与点击命中通过均匀网格只检查附近的连线。
+class EdgeLayer : public QGraphicsItem {
+public:
+    explicit EdgeLayer(QGraphicsItem* parent = nullptr);
+
+    // 登记一种画笔，相同的画笔返回已有的样式编号
+    int addStyle(const QPen& pen);
+    int addEdge(const QLineF& line, int style);
+    int edgeCount() const { return int(edgeBucket.size()); }
+
+    QLineF line(int edge) const { return buckets[edgeBucket[edge]].lines[edgeSlot[edge]]; }
+    int style(int edge) const { return edgeBucket[edge]; }
+    const QPen& stylePen(int style) const { return buckets[style].pen; }
+    void setLine(int edge, const QLineF& line);
+    void setStyle(int edge, int style);
+
+    // 连线中点旁的文字标签，文本为空时去掉
+    void setLabel(int edge, const QString& text, const QColor& color);
+    void setLabelsVisible(bool visible);
+    void setLabelFont(const QFont& font);
+
+    // 离 scenePos 不超过 tolerance 的最近连线，没有返回 -1
+    int edgeAt(const QPointF& scenePos, qreal tolerance = 4) const;
+    // 悬停提示的文字
+    void setDescriber(const std::function<QString(int)>& describe) { describer = describe; }
+
+    QRectF boundingRect() const override;
+    bool contains(const QPointF& point) const override;
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option,
+               QWidget* widget = nullptr) override;
+
+protected:
+    void hoverMoveEvent(QGraphicsSceneHoverEvent* event) override;
+
+private:
+    struct Bucket {
+        QPen pen;
+        QVector<QLineF> lines;
+        QVector<int> edges;     // 桶内位置 -> 连线
+    };
+    struct Label {
+        QStaticText text;
+        QColor color;
+    };
+
+    void insertIntoGrid(int edge, const QLineF& line);
+    void removeFromGrid(int edge, const QLineF& line);
+    QPointF labelPos(int edge) const;
+    void growBounds(const QLineF& line);
+
+    QVector<Bucket> buckets;
+    QVector<int> edgeBucket;
+    QVector<int> edgeSlot;
+    QHash<quint64, QVector<int>> grid;   // 网格单元 -> 经过的连线
+    QHash<int, Label> labels;
+    QFont labelFont;
+    bool labelsVisible = true;
+    QRectF bounds;
+    qreal maxPenWidth = 0;
+    int hoveredEdge = -1;
+    std::function<QString(int)> describer;
+};
+
+#endif // EDGELAYER_H
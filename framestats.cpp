@@ -0,0 +1,215 @@
+// framestats.cpp
+#include "framestats.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <algorithm>
+
+FrameStats* FrameStats::current = nullptr;
+
+namespace {
+
+// 正在计时的 Timer 是否已有外层
+bool timerActive = false;
+
+const qint64 kMaxIntervalNs = qint64(1000) * 1000 * 1000;
+
+} // namespace
+
+const char* FrameStats::sectionName(Section section) {
+    switch (section) {
+    case Tiles: return "tiles";
+    case Modules: return "modules";
+    case Links: return "links";
+    case Packets: return "packets";
+    case Latency: return "latency";
+    case Highlight: return "highlight";
+    default: return "";
+    }
+}
+
+FrameStats::Timer::Timer(Section section) : stats(nullptr), section(section) {
+    if (!current || timerActive)
+        return;
+    stats = current;
+    timerActive = true;
+    clock.start();
+}
+
+FrameStats::Timer::~Timer() {
+    if (!stats)
+        return;
+    stats->addSection(section, clock.nsecsElapsed());
+    timerActive = false;
+}
+
+void FrameStats::beginFrame() {
+    open = Frame();
+    if (lastBegin.isValid()) {
+        const qint64 interval = lastBegin.nsecsElapsed();
+        if (interval <= kMaxIntervalNs)
+            open.intervalNs = interval;
+    }
+    lastBegin.start();
+    frameClock.start();
+    inFrame = true;
+}
+
+void FrameStats::endFrame() {
+    if (!inFrame)
+        return;
+    inFrame = false;
+    open.paintNs = frameClock.nsecsElapsed();
+    if (frames.size() < kWindow) {
+        frames.append(open);
+    } else {
+        frames[head] = open;
+        head = (head + 1) % kWindow;
+    }
+    ++totalFrames;
+}
+
+void FrameStats::addSection(Section section, qint64 ns) {
+    if (inFrame)
+        open.sectionNs[section] += ns;
+}
+
+void FrameStats::clear() {
+    frames.clear();
+    head = 0;
+    inFrame = false;
+    lastBegin.invalidate();
+    totalFrames = 0;
+}
+
+double FrameStats::meanFrameMs() const {
+    if (frames.isEmpty())
+        return 0;
+    qint64 sum = 0;
+    for (const Frame& frame : frames)
+        sum += frame.paintNs;
+    return sum / 1e6 / frames.size();
+}
+
+double FrameStats::percentileFrameMs(double p) const {
+    if (frames.isEmpty())
+        return 0;
+    QVector<qint64> sorted;
+    sorted.reserve(frames.size());
+    for (const Frame& frame : frames)
+        sorted.append(frame.paintNs);
+    const int k = qBound(0, int(p / 100 * (sorted.size() - 1) + 0.5), int(sorted.size()) - 1);
+    std::nth_element(sorted.begin(), sorted.begin() + k, sorted.end());
+    return sorted[k] / 1e6;
+}
+
+double FrameStats::maxFrameMs() const {
+    qint64 most = 0;
+    for (const Frame& frame : frames)
+        most = qMax(most, frame.paintNs);
+    return most / 1e6;
+}
+
+double FrameStats::meanIntervalMs() const {
+    qint64 sum = 0;
+    int count = 0;
+    for (const Frame& frame : frames) {
+        if (frame.intervalNs >= 0) {
+            sum += frame.intervalNs;
+            ++count;
+        }
+    }
+    return count > 0 ? sum / 1e6 / count : 0;
+}
+
+double FrameStats::meanSectionMs(Section section) const {
+    if (frames.isEmpty())
+        return 0;
+    qint64 sum = 0;
+    for (const Frame& frame : frames)
+        sum += frame.sectionNs[section];
+    return sum / 1e6 / frames.size();
+}
+
+double FrameStats::meanOtherMs() const {
+    double other = meanFrameMs();
+    for (int s = 0; s < SectionCount; ++s)
+        other -= meanSectionMs(Section(s));
+    return qMax(0.0, other);
+}
+
+void FrameStats::setCount(const QString& name, qint64 count) {
+    itemCounts[name] = count;
+}
+
+QString FrameStats::summary() const {
+    QString text = QString("帧 %1  均值 %2 ms  p95 %3 ms  最大 %4 ms")
+                       .arg(totalFrames)
+                       .arg(meanFrameMs(), 0, 'f', 2)
+                       .arg(percentileFrameMs(95), 0, 'f', 2)
+                       .arg(maxFrameMs(), 0, 'f', 2);
+    const double interval = meanIntervalMs();
+    if (interval > 0)
+        text += QString("  间隔 %1 ms").arg(interval, 0, 'f', 1);
+    text += "\n";
+    for (int s = 0; s < SectionCount; ++s)
+        text += QString("%1 %2  ").arg(QString::fromLatin1(sectionName(Section(s))))
+                    .arg(meanSectionMs(Section(s)), 0, 'f', 2);
+    text += QString("other %1 ms").arg(meanOtherMs(), 0, 'f', 2);
+    QString line;
+    for (auto it = itemCounts.cbegin(); it != itemCounts.cend(); ++it) {
+        if (line.size() > 60) {
+            text += "\n" + line.trimmed();
+            line.clear();
+        }
+        line += QString("%1 %2  ").arg(it.key()).arg(it.value());
+    }
+    if (!line.isEmpty())
+        text += "\n" + line.trimmed();
+    return text;
+}
+
+QJsonObject FrameStats::toJson() const {
+    QJsonObject frame;
+    frame["mean"] = meanFrameMs();
+    frame["p50"] = percentileFrameMs(50);
+    frame["p95"] = percentileFrameMs(95);
+    frame["p99"] = percentileFrameMs(99);
+    frame["max"] = maxFrameMs();
+    QJsonObject sections;
+    for (int s = 0; s < SectionCount; ++s)
+        sections[QString::fromLatin1(sectionName(Section(s)))] = meanSectionMs(Section(s));
+    sections["other"] = meanOtherMs();
+    QJsonObject counts;
+    for (auto it = itemCounts.cbegin(); it != itemCounts.cend(); ++it)
+        counts[it.key()] = double(it.value());
+    QJsonArray samples;
+    for (int i = 0; i < frames.size(); ++i)
+        samples.append(frameAt(i).paintNs / 1e6);
+
+    QJsonObject object;
+    object["frames"] = double(totalFrames);
+    object["window"] = int(frames.size());
+    object["frame_ms"] = frame;
+    object["interval_ms"] = meanIntervalMs();
+    object["sections_ms"] = sections;
+    object["counts"] = counts;
+    object["samples_ms"] = samples;
+    return object;
+}
+
+bool FrameStats::writeJson(const QString& path, const QJsonObject& object, QString* errorMessage) {
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (errorMessage)
+            *errorMessage = QString("无法写入 %1：%2").arg(path, file.errorString());
+        return false;
+    }
+    file.write(QJsonDocument(object).toJson());
+    if (!file.commit()) {
+        if (errorMessage)
+            *errorMessage = QString("写入 %1 失败：%2").arg(path, file.errorString());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,84 @@
+// framestats.h
+#ifndef FRAMESTATS_H
+#define FRAMESTATS_H
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QMap>
+#include <QString>
+#include <QVector>
+
+// 场景绘制的帧时间：每帧 QGraphicsView::paintEvent 的耗时、相邻两帧的间隔，以及其中各类图元绘制的耗时。
+// 只保留最近 kWindow 帧，统计随之滚动；各类图元由绘制代码里的 FrameStats::Timer 记入 current。
+// 只在界面线程上使用
+class FrameStats {
+public:
+    enum Section { Tiles, Modules, Links, Packets, Latency, Highlight, SectionCount };
+    static const char* sectionName(Section section);
+
+    static const int kWindow = 240;
+
+    // 正在记录的那一份，只在帧内不为空；为空时 Timer 不计时，绘制代码不必关心是否开启了统计
+    static FrameStats* current;
+
+    // 作用域内的绘制记入 section；嵌套时只算最外层（突出显示层重画模块时整体算作 Highlight）
+    class Timer {
+    public:
+        explicit Timer(Section section);
+        ~Timer();
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+    private:
+        FrameStats* stats;
+        Section section;
+        QElapsedTimer clock;
+    };
+
+    void beginFrame();
+    void endFrame();
+    void addSection(Section section, qint64 ns);
+    // 丢弃已记录的帧，图元数量保留
+    void clear();
+
+    // 窗口内的帧数与 clear 之后的总帧数
+    int frameCount() const { return int(frames.size()); }
+    qint64 totalFrameCount() const { return totalFrames; }
+    double meanFrameMs() const;
+    // p 取 0~100
+    double percentileFrameMs(double p) const;
+    double maxFrameMs() const;
+    // 相邻两帧开始之间的平均间隔，间隔超过 1 秒（画面静止）的不计
+    double meanIntervalMs() const;
+    double meanSectionMs(Section section) const;
+    // 帧时间中不属于任何一类图元的部分（视图自身、文字等逐个绘制的图元）
+    double meanOtherMs() const;
+
+    // 画面上的图元数量，按名称覆盖
+    void setCount(const QString& name, qint64 count);
+    const QMap<QString, qint64>& counts() const { return itemCounts; }
+
+    // 几行可读的摘要，供 HUD 显示
+    QString summary() const;
+    // 各项统计与最近各帧的耗时
+    QJsonObject toJson() const;
+    static bool writeJson(const QString& path, const QJsonObject& object, QString* errorMessage = nullptr);
+
+private:
+    struct Frame {
+        qint64 paintNs = 0;
+        qint64 intervalNs = -1;   // 第一帧或间隔过长时为 -1
+        qint64 sectionNs[SectionCount] = {};
+    };
+    const Frame& frameAt(int i) const { return frames[(head + i) % frames.size()]; }
+
+    QVector<Frame> frames;    // 满 kWindow 后循环覆盖，head 为最早的一帧
+    int head = 0;
+    Frame open;               // 正在绘制的一帧
+    bool inFrame = false;
+    QElapsedTimer frameClock;
+    QElapsedTimer lastBegin;  // 上一帧开始的时刻
+    qint64 totalFrames = 0;   // clear 之后的总帧数，包括已滚出窗口的
+    QMap<QString, qint64> itemCounts;
+};
+
+#endif // FRAMESTATS_H
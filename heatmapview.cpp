@@ -0,0 +1,361 @@
+// heatmapview.cpp
+#include "heatmapview.h"
+#include "counterstore.h"
+#include "scenebuilder.h"
+#include "topology.h"
+#include <QCheckBox>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QTimer>
+#include <QVBoxLayout>
+#include <QWheelEvent>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtMath>
+
+namespace {
+
+const int kMaxZoom = 6;           // 每格最大 64 像素
+const int kTileCacheSize = 256;   // 缓存的块数，每块 256 KB
+
+quint64 tileKey(int zoom, int tx, int ty) {
+    return (quint64(zoom + 64) << 48) | (quint64(ty) << 24) | quint64(tx);
+}
+
+struct TileJob {
+    int tx;
+    int ty;
+    QImage image;
+};
+
+} // namespace
+
+// ============== HeatmapView ==============
+HeatmapView::HeatmapView(QWidget* parent)
+    : QWidget(parent), m_palette(colorTable())
+{
+    m_tiles.setMaxCost(kTileCacheSize);
+    setMouseTracking(true);
+    setMinimumSize(200, 200);
+}
+
+QVector<quint32> HeatmapView::colorTable()
+{
+    // 浅黄 -> 橙 -> 深红，分两段线性插值
+    const QColor stops[] = {QColor(255, 255, 204), QColor(253, 141, 60), QColor(128, 0, 38)};
+    QVector<quint32> table(256);
+    table[0] = qRgb(255, 255, 255);
+    for (int level = 1; level < 256; ++level) {
+        const qreal t = (level - 1) / 254.0 * 2;
+        const int segment = qMin(1, int(t));
+        const qreal f = t - segment;
+        const QColor& a = stops[segment];
+        const QColor& b = stops[segment + 1];
+        table[level] = qRgb(qRound(a.red() + (b.red() - a.red()) * f),
+                            qRound(a.green() + (b.green() - a.green()) * f),
+                            qRound(a.blue() + (b.blue() - a.blue()) * f));
+    }
+    return table;
+}
+
+void HeatmapView::setMatrix(const TrafficMatrix* matrix)
+{
+    m_matrix = matrix;
+    m_fitPending = true;
+    matrixChanged();
+}
+
+void HeatmapView::matrixChanged()
+{
+    m_tiles.clear();
+    m_hovered = QPoint(-1, -1);
+    update();
+}
+
+int HeatmapView::extent() const
+{
+    const int ports = m_matrix ? m_matrix->size() : 0;
+    if (m_zoom >= 0)
+        return ports << m_zoom;
+    return (ports + (1 << -m_zoom) - 1) >> -m_zoom;
+}
+
+void HeatmapView::fitToView()
+{
+    if (!m_matrix || m_matrix->isEmpty() || width() <= 0 || height() <= 0)
+        return;
+    // 能整个放进窗口的最大一级
+    const int side = qMin(width(), height());
+    m_zoom = kMaxZoom;
+    while (m_zoom > -24 && extent() > side)
+        --m_zoom;
+    const int size = extent();
+    m_offset = -QPointF(width() - size, height() - size) / 2;
+    m_fitPending = false;
+    update();
+}
+
+void HeatmapView::setZoom(int zoom, const QPointF& anchor)
+{
+    // 最小缩放到矩阵约 64 像素见方
+    const int ports = m_matrix->size();
+    int minZoom = 0;
+    while (minZoom > -24 && (ports >> (1 - minZoom)) >= 64)
+        --minZoom;
+    zoom = qBound(minZoom, zoom, kMaxZoom);
+    if (zoom == m_zoom)
+        return;
+    // 光标下的位置缩放前后不动
+    const qreal factor = std::ldexp(1.0, zoom - m_zoom);
+    m_offset = (m_offset + anchor) * factor - anchor;
+    m_zoom = zoom;
+    update();
+    updateHover(anchor);
+}
+
+QPoint HeatmapView::cellAt(const QPointF& pos) const
+{
+    const QPointF p = pos + m_offset;
+    const int size = extent();
+    if (!m_matrix || p.x() < 0 || p.y() < 0 || p.x() >= size || p.y() >= size)
+        return QPoint(-1, -1);
+    // 缩小时一个像素代表多格，取其中第一格
+    const int x = int(p.x());
+    const int y = int(p.y());
+    const int last = m_matrix->size() - 1;
+    if (m_zoom >= 0)
+        return QPoint(qMin(last, x >> m_zoom), qMin(last, y >> m_zoom));
+    return QPoint(qMin(last, x << -m_zoom), qMin(last, y << -m_zoom));
+}
+
+void HeatmapView::updateHover(const QPointF& pos)
+{
+    const QPoint cell = cellAt(pos);
+    if (cell == m_hovered)
+        return;
+    m_hovered = cell;
+    if (cell.x() < 0)
+        emit cellHovered(-1, -1);
+    else
+        emit cellHovered(m_matrix->rowPort(cell.y()), m_matrix->columnPort(cell.x()));
+    if (m_zoom >= 2)
+        update();
+}
+
+void HeatmapView::paintEvent(QPaintEvent* event)
+{
+    Q_UNUSED(event);
+    QPainter painter(this);
+    painter.fillRect(rect(), QColor(230, 230, 230));
+    if (!m_matrix || m_matrix->isEmpty()) {
+        painter.drawText(rect(), Qt::AlignCenter, "没有端口流量数据");
+        return;
+    }
+    if (m_fitPending)
+        fitToView();
+
+    // 与窗口相交的块；没有缓存的在线程池上一起画
+    const int size = extent();
+    const int lastTile = (size - 1) / kTileSize;
+    const int tx0 = qMax(0, qFloor(m_offset.x() / kTileSize));
+    const int ty0 = qMax(0, qFloor(m_offset.y() / kTileSize));
+    const int tx1 = qMin(lastTile, qFloor((m_offset.x() + width() - 1) / kTileSize));
+    const int ty1 = qMin(lastTile, qFloor((m_offset.y() + height() - 1) / kTileSize));
+    QVector<TileJob> missing;
+    for (int ty = ty0; ty <= ty1; ++ty) {
+        for (int tx = tx0; tx <= tx1; ++tx) {
+            if (!m_tiles.contains(tileKey(m_zoom, tx, ty)))
+                missing.append({tx, ty, QImage()});
+        }
+    }
+    const TrafficMatrix* matrix = m_matrix;
+    const int zoom = m_zoom;
+    const quint32* palette = m_palette.constData();
+    QtConcurrent::blockingMap(missing, [=](TileJob& job) {
+        job.image = QImage(kTileSize, kTileSize, QImage::Format_RGB32);
+        matrix->render(reinterpret_cast<quint32*>(job.image.bits()), job.image.bytesPerLine(),
+                       job.tx * kTileSize, job.ty * kTileSize, kTileSize, kTileSize, zoom, palette);
+    });
+    for (const TileJob& job : missing)
+        m_tiles.insert(tileKey(m_zoom, job.tx, job.ty), new QImage(job.image));
+
+    painter.save();
+    painter.setClipRect(QRectF(-m_offset, QSizeF(size, size)));
+    for (int ty = ty0; ty <= ty1; ++ty) {
+        for (int tx = tx0; tx <= tx1; ++tx) {
+            if (const QImage* tile = m_tiles.object(tileKey(m_zoom, tx, ty)))
+                painter.drawImage(QPointF(tx * kTileSize, ty * kTileSize) - m_offset, *tile);
+        }
+    }
+    painter.restore();
+
+    // 放大到能看清单格时框出光标下的格子
+    if (m_hovered.x() >= 0 && m_zoom >= 2) {
+        const int cell = 1 << m_zoom;
+        painter.setPen(QPen(Qt::black, 1));
+        painter.setBrush(Qt::NoBrush);
+        painter.drawRect(QRectF(QPointF(m_hovered.x() * cell, m_hovered.y() * cell) - m_offset,
+                                QSizeF(cell, cell)));
+    }
+
+    // 右下角色标
+    const QRect bar(width() - 140, height() - 22, 128, 10);
+    for (int i = 0; i < bar.width(); ++i)
+        painter.fillRect(QRect(bar.left() + i, bar.top(), 1, bar.height()),
+                         QColor::fromRgb(m_palette[1 + i * 254 / (bar.width() - 1)]));
+    painter.setPen(Qt::black);
+    painter.drawRect(bar.adjusted(0, 0, -1, -1));
+    painter.drawText(QRect(bar.left() - 60, bar.top() - 3, 56, 16), Qt::AlignRight | Qt::AlignVCenter, "1");
+    painter.drawText(QRect(bar.left(), bar.top() - 16, bar.width(), 14), Qt::AlignRight | Qt::AlignVCenter,
+                     QString::number(m_matrix->maxValue(), 'g', 6));
+}
+
+void HeatmapView::wheelEvent(QWheelEvent* event)
+{
+    if (!m_matrix || m_matrix->isEmpty() || event->angleDelta().y() == 0)
+        return;
+    setZoom(m_zoom + (event->angleDelta().y() > 0 ? 1 : -1), event->position());
+    event->accept();
+}
+
+void HeatmapView::mousePressEvent(QMouseEvent* event)
+{
+    if (event->button() != Qt::LeftButton)
+        return;
+    m_dragging = true;
+    m_dragStart = event->position();
+    m_dragOffset = m_offset;
+    setCursor(Qt::ClosedHandCursor);
+}
+
+void HeatmapView::mouseMoveEvent(QMouseEvent* event)
+{
+    if (m_dragging) {
+        m_offset = m_dragOffset - (event->position() - m_dragStart);
+        update();
+    }
+    if (m_matrix && !m_matrix->isEmpty())
+        updateHover(event->position());
+}
+
+void HeatmapView::mouseReleaseEvent(QMouseEvent* event)
+{
+    if (event->button() != Qt::LeftButton)
+        return;
+    m_dragging = false;
+    unsetCursor();
+}
+
+void HeatmapView::mouseDoubleClickEvent(QMouseEvent* event)
+{
+    Q_UNUSED(event);
+    fitToView();
+}
+
+void HeatmapView::leaveEvent(QEvent* event)
+{
+    Q_UNUSED(event);
+    if (m_hovered.x() >= 0) {
+        m_hovered = QPoint(-1, -1);
+        emit cellHovered(-1, -1);
+        update();
+    }
+}
+
+// ============== HeatmapDock ==============
+HeatmapDock::HeatmapDock(QWidget* parent)
+    : QDockWidget("端口流量矩阵", parent)
+{
+    setObjectName("heatmapDock");
+    QWidget* body = new QWidget(this);
+    QVBoxLayout* layout = new QVBoxLayout(body);
+    layout->setContentsMargins(4, 4, 4, 4);
+    QHBoxLayout* bar = new QHBoxLayout();
+    m_sortBox = new QCheckBox("按总流量排序", body);
+    m_readout = new QLabel(body);
+    m_readout->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    bar->addWidget(m_sortBox);
+    bar->addWidget(m_readout, 1);
+    layout->addLayout(bar);
+    m_view = new HeatmapView(body);
+    m_view->setMatrix(&m_matrix);
+    layout->addWidget(m_view, 1);
+    setWidget(body);
+
+    m_rebuildTimer = new QTimer(this);
+    m_rebuildTimer->setSingleShot(true);
+    m_rebuildTimer->setInterval(500);
+    connect(m_rebuildTimer, &QTimer::timeout, this, [this]() {
+        if (isVisible())
+            rebuild();
+        else
+            m_stale = true;
+    });
+    connect(this, &QDockWidget::visibilityChanged, this, [this](bool visible) {
+        if (visible && m_stale)
+            rebuild();
+    });
+    connect(m_sortBox, &QCheckBox::toggled, this, [this](bool sort) {
+        m_matrix.setSortByTotal(sort);
+        m_view->matrixChanged();
+    });
+    connect(m_view, &HeatmapView::cellHovered, this, &HeatmapDock::showCell);
+    showCell(-1, -1);
+}
+
+void HeatmapDock::setRun(const Topology* topology, const StatsView* view)
+{
+    m_topology = topology;
+    m_statsView = view;
+    m_rebuildTimer->stop();
+    m_stale = true;
+    // 换了运行，重新适配窗口
+    m_view->setMatrix(&m_matrix);
+    if (isVisible())
+        rebuild();
+}
+
+void HeatmapDock::statsChanged()
+{
+    m_rebuildTimer->start();
+}
+
+void HeatmapDock::rebuild()
+{
+    m_stale = false;
+    const int portCount = m_topology ? int(m_topology->nodeOfPort.size()) : 0;
+    const int before = m_matrix.size();
+    if (!m_statsView || !m_statsView->store || !m_matrix.build(*m_statsView->store, portCount))
+        m_matrix.clear();
+    if (m_matrix.size() != before)
+        m_view->setMatrix(&m_matrix);
+    else
+        m_view->matrixChanged();
+    showCell(-1, -1);
+}
+
+QString HeatmapDock::portName(int port) const
+{
+    const int module = m_topology ? m_topology->moduleOfPort.value(port, -1) : -1;
+    if (module < 0)
+        return QString("端口%1").arg(port);
+    return QString("端口%1 (%2)").arg(port).arg(QString::fromUtf8(m_topology->modules[module].name));
+}
+
+void HeatmapDock::showCell(int fromPort, int toPort)
+{
+    if (fromPort < 0 || toPort < 0) {
+        m_readout->setText(m_matrix.isEmpty()
+                               ? QString()
+                               : QString("%1 个端口，%2 对有流量，单格最多 %3 个包")
+                                     .arg(m_matrix.size()).arg(m_matrix.nonZeroCount())
+                                     .arg(m_matrix.maxValue(), 0, 'g', 10));
+        return;
+    }
+    m_readout->setText(QString("%1 → %2: %3 个包（发出合计 %4，收到合计 %5）")
+                           .arg(portName(fromPort), portName(toPort))
+                           .arg(m_matrix.value(fromPort, toPort), 0, 'g', 10)
+                           .arg(m_matrix.rowTotal(fromPort), 0, 'g', 10)
+                           .arg(m_matrix.columnTotal(toPort), 0, 'g', 10));
+}
@@ -0,0 +1,93 @@
+// heatmapview.h
+#ifndef HEATMAPVIEW_H
+#define HEATMAPVIEW_H
+#include <QCache>
+#include <QDockWidget>
+#include <QImage>
+#include <QVector>
+#include <QWidget>
+#include "trafficmatrix.h"
+
+class Topology;
+class StatsView;
+class QCheckBox;
+class QLabel;
+class QTimer;
+
+// 流量矩阵热力图：整张矩阵画成若干 256×256 的 QImage 块，不为每格建图元
+// 缩放按 2 的幂分级，每级的块画好后缓存，平移时只补画新露出的块；缺的块在线程池上并行画。
+// 滚轮缩放（以光标为中心），左键拖动平移，双击适配窗口。
+class HeatmapView : public QWidget {
+    Q_OBJECT
+public:
+    explicit HeatmapView(QWidget* parent = nullptr);
+
+    // matrix 由调用方持有；内容或顺序变化后调用 matrixChanged
+    void setMatrix(const TrafficMatrix* matrix);
+    void matrixChanged();
+    void fitToView();
+
+    // 色阶 0 为白色（没有流量），1-255 由浅黄到深红
+    static QVector<quint32> colorTable();
+
+signals:
+    // 光标下的格子（端口号），移出矩阵时为 -1
+    void cellHovered(int fromPort, int toPort);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void wheelEvent(QWheelEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
+    void mouseDoubleClickEvent(QMouseEvent* event) override;
+    void leaveEvent(QEvent* event) override;
+
+private:
+    static const int kTileSize = 256;
+
+    int extent() const;                       // 当前缩放下矩阵的边长（像素）
+    QPoint cellAt(const QPointF& pos) const;  // 显示行列，矩阵外为 (-1, -1)
+    void setZoom(int zoom, const QPointF& anchor);
+    void updateHover(const QPointF& pos);
+
+    const TrafficMatrix* m_matrix = nullptr;
+    QVector<quint32> m_palette;
+    int m_zoom = 0;               // >= 0 每格 2^zoom 像素，< 0 每像素 2^-zoom 格
+    QPointF m_offset;             // 窗口左上角在当前缩放下的像素坐标
+    QCache<quint64, QImage> m_tiles;
+    bool m_fitPending = true;
+    bool m_dragging = false;
+    QPointF m_dragStart;
+    QPointF m_dragOffset;
+    QPoint m_hovered = QPoint(-1, -1);
+};
+
+// 停靠窗：热力图、排序开关与悬停读数
+// 统计数据变化时只在可见时重新取矩阵，隐藏期间的变化等显示时一并处理
+class HeatmapDock : public QDockWidget {
+    Q_OBJECT
+public:
+    explicit HeatmapDock(QWidget* parent = nullptr);
+
+    // topology 与 view 由调用方持有，须在停靠窗存活期间有效；矩阵取自 view 当前的存储，即所显示的 epoch
+    void setRun(const Topology* topology, const StatsView* view);
+    // 显示的统计有新增或变化的行，或切换了 epoch
+    void statsChanged();
+
+private:
+    void rebuild();
+    void showCell(int fromPort, int toPort);
+    QString portName(int port) const;
+
+    const Topology* m_topology = nullptr;
+    const StatsView* m_statsView = nullptr;
+    TrafficMatrix m_matrix;
+    bool m_stale = false;
+    HeatmapView* m_view;
+    QCheckBox* m_sortBox;
+    QLabel* m_readout;
+    QTimer* m_rebuildTimer;       // 实时跟踪时合并连续的更新
+};
+
+#endif // HEATMAPVIEW_H
@@ -0,0 +1,103 @@
+// highlightlayer.cpp
+#include "highlightlayer.h"
+#include "edgelayer.h"
+#include "moduleitem.h"
+#include "framestats.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+namespace {
+const QColor kVeilColor(255, 255, 255, 190);      // 未命中部分蒙上的一层
+const QColor kHighlightColor(255, 140, 0);        // 命中的描边
+const qreal kOutlinePixels = 3;                   // 描边在屏幕上的宽度，与缩放无关
+}
+
+HighlightLayer::HighlightLayer(QGraphicsItem* parent)
+    : QGraphicsItem(parent)
+{
+    // 只蒙露出的部分；不接收任何鼠标事件
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+    setAcceptedMouseButtons(Qt::NoButton);
+    setAcceptHoverEvents(false);
+}
+
+void HighlightLayer::setBounds(const QRectF& bounds) {
+    prepareGeometryChange();
+    this->bounds = bounds;
+}
+
+void HighlightLayer::setTargets(const QVector<ModuleItem*>& modules, const EdgeLayer* layer,
+                                const QVector<int>& links) {
+    this->modules = modules;
+    this->layer = layer;
+    this->links = links;
+    update();
+}
+
+void HighlightLayer::clear() {
+    modules.clear();
+    layer = nullptr;
+    links.clear();
+    update();
+}
+
+QRectF HighlightLayer::boundingRect() const {
+    return bounds;
+}
+
+QPainterPath HighlightLayer::shape() const {
+    return QPainterPath();
+}
+
+bool HighlightLayer::contains(const QPointF&) const {
+    return false;
+}
+
+void HighlightLayer::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) {
+    FrameStats::Timer timer(FrameStats::Highlight);
+    const QRectF exposed = option->exposedRect & bounds;
+    painter->fillRect(exposed, kVeilColor);
+
+    // 命中的连线：先一次画出描边，再按各自原来的画笔重画
+    if (layer) {
+        const qreal lod = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+        const qreal margin = kOutlinePixels / qMax<qreal>(lod, 1e-6);
+        // 水平、竖直的连线外框为空矩形，先按描边宽度放大再判断相交
+        auto isVisible = [&](const QLineF& line) {
+            return QRectF(line.p1(), line.p2()).normalized()
+                .adjusted(-margin, -margin, margin, margin).intersects(exposed);
+        };
+        lines.clear();
+        for (const int link : links) {
+            const QLineF line = layer->line(link);
+            if (isVisible(line))
+                lines.append(line);
+        }
+        QPen outline(kHighlightColor, 2 * kOutlinePixels, Qt::SolidLine, Qt::RoundCap);
+        outline.setCosmetic(true);
+        painter->setPen(outline);
+        painter->drawLines(lines.constData(), int(lines.size()));
+        for (const int link : links) {
+            const QLineF line = layer->line(link);
+            if (isVisible(line)) {
+                painter->setPen(layer->stylePen(layer->style(link)));
+                painter->drawLine(line);
+            }
+        }
+    }
+
+    // 命中的模块：原样重画（主体、端口与名称），再描边
+    QPen outline(kHighlightColor, kOutlinePixels);
+    outline.setCosmetic(true);
+    for (ModuleItem* module : modules) {
+        if (!module->sceneBoundingRect().intersects(exposed))
+            continue;
+        painter->save();
+        painter->setTransform(module->sceneTransform(), true);
+        module->paint(painter, option, widget);
+        painter->setPen(outline);
+        painter->setBrush(Qt::NoBrush);
+        painter->drawRect(module->rect());
+        painter->restore();
+    }
+}
@@ -0,0 +1,43 @@
+// highlightlayer.h
+#ifndef HIGHLIGHTLAYER_H
+#define HIGHLIGHTLAYER_H
+#include <QGraphicsItem>
+#include <QLineF>
+#include <QVector>
+
+class ModuleItem;
+class EdgeLayer;
+
+// 搜索结果的突出显示，整个场景只有这一个图元，压在其他图元上面：
+// 先在露出的范围内蒙一层半透明的白色，其余图元都因此变淡；再把命中的连线一次 drawLines 描边后按原样式重画，
+// 命中的模块原样重画一遍并描边。绘制代价与命中的数量相关，不遍历场景中的其他图元。
+// 模块与连线的位置在绘制时现取，拖动模块后不需要重新设置。
+class HighlightLayer : public QGraphicsItem {
+public:
+    explicit HighlightLayer(QGraphicsItem* parent = nullptr);
+
+    // 场景的范围，蒙层只画在其中
+    void setBounds(const QRectF& bounds);
+    // layer 为 links 所在的连线图层，由场景持有
+    void setTargets(const QVector<ModuleItem*>& modules, const EdgeLayer* layer,
+                    const QVector<int>& links);
+    void clear();
+    int moduleCount() const { return int(modules.size()); }
+    int linkCount() const { return int(links.size()); }
+
+    QRectF boundingRect() const override;
+    // 形状为空：不挡住下面图元的悬停与点击，视图的 itemAt 也不会取到它
+    QPainterPath shape() const override;
+    bool contains(const QPointF& point) const override;
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option,
+               QWidget* widget = nullptr) override;
+
+private:
+    QVector<ModuleItem*> modules;
+    const EdgeLayer* layer = nullptr;
+    QVector<int> links;
+    QVector<QLineF> lines;       // 绘制时重用
+    QRectF bounds;
+};
+
+#endif // HIGHLIGHTLAYER_H
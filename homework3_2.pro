@@ -1,30 +1,55 @@
-QT       += core gui
-
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
-
-CONFIG += c++17
-
-# You can make your code fail to compile if it uses deprecated APIs.
-# In order to do so, uncomment the following line.
-#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
-
-SOURCES += \
-    connectionitem.cpp \
-    main.cpp \
-    mainwindow.cpp \
-    moduleitem.cpp \
-    scenewidget.cpp
-
-HEADERS += \
-    connectionitem.h \
-    mainwindow.h \
-    moduleitem.h \
-    scenewidget.h
-
-FORMS += \
-    mainwindow.ui
-
-# Default rules for deployment.
-qnx: target.path = /tmp/$${TARGET}/bin
-else: unix:!android: target.path = /opt/$${TARGET}/bin
-!isEmpty(target.path): INSTALLS += target
+QT       += core gui
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+# 无窗口批量出图写 SVG
+QT += svg
+
+CONFIG += c++17
+
+# You can make your code fail to compile if it uses deprecated APIs.
+# In order to do so, uncomment the following line.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+SOURCES += \
+    batchrenderer.cpp \
+    edgelayer.cpp \
+    heatmapview.cpp \
+    highlightlayer.cpp \
+    inspectorpanel.cpp \
+    latencybars.cpp \
+    main.cpp \
+    mainwindow.cpp \
+    moduleitem.cpp \
+    packetlayer.cpp \
+    scenebuilder.cpp \
+    scenewidget.cpp \
+    searchbar.cpp \
+    sweepview.cpp \
+    tilecache.cpp
+
+HEADERS += \
+    batchrenderer.h \
+    edgelayer.h \
+    heatmapview.h \
+    highlightlayer.h \
+    inspectorpanel.h \
+    latencybars.h \
+    mainwindow.h \
+    moduleitem.h \
+    packetlayer.h \
+    scenebuilder.h \
+    scenewidget.h \
+    searchbar.h \
+    sweepview.h \
+    tilecache.h
+
+FORMS += \
+    mainwindow.ui
+
+include(core.pri)
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
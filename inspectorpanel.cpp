@@ -0,0 +1,413 @@
+// inspectorpanel.cpp
+#include "inspectorpanel.h"
+#include "counterstore.h"
+#include "runcomparison.h"
+#include "topology.h"
+#include <QColor>
+#include <QFont>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QTableView>
+#include <QToolButton>
+#include <QVBoxLayout>
+#include <QtMath>
+
+// ============== InspectorModel ==============
+InspectorModel::InspectorModel(QObject* parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+void InspectorModel::setRun(const Topology* topology, const StatsView* view)
+{
+    beginResetModel();
+    m_topology = topology;
+    m_view = view;
+    m_comparison = nullptr;
+    m_target = SceneTarget();
+    m_storeModule = -1;
+    m_counterSection = -1;
+    m_entries.clear();
+    m_texts.clear();
+    m_rows.clear();
+    m_scannedRows = 0;
+    endResetModel();
+}
+
+void InspectorModel::setComparison(const RunComparison* comparison)
+{
+    // 列数变了，表格整体重置；选中对象和已扫描的行不变
+    beginResetModel();
+    m_comparison = m_view ? comparison : nullptr;
+    endResetModel();
+}
+
+void InspectorModel::inspect(const SceneTarget& target)
+{
+    beginResetModel();
+    m_target = m_topology ? target : SceneTarget();
+    m_storeModule = -1;
+    m_counterSection = -1;
+    m_entries.clear();
+    m_texts.clear();
+    m_rows.clear();
+    m_scannedRows = 0;
+    describe();
+    if (m_target.kind != SceneTarget::None && m_view && m_view->isValid())
+        scanRows(m_view->indexedRowCount());
+    endResetModel();
+}
+
+bool InspectorModel::canInspectBus() const
+{
+    return m_topology && m_topology->busModule >= 0 && m_view && m_view->isValid();
+}
+
+void InspectorModel::inspectBus()
+{
+    if (canInspectBus())
+        inspect({SceneTarget::Module, m_topology->busModule});
+}
+
+QString InspectorModel::title() const
+{
+    switch (m_target.kind) {
+    case SceneTarget::Module:
+        return QString::fromLatin1(m_topology->modules[m_target.index].name);
+    case SceneTarget::L1:
+        return QString("L1%1").arg(m_topology->modules[m_target.index].index);
+    case SceneTarget::Router:
+        return QString("Router%1").arg(m_target.index);
+    default:
+        return QString("点击场景中的模块查看详情");
+    }
+}
+
+void InspectorModel::statsChanged()
+{
+    if (m_target.kind == SceneTarget::None || !m_view || !m_view->isValid())
+        return;
+    const int before = rowCount();
+    const int rows = m_view->indexedRowCount();
+    if (rows > m_scannedRows) {
+        // 先数出新增的行，再按 beginInsertRows 要求的顺序插入
+        const int kept = int(m_rows.size());
+        scanRows(rows);
+        const int added = int(m_rows.size()) - kept;
+        if (added > 0) {
+            QVector<qint32> fresh = m_rows.mid(kept);
+            m_rows.resize(kept);
+            beginInsertRows(QModelIndex(), before, before + added - 1);
+            m_rows += fresh;
+            endInsertRows();
+        }
+    }
+    if (before > 0)
+        emit dataChanged(index(0, ValueColumn), index(before - 1, columnCount() - 1),
+                         {Qt::DisplayRole, Qt::ForegroundRole});
+}
+
+void InspectorModel::addSection(const QString& title)
+{
+    m_entries.append({Section, qint32(m_texts.size())});
+    m_texts.append({title, QString()});
+}
+
+void InspectorModel::addText(const QString& name, const QString& value)
+{
+    m_entries.append({Text, qint32(m_texts.size())});
+    m_texts.append({name, value});
+}
+
+// 表头部分与原来详情对话框中的说明一致，只有几十行，选中时一次生成
+void InspectorModel::describe()
+{
+    const Topology& t = *m_topology;
+    const bool hasStats = m_view && m_view->isValid();
+    switch (m_target.kind) {
+    case SceneTarget::Module: {
+        const int m = m_target.index;
+        const TopologyModule& mod = t.modules[m];
+        m_storeModule = hasStats ? m_view->storeModule.value(m, -1) : -1;
+        addSection(QString("%1 详细信息").arg(QString::fromLatin1(mod.name)));
+        addText("时钟", QString("@%1tick").arg(mod.tick));
+        if (mod.portId >= 0)
+            addText("总线端口", QString("%1 (节点%2)").arg(mod.portId).arg(t.nodeOfModule(m)));
+        if (mod.paramCount > 0) {
+            addSection("配置参数");
+            for (int i = mod.paramBegin; i < mod.paramBegin + mod.paramCount; ++i)
+                m_entries.append({Param, i});
+        }
+        if (m_storeModule >= 0) {
+            bool any = false;
+            for (int i = 0; i < m_view->metrics.metricCount(); ++i) {
+                if (qIsNaN(m_view->metrics.value(i, m_storeModule)))
+                    continue;
+                if (!any)
+                    addSection("派生指标");
+                any = true;
+                m_entries.append({Metric, i});
+            }
+        }
+        break;
+    }
+    case SceneTarget::L1: {
+        const int l2 = m_target.index;
+        m_storeModule = hasStats ? m_view->storeModule.value(l2, -1) : -1;
+        addSection(QString("L1%1 缓存").arg(t.modules[l2].index));
+        addText("类型", "一级缓存 (核心私有)");
+        addText("L1i", QString("%1路 x %2组").arg(t.param(l2, "l1i_way_count"))
+                                               .arg(t.param(l2, "l1i_set_count")));
+        addText("L1d", QString("%1路 x %2组").arg(t.param(l2, "l1d_way_count"))
+                                               .arg(t.param(l2, "l1d_set_count")));
+        if (m_storeModule >= 0) {
+            bool any = false;
+            for (const int i : {int(DerivedMetrics::L1iHitRate), int(DerivedMetrics::L1dHitRate)}) {
+                if (qIsNaN(m_view->metrics.value(i, m_storeModule)))
+                    continue;
+                if (!any)
+                    addSection("派生指标");
+                any = true;
+                m_entries.append({Metric, i});
+            }
+        }
+        return;   // L1 的计数器记在所属的 L2Cache 下
+    }
+    case SceneTarget::Router: {
+        const int node = m_target.index;
+        addSection(QString("Router%1 详细信息").arg(node));
+        QString out, in;
+        for (const BusEdge& e : t.edges) {
+            if (e.from == node) out += QString(" %1").arg(e.to);
+            if (e.to == node) in += QString(" %1").arg(e.from);
+        }
+        addText("出边", out.isEmpty() ? QString("无") : out.trimmed());
+        addText("入边", in.isEmpty() ? QString("无") : in.trimmed());
+        bool any = false;
+        for (int p = 0; p < t.nodeOfPort.size(); ++p) {
+            if (t.nodeOfPort[p] != node)
+                continue;
+            if (!any)
+                addSection("端口映射");
+            any = true;
+            const int m = t.moduleOfPort.value(p, -1);
+            addText(QString("Port%1").arg(p),
+                    m >= 0 ? QString::fromLatin1(t.modules[m].name) : QString("未连接"));
+        }
+        break;
+    }
+    default:
+        return;
+    }
+    if (hasStats) {
+        m_counterSection = int(m_entries.size());
+        addSection("统计数据");
+    }
+}
+
+// 模块：该模块的全部计数器；路由器：总线上本节点的 node_X_* 与出边计数器，
+// 以及从本节点端口发出的流量。都取自 StatsView 按模块/节点归好的行，不逐行扫描
+void InspectorModel::scanRows(int end)
+{
+    if (m_target.kind == SceneTarget::Module)
+        m_rows += m_view->moduleRowsIn(m_storeModule, m_scannedRows, end);
+    else if (m_target.kind == SceneTarget::Router)
+        m_rows += m_view->routerRowsIn(*m_topology, m_target.index, m_scannedRows, end);
+    m_scannedRows = end;
+}
+
+int InspectorModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : int(m_entries.size() + m_rows.size());
+}
+
+int InspectorModel::columnCount(const QModelIndex& parent) const
+{
+    if (parent.isValid())
+        return 0;
+    return m_comparison ? ChangeColumn + 1 : ValueColumn + 1;
+}
+
+// 对比的两列：只有派生指标和计数器行有值，变化一列增加为深红、减少为深蓝
+QVariant InspectorModel::compareData(int row, int column, int role) const
+{
+    if (role != Qt::DisplayRole && role != Qt::ForegroundRole)
+        return QVariant();
+    double before = qQNaN();
+    double after = qQNaN();
+    QString afterText("-");
+    if (row >= m_entries.size()) {
+        const CounterStore& store = *m_view->store;
+        const int r = m_rows[row - m_entries.size()];
+        if (r >= store.rowCount())
+            return QVariant();
+        before = store.values[r];
+        after = m_comparison->otherValue(r);
+        if (!qIsNaN(after))
+            afterText = SceneBuilder::formatValue(m_comparison->aligned, r);
+    } else if (m_entries[row].kind == Metric) {
+        const int metric = m_entries[row].index;
+        before = m_view->metrics.value(metric, m_storeModule);
+        after = m_comparison->metrics.value(metric, m_storeModule);
+        if (!qIsNaN(after))
+            afterText = m_view->metricText(metric, after);
+    } else {
+        return QVariant();
+    }
+    const double change = RunComparison::relativeChange(before, after);
+    if (role == Qt::ForegroundRole) {
+        if (column != ChangeColumn || qIsNaN(change) || change == 0)
+            return QVariant();
+        return change > 0 ? QColor(Qt::darkRed) : QColor(Qt::darkBlue);
+    }
+    return column == OtherColumn ? afterText : SceneBuilder::changeText(change);
+}
+
+QVariant InspectorModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid())
+        return QVariant();
+    const int row = index.row();
+    if (index.column() >= OtherColumn)
+        return compareData(row, index.column(), role);
+    const bool name = index.column() == NameColumn;
+    if (row >= m_entries.size()) {
+        if (role != Qt::DisplayRole)
+            return QVariant();
+        const CounterStore& store = *m_view->store;
+        const int r = m_rows[row - m_entries.size()];
+        if (r >= store.rowCount())
+            return QVariant();
+        return name ? QString::fromLatin1(store.counterName(r)) : SceneBuilder::formatValue(store, r);
+    }
+
+    const Entry& entry = m_entries[row];
+    if (entry.kind == Section) {
+        if (role == Qt::FontRole) {
+            QFont font;
+            font.setBold(true);
+            return font;
+        }
+        if (role == Qt::BackgroundRole)
+            return QColor(240, 240, 240);
+    }
+    if (role != Qt::DisplayRole)
+        return QVariant();
+    switch (entry.kind) {
+    case Section:
+        if (!name)
+            return QVariant();
+        // 计数器一节的标题带上行数，随追加的行变化
+        if (row == m_counterSection)
+            return QString("统计数据 (%1项)").arg(m_rows.size());
+        return m_texts[entry.index].first;
+    case Text:
+        return name ? m_texts[entry.index].first : m_texts[entry.index].second;
+    case Param: {
+        const TopologyParam& param = m_topology->params[entry.index];
+        if (name)
+            return QString::fromLatin1(m_topology->paramKeys[param.key]);
+        return QString::number(param.value);
+    }
+    case Metric: {
+        if (name)
+            return m_view->metrics.label(entry.index);
+        const double v = m_view->metrics.value(entry.index, m_storeModule);
+        return qIsNaN(v) ? QString("-") : m_view->metricText(entry.index, v);
+    }
+    }
+    return QVariant();
+}
+
+QVariant InspectorModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QVariant();
+    switch (section) {
+    case NameColumn: return QString("名称");
+    case ValueColumn: return QString("值");
+    case OtherColumn: return QString("对比值");
+    default: return QString("变化");
+    }
+}
+
+// ============== InspectorDock ==============
+InspectorDock::InspectorDock(QWidget* parent)
+    : QDockWidget("模块详情", parent)
+{
+    setObjectName("inspectorDock");
+    QWidget* body = new QWidget(this);
+    QVBoxLayout* layout = new QVBoxLayout(body);
+    layout->setContentsMargins(4, 4, 4, 4);
+    QHBoxLayout* bar = new QHBoxLayout();
+    m_title = new QLabel(body);
+    QFont titleFont = m_title->font();
+    titleFont.setBold(true);
+    m_title->setFont(titleFont);
+    m_busButton = new QToolButton(body);
+    m_busButton->setText("总线");
+    m_busButton->setToolTip("查看总线的全部计数器（流量矩阵、连线使用率等）");
+    m_busButton->setEnabled(false);
+    bar->addWidget(m_title, 1);
+    bar->addWidget(m_busButton);
+    layout->addLayout(bar);
+
+    // 行高固定：QTableView 只按可见区域取数据，不会为了量行高去读每一行
+    m_model = new InspectorModel(this);
+    m_table = new QTableView(body);
+    m_table->setModel(m_model);
+    m_table->setWordWrap(false);
+    m_table->setShowGrid(false);
+    m_table->setAlternatingRowColors(true);
+    m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->verticalHeader()->hide();
+    m_table->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    m_table->verticalHeader()->setDefaultSectionSize(m_table->fontMetrics().height() + 6);
+    m_table->horizontalHeader()->setStretchLastSection(true);
+    m_table->setColumnWidth(InspectorModel::NameColumn, 240);
+    layout->addWidget(m_table, 1);
+    setWidget(body);
+
+    connect(m_busButton, &QToolButton::clicked, this, [this]() {
+        m_model->inspectBus();
+        m_table->scrollToTop();
+        updateTitle();
+    });
+    updateTitle();
+}
+
+void InspectorDock::setRun(const Topology* topology, const StatsView* view)
+{
+    m_model->setRun(topology, view);
+    m_busButton->setEnabled(m_model->canInspectBus());
+    updateTitle();
+}
+
+void InspectorDock::setComparison(const RunComparison* comparison)
+{
+    m_model->setComparison(comparison);
+}
+
+void InspectorDock::inspect(const SceneTarget& target)
+{
+    if (target.kind == SceneTarget::None)
+        return;
+    m_model->inspect(target);
+    m_table->scrollToTop();
+    updateTitle();
+    show();
+    raise();
+}
+
+void InspectorDock::statsChanged()
+{
+    m_model->statsChanged();
+    m_busButton->setEnabled(m_model->canInspectBus());
+}
+
+void InspectorDock::updateTitle()
+{
+    m_title->setText(m_model->title());
+}
@@ -0,0 +1,93 @@
+// inspectorpanel.h
+#ifndef INSPECTORPANEL_H
+#define INSPECTORPANEL_H
+#include <QAbstractTableModel>
+#include <QDockWidget>
+#include <QPair>
+#include <QStringList>
+#include <QVector>
+#include "scenebuilder.h"
+
+class Topology;
+class RunComparison;
+class QLabel;
+class QTableView;
+class QToolButton;
+
+// 检查面板的表格模型：选中对象的配置参数、派生指标和计数器，每行一项
+// 只记下各行取自哪里（参数下标、指标ID、CounterStore 行号），文字在视图要画这一行时才生成，
+// 因此带着整张流量矩阵的总线（上百万行）也能立即打开，滚动时只格式化可见的几十行。
+// 有对比运行时多出“对比值”和“变化”两列，指标与计数器行按同一行号取对比运行的值。
+class InspectorModel : public QAbstractTableModel {
+    Q_OBJECT
+public:
+    enum Column { NameColumn, ValueColumn, OtherColumn, ChangeColumn };
+
+    explicit InspectorModel(QObject* parent = nullptr);
+
+    // topology 与 view 由调用方持有；换了运行后重新设置，原来的选中对象随之清除
+    void setRun(const Topology* topology, const StatsView* view);
+    // comparison 对齐在 view 的统计数据上，由调用方持有；为空时去掉对比的两列
+    void setComparison(const RunComparison* comparison);
+    void inspect(const SceneTarget& target);
+    // 查看总线模块本身（流量矩阵、连线使用率等全部总线计数器）
+    bool canInspectBus() const;
+    void inspectBus();
+    const SceneTarget& target() const { return m_target; }
+    QString title() const;
+
+    // 统计数据的值变化或追加了行（含切换 epoch）：值一列整体通知重画，新增的行接在末尾
+    void statsChanged();
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+private:
+    enum EntryKind : quint8 { Section, Text, Param, Metric };
+    struct Entry {
+        EntryKind kind;
+        qint32 index;   // Section/Text 为 m_texts 下标，Param 为 Topology::params 下标，Metric 为指标ID
+    };
+
+    void describe();
+    void addSection(const QString& title);
+    void addText(const QString& name, const QString& value);
+    void scanRows(int end);
+    QVariant compareData(int row, int column, int role) const;
+
+    const Topology* m_topology = nullptr;
+    const StatsView* m_view = nullptr;
+    const RunComparison* m_comparison = nullptr;
+    SceneTarget m_target;
+    int m_storeModule = -1;         // 参数与指标所属的 CounterStore 模块
+    int m_counterSection = -1;      // “统计数据”一节标题所在的行
+    QVector<Entry> m_entries;       // 表头部分：说明、参数与指标
+    QVector<QPair<QString, QString>> m_texts;
+    QVector<qint32> m_rows;         // 其后每行一个计数器，CounterStore 行号
+    int m_scannedRows = 0;          // 已检查过的 CounterStore 行数
+};
+
+// 停靠窗：标题、表格与“总线”按钮，点击场景中的模块时显示该模块
+class InspectorDock : public QDockWidget {
+    Q_OBJECT
+public:
+    explicit InspectorDock(QWidget* parent = nullptr);
+
+    void setRun(const Topology* topology, const StatsView* view);
+    void setComparison(const RunComparison* comparison);
+    void inspect(const SceneTarget& target);
+    void statsChanged();
+
+private:
+    void updateTitle();
+
+    InspectorModel* m_model;
+    QLabel* m_title;
+    QTableView* m_table;
+    QToolButton* m_busButton;
+};
+
+#endif // INSPECTORPANEL_H
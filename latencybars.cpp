@@ -0,0 +1,147 @@
+// latencybars.cpp
+#include "latencybars.h"
+#include "framestats.h"
+#include <QFont>
+#include <QPainter>
+#include <QStringList>
+
+namespace {
+const qreal kRowHeight = 12;
+const qreal kBarHeight = 9;
+const qreal kLabelWidth = 44;     // 行首事件类名称
+const qreal kValueWidth = 40;     // 条尾的合计周期
+const qreal kTitleHeight = 18;
+const qreal kLegendRow = 13;
+
+QFont smallFont() {
+    QFont font;
+    font.setPointSizeF(7);
+    return font;
+}
+}
+
+LatencyBars::LatencyBars(QGraphicsItem* parent)
+    : QGraphicsItem(parent)
+{
+}
+
+QColor LatencyBars::hopColor(int hop) {
+    // 去程偏暖、回程偏冷，经过内存的两段最深
+    static const QColor colors[CacheTrace::HopCount] = {
+        QColor(255, 215, 0),    // L1→L2
+        QColor(30, 144, 255),   // L2→L1
+        QColor(255, 165, 79),   // L2→其他L1
+        QColor(135, 206, 250),  // 其他L1→L1
+        QColor(154, 205, 50),   // L2→L3
+        QColor(46, 139, 87),    // L3→L2
+        QColor(186, 85, 211),   // L3→其他L2
+        QColor(106, 90, 205),   // 其他L2→L2
+        QColor(255, 99, 71),    // L3→内存
+        QColor(178, 34, 34),    // 内存→L2
+    };
+    return hop >= 0 && hop < CacheTrace::HopCount ? colors[hop] : QColor(Qt::gray);
+}
+
+double LatencyBars::maxTotalTicks(const LatencyHistograms& h, LatencyHistograms::Scope scope,
+                                  int owner) {
+    double result = 0;
+    for (int c = 0; c < CacheTrace::EventClassCount; ++c) {
+        double total = 0;
+        for (int i = 0; i < CacheTrace::hopCount(c); ++i)
+            total += h.meanTicks(scope, owner, c, i);
+        result = qMax(result, total);
+    }
+    return result;
+}
+
+void LatencyBars::setData(const LatencyHistograms* h, LatencyHistograms::Scope scope, int owner,
+                          qreal pxPerTick) {
+    prepareGeometryChange();
+    rows.clear();
+    this->pxPerTick = pxPerTick;
+    QStringList tip;
+    if (h && owner < h->owners(scope)) {
+        for (int c = 0; c < CacheTrace::EventClassCount; ++c) {
+            Row row = {c, h->count(scope, owner, c), {}};
+            if (row.count == 0)
+                continue;
+            tip << QString("%1（%2）: %3 次")
+                       .arg(CacheTrace::classLabel(c), QLatin1String(CacheTrace::className(c)))
+                       .arg(row.count);
+            for (int i = 0; i < CacheTrace::hopCount(c); ++i) {
+                row.mean[i] = h->meanTicks(scope, owner, c, i);
+                tip << QString("    %1  平均 %2  p50 ≥%3  p99 ≥%4")
+                           .arg(CacheTrace::hopLabel(CacheTrace::hopAt(c, i)))
+                           .arg(row.mean[i], 0, 'f', 1)
+                           .arg(h->percentile(scope, owner, c, i, 0.5))
+                           .arg(h->percentile(scope, owner, c, i, 0.99));
+            }
+            rows.append(row);
+        }
+    }
+    setToolTip(tip.join('\n'));
+    update();
+}
+
+void LatencyBars::setTitle(const QString& title) {
+    prepareGeometryChange();
+    this->title = title;
+    update();
+}
+
+QRectF LatencyBars::boundingRect() const {
+    qreal height = rows.size() * kRowHeight;
+    if (!title.isEmpty())
+        height += kTitleHeight + (CacheTrace::HopCount + 1) / 2 * kLegendRow + 4;
+    return QRectF(0, 0, kLabelWidth + kBarWidth + kValueWidth, height);
+}
+
+void LatencyBars::paint(QPainter* painter, const QStyleOptionGraphicsItem*, QWidget*) {
+    FrameStats::Timer timer(FrameStats::Latency);
+    if (rows.isEmpty())
+        return;
+    painter->setFont(smallFont());
+    qreal y = 0;
+    if (!title.isEmpty()) {
+        painter->setPen(Qt::black);
+        painter->drawText(QRectF(0, 0, boundingRect().width(), kTitleHeight),
+                          Qt::AlignLeft | Qt::AlignVCenter, title);
+        y = kTitleHeight;
+    }
+
+    for (const Row& row : rows) {
+        painter->setPen(Qt::black);
+        painter->drawText(QRectF(0, y, kLabelWidth - 4, kRowHeight), Qt::AlignRight | Qt::AlignVCenter,
+                          CacheTrace::classLabel(row.eventClass));
+        qreal x = kLabelWidth;
+        double total = 0;
+        painter->setPen(Qt::NoPen);
+        for (int i = 0; i < CacheTrace::hopCount(row.eventClass); ++i) {
+            const qreal w = row.mean[i] * pxPerTick;
+            painter->setBrush(hopColor(CacheTrace::hopAt(row.eventClass, i)));
+            painter->drawRect(QRectF(x, y + (kRowHeight - kBarHeight) / 2, w, kBarHeight));
+            x += w;
+            total += row.mean[i];
+        }
+        painter->setPen(Qt::black);
+        painter->drawText(QRectF(x + 3, y, kValueWidth, kRowHeight), Qt::AlignLeft | Qt::AlignVCenter,
+                          QString::number(total, 'f', 0));
+        y += kRowHeight;
+    }
+
+    if (title.isEmpty())
+        return;
+    // 各段图例，两列
+    y += 4;
+    const qreal column = (kLabelWidth + kBarWidth + kValueWidth) / 2;
+    for (int hop = 0; hop < CacheTrace::HopCount; ++hop) {
+        const qreal x = (hop % 2) * column;
+        const qreal top = y + (hop / 2) * kLegendRow;
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(hopColor(hop));
+        painter->drawRect(QRectF(x, top + 2, 14, kLegendRow - 4));
+        painter->setPen(Qt::black);
+        painter->drawText(QRectF(x + 18, top, column - 18, kLegendRow), Qt::AlignLeft | Qt::AlignVCenter,
+                          CacheTrace::hopLabel(hop));
+    }
+}
@@ -0,0 +1,45 @@
+// latencybars.h
+#ifndef LATENCYBARS_H
+#define LATENCYBARS_H
+#include <QColor>
+#include <QGraphicsItem>
+#include <QVector>
+#include "cachetrace.h"
+
+// 事件跟踪的分段延迟条：每个出现过的事件类一行，按各段的平均周期首尾相接画成堆叠条
+// 所有条共用同一个比例尺（每周期多少像素），不同模块之间可以直接比较长短
+// 悬停提示列出各段的平均、中位数与 99 分位
+class LatencyBars : public QGraphicsItem {
+public:
+    static const int kBarWidth = 140;   // 最长一条的像素宽度
+
+    explicit LatencyBars(QGraphicsItem* parent = nullptr);
+
+    // histograms 由调用方持有；owner 为 -1 时合计该范围内的全部核心/分片
+    void setData(const LatencyHistograms* histograms, LatencyHistograms::Scope scope, int owner,
+                 qreal pxPerTick);
+    // 不为空时在条形上方画标题，下方画各段的图例
+    void setTitle(const QString& title);
+    bool isEmpty() const { return rows.isEmpty(); }
+
+    // 各事件类所有段平均周期之和中的最大值，用来定比例尺
+    static double maxTotalTicks(const LatencyHistograms& histograms, LatencyHistograms::Scope scope,
+                                int owner);
+    static QColor hopColor(int hop);
+
+    QRectF boundingRect() const override;
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option,
+               QWidget* widget = nullptr) override;
+
+private:
+    struct Row {
+        int eventClass;
+        quint64 count;
+        double mean[CacheTrace::kMaxHops];
+    };
+    QVector<Row> rows;
+    QString title;
+    qreal pxPerTick = 1;
+};
+
+#endif // LATENCYBARS_H
@@ -0,0 +1,432 @@
+// layoutengine.cpp
+#include "layoutengine.h"
+#include <QHash>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 簇内的相对位置（左上角，相对路由器左上角），与 SceneBuilder 的图元尺寸一致
+const qreal kRouterWidth = 120;
+const qreal kRouterHeight = 70;
+const qreal kL2Dx = -300;         // L2 120x50
+const qreal kL1Dx = -450;         // L1 100x60
+const qreal kCpuDx = -600;        // CPU 120x60
+const qreal kChainGap = 200;      // 同一路由器上相邻两条链的间距
+const qreal kChainHeight = 60 + 60;   // 链本身加上 CPU 下方的统计标签
+const qreal kAttachDx = -15;      // L3/内存 150x70
+const qreal kAttachDy = 110;
+const qreal kAttachGap = 90;
+const qreal kLabelLeft = 50;      // CPU 统计标签伸出 CPU 左缘的距离
+const qreal kLabelRight = 330;    // 端口映射/L3 标签伸出路由器右缘的距离
+const qreal kClusterGap = 120;    // 相邻两簇之间至少留出的空隙
+const QPointF kOrigin(100, 300);  // 图例和标题在上方
+
+// 力导向参数
+const int kColdIterations = 300;
+const int kWarmIterations = 60;
+const qreal kTheta = 0.9;         // Barnes-Hut 开角，越大越快越粗略
+const qreal kGravity = 0.02;      // 把不连通的分量拉向中心
+const int kMaxDepth = 32;
+const int kChunkSize = 256;       // 每个并行任务处理的节点数
+
+// Barnes-Hut 四叉树，节点平铺在数组中
+struct QuadTree {
+    struct Node {
+        qreal cx, cy, half;       // 正方形区域
+        qreal mass = 0;
+        qreal mx = 0, my = 0;     // 质心
+        int child[4] = {-1, -1, -1, -1};
+        int body = -1;            // 叶子中唯一的点，内部节点为 -1
+    };
+    QVector<Node> nodes;
+    const QVector<QPointF>* points = nullptr;
+
+    void build(const QVector<QPointF>& p) {
+        points = &p;
+        nodes.clear();
+        if (p.isEmpty())
+            return;
+        qreal minX = p[0].x(), maxX = minX, minY = p[0].y(), maxY = minY;
+        for (const QPointF& q : p) {
+            minX = qMin(minX, q.x()); maxX = qMax(maxX, q.x());
+            minY = qMin(minY, q.y()); maxY = qMax(maxY, q.y());
+        }
+        Node root;
+        root.cx = (minX + maxX) / 2;
+        root.cy = (minY + maxY) / 2;
+        root.half = qMax(maxX - minX, maxY - minY) / 2 + 1e-6;
+        nodes.reserve(p.size() * 2 + 1);
+        nodes.append(root);
+        for (int i = 0; i < p.size(); ++i)
+            insert(i);
+    }
+
+    int quadrant(const Node& n, const QPointF& q) const {
+        return (q.x() >= n.cx ? 1 : 0) | (q.y() >= n.cy ? 2 : 0);
+    }
+
+    int childOf(int n, int quad) {
+        if (nodes[n].child[quad] < 0) {
+            Node c;
+            const qreal h = nodes[n].half / 2;
+            c.half = h;
+            c.cx = nodes[n].cx + (quad & 1 ? h : -h);
+            c.cy = nodes[n].cy + (quad & 2 ? h : -h);
+            nodes.append(c);
+            nodes[n].child[quad] = int(nodes.size()) - 1;
+        }
+        return nodes[n].child[quad];
+    }
+
+    void insert(int body) {
+        const QPointF q = (*points)[body];
+        int n = 0;
+        for (int depth = 0;; ++depth) {
+            Node& node = nodes[n];
+            node.mx = (node.mx * node.mass + q.x()) / (node.mass + 1);
+            node.my = (node.my * node.mass + q.y()) / (node.mass + 1);
+            node.mass += 1;
+            const bool leaf = node.child[0] < 0 && node.child[1] < 0
+                              && node.child[2] < 0 && node.child[3] < 0;
+            if (leaf && node.mass == 1) {
+                node.body = body;
+                return;
+            }
+            // 重合的点太多时不再细分，作为一个整体
+            if (depth >= kMaxDepth) {
+                node.body = -1;
+                return;
+            }
+            if (leaf && node.body >= 0) {
+                // 把原来的点下推一层
+                const int old = node.body;
+                nodes[n].body = -1;
+                const int c = childOf(n, quadrant(nodes[n], (*points)[old]));
+                Node& child = nodes[c];
+                child.mass = 1;
+                child.mx = (*points)[old].x();
+                child.my = (*points)[old].y();
+                child.body = old;
+            }
+            n = childOf(n, quadrant(nodes[n], q));
+        }
+    }
+
+    // 对 body 的斥力（k = 1 时为 1/d，沿两点连线方向）
+    QPointF repulsion(int body) const {
+        const QPointF q = (*points)[body];
+        QPointF force;
+        int stack[4 * kMaxDepth + 8];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node& node = nodes[stack[--top]];
+            if (node.mass == 0 || node.body == body)
+                continue;
+            qreal dx = q.x() - node.mx;
+            qreal dy = q.y() - node.my;
+            qreal d2 = dx * dx + dy * dy;
+            const bool leaf = node.child[0] < 0 && node.child[1] < 0
+                              && node.child[2] < 0 && node.child[3] < 0;
+            if (leaf || (2 * node.half) * (2 * node.half) < kTheta * kTheta * d2) {
+                if (d2 < 1e-12) {
+                    // 重合时按编号错开一个确定的方向
+                    dx = 1e-3 * std::cos(body);
+                    dy = 1e-3 * std::sin(body);
+                    d2 = dx * dx + dy * dy;
+                }
+                force += QPointF(dx, dy) * (node.mass / d2);
+                continue;
+            }
+            for (int c : node.child) {
+                if (c >= 0)
+                    stack[top++] = c;
+            }
+        }
+        return force;
+    }
+};
+
+struct ForceChunk {
+    int begin;
+    int end;
+};
+
+// 簇的外形：相对路由器左上角的包围盒
+struct Cluster {
+    qreal left, top, right, bottom;
+    qreal width() const { return right - left; }
+    qreal height() const { return bottom - top; }
+};
+
+} // namespace
+
+QVector<QPointF> LayoutEngine::forceLayout(int n, const QVector<BusEdge>& edges,
+                                           const QVector<QPointF>& initial, QThreadPool* pool) {
+    QVector<QPointF> pos(n);
+    if (n == 0)
+        return pos;
+    if (!pool)
+        pool = QThreadPool::globalInstance();
+
+    // 无向邻接表（CSR），每个节点只累加自己的受力，并行时不需要同步
+    QVector<int> degree(n + 1, 0);
+    for (const BusEdge& e : edges) {
+        if (e.from == e.to || e.from < 0 || e.to < 0 || e.from >= n || e.to >= n)
+            continue;
+        ++degree[e.from + 1];
+        ++degree[e.to + 1];
+    }
+    for (int i = 0; i < n; ++i)
+        degree[i + 1] += degree[i];
+    QVector<int> adjacency(degree[n]);
+    QVector<int> fill(degree.begin(), degree.end() - 1);
+    for (const BusEdge& e : edges) {
+        if (e.from == e.to || e.from < 0 || e.to < 0 || e.from >= n || e.to >= n)
+            continue;
+        adjacency[fill[e.from]++] = e.to;
+        adjacency[fill[e.to]++] = e.from;
+    }
+
+    // 初始位置：冷启动排成方阵（与按行编号的网格拓扑一致）；
+    // 热启动沿用已有位置，新节点放在已放置邻居的平均位置附近
+    const int cols = qMax(1, int(qCeil(qSqrt(qreal(n)))));
+    const bool warm = !initial.isEmpty();
+    QVector<bool> placed(n, false);
+    for (int i = 0; i < n; ++i) {
+        if (warm && i < initial.size() && !std::isnan(initial[i].x())) {
+            pos[i] = initial[i];
+            placed[i] = true;
+        } else {
+            pos[i] = QPointF(i % cols, i / cols);
+        }
+    }
+    if (warm) {
+        for (int i = 0; i < n; ++i) {
+            if (placed[i])
+                continue;
+            QPointF sum;
+            int count = 0;
+            for (int a = degree[i]; a < degree[i + 1]; ++a) {
+                if (placed[adjacency[a]]) {
+                    sum += pos[adjacency[a]];
+                    ++count;
+                }
+            }
+            if (count > 0)
+                pos[i] = sum / count + QPointF(0.3 * std::cos(i), 0.3 * std::sin(i));
+            placed[i] = true;
+        }
+    }
+
+    // Fruchterman-Reingold：斥力 1/d（Barnes-Hut），沿边引力 d²，位移不超过温度，温度线性下降
+    const int iterations = warm ? kWarmIterations : kColdIterations;
+    const qreal startTemperature = warm ? 0.2 : qMax<qreal>(1, cols * 0.1);
+    QVector<QPointF> next(n);
+    QVector<ForceChunk> chunks;
+    for (int b = 0; b < n; b += kChunkSize)
+        chunks.append({b, qMin(n, b + kChunkSize)});
+    QuadTree tree;
+    for (int it = 0; it < iterations; ++it) {
+        const qreal temperature = startTemperature * (1 - qreal(it) / iterations) + 1e-3;
+        tree.build(pos);
+        QPointF center;
+        for (const QPointF& p : pos)
+            center += p;
+        center /= n;
+
+        // 由上一轮的位置算出本轮全部位置，结果与线程数无关
+        QtConcurrent::blockingMap(pool, chunks, [&](const ForceChunk& c) {
+            for (int i = c.begin; i < c.end; ++i) {
+                QPointF force = tree.repulsion(i);
+                for (int a = degree[i]; a < degree[i + 1]; ++a) {
+                    const QPointF d = pos[adjacency[a]] - pos[i];
+                    force += d * qSqrt(d.x() * d.x() + d.y() * d.y());
+                }
+                force += (center - pos[i]) * kGravity;
+                const qreal length = qSqrt(force.x() * force.x() + force.y() * force.y());
+                next[i] = pos[i] + (length > temperature ? force * (temperature / length) : force);
+            }
+        });
+        pos.swap(next);
+    }
+    return pos;
+}
+
+Layout LayoutEngine::layout(const Topology& t, const Layout* previous, QThreadPool* pool) {
+    Layout out;
+    const int n = t.nodeCount;
+    out.routers.resize(n);
+    out.modules.fill(QPointF(), t.modules.size());
+    out.l1.fill(QPointF(), t.modules.size());
+
+    // ============== CPU→L1→L2 链 ==============
+    // 同一编号的 CPUn 与 L2Cachen 组成一条链，L1 的几何参数来自 L2Cache 块
+    QHash<int, int> l2OfCore;
+    for (int m = 0; m < t.modules.size(); ++m) {
+        if (t.modules[m].kind == ModuleKind::L2Cache)
+            l2OfCore.insert(t.modules[m].index, m);
+    }
+    QVector<bool> chained(t.modules.size(), false);
+    for (int m = 0; m < t.modules.size(); ++m) {
+        if (t.modules[m].kind == ModuleKind::Cpu) {
+            const int l2 = l2OfCore.value(t.modules[m].index, -1);
+            out.chainCpu.append(m);
+            out.chainL2.append(l2);
+            if (l2 >= 0) chained[l2] = true;
+        }
+    }
+    for (int m = 0; m < t.modules.size(); ++m) {
+        if (t.modules[m].kind == ModuleKind::L2Cache && !chained[m]) {
+            out.chainCpu.append(-1);
+            out.chainL2.append(m);
+        }
+    }
+
+    // 各路由器上的链与下方模块
+    QVector<QVector<int>> nodeChains(n);
+    QVector<int> looseChains;          // L2 没有接到总线的链
+    for (int c = 0; c < out.chainCpu.size(); ++c) {
+        const int node = t.nodeOfModule(out.chainL2[c]);
+        if (node >= 0)
+            nodeChains[node].append(c);
+        else
+            looseChains.append(c);
+    }
+    QVector<QVector<int>> nodeAttached(n);
+    for (int m = 0; m < t.modules.size(); ++m) {
+        const int node = t.nodeOfModule(m);
+        if (node >= 0 && t.modules[m].kind != ModuleKind::L2Cache)
+            nodeAttached[node].append(m);
+    }
+
+    // ============== 簇的外形 ==============
+    QVector<Cluster> clusters(n);
+    qreal cellWidth = 1, cellHeight = 1;
+    for (int node = 0; node < n; ++node) {
+        const int chains = int(nodeChains[node].size());
+        const qreal chainTop = -(chains - 1) / 2.0 * kChainGap;
+        Cluster& c = clusters[node];
+        c.left = chains > 0 ? kCpuDx - kLabelLeft : kAttachDx;
+        c.right = kRouterWidth + kLabelRight;
+        c.top = qMin<qreal>(0, chainTop);
+        c.bottom = qMax<qreal>(kRouterHeight, chainTop + (chains - 1) * kChainGap + kChainHeight);
+        if (!nodeAttached[node].isEmpty())
+            c.bottom = qMax(c.bottom, kAttachDy + (nodeAttached[node].size() - 1) * kAttachGap + 70);
+        cellWidth = qMax(cellWidth, c.width() + kClusterGap);
+        cellHeight = qMax(cellHeight, c.height() + kClusterGap);
+    }
+
+    // ============== 路由器网络：力导向 ==============
+    // 在以簇为单位的坐标中布局，理想边长即一个簇的大小
+    QVector<QPointF> initial;
+    if (previous && !previous->nodeCenters.isEmpty()) {
+        initial = previous->nodeCenters;
+        initial.resize(n);
+        for (int i = int(previous->nodeCenters.size()); i < n; ++i)
+            initial[i] = QPointF(qQNaN(), qQNaN());
+    }
+    QVector<QPointF> centers = forceLayout(n, t.edges, initial, pool);
+    out.nodeCenters = centers;
+
+    // 斥力作用于所有节点对，节点越多整体撑得越开；按平均边长缩回约一个簇的间距，
+    // 缩过头造成的重叠交给下一步处理
+    qreal edgeLength = 0;
+    int edgeCount = 0;
+    for (const BusEdge& e : t.edges) {
+        if (e.from == e.to || e.from < 0 || e.to < 0 || e.from >= n || e.to >= n)
+            continue;
+        const QPointF d = centers[e.to] - centers[e.from];
+        edgeLength += qSqrt(d.x() * d.x() + d.y() * d.y());
+        ++edgeCount;
+    }
+    if (edgeCount > 0 && edgeLength > 0) {
+        const qreal factor = edgeCount / edgeLength;
+        for (QPointF& p : centers)
+            p = p * factor;
+    }
+
+    // 按各簇实际大小推开仍然重叠的簇：同一网格单元及相邻单元内两两检查
+    for (int pass = 0; pass < 64; ++pass) {
+        QHash<qint64, QVector<int>> grid;
+        auto cellKey = [](qint64 x, qint64 y) { return (x << 32) ^ (y & 0xffffffff); };
+        for (int i = 0; i < n; ++i)
+            grid[cellKey(qFloor(centers[i].x()), qFloor(centers[i].y()))].append(i);
+        bool moved = false;
+        for (int i = 0; i < n; ++i) {
+            const qint64 cx = qFloor(centers[i].x());
+            const qint64 cy = qFloor(centers[i].y());
+            for (qint64 dx = -1; dx <= 1; ++dx) {
+                for (qint64 dy = -1; dy <= 1; ++dy) {
+                    const auto it = grid.constFind(cellKey(cx + dx, cy + dy));
+                    if (it == grid.constEnd())
+                        continue;
+                    for (const int j : it.value()) {
+                        if (j <= i)
+                            continue;
+                        const qreal needX = (clusters[i].width() + clusters[j].width() + 2 * kClusterGap)
+                                            / 2 / cellWidth;
+                        const qreal needY = (clusters[i].height() + clusters[j].height() + 2 * kClusterGap)
+                                            / 2 / cellHeight;
+                        const QPointF d = centers[j] - centers[i];
+                        const qreal overlapX = needX - qAbs(d.x());
+                        const qreal overlapY = needY - qAbs(d.y());
+                        if (overlapX <= 0 || overlapY <= 0)
+                            continue;
+                        // 沿重叠较小的方向各退一半
+                        QPointF push = overlapX < overlapY
+                                           ? QPointF((d.x() >= 0 ? overlapX : -overlapX) / 2, 0)
+                                           : QPointF(0, (d.y() >= 0 ? overlapY : -overlapY) / 2);
+                        centers[i] -= push;
+                        centers[j] += push;
+                        moved = true;
+                    }
+                }
+            }
+        }
+        if (!moved)
+            break;
+    }
+
+    // ============== 换算到场景坐标 ==============
+    qreal minX = 0, minY = 0;
+    for (int node = 0; node < n; ++node) {
+        const Cluster& c = clusters[node];
+        // 簇中心 -> 路由器左上角
+        const QPointF center(centers[node].x() * cellWidth, centers[node].y() * cellHeight);
+        out.routers[node] = center - QPointF((c.left + c.right) / 2, (c.top + c.bottom) / 2);
+        minX = node == 0 ? out.routers[node].x() + c.left : qMin(minX, out.routers[node].x() + c.left);
+        minY = node == 0 ? out.routers[node].y() + c.top : qMin(minY, out.routers[node].y() + c.top);
+    }
+    // 没接到总线的链单独排成一列，放在最左边
+    const qreal looseWidth = looseChains.isEmpty() ? 0 : -kCpuDx + kLabelLeft + kClusterGap;
+    const QPointF shift = kOrigin + QPointF(looseWidth, 0) - QPointF(minX, minY);
+    for (QPointF& p : out.routers)
+        p += shift;
+
+    auto placeChain = [&](int c, const QPointF& l2Pos) {
+        if (out.chainL2[c] >= 0) {
+            out.modules[out.chainL2[c]] = l2Pos;
+            out.l1[out.chainL2[c]] = l2Pos + QPointF(kL1Dx - kL2Dx, 0);
+        }
+        if (out.chainCpu[c] >= 0)
+            out.modules[out.chainCpu[c]] = l2Pos + QPointF(kCpuDx - kL2Dx, 0);
+    };
+    for (int node = 0; node < n; ++node) {
+        const QPointF r = out.routers[node];
+        const QVector<int>& chains = nodeChains[node];
+        const qreal chainTop = -(chains.size() - 1) / 2.0 * kChainGap;
+        for (int k = 0; k < chains.size(); ++k)
+            placeChain(chains[k], r + QPointF(kL2Dx, chainTop + k * kChainGap));
+        const QVector<int>& attached = nodeAttached[node];
+        for (int a = 0; a < attached.size(); ++a)
+            out.modules[attached[a]] = r + QPointF(kAttachDx, kAttachDy + a * kAttachGap);
+    }
+    for (int k = 0; k < looseChains.size(); ++k)
+        placeChain(looseChains[k], kOrigin + QPointF(kLabelLeft - kCpuDx + kL2Dx, k * kChainGap));
+    return out;
+}
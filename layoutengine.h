@@ -0,0 +1,40 @@
+// layoutengine.h
+#ifndef LAYOUTENGINE_H
+#define LAYOUTENGINE_H
+#include <QPointF>
+#include <QVector>
+#include "topology.h"
+
+class QThreadPool;
+
+// 场景中各图元的位置（左上角），由 LayoutEngine 根据拓扑算出
+struct Layout {
+    QVector<QPointF> routers;      // 总线节点 -> 路由器
+    QVector<QPointF> modules;      // Topology 模块 -> 模块（L2Cache、CPU、挂在总线上的模块）
+    QVector<QPointF> l1;           // L2Cache 模块 -> 其 L1
+    QVector<int> chainCpu;         // CPU→L1→L2 链，缺 CPU 或 L2 时为 -1
+    QVector<int> chainL2;
+    QVector<QPointF> nodeCenters;  // 力导向布局给出的各路由器簇中心（未消除重叠），供热启动
+
+    bool isEmpty() const { return routers.isEmpty() && modules.isEmpty(); }
+};
+
+// 自动布局
+// 每个路由器与挂在它上面的模块组成一簇：CPU→L1→L2 链分层排在路由器左侧，
+// L3/内存等依次排在路由器下方。簇之间按 setup.txt 的 edge 互连表做力导向布局，
+// 斥力用 Barnes-Hut 四叉树近似，各节点的受力在线程池上并行计算；
+// 最后按各簇实际大小消除重叠。
+class LayoutEngine {
+public:
+    // previous 不为空时热启动：沿用其中已有节点的位置，只做少量迭代
+    static Layout layout(const Topology& topology, const Layout* previous = nullptr,
+                         QThreadPool* pool = nullptr);
+
+    // 力导向布局本身，坐标以理想边长为单位
+    // initial 为空时从方阵排列冷启动；否则热启动，其中 NaN 的点视为新节点
+    static QVector<QPointF> forceLayout(int nodeCount, const QVector<BusEdge>& edges,
+                                        const QVector<QPointF>& initial = QVector<QPointF>(),
+                                        QThreadPool* pool = nullptr);
+};
+
+#endif // LAYOUTENGINE_H
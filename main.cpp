@@ -1,11 +1,19 @@
-// main.cpp
-#include <QApplication>
-#include "mainwindow.h"
-
-int main(int argc, char *argv[]) {
-    QApplication a(argc, argv);
-    MainWindow w;
-    w.resize(800, 600);
-    w.show();
-    return a.exec();
-}
+// main.cpp
+#include <QApplication>
+#include "mainwindow.h"
+#include "batchrenderer.h"
+
+int main(int argc, char *argv[]) {
+    // --render：不开窗口，在离屏平台上批量出图
+    const bool headless = BatchRenderer::wantsHeadless(argc, argv);
+    if (headless && !qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication a(argc, argv);
+    if (headless)
+        return BatchRenderer::run(a.arguments());
+
+    MainWindow w;
+    w.resize(800, 600);
+    w.show();
+    return a.exec();
+}
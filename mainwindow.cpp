@@ -1,13 +1,356 @@
-// mainwindow.cpp
-#include "mainwindow.h"
-#include "scenewidget.h"
-MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
-    SceneWidget* widget = new SceneWidget(this);
-    setCentralWidget(widget);
-
-    // 确保窗口足够大
-    resize(1200, 900);
-
-    // 设置窗口标题
-    setWindowTitle("优化后的总线拓扑可视化");
-}
+// mainwindow.cpp
+#include "mainwindow.h"
+#include "scenewidget.h"
+#include "heatmapview.h"
+#include "inspectorpanel.h"
+#include "runcomparison.h"
+#include "cachetrace.h"
+#include "sweepview.h"
+#include "statingest.h"
+#include "searchbar.h"
+#include <QMenuBar>
+#include <QStatusBar>
+#include <QToolBar>
+#include <QSlider>
+#include <QLabel>
+#include <QProgressBar>
+#include <QToolButton>
+#include <QComboBox>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QFileInfo>
+#include <QDir>
+#include <QCoreApplication>
+
+MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
+    sceneWidget = new SceneWidget(this);
+    setCentralWidget(sceneWidget);
+
+    QMenu* fileMenu = menuBar()->addMenu("文件");
+    fileMenu->addAction("打开配置...", this, &MainWindow::openSetupDialog);
+    QAction* liveAction = fileMenu->addAction("实时跟踪统计数据");
+    liveAction->setCheckable(true);
+    connect(liveAction, &QAction::toggled, sceneWidget, &SceneWidget::setLiveTail);
+    QAction* ingestAction = fileMenu->addAction("接收模拟器推送");
+    ingestAction->setCheckable(true);
+    connect(ingestAction, &QAction::toggled, this, [this, ingestAction](bool enabled) {
+        if (!enabled) {
+            sceneWidget->stopIngest();
+            statusBar()->showMessage("已停止接收推送", 3000);
+            return;
+        }
+        QString error;
+        if (!sceneWidget->startIngest(StatIngestServer::defaultServerName(), &error)) {
+            ingestAction->setChecked(false);
+            QMessageBox::warning(this, "接收推送", error);
+            return;
+        }
+        statusBar()->showMessage(QString("正在 %1 上等待模拟器连接").arg(sceneWidget->ingest()->serverName()));
+    });
+    connect(sceneWidget->ingest(), &StatIngestServer::clientConnected, this, [this]() {
+        statusBar()->showMessage("模拟器已连接");
+    });
+    connect(sceneWidget->ingest(), &StatIngestServer::clientDisconnected, this,
+            [this](const QString& errorMessage) {
+        statusBar()->showMessage(errorMessage.isEmpty()
+                                     ? QString("模拟器已断开")
+                                     : QString("模拟器连接出错：%1").arg(errorMessage));
+    });
+    fileMenu->addSeparator();
+    fileMenu->addAction("与另一次运行对比...", this, &MainWindow::openComparisonDialog);
+    fileMenu->addAction("清除对比", sceneWidget, &SceneWidget::clearComparison);
+    connect(sceneWidget, &SceneWidget::comparisonFinished, this, &MainWindow::showComparisonResult);
+    fileMenu->addAction("打开事件跟踪...", this, &MainWindow::openTraceDialog);
+    fileMenu->addAction("清除事件跟踪", sceneWidget, &SceneWidget::clearTrace);
+    connect(sceneWidget, &SceneWidget::traceFinished, this, &MainWindow::showTraceResult);
+    fileMenu->addAction("参数扫描...", this, &MainWindow::openSweepDialog);
+    fileMenu->addAction("回放总线事件...", this, &MainWindow::openPlaybackDialog);
+    connect(sceneWidget, &SceneWidget::statsUpdated, this, [this](int rows) {
+        statusBar()->showMessage(QString("statistic.txt 已更新 %1 项").arg(rows), 3000);
+    });
+    connect(sceneWidget, &SceneWidget::liveTailError, this, [this](const QString& message) {
+        statusBar()->showMessage(message);
+    });
+
+    // 时间轴：最右端为最后一个 epoch，跟踪时随新 epoch 前进
+    timelineBar = new QToolBar("时间轴", this);
+    timelineBar->setMovable(false);
+    epochSlider = new QSlider(Qt::Horizontal, timelineBar);
+    epochSlider->setMinimum(0);
+    epochLabel = new QLabel(timelineBar);
+    epochLabel->setMinimumWidth(120);
+    timelineBar->addWidget(epochSlider);
+    timelineBar->addWidget(epochLabel);
+    addToolBar(Qt::BottomToolBarArea, timelineBar);
+    timelineBar->setVisible(false);
+    connect(epochSlider, &QSlider::valueChanged, this, [this](int value) {
+        sceneWidget->showEpoch(value);
+        updateEpochLabel();
+    });
+    connect(sceneWidget, &SceneWidget::epochsChanged, this, &MainWindow::updateTimeline);
+
+    // 回放控制：暂停、速度（每秒推进的 tick 数）与停止
+    playbackBar = new QToolBar("回放", this);
+    playbackBar->setMovable(false);
+    pauseButton = new QToolButton(playbackBar);
+    pauseButton->setText("暂停");
+    pauseButton->setCheckable(true);
+    speedBox = new QComboBox(playbackBar);
+    for (const int speed : {100, 1000, 10000, 100000, 1000000})
+        speedBox->addItem(QString("%1 tick/s").arg(speed), speed);
+    speedBox->setCurrentIndex(1);
+    QToolButton* stopButton = new QToolButton(playbackBar);
+    stopButton->setText("停止");
+    playbackLabel = new QLabel(playbackBar);
+    playbackLabel->setMinimumWidth(220);
+    playbackBar->addWidget(pauseButton);
+    playbackBar->addWidget(speedBox);
+    playbackBar->addWidget(stopButton);
+    playbackBar->addWidget(playbackLabel);
+    addToolBar(Qt::BottomToolBarArea, playbackBar);
+    playbackBar->setVisible(false);
+    connect(pauseButton, &QToolButton::toggled, sceneWidget, &SceneWidget::setPlaybackPaused);
+    connect(speedBox, &QComboBox::currentIndexChanged, this, [this]() {
+        sceneWidget->setPlaybackSpeed(speedBox->currentData().toDouble());
+    });
+    connect(stopButton, &QToolButton::clicked, sceneWidget, &SceneWidget::stopPlayback);
+    connect(sceneWidget, &SceneWidget::playbackProgress, this, [this](quint64 tick, int inFlight) {
+        playbackLabel->setText(QString("tick %1，在途 %2 个包").arg(tick).arg(inFlight));
+    });
+    connect(sceneWidget, &SceneWidget::playbackFinished, this, &MainWindow::showPlaybackResult);
+
+    // 加载进度与取消
+    loadBar = new QProgressBar(this);
+    loadBar->setRange(0, 100);
+    loadBar->setMaximumWidth(200);
+    cancelButton = new QToolButton(this);
+    cancelButton->setText("取消");
+    statusBar()->addPermanentWidget(loadBar);
+    statusBar()->addPermanentWidget(cancelButton);
+    loadBar->setVisible(false);
+    cancelButton->setVisible(false);
+    connect(cancelButton, &QToolButton::clicked, sceneWidget, &SceneWidget::cancelLoad);
+    connect(sceneWidget, &SceneWidget::loadProgress, this, [this](int percent) {
+        loadBar->setValue(percent);
+        loadBar->setVisible(true);
+        cancelButton->setVisible(true);
+    });
+    connect(sceneWidget, &SceneWidget::loadFinished, this, &MainWindow::showLoadResult);
+
+    // 端口流量矩阵热力图，从“视图”菜单打开
+    heatmapDock = new HeatmapDock(this);
+    addDockWidget(Qt::RightDockWidgetArea, heatmapDock);
+    heatmapDock->hide();
+    QMenu* viewMenu = menuBar()->addMenu("视图");
+    viewMenu->addAction(heatmapDock->toggleViewAction());
+    connect(sceneWidget, &SceneWidget::statsShown, heatmapDock, &HeatmapDock::statsChanged);
+
+    // 模块详情：单击场景中的模块时显示，整个窗口只有这一个
+    inspectorDock = new InspectorDock(this);
+    addDockWidget(Qt::RightDockWidgetArea, inspectorDock);
+    inspectorDock->hide();
+    viewMenu->addAction(inspectorDock->toggleViewAction());
+    connect(sceneWidget, &SceneWidget::targetClicked, inspectorDock, &InspectorDock::inspect);
+    connect(sceneWidget, &SceneWidget::statsShown, inspectorDock, &InspectorDock::statsChanged);
+
+    // 参数扫描：一个目录下的全部运行汇成一张表，双击某个运行在主视图中打开
+    sweepDock = new SweepDock(this);
+    addDockWidget(Qt::BottomDockWidgetArea, sweepDock);
+    sweepDock->hide();
+    viewMenu->addAction(sweepDock->toggleViewAction());
+    connect(sweepDock, &SweepDock::openRun, this, &MainWindow::openSetup);
+
+    // 搜索：命中的模块与连线突出显示，其余变淡；统计值变化后按当前条件重查
+    searchBar = new SearchBar(this);
+    addToolBar(Qt::TopToolBarArea, searchBar);
+    viewMenu->addAction(searchBar->toggleViewAction());
+    QAction* findAction = viewMenu->addAction("搜索...");
+    findAction->setShortcut(QKeySequence::Find);
+    connect(findAction, &QAction::triggered, searchBar, &SearchBar::focusSearch);
+    connect(searchBar, &SearchBar::resultReady, sceneWidget, &SceneWidget::setHighlight);
+    connect(searchBar, &SearchBar::cleared, sceneWidget, &SceneWidget::clearHighlight);
+    connect(sceneWidget, &SceneWidget::statsShown, searchBar, &SearchBar::statsChanged);
+
+    // 性能 HUD：打开时开始统计帧时间，关掉后不再计时
+    viewMenu->addSeparator();
+    QAction* hudAction = viewMenu->addAction("性能 HUD");
+    hudAction->setCheckable(true);
+    connect(hudAction, &QAction::toggled, this, [this](bool visible) {
+        sceneWidget->setFrameTiming(visible);
+        sceneWidget->setHudVisible(visible);
+    });
+    viewMenu->addAction("导出帧时间...", this, &MainWindow::exportFrameStats);
+
+    // 确保窗口足够大
+    resize(1200, 900);
+
+    // 设置窗口标题
+    setWindowTitle("优化后的总线拓扑可视化");
+
+    // 默认打开工作目录或程序目录下的 setup.txt
+    const QStringList candidates = {
+        QDir::current().filePath("setup.txt"),
+        QDir(QCoreApplication::applicationDirPath()).filePath("setup.txt")
+    };
+    for (const QString& path : candidates) {
+        if (QFileInfo::exists(path)) {
+            openSetup(path);
+            break;
+        }
+    }
+}
+
+void MainWindow::openSetup(const QString& setupPath) {
+    // 统计数据默认与配置文件放在同一目录
+    const QString statPath = QFileInfo(setupPath).dir().filePath("statistic.txt");
+    sceneWidget->loadRun(setupPath, QFileInfo::exists(statPath) ? statPath : QString());
+    statusBar()->showMessage(QString("正在加载 %1 ...").arg(QFileInfo(setupPath).fileName()));
+}
+
+void MainWindow::showLoadResult(bool ok, const QString& errorMessage) {
+    loadBar->setVisible(false);
+    cancelButton->setVisible(false);
+    statusBar()->clearMessage();
+    if (ok) {
+        heatmapDock->setRun(&sceneWidget->topology(), &sceneWidget->statsView());
+        inspectorDock->setRun(&sceneWidget->topology(), &sceneWidget->statsView());
+        searchBar->setView(&sceneWidget->statsView());
+        setWindowTitle(QString("优化后的总线拓扑可视化 - %1")
+                           .arg(QFileInfo(sceneWidget->setupPath()).fileName()));
+    } else if (!errorMessage.isEmpty()) {
+        QMessageBox::warning(this, "打开失败", errorMessage);
+    }
+}
+
+void MainWindow::openSetupDialog() {
+    const QString path = QFileDialog::getOpenFileName(this, "打开硬件配置", QString(),
+                                                      "配置文件 (*.txt);;所有文件 (*)");
+    if (!path.isEmpty())
+        openSetup(path);
+}
+
+void MainWindow::openComparisonDialog() {
+    if (sceneWidget->stats().isEmpty()) {
+        QMessageBox::information(this, "对比", "当前运行没有统计数据");
+        return;
+    }
+    const QString path = QFileDialog::getOpenFileName(this, "选择对比运行的统计数据",
+                                                      QFileInfo(sceneWidget->setupPath()).path(),
+                                                      "统计数据 (*.txt);;所有文件 (*)");
+    if (path.isEmpty())
+        return;
+    sceneWidget->loadComparison(path);
+    statusBar()->showMessage(QString("正在对齐 %1 ...").arg(QFileInfo(path).fileName()));
+}
+
+void MainWindow::showComparisonResult(bool ok, const QString& errorMessage) {
+    inspectorDock->setComparison(sceneWidget->comparison());
+    if (ok) {
+        const RunComparison& c = *sceneWidget->comparison();
+        statusBar()->showMessage(QString("对比 %1：%2 项对齐，%3 项只在当前运行，%4 项只在对比运行；"
+                                         "红色为增加，蓝色为减少")
+                                     .arg(QFileInfo(sceneWidget->comparisonPath()).fileName())
+                                     .arg(c.matchedRows).arg(c.onlyInBase).arg(c.onlyInOther));
+    } else if (!errorMessage.isEmpty()) {
+        statusBar()->clearMessage();
+        QMessageBox::warning(this, "对比失败", errorMessage);
+    } else {
+        statusBar()->showMessage("已清除对比", 3000);
+    }
+}
+
+void MainWindow::openTraceDialog() {
+    const QString path = QFileDialog::getOpenFileName(this, "打开事件跟踪",
+                                                      QFileInfo(sceneWidget->setupPath()).path(),
+                                                      "事件跟踪 (*.qtrace);;所有文件 (*)");
+    if (path.isEmpty())
+        return;
+    sceneWidget->loadTrace(path);
+    statusBar()->showMessage(QString("正在读取 %1 ...").arg(QFileInfo(path).fileName()));
+}
+
+void MainWindow::showTraceResult(bool ok, const QString& errorMessage) {
+    if (ok) {
+        const LatencyHistograms& h = *sceneWidget->latency();
+        QString message = QString("事件跟踪 %1：%2 个事件，L2/L3 下方为各段平均延迟")
+                              .arg(QFileInfo(sceneWidget->tracePath()).fileName())
+                              .arg(h.records);
+        if (h.skipped > 0)
+            message += QString("，%1 条记录超出范围已跳过").arg(h.skipped);
+        statusBar()->showMessage(message);
+    } else if (!errorMessage.isEmpty()) {
+        statusBar()->clearMessage();
+        QMessageBox::warning(this, "事件跟踪", errorMessage);
+    } else {
+        statusBar()->showMessage("已清除事件跟踪", 3000);
+    }
+}
+
+void MainWindow::openPlaybackDialog() {
+    const QString path = QFileDialog::getOpenFileName(this, "回放总线事件",
+                                                      QFileInfo(sceneWidget->setupPath()).path(),
+                                                      "总线事件 (*.qbus);;所有文件 (*)");
+    if (path.isEmpty())
+        return;
+    QString error;
+    if (!sceneWidget->startPlayback(path, &error)) {
+        QMessageBox::warning(this, "回放", error);
+        return;
+    }
+    sceneWidget->setPlaybackSpeed(speedBox->currentData().toDouble());
+    pauseButton->setChecked(false);
+    playbackBar->setVisible(true);
+}
+
+void MainWindow::showPlaybackResult(const QString& errorMessage) {
+    playbackBar->setVisible(false);
+    if (!errorMessage.isEmpty())
+        QMessageBox::warning(this, "回放", errorMessage);
+    else
+        statusBar()->showMessage("回放结束", 3000);
+}
+
+void MainWindow::exportFrameStats() {
+    if (!sceneWidget->frameTiming()) {
+        QMessageBox::information(this, "导出帧时间", "先从“视图”菜单打开性能 HUD，平移、缩放一会儿再导出");
+        return;
+    }
+    const QString suggested = QFileInfo(sceneWidget->setupPath()).dir().filePath("frames.json");
+    const QString path = QFileDialog::getSaveFileName(this, "导出帧时间", suggested,
+                                                      "JSON (*.json);;所有文件 (*)");
+    if (path.isEmpty())
+        return;
+    QString error;
+    if (!sceneWidget->exportFrameStats(path, &error)) {
+        QMessageBox::warning(this, "导出帧时间", error);
+        return;
+    }
+    statusBar()->showMessage(QString("已导出最近 %1 帧到 %2")
+                                 .arg(sceneWidget->frameStats().frameCount())
+                                 .arg(QFileInfo(path).fileName()), 3000);
+}
+
+void MainWindow::openSweepDialog() {
+    const QString root = QFileDialog::getExistingDirectory(this, "选择包含多个运行目录的文件夹");
+    if (root.isEmpty())
+        return;
+    sweepDock->loadDirectory(root);
+    sweepDock->show();
+    sweepDock->raise();
+}
+
+void MainWindow::updateTimeline(int epochCount) {
+    // 原来停在最后一个 epoch 时继续跟随
+    const bool atEnd = epochSlider->value() == epochSlider->maximum();
+    const QSignalBlocker blocker(epochSlider);
+    epochSlider->setMaximum(qMax(0, epochCount - 1));
+    if (atEnd || sceneWidget->currentEpoch() < 0)
+        epochSlider->setValue(epochSlider->maximum());
+    timelineBar->setVisible(epochCount > 1);
+    updateEpochLabel();
+}
+
+void MainWindow::updateEpochLabel() {
+    epochLabel->setText(QString("Epoch %1 / %2").arg(epochSlider->value() + 1)
+                                                  .arg(epochSlider->maximum() + 1));
+}
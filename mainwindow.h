@@ -1,10 +1,53 @@
-// mainwindow.h
-#ifndef MAINWINDOW_H
-#define MAINWINDOW_H
-#include <QMainWindow>
-class MainWindow : public QMainWindow {
-    Q_OBJECT
-public:
-    explicit MainWindow(QWidget *parent = nullptr);
-};
-#endif // MAINWINDOW_H
+// mainwindow.h
+#ifndef MAINWINDOW_H
+#define MAINWINDOW_H
+#include <QMainWindow>
+class SceneWidget;
+class HeatmapDock;
+class InspectorDock;
+class SweepDock;
+class SearchBar;
+class QToolBar;
+class QSlider;
+class QLabel;
+class QProgressBar;
+class QToolButton;
+class QComboBox;
+class MainWindow : public QMainWindow {
+    Q_OBJECT
+public:
+    explicit MainWindow(QWidget *parent = nullptr);
+
+    // 在后台加载，完成后更新标题，失败时提示
+    void openSetup(const QString& setupPath);
+
+private:
+    void openSetupDialog();
+    void updateTimeline(int epochCount);
+    void updateEpochLabel();
+    void showLoadResult(bool ok, const QString& errorMessage);
+    void openComparisonDialog();
+    void openSweepDialog();
+    void showComparisonResult(bool ok, const QString& errorMessage);
+    void openTraceDialog();
+    void showTraceResult(bool ok, const QString& errorMessage);
+    void openPlaybackDialog();
+    void showPlaybackResult(const QString& errorMessage);
+    void exportFrameStats();
+
+    SceneWidget* sceneWidget;
+    QToolBar* timelineBar;     // 多个 epoch 时显示的时间轴
+    QSlider* epochSlider;
+    QLabel* epochLabel;
+    QProgressBar* loadBar;     // 加载期间显示在状态栏
+    QToolButton* cancelButton;
+    HeatmapDock* heatmapDock;  // 端口流量矩阵，默认隐藏
+    InspectorDock* inspectorDock; // 模块详情，第一次单击模块时显示
+    SweepDock* sweepDock;      // 参数扫描表与散点图，默认隐藏
+    SearchBar* searchBar;      // 按模块名、计数器名与数值搜索，命中的在场景中突出显示
+    QToolBar* playbackBar;     // 回放总线事件时显示
+    QToolButton* pauseButton;
+    QComboBox* speedBox;
+    QLabel* playbackLabel;
+};
+#endif // MAINWINDOW_H
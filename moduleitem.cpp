@@ -1,108 +1,155 @@
-#include "moduleitem.h"
-#include <QBrush>
-#include <QGraphicsEllipseItem>
-#include <QGraphicsTextItem>
-#include <QGraphicsSceneMouseEvent> // 添加鼠标事件支持
-#include <QMessageBox> // 添加消息框支持
-#include <QVBoxLayout>
-
-// 详细信息对话框类
-class ModuleDetailsDialog : public QDialog {
-public:
-    ModuleDetailsDialog(const QString& title, const QString& content, QWidget* parent = nullptr)
-        : QDialog(parent) {
-        setWindowTitle(title);
-        setWindowFlags(windowFlags() | Qt::WindowStaysOnTopHint);
-        setMinimumSize(300, 200);
-
-        QVBoxLayout* layout = new QVBoxLayout(this);
-        QLabel* contentLabel = new QLabel(content);
-        contentLabel->setWordWrap(true);
-        contentLabel->setTextFormat(Qt::RichText);
-        contentLabel->setAlignment(Qt::AlignLeft | Qt::AlignTop);
-        layout->addWidget(contentLabel);
-    }
-};
-
-ModuleItem::ModuleItem(const QString& name, qreal x, qreal y, qreal w, qreal h)
-    : QGraphicsRectItem(0, 0, w, h), moduleName(name)
-{
-    setPos(x, y);
-    setBrush(QBrush(Qt::lightGray));
-    setAcceptHoverEvents(true); // 接受悬停事件
-
-    // 默认的详细信息
-    infoText = QString("<b>基本参数:</b><br>")
-               + QString("• 位置: (%1, %2)<br>").arg(x).arg(y)
-               + QString("• 尺寸: %1 x %2<br>").arg(w).arg(h);
-
-    // 添加标签
-    label = new QGraphicsTextItem(name, this);
-    label->setPos(10, 10);
-    label->setDefaultTextColor(Qt::black);
-
-    // 初始端口
-    addPort(Right);
-    addPort(Left);
-}
-
-void ModuleItem::setSize(qreal width, qreal height) {
-    setRect(0, 0, width, height);
-    updatePortPositions();
-}
-
-void ModuleItem::addPort(PortPosition pos) {
-    QGraphicsEllipseItem* port = new QGraphicsEllipseItem(-4, -4, 8, 8, this);
-    port->setBrush(Qt::yellow);
-    ports.append({port, pos});
-    updatePortPositions();
-}
-
-QPointF ModuleItem::getPortPos(int portId) const {
-    if(portId >= 0 && portId < ports.size()) {
-        QPointF localPos;
-        const Port& port = ports[portId];
-        const QRectF rect = this->rect();
-
-        switch(port.position) {
-        case Left:   localPos = QPointF(0, rect.height()/2); break;
-        case Right:  localPos = QPointF(rect.width(), rect.height()/2); break;
-        case Top:    localPos = QPointF(rect.width()/2, 0); break;
-        case Bottom: localPos = QPointF(rect.width()/2, rect.height()); break;
-        }
-        return mapToScene(localPos);
-    }
-    return pos();
-}
-
-void ModuleItem::updatePortPositions() {
-    const QRectF rect = this->rect();
-    for(int i=0; i<ports.size(); ++i) {
-        QGraphicsEllipseItem* port = ports[i].shape;
-        switch(ports[i].position) {
-        case Left:   port->setPos(0, rect.height()/2 - 4); break;
-        case Right:  port->setPos(rect.width(), rect.height()/2 - 4); break;
-        case Top:    port->setPos(rect.width()/2 - 4, 0); break;
-        case Bottom: port->setPos(rect.width()/2 - 4, rect.height()); break;
-        }
-    }
-}
-
-void ModuleItem::setName(const QString& name) {
-    moduleName = name;
-    label->setPlainText(name);
-}
-
-void ModuleItem::setInfoText(const QString& text) {
-    infoText = text;
-}
-
-void ModuleItem::mousePressEvent(QGraphicsSceneMouseEvent* event) {
-    // 调用基类事件处理
-    QGraphicsRectItem::mousePressEvent(event);
-
-    // 创建并显示详细信息对话框
-    ModuleDetailsDialog* dialog = new ModuleDetailsDialog(moduleName, infoText);
-    dialog->setAttribute(Qt::WA_DeleteOnClose); // 关闭时自动删除
-    dialog->show();
-}
+#include "moduleitem.h"
+#include "edgelayer.h"
+#include "framestats.h"
+#include "scenebuilder.h"
+#include <QBrush>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QGraphicsSceneHoverEvent>
+
+ModuleItem::ModuleItem(const QString& name, qreal x, qreal y, qreal w, qreal h)
+    : QGraphicsRectItem(0, 0, w, h), moduleName(name), label(name)
+{
+    setPos(x, y);
+    lastPos = pos();
+    setBrush(QBrush(Qt::lightGray));
+    setAcceptHoverEvents(true); // 接受悬停事件
+    setFlag(QGraphicsItem::ItemIsMovable);
+    setFlag(QGraphicsItem::ItemSendsGeometryChanges);
+    label.setPerformanceHint(QStaticText::AggressiveCaching);
+
+    // 初始端口
+    addPort(Right);
+    addPort(Left);
+}
+
+void ModuleItem::setSize(qreal width, qreal height) {
+    prepareGeometryChange();
+    setRect(0, 0, width, height);
+}
+
+void ModuleItem::addPort(PortPosition pos) {
+    prepareGeometryChange();
+    ports.append(quint8(pos));
+}
+
+QPointF ModuleItem::portLocalPos(int portId) const {
+    const QRectF rect = this->rect();
+    switch (PortPosition(ports[portId])) {
+    case Left:   return QPointF(0, rect.height()/2);
+    case Right:  return QPointF(rect.width(), rect.height()/2);
+    case Top:    return QPointF(rect.width()/2, 0);
+    case Bottom: return QPointF(rect.width()/2, rect.height());
+    }
+    return rect.center();
+}
+
+QPointF ModuleItem::getPortPos(int portId) const {
+    if(portId >= 0 && portId < ports.size())
+        return mapToScene(portLocalPos(portId));
+    return pos();
+}
+
+int ModuleItem::portIndex(PortPosition pos) const {
+    for(int i=0; i<ports.size(); ++i) {
+        if(ports[i] == pos)
+            return i;
+    }
+    return -1;
+}
+
+int ModuleItem::portAt(const QPointF& localPos) const {
+    for(int i=0; i<ports.size(); ++i) {
+        const QPointF d = localPos - portLocalPos(i);
+        if(d.x() * d.x() + d.y() * d.y() <= kPortRadius * kPortRadius)
+            return i;
+    }
+    return -1;
+}
+
+QRectF ModuleItem::boundingRect() const {
+    // 端口圆点伸出矩形边缘半个直径
+    const qreal margin = kPortRadius + pen().widthF() / 2;
+    return rect().adjusted(-margin, -margin, margin, margin);
+}
+
+QPainterPath ModuleItem::shape() const {
+    QPainterPath path;
+    path.addRect(rect());
+    for(int i=0; i<ports.size(); ++i)
+        path.addEllipse(portLocalPos(i), kPortRadius, kPortRadius);
+    return path;
+}
+
+void ModuleItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) {
+    Q_UNUSED(widget);
+    FrameStats::Timer timer(FrameStats::Modules);
+    painter->setPen(pen());
+    painter->setBrush(brush());
+    painter->drawRect(rect());
+
+    // 缩小到看不清时只画主体
+    const qreal lod = option->levelOfDetailFromTransform(painter->worldTransform());
+    if(!detailVisible || lod < kFullScale)
+        return;
+
+    painter->setBrush(Qt::yellow);
+    for(int i=0; i<ports.size(); ++i)
+        painter->drawEllipse(portLocalPos(i), kPortRadius, kPortRadius);
+
+    // 与原 QGraphicsTextItem 标签位置一致：(10, 10) 加上文档边距
+    painter->setPen(Qt::black);
+    painter->drawStaticText(kLabelPos, label);
+}
+
+void ModuleItem::setName(const QString& name) {
+    moduleName = name;
+    label.setText(name);
+    update();
+}
+
+void ModuleItem::setDetailVisible(bool visible) {
+    if (detailVisible == visible)
+        return;
+    detailVisible = visible;
+    update();
+}
+
+void ModuleItem::attachEdge(EdgeLayer* layer, int edge, int portId, bool atStart, const QPointF& offset) {
+    incidentEdges.append({layer, edge, portId, atStart, offset});
+}
+
+void ModuleItem::addFollower(QGraphicsItem* item) {
+    followers.append(item);
+}
+
+QVariant ModuleItem::itemChange(GraphicsItemChange change, const QVariant& value) {
+    if (change == ItemPositionHasChanged) {
+        // 只改接在本模块上的连线，代价与度数成正比
+        for (const IncidentEdge& e : incidentEdges) {
+            const QPointF p = (e.port >= 0 ? getPortPos(e.port) : sceneBoundingRect().center()) + e.offset;
+            QLineF line = e.layer->line(e.edge);
+            if (e.atStart)
+                line.setP1(p);
+            else
+                line.setP2(p);
+            e.layer->setLine(e.edge, line);
+        }
+        const QPointF delta = pos() - lastPos;
+        for (QGraphicsItem* item : followers)
+            item->moveBy(delta.x(), delta.y());
+        lastPos = pos();
+    }
+    return QGraphicsRectItem::itemChange(change, value);
+}
+
+void ModuleItem::hoverMoveEvent(QGraphicsSceneHoverEvent* event) {
+    QGraphicsRectItem::hoverMoveEvent(event);
+    const int port = portAt(event->pos());
+    if (port == hoveredPort)
+        return;
+    hoveredPort = port;
+    static const char* const sides[] = {"左", "右", "上", "下"};
+    setToolTip(port >= 0 ? QString("%1 端口%2 (%3侧)").arg(moduleName).arg(port).arg(sides[ports[port]])
+                         : QString());
+}
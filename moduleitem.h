@@ -1,47 +1,78 @@
-#ifndef MODULEITEM_H
-#define MODULEITEM_H
-
-#include <QGraphicsRectItem>
-#include <QVector>
-#include <QDialog> // 添加对话框支持
-#include <QLabel> // 添加标签支持
-
-// 前置声明
-class ModuleDetailsDialog;
-
-class ModuleItem : public QGraphicsRectItem {
-public:
-    enum PortPosition { Left, Right, Top, Bottom };
-    explicit ModuleItem(const QString& name, qreal x, qreal y,
-                        qreal w = 100, qreal h = 60);
-    void setSize(qreal width, qreal height);
-    void addPort(PortPosition pos);
-    QPointF getPortPos(int portId) const;
-    void setName(const QString& name);
-    void setInfoText(const QString& text); // 新增：设置详细信息文本
-
-    // 新添加的获取端口数量方法
-    int getPortsCount() const { return ports.size(); }
-
-    // 新添加的设置画刷方法
-    void setBrush(const QBrush& brush) {
-        QGraphicsRectItem::setBrush(brush);
-    }
-
-protected:
-    // 重写鼠标点击事件
-    void mousePressEvent(QGraphicsSceneMouseEvent* event) override;
-
-private:
-    struct Port {
-        QGraphicsEllipseItem* shape;
-        PortPosition position;
-    };
-    QVector<Port> ports;
-    QString moduleName;
-    QString infoText; // 新增：存储详细信息文本
-    QGraphicsTextItem* label;
-    void updatePortPositions();
-};
-
-#endif // MODULEITEM_H
+#ifndef MODULEITEM_H
+#define MODULEITEM_H
+
+#include <QGraphicsRectItem>
+#include <QVector>
+#include <QStaticText>
+
+// 前置声明
+class EdgeLayer;
+
+// 模块图元：主体、端口和名称都在一次 paint() 里画出，不再为每个端口和标签各建子图元
+// 端口只记录所在的边，位置按矩形尺寸现算；名称用缓存排版结果的 QStaticText
+// 模块可以拖动：每个模块记下接在自己端口上的连线，移动时只更新这些连线和跟随的标签
+// 模块不保存详情文本；点击后由视图查出对应的模型对象，交给检查面板现取现显示
+class ModuleItem : public QGraphicsRectItem {
+public:
+    enum { Type = UserType + 1 };   // 供 qgraphicsitem_cast 识别
+    enum PortPosition { Left, Right, Top, Bottom };
+    static constexpr qreal kPortRadius = 4;
+    static constexpr QPointF kLabelPos = QPointF(14, 14);   // 模块名左上角的局部坐标
+    explicit ModuleItem(const QString& name, qreal x, qreal y,
+                        qreal w = 100, qreal h = 60);
+    void setSize(qreal width, qreal height);
+    void addPort(PortPosition pos);
+    QPointF getPortPos(int portId) const;
+    int portIndex(PortPosition pos) const; // 第一个位于该侧的端口，没有返回 -1
+    int portAt(const QPointF& localPos) const; // 局部坐标处的端口，没有返回 -1
+    void setName(const QString& name);
+    const QString& name() const { return moduleName; }
+    void setDetailVisible(bool visible);   // 缩小时隐藏端口和模块名
+
+    // 登记一条接在端口 portId（-1 为模块中心）上的连线，atStart 表示连线起点在此，
+    // offset 为端点相对端口的固定偏移（如双向连线错开的距离）
+    void attachEdge(EdgeLayer* layer, int edge, int portId, bool atStart,
+                    const QPointF& offset = QPointF());
+    // 随模块一起移动的图元（统计标签等不是子图元的说明文字）
+    void addFollower(QGraphicsItem* item);
+
+    // 新添加的获取端口数量方法
+    int getPortsCount() const { return ports.size(); }
+
+    // 新添加的设置画刷方法
+    void setBrush(const QBrush& brush) {
+        QGraphicsRectItem::setBrush(brush);
+    }
+
+    int type() const override { return Type; }
+    QRectF boundingRect() const override;
+    QPainterPath shape() const override;
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option,
+               QWidget* widget = nullptr) override;
+
+protected:
+    void hoverMoveEvent(QGraphicsSceneHoverEvent* event) override;
+    QVariant itemChange(GraphicsItemChange change, const QVariant& value) override;
+
+private:
+    QPointF portLocalPos(int portId) const;
+
+    struct IncidentEdge {
+        EdgeLayer* layer;
+        int edge;
+        int port;
+        bool atStart;
+        QPointF offset;
+    };
+    QVector<IncidentEdge> incidentEdges;
+    QVector<QGraphicsItem*> followers;
+    QPointF lastPos;          // 上次通知移动时的位置，用于平移跟随的图元
+
+    QVector<quint8> ports;    // 各端口所在的边（PortPosition）
+    QString moduleName;
+    QStaticText label;
+    bool detailVisible = true;
+    int hoveredPort = -1;
+};
+
+#endif // MODULEITEM_H
@@ -0,0 +1,162 @@
+// packetlayer.cpp
+#include "packetlayer.h"
+#include "framestats.h"
+#include <QLineF>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+namespace {
+const qreal kPacketPixels = 4;    // 包在屏幕上的边长，与缩放无关
+}
+
+PacketLayer::PacketLayer(QGraphicsItem* parent)
+    : QGraphicsItem(parent)
+{
+    // 只画露出部分里的包
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+    routeBegin.append(0);
+}
+
+void PacketLayer::setRouteFunction(const RouteFunction& route) {
+    this->route = route;
+    clear();
+}
+
+void PacketLayer::setBounds(const QRectF& bounds) {
+    prepareGeometryChange();
+    this->bounds = bounds;
+}
+
+void PacketLayer::clear() {
+    packets.clear();
+    positions.clear();
+    routeOfPair.clear();
+    routeBegin = {0};
+    routePoints.clear();
+    routeLength.clear();
+    routeHops.clear();
+    compactAt = kMaxRoutePoints;
+    update();
+}
+
+int PacketLayer::routeOf(int fromPort, int toPort) {
+    const qint64 key = (qint64(fromPort) << 32) | quint32(toPort);
+    const auto it = routeOfPair.constFind(key);
+    if (it != routeOfPair.constEnd())
+        return it.value();
+    if (!route || !route(fromPort, toPort, scratch) || scratch.size() < 2) {
+        routeOfPair.insert(key, -1);   // 不可达的端口对也记下，不再重复求路由
+        return -1;
+    }
+    if (routePoints.size() + scratch.size() > compactAt)
+        compactRoutes();
+    const int r = int(routeHops.size());
+    qreal length = 0;
+    for (int i = 0; i < scratch.size(); ++i) {
+        if (i > 0)
+            length += QLineF(scratch[i - 1], scratch[i]).length();
+        routePoints.append(scratch[i]);
+        routeLength.append(length);
+    }
+    // 折线为 源 → (每条连线两端) → 目的
+    routeHops.append(qMax(1, int(scratch.size() - 2) / 2));
+    routeBegin.append(qint32(routePoints.size()));
+    routeOfPair.insert(key, r);
+    return r;
+}
+
+// 只保留在途的包还在用的折线，编号随之重排
+void PacketLayer::compactRoutes() {
+    QVector<qint32> remap(routeHops.size(), -1);
+    QVector<qint32> begin = {0};
+    QVector<QPointF> points;
+    QVector<qreal> length;
+    QVector<qint32> hops;
+    for (Packet& p : packets) {
+        qint32& to = remap[p.route];
+        if (to < 0) {
+            to = qint32(hops.size());
+            for (int i = routeBegin[p.route]; i < routeBegin[p.route + 1]; ++i) {
+                points.append(routePoints[i]);
+                length.append(routeLength[i]);
+            }
+            hops.append(routeHops[p.route]);
+            begin.append(qint32(points.size()));
+        }
+        p.route = to;
+    }
+    for (auto it = routeOfPair.begin(); it != routeOfPair.end();) {
+        if (it.value() >= 0 && remap[it.value()] >= 0) {
+            it.value() = remap[it.value()];
+            ++it;
+        } else {
+            it = routeOfPair.erase(it);
+        }
+    }
+    routeBegin = begin;
+    routePoints = points;
+    routeLength = length;
+    routeHops = hops;
+    compactAt = qMax<qsizetype>(kMaxRoutePoints, routePoints.size() * 2);
+}
+
+bool PacketLayer::add(const BusEvent& event) {
+    const int r = routeOf(event.fromPort, event.toPort);
+    if (r < 0)
+        return false;
+    const quint64 hopTicks = qMax<quint64>(1, event.hopTicks);
+    packets.append({event.tick, hopTicks * quint64(routeHops[r]), r});
+    return true;
+}
+
+void PacketLayer::advance(quint64 tick) {
+    // 到达的包与末尾交换后移除，不搬动其余的包
+    qsizetype n = packets.size();
+    positions.resize(n);
+    for (qsizetype i = 0; i < n;) {
+        const Packet& p = packets[i];
+        if (tick >= p.start + p.duration) {
+            packets[i] = packets[--n];
+            continue;
+        }
+        // 沿折线匀速前进：按走过的长度找到所在的一段再插值
+        const int begin = routeBegin[p.route];
+        const int end = routeBegin[p.route + 1];
+        const qreal distance = tick > p.start
+                                   ? routeLength[end - 1] * qreal(tick - p.start) / qreal(p.duration)
+                                   : 0;
+        int k = begin + 1;
+        while (k < end - 1 && routeLength[k] < distance)
+            ++k;
+        const qreal span = routeLength[k] - routeLength[k - 1];
+        const qreal t = span > 0 ? (distance - routeLength[k - 1]) / span : 0;
+        positions[i] = routePoints[k - 1] + (routePoints[k] - routePoints[k - 1]) * t;
+        ++i;
+    }
+    packets.resize(n);
+    positions.resize(n);
+    update();
+}
+
+QRectF PacketLayer::boundingRect() const {
+    return bounds;
+}
+
+void PacketLayer::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget*) {
+    FrameStats::Timer timer(FrameStats::Packets);
+    if (positions.isEmpty())
+        return;
+    const qreal lod = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    const qreal size = kPacketPixels / qMax<qreal>(lod, 1e-6);
+    const QRectF visible = option->exposedRect.adjusted(-size, -size, size, size);
+    rects.clear();
+    for (const QPointF& p : positions) {
+        if (visible.contains(p))
+            rects.append(QRectF(p.x() - size / 2, p.y() - size / 2, size, size));
+    }
+    // 方块不需要抗锯齿；画家状态由场景在每个图元前后保存恢复
+    painter->setRenderHint(QPainter::Antialiasing, false);
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(color);
+    painter->drawRects(rects.constData(), int(rects.size()));
+}
@@ -0,0 +1,64 @@
+// packetlayer.h
+#ifndef PACKETLAYER_H
+#define PACKETLAYER_H
+#include <QColor>
+#include <QGraphicsItem>
+#include <QHash>
+#include <QVector>
+#include <functional>
+#include "busevents.h"
+
+// 回放时在途的包，全部画在同一个图元里
+// 包只记注入时刻、每跳周期和所走的折线，位置在 advance 时按当前 tick 现算；
+// 折线按（源端口, 目的端口）缓存，缓存过大时只保留在途的包还在用的折线，内存与回放多久无关。
+// 绘制时所有包的方块一次 drawRects 画出
+class PacketLayer : public QGraphicsItem {
+public:
+    // 端口到端口的折线，不可达返回 false
+    using RouteFunction = std::function<bool(int fromPort, int toPort, QVector<QPointF>& points)>;
+    static const int kMaxRoutePoints = 1 << 20;   // 缓存的折线顶点数上限（约 24 MB）
+
+    explicit PacketLayer(QGraphicsItem* parent = nullptr);
+
+    void setRouteFunction(const RouteFunction& route);
+    // 场景的范围；包只在其中移动
+    void setBounds(const QRectF& bounds);
+    void setColor(const QColor& color) { this->color = color; }
+    // 去掉在途的包与缓存的折线（模块被拖动之后折线也会过时）
+    void clear();
+
+    // 注入一个包，不可达的包丢弃并返回 false
+    bool add(const BusEvent& event);
+    // 推进到 tick：到达的包移除，其余的算出位置
+    void advance(quint64 tick);
+    int inFlight() const { return int(packets.size()); }
+
+    QRectF boundingRect() const override;
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option,
+               QWidget* widget = nullptr) override;
+
+private:
+    struct Packet {
+        quint64 start;
+        quint64 duration;        // 跳数 × 每跳周期
+        qint32 route;            // routeBegin 的下标
+    };
+    int routeOf(int fromPort, int toPort);
+    void compactRoutes();
+
+    RouteFunction route;
+    QVector<Packet> packets;
+    QVector<QPointF> positions;      // 对应 packets，advance 时更新
+    QHash<qint64, int> routeOfPair;
+    QVector<qint32> routeBegin;      // 折线 r 的顶点为 routePoints[routeBegin[r], routeBegin[r + 1])
+    QVector<QPointF> routePoints;
+    QVector<qreal> routeLength;      // 对应 routePoints，从折线起点到该顶点的长度
+    QVector<qint32> routeHops;       // 折线经过的连线数，至少为 1
+    qsizetype compactAt = kMaxRoutePoints;  // 顶点数超过此值时整理；在途的包本身就用了很多折线时随之放宽
+    QVector<QPointF> scratch;
+    QVector<QRectF> rects;           // 绘制时重用
+    QRectF bounds;
+    QColor color = Qt::red;
+};
+
+#endif // PACKETLAYER_H
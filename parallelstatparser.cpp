@@ -0,0 +1,223 @@
+// parallelstatparser.cpp
+#include "parallelstatparser.h"
+#include "statparser.h"
+#include "textscan.h"
+#include <QFile>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentMap>
+#include <numeric>
+
+namespace {
+
+// 小文件不值得切块
+const qsizetype kMinParallelSize = 4 << 20;
+// 在目标切点之后最多向后找这么远的段边界，找不到就在行边界切
+const qsizetype kBoundaryWindow = 1 << 20;
+// 续接块中用于占位的模块ID：合并时替换为前一块最后所在的模块
+const int kInheritedModule = 0;
+
+struct Chunk {
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    bool continuation = false;   // 是否从段中间开始
+    CounterStore store;
+    int lastModule = -1;         // 解析结束时所在的模块（局部ID）
+    bool ok = false;
+};
+
+bool isBlank(TextScan::Span line) {
+    return TextScan::trimmed(line).isEmpty();
+}
+
+// 从 pos 开始找下一个切点，返回切点并指出是否落在段中间
+const char* findBoundary(const char* pos, const char* end, bool& continuation) {
+    // 先对齐到行首
+    const char* p = pos;
+    if (p > end) p = end;
+    const char* nl = static_cast<const char*>(memchr(p, '\n', size_t(end - p)));
+    p = nl ? nl + 1 : end;
+    const char* firstLine = p;
+
+    const char* windowEnd = qMin(end, p + kBoundaryWindow);
+    bool previousBlank = false;
+    while (p < windowEnd) {
+        const char* lineStart = p;
+        const TextScan::Span line = TextScan::nextLine(p, end);
+        if (previousBlank && StatParser::isSectionHeader(line.begin, line.size())) {
+            continuation = false;
+            return lineStart;
+        }
+        previousBlank = isBlank(line);
+    }
+    continuation = true;
+    return firstLine;
+}
+
+} // namespace
+
+bool ParallelStatParser::parseFile(const QString& path, CounterStore& out,
+                                   QString* errorMessage, QThreadPool* pool) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorMessage)
+            *errorMessage = QString("无法打开 %1: %2").arg(path, file.errorString());
+        return false;
+    }
+    out.clear();
+    const qint64 size = file.size();
+    if (size == 0)
+        return true;
+
+    const uchar* data = file.map(0, size);
+    if (!data) {
+        const QByteArray all = file.readAll();
+        return parse(all.constData(), all.size(), out, errorMessage, pool);
+    }
+    const bool ok = parse(reinterpret_cast<const char*>(data), qsizetype(size), out, errorMessage, pool);
+    file.unmap(const_cast<uchar*>(data));
+    return ok;
+}
+
+bool ParallelStatParser::parse(const char* data, qsizetype size, CounterStore& out,
+                               QString* errorMessage, QThreadPool* pool) {
+    out.clear();
+    if (!pool)
+        pool = QThreadPool::globalInstance();
+    const int threads = qMax(1, pool->maxThreadCount());
+    if (threads == 1 || size < kMinParallelSize) {
+        out.reserveRows(int(qMin<qsizetype>(size / 40, 1 << 28)));
+        return StatParser::parse(data, size, out, errorMessage);
+    }
+
+    // ============== 切块 ==============
+    // 每个线程分到约4块，便于负载均衡
+    const int target = threads * 4;
+    const char* end = data + size;
+    QVector<Chunk> chunks;
+    chunks.reserve(target);
+    const char* begin = data;
+    bool continuation = false;
+    for (int i = 1; i < target && begin < end; ++i) {
+        const char* want = data + size / target * i;
+        if (want <= begin)
+            continue;
+        bool nextContinuation = false;
+        const char* cut = findBoundary(want, end, nextContinuation);
+        if (cut <= begin || cut >= end)
+            continue;
+        Chunk c;
+        c.begin = begin;
+        c.end = cut;
+        c.continuation = continuation;
+        chunks.append(std::move(c));
+        begin = cut;
+        continuation = nextContinuation;
+    }
+    Chunk last;
+    last.begin = begin;
+    last.end = end;
+    last.continuation = continuation;
+    chunks.append(std::move(last));
+
+    // ============== 并行解析各块 ==============
+    QtConcurrent::blockingMap(pool, chunks, [](Chunk& c) {
+        c.store.reserveRows(int(qMin<qsizetype>((c.end - c.begin) / 40, 1 << 28)));
+        if (c.continuation) {
+            // 局部ID 0 预留给继承来的模块
+            c.store.addModule("", 0, 0);
+            c.lastModule = kInheritedModule;
+        }
+        c.ok = StatParser::parse(c.begin, c.end - c.begin, c.store, nullptr, &c.lastModule);
+    });
+
+    for (const Chunk& c : chunks) {
+        if (!c.ok) {
+            // 出错时顺序重解析一遍，以得到准确的行号
+            out.clear();
+            return StatParser::parse(data, size, out, errorMessage);
+        }
+    }
+
+    // ============== 按块顺序驻留名称 ==============
+    const int chunkCount = int(chunks.size());
+    QVector<QVector<int>> moduleMap(chunkCount);
+    QVector<QVector<int>> counterMap(chunkCount);
+    QVector<int> rowOffset(chunkCount + 1, 0);
+    int inherited = -1;
+    for (int i = 0; i < chunkCount; ++i) {
+        const CounterStore& local = chunks[i].store;
+        QVector<int>& modules = moduleMap[i];
+        modules.resize(local.modules.size());
+        for (int m = 0; m < local.modules.size(); ++m) {
+            if (chunks[i].continuation && m == kInheritedModule) {
+                modules[m] = inherited;
+                continue;
+            }
+            const QByteArray& name = local.modules.at(m);
+            modules[m] = out.addModule(name.constData(), name.size(), local.moduleLatency[m]);
+        }
+        QVector<int>& counters = counterMap[i];
+        counters.resize(local.counters.size());
+        for (int c = 0; c < local.counters.size(); ++c) {
+            const QByteArray& name = local.counters.at(c);
+            counters[c] = out.addCounter(name.constData(), name.size());
+            if (local.counterIsReal[c])
+                out.counterIsReal[counters[c]] = 1;
+        }
+        if (chunks[i].lastModule >= 0)
+            inherited = modules[chunks[i].lastModule];
+        rowOffset[i + 1] = rowOffset[i] + local.rowCount();
+    }
+
+    // ============== 并行拷贝各列 ==============
+    const int totalRows = rowOffset[chunkCount];
+    out.resizeRows(totalRows);
+    qint32* outModule = out.rowModule.data();
+    qint32* outCounter = out.rowCounter.data();
+    qint32* outIndex0 = out.rowIndex0.data();
+    qint32* outIndex1 = out.rowIndex1.data();
+    double* outValues = out.values.data();
+    QVector<quint32> rowHashes(totalRows);
+    quint32* hashes = rowHashes.data();
+
+    QVector<int> chunkIds(chunkCount);
+    std::iota(chunkIds.begin(), chunkIds.end(), 0);
+    QtConcurrent::blockingMap(pool, chunkIds, [&](int& i) {
+        const CounterStore& local = chunks[i].store;
+        const int* modules = moduleMap[i].constData();
+        const int* counters = counterMap[i].constData();
+        const int rows = local.rowCount();
+        const int offset = rowOffset[i];
+        for (int r = 0; r < rows; ++r) {
+            outModule[offset + r] = modules[local.rowModule[r]];
+            outCounter[offset + r] = counters[local.rowCounter[r]];
+        }
+        memcpy(outIndex0 + offset, local.rowIndex0.constData(), size_t(rows) * sizeof(qint32));
+        memcpy(outIndex1 + offset, local.rowIndex1.constData(), size_t(rows) * sizeof(qint32));
+        memcpy(outValues + offset, local.values.constData(), size_t(rows) * sizeof(double));
+        // 顺便算好每行的哈希，重建索引时各分片只需读这一列
+        for (int r = offset; r < offset + rows; ++r)
+            hashes[r] = out.rowHash(r);
+    });
+    chunks.clear();
+
+    // ============== 并行重建索引并消除跨块重复 ==============
+    QVector<qint32> duplicateOf(totalRows, -1);
+    QVector<int> shards(CounterStore::kIndexShards);
+    std::iota(shards.begin(), shards.end(), 0);
+    QVector<int> shardHasDuplicates(CounterStore::kIndexShards, 0);
+    qint32* duplicates = duplicateOf.data();
+    int* hasDuplicates = shardHasDuplicates.data();
+    QtConcurrent::blockingMap(pool, shards, [&](int& shard) {
+        hasDuplicates[shard] = out.rebuildIndexShard(shard, duplicates, hashes) ? 1 : 0;
+    });
+
+    if (shardHasDuplicates.contains(1)) {
+        // 跨块重复（如多个快照中的同一计数器）：首行已持有最后的值，删除其余行后重建索引
+        out.removeDuplicateRows(duplicates);
+        QtConcurrent::blockingMap(pool, shards, [&](int& shard) {
+            out.rebuildIndexShard(shard);
+        });
+    }
+    return true;
+}
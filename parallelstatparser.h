@@ -0,0 +1,24 @@
+// parallelstatparser.h
+#ifndef PARALLELSTATPARSER_H
+#define PARALLELSTATPARSER_H
+#include <QString>
+#include "counterstore.h"
+
+class QThreadPool;
+
+// 多线程解析 statistic.txt
+// 文件整体映射后按段边界（"Name Latency:N" 之前的空行）切块；
+// 单个段过大时退而在行边界切开，续接的块继承前一块最后所在的模块。
+// 各块在线程池上解析到各自的 CounterStore，再按块顺序合并：
+// 名称按块顺序驻留、各列并行拷贝、索引按分片并行重建并消除跨块重复，
+// 结果（包括各ID与行的顺序）与 StatParser 顺序解析完全一致。
+class ParallelStatParser {
+public:
+    // pool 为空时使用 QThreadPool::globalInstance()，其 maxThreadCount 决定并行度
+    static bool parseFile(const QString& path, CounterStore& out,
+                          QString* errorMessage = nullptr, QThreadPool* pool = nullptr);
+    static bool parse(const char* data, qsizetype size, CounterStore& out,
+                      QString* errorMessage = nullptr, QThreadPool* pool = nullptr);
+};
+
+#endif // PARALLELSTATPARSER_H
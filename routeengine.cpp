@@ -0,0 +1,372 @@
+// routeengine.cpp
+#include "routeengine.h"
+#include "counterstore.h"
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtMath>
+#include <algorithm>
+
+namespace {
+
+// 每个任务负责的源节点数；BFS 的临时数组按任务分配，各任务互不共享
+const int kSourcesPerChunk = 32;
+
+// 各任务的部分和，最后按任务顺序相加，结果与线程数无关
+struct SourceChunk {
+    int begin;
+    int end;
+    QVector<double> edgeLoad;
+    double routed = 0;
+    double unrouted = 0;
+    double hopPackets = 0;     // 包数 * 跳数
+};
+
+} // namespace
+
+double RouteLoad::score(int edge) const {
+    if (measuredBusy[edge] >= 0)
+        return measuredBusy[edge];
+    if (predictedBusy[edge] >= 0)
+        return predictedBusy[edge];
+    return edgeLoad[edge];
+}
+
+void RouteEngine::setTopology(const Topology& t) {
+    trees.clear();
+    nodes = t.nodeCount;
+    edges = t.edges;
+    nodeOfPort = t.nodeOfPort;
+    outBegin.fill(0, nodes + 1);
+    for (const BusEdge& e : edges) {
+        if (e.from >= 0 && e.from < nodes && e.to >= 0 && e.to < nodes)
+            ++outBegin[e.from + 1];
+    }
+    for (int i = 0; i < nodes; ++i)
+        outBegin[i + 1] += outBegin[i];
+    outEdges.resize(outBegin[nodes]);
+    QVector<int> next(outBegin.begin(), outBegin.end() - 1);
+    for (int i = 0; i < edges.size(); ++i) {
+        const BusEdge& e = edges[i];
+        if (e.from >= 0 && e.from < nodes && e.to >= 0 && e.to < nodes)
+            outEdges[next[e.from]++] = i;
+    }
+}
+
+void RouteEngine::bfs(int source, QVector<int>& parentEdge, QVector<int>& order,
+                      QVector<int>& depth) const {
+    parentEdge.fill(-1, nodes);
+    depth.fill(-1, nodes);
+    order.clear();
+    depth[source] = 0;
+    order.append(source);
+    for (int i = 0; i < order.size(); ++i) {
+        const int u = order[i];
+        for (int a = outBegin[u]; a < outBegin[u + 1]; ++a) {
+            const int v = edges[outEdges[a]].to;
+            if (depth[v] >= 0)
+                continue;
+            depth[v] = depth[u] + 1;
+            parentEdge[v] = outEdges[a];
+            order.append(v);
+        }
+    }
+}
+
+QVector<int> RouteEngine::route(int fromNode, int toNode) const {
+    QVector<int> path;
+    if (fromNode < 0 || fromNode >= nodes || toNode < 0 || toNode >= nodes || fromNode == toNode)
+        return path;
+    QVector<int> parentEdge, order, depth;
+    bfs(fromNode, parentEdge, order, depth);
+    for (int v = toNode; parentEdge[v] >= 0; v = edges[parentEdge[v]].from)
+        path.append(parentEdge[v]);
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+RouteLoad RouteEngine::project(const CounterStore& store, QThreadPool* pool) const {
+    if (!pool)
+        pool = QThreadPool::globalInstance();
+    RouteLoad out;
+    const int edgeCount = int(edges.size());
+    out.edgeLoad.fill(0, edgeCount);
+    out.measuredBusy.fill(-1, edgeCount);
+    out.predictedBusy.fill(-1, edgeCount);
+    if (nodes == 0)
+        return out;
+
+    // ============== 取出流量与实测使用率 ==============
+    // 流量按源节点做计数排序，每个源节点的流量连续存放
+    const int flowCounter = store.findCounter("transmit_package_number_from_#_to_#");
+    const int busyCounter = store.findCounter("edge_#_to_#_busy_rate");
+    QHash<qint64, int> edgeOfPair;
+    for (int i = 0; i < edgeCount; ++i)
+        edgeOfPair.insert((qint64(edges[i].from) << 32) | quint32(edges[i].to), i);
+    QVector<int> flowSource, flowTarget;
+    QVector<double> flowPackets;
+    const int rows = store.rowCount();
+    for (int r = 0; r < rows; ++r) {
+        const int counter = store.rowCounter[r];
+        if (counter != flowCounter && counter != busyCounter)
+            continue;
+        const int index0 = store.rowIndex0[r];
+        const int index1 = store.rowIndex1[r];
+        if (index0 < 0 || index1 < 0)
+            continue;
+        if (counter == busyCounter) {
+            const int edge = edgeOfPair.value((qint64(index0) << 32) | quint32(index1), -1);
+            if (edge >= 0)
+                out.measuredBusy[edge] = store.values[r];
+            continue;
+        }
+        const double packets = store.values[r];
+        if (!(packets > 0))
+            continue;
+        out.flowRows.append(r);
+        out.flowPackets.append(packets);
+        const int source = nodeOfPort.value(index0, -1);
+        const int target = nodeOfPort.value(index1, -1);
+        if (source < 0 || target < 0 || source >= nodes || target >= nodes) {
+            out.unroutedPackets += packets;
+            continue;
+        }
+        flowSource.append(source);
+        flowTarget.append(target);
+        flowPackets.append(packets);
+    }
+    const int flows = int(flowPackets.size());
+    QVector<int> flowBegin(nodes + 1, 0);
+    for (int f = 0; f < flows; ++f)
+        ++flowBegin[flowSource[f] + 1];
+    for (int i = 0; i < nodes; ++i)
+        flowBegin[i + 1] += flowBegin[i];
+    QVector<int> bySource(flows);
+    {
+        QVector<int> next(flowBegin.begin(), flowBegin.end() - 1);
+        for (int f = 0; f < flows; ++f)
+            bySource[next[flowSource[f]]++] = f;
+    }
+
+    // ============== 每个源节点一次 BFS，在树上自底向上累加 ==============
+    QVector<SourceChunk> chunks;
+    for (int b = 0; b < nodes; b += kSourcesPerChunk)
+        chunks.append({b, qMin(nodes, b + kSourcesPerChunk), QVector<double>()});
+    QtConcurrent::blockingMap(pool, chunks, [&](SourceChunk& c) {
+        c.edgeLoad.fill(0, edgeCount);
+        QVector<int> parentEdge, order, depth;
+        QVector<double> carried(nodes, 0);
+        for (int s = c.begin; s < c.end; ++s) {
+            if (flowBegin[s] == flowBegin[s + 1])
+                continue;
+            bfs(s, parentEdge, order, depth);
+            for (int i = flowBegin[s]; i < flowBegin[s + 1]; ++i) {
+                const int f = bySource[i];
+                const int target = flowTarget[f];
+                if (depth[target] < 0) {
+                    c.unrouted += flowPackets[f];
+                    continue;
+                }
+                carried[target] += flowPackets[f];
+                c.routed += flowPackets[f];
+                c.hopPackets += flowPackets[f] * depth[target];
+            }
+            // 逆 BFS 顺序：子节点先于父节点，carried[v] 即经过进入 v 的连线的流量
+            for (int i = int(order.size()) - 1; i > 0; --i) {
+                const int v = order[i];
+                if (carried[v] == 0)
+                    continue;
+                const int edge = parentEdge[v];
+                c.edgeLoad[edge] += carried[v];
+                carried[edges[edge].from] += carried[v];
+                carried[v] = 0;
+            }
+            carried[s] = 0;
+        }
+    });
+    for (const SourceChunk& c : chunks) {
+        for (int e = 0; e < edgeCount; ++e)
+            out.edgeLoad[e] += c.edgeLoad[e];
+        out.routedPackets += c.routed;
+        out.unroutedPackets += c.unrouted;
+        out.hopPackets += c.hopPackets;
+    }
+    out.meanHops = out.routedPackets > 0 ? out.hopPackets / out.routedPackets : 0;
+
+    collectTopFlows(out, store);
+    rank(out);
+    return out;
+}
+
+// ============== 最大的几股跨节点流量 ==============
+// 从记下的流量行中选，包数相同时行号小的在前
+void RouteEngine::collectTopFlows(RouteLoad& load, const CounterStore& store) const {
+    QVector<int> remote;
+    for (int i = 0; i < load.flowRows.size(); ++i) {
+        const qint32 r = load.flowRows[i];
+        const int source = nodeOfPort.value(store.rowIndex0[r], -1);
+        const int target = nodeOfPort.value(store.rowIndex1[r], -1);
+        if (load.flowPackets[i] > 0 && source >= 0 && target >= 0 && source < nodes && target < nodes
+            && source != target)
+            remote.append(i);
+    }
+    const int top = qMin(int(remote.size()), kTopFlows);
+    std::partial_sort(remote.begin(), remote.begin() + top, remote.end(), [&](int a, int b) {
+        return load.flowPackets[a] > load.flowPackets[b] || (load.flowPackets[a] == load.flowPackets[b] && a < b);
+    });
+    load.topFlows.clear();
+    for (int i = 0; i < top; ++i) {
+        const qint32 r = load.flowRows[remote[i]];
+        load.topFlows.append({store.rowIndex0[r], store.rowIndex1[r], load.flowPackets[remote[i]], r});
+    }
+}
+
+const RouteEngine::SourceTree& RouteEngine::treeFor(int source) {
+    auto it = trees.constFind(source);
+    if (it != trees.constEnd())
+        return it.value();
+    if (trees.size() >= kCachedTrees)
+        trees.clear();
+    SourceTree& tree = trees[source];
+    QVector<int> order;
+    bfs(source, tree.parentEdge, order, tree.depth);
+    return tree;
+}
+
+void RouteEngine::applyFlowChanges(RouteLoad& load, const CounterStore& store, const QVector<qint32>& rows) {
+    struct Change {
+        int source;
+        int target;
+        double packets;
+    };
+    QVector<Change> changes;
+    // 最大的几股流量：只有其中某股变小时才要在全部流量行中重选，
+    // 其余变化只可能让变大的流量挤进来，与原来的几股合在一起重排即可
+    const bool topFull = load.topFlows.size() == kTopFlows;
+    const double topFloor = topFull ? load.topFlows.last().packets : 0;
+    bool topShrunk = false;
+    QVector<RouteLoad::Flow> raised;
+    for (const qint32 r : rows) {
+        const int fromPort = store.rowIndex0[r];
+        const int toPort = store.rowIndex1[r];
+        if (fromPort < 0 || toPort < 0)
+            continue;
+        const double packets = store.values[r] > 0 ? store.values[r] : 0;
+        const int i = int(std::lower_bound(load.flowRows.cbegin(), load.flowRows.cend(), r)
+                          - load.flowRows.cbegin());
+        double before = 0;
+        if (i < load.flowRows.size() && load.flowRows[i] == r) {
+            before = load.flowPackets[i];
+            load.flowPackets[i] = packets;
+        } else if (packets > 0) {
+            // 新出现的流量行，行号大多在末尾
+            load.flowRows.insert(i, r);
+            load.flowPackets.insert(i, packets);
+        }
+        const double delta = packets - before;
+        if (delta == 0)
+            continue;
+        const int source = nodeOfPort.value(fromPort, -1);
+        const int target = nodeOfPort.value(toPort, -1);
+        if (source < 0 || target < 0 || source >= nodes || target >= nodes) {
+            load.unroutedPackets += delta;
+            continue;
+        }
+        if (source != target) {
+            bool inTop = false;
+            for (const RouteLoad::Flow& flow : load.topFlows)
+                inTop = inTop || flow.row == r;
+            if (inTop && delta < 0)
+                topShrunk = true;
+            else if (packets > 0 && (inTop || !topFull || packets >= topFloor))
+                raised.append({fromPort, toPort, packets, r});
+        }
+        changes.append({source, target, delta});
+    }
+
+    // 同一源节点的变化共用一棵 BFS 树，差额沿树从目的走回源节点
+    std::stable_sort(changes.begin(), changes.end(),
+                     [](const Change& a, const Change& b) { return a.source < b.source; });
+    for (int i = 0; i < changes.size();) {
+        const int source = changes[i].source;
+        const SourceTree& tree = treeFor(source);
+        for (; i < changes.size() && changes[i].source == source; ++i) {
+            const Change& c = changes[i];
+            if (tree.depth[c.target] < 0) {
+                load.unroutedPackets += c.packets;
+                continue;
+            }
+            load.routedPackets += c.packets;
+            load.hopPackets += c.packets * tree.depth[c.target];
+            for (int v = c.target; tree.parentEdge[v] >= 0; v = edges[tree.parentEdge[v]].from)
+                load.edgeLoad[tree.parentEdge[v]] += c.packets;
+        }
+    }
+    load.meanHops = load.routedPackets > 0 ? load.hopPackets / load.routedPackets : 0;
+
+    if (topShrunk) {
+        collectTopFlows(load, store);
+    } else if (!raised.isEmpty()) {
+        QVector<RouteLoad::Flow> merged = raised;
+        for (const RouteLoad::Flow& flow : load.topFlows) {
+            bool updated = false;
+            for (const RouteLoad::Flow& other : raised)
+                updated = updated || other.row == flow.row;
+            if (!updated)
+                merged.append(flow);
+        }
+        const int top = qMin(int(merged.size()), kTopFlows);
+        std::partial_sort(merged.begin(), merged.begin() + top, merged.end(),
+                          [](const RouteLoad::Flow& a, const RouteLoad::Flow& b) {
+                              return a.packets > b.packets || (a.packets == b.packets && a.row < b.row);
+                          });
+        merged.resize(top);
+        load.topFlows = merged;
+    }
+}
+
+void RouteEngine::rank(RouteLoad& out) const {
+    const int edgeCount = int(out.edgeLoad.size());
+
+    // ============== 与实测对照 ==============
+    // 最小二乘拟合 实测使用率 ≈ k * 包数，预测使用率即 k * 预测包数
+    double loadBusy = 0, loadSquared = 0;
+    for (int e = 0; e < edgeCount; ++e) {
+        if (out.measuredBusy[e] >= 0 && out.edgeLoad[e] > 0) {
+            loadBusy += out.edgeLoad[e] * out.measuredBusy[e];
+            loadSquared += out.edgeLoad[e] * out.edgeLoad[e];
+        }
+    }
+    out.busyPerPacket = loadSquared > 0 ? loadBusy / loadSquared : 0;
+    for (int e = 0; e < edgeCount; ++e)
+        out.predictedBusy[e] = out.busyPerPacket > 0 ? out.busyPerPacket * out.edgeLoad[e] : -1;
+
+    // ============== 热点连线 ==============
+    double sum = 0, squares = 0;
+    int count = 0;
+    int busiest = -1;
+    for (int e = 0; e < edgeCount; ++e) {
+        const double s = out.score(e);
+        if (edges[e].from == edges[e].to || !(s > 0))
+            continue;
+        sum += s;
+        squares += s * s;
+        ++count;
+        if (busiest < 0 || s > out.score(busiest))
+            busiest = e;
+    }
+    out.hotspots.clear();
+    if (count > 0) {
+        const double mean = sum / count;
+        const double threshold = mean + 2 * qSqrt(qMax(0.0, squares / count - mean * mean));
+        for (int e = 0; e < edgeCount; ++e) {
+            if (edges[e].from != edges[e].to && out.score(e) > threshold)
+                out.hotspots.append(e);
+        }
+        std::stable_sort(out.hotspots.begin(), out.hotspots.end(),
+                         [&](int a, int b) { return out.score(a) > out.score(b); });
+        if (out.hotspots.size() > kMaxHotspots)
+            out.hotspots.resize(kMaxHotspots);
+        if (out.hotspots.isEmpty())
+            out.hotspots.append(busiest);
+    }
+}
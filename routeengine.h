@@ -0,0 +1,84 @@
+// routeengine.h
+#ifndef ROUTEENGINE_H
+#define ROUTEENGINE_H
+#include <QHash>
+#include <QVector>
+#include "topology.h"
+
+class CounterStore;
+class QThreadPool;
+
+// 端口间流量投射到总线连线上的结果
+struct RouteLoad {
+    struct Flow {
+        int fromPort;
+        int toPort;
+        double packets;
+        qint32 row;                  // 流量行，包数相同时行号小的在前
+    };
+
+    QVector<double> edgeLoad;        // Topology::edges -> 按最短路由预测经过的包数
+    QVector<double> measuredBusy;    // Topology::edges -> 实测 edge_A_to_B_busy_rate，没有为 -1
+    QVector<double> predictedBusy;   // 包数按拟合的比例换算成使用率，无法换算为 -1
+    double busyPerPacket = 0;        // 拟合比例：实测使用率 ≈ busyPerPacket * 包数
+    double routedPackets = 0;
+    double unroutedPackets = 0;      // 端口未映射到节点或目的不可达
+    double hopPackets = 0;           // 包数 * 跳数之和
+    double meanHops = 0;             // 按包数加权的平均跳数
+    QVector<int> hotspots;           // 热点连线，由高到低
+    QVector<Flow> topFlows;          // 跨节点的最大几股流量，由大到小
+    // 投射时各流量行（按行号升序）的包数，流量行变化时据此求出差额
+    QVector<qint32> flowRows;
+    QVector<double> flowPackets;
+
+    bool isEmpty() const { return edgeLoad.isEmpty(); }
+    // 热点判定用的负载：有实测用实测，否则用预测
+    double score(int edge) const;
+};
+
+// 总线节点图上的最短路由（逐跳 BFS，出边按 Topology::edges 的顺序，结果确定）
+// 投射时对每个源节点做一次 BFS，在 BFS 树上自底向上累加到各目的的流量，
+// 一次得到该源的全部流量在各连线上的负载；各源节点分块在线程池上并行。
+// 少数流量行变化时只把差额加到各自路由经过的连线上，用到的源节点的 BFS 树留着给之后的变化复用。
+class RouteEngine {
+public:
+    static const int kMaxHotspots = 16;
+    static const int kTopFlows = 3;
+    static const int kCachedTrees = 256;   // 留着的 BFS 树数，超出时全部丢弃
+
+    void setTopology(const Topology& topology);
+    int nodeCount() const { return nodes; }
+
+    // fromNode 到 toNode 依次经过的连线（Topology::edges 下标），不可达或同一节点为空
+    QVector<int> route(int fromNode, int toNode) const;
+
+    // 把 transmit_package_number_from_X_to_Y 投射到连线上，并与 edge_A_to_B_busy_rate 对照
+    RouteLoad project(const CounterStore& store, QThreadPool* pool = nullptr) const;
+    // 只有实测使用率变化时：按 load.measuredBusy 重新拟合预测使用率并重选热点，不重新路由
+    // 热点为负载明显高于其余连线（均值加两倍标准差以上）的连线，最多 kMaxHotspots 条；
+    // 没有这样的连线时取负载最高的一条。
+    void rank(RouteLoad& load) const;
+    // 只有 rows 中的流量行变化时：与 load 中记下的包数相比，把差额加到这些流量路由经过的连线上，
+    // 需要时重选最大的几股流量；不重新拟合（之后调用 rank）
+    void applyFlowChanges(RouteLoad& load, const CounterStore& store, const QVector<qint32>& rows);
+
+private:
+    struct SourceTree {
+        QVector<int> parentEdge;
+        QVector<int> depth;
+    };
+
+    const SourceTree& treeFor(int source);
+    void collectTopFlows(RouteLoad& load, const CounterStore& store) const;
+    // 从 source 出发的 BFS：parentEdge[v] 为树上进入 v 的连线，order 为访问顺序，depth 为跳数
+    void bfs(int source, QVector<int>& parentEdge, QVector<int>& order, QVector<int>& depth) const;
+
+    int nodes = 0;
+    QVector<BusEdge> edges;
+    QVector<int> outBegin;           // CSR：节点 -> outEdges 中的起点，共 nodes + 1 项
+    QVector<int> outEdges;           // 出边的 Topology::edges 下标
+    QVector<int> nodeOfPort;
+    QHash<int, SourceTree> trees;    // 源节点 -> 增量更新用过的 BFS 树
+};
+
+#endif // ROUTEENGINE_H
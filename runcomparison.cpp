@@ -0,0 +1,72 @@
+// runcomparison.cpp
+#include "runcomparison.h"
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtMath>
+
+namespace {
+
+// 每个任务对齐的行数
+const int kRowsPerChunk = 1 << 16;
+
+struct RowChunk {
+    int begin;
+    int end;
+    int matched = 0;
+};
+
+// other 的名称ID -> base 的名称ID，base 中没有为 -1
+QVector<int> mapNames(const StringTable& base, const StringTable& other) {
+    QVector<int> map(other.size());
+    for (int id = 0; id < other.size(); ++id)
+        map[id] = base.find(other.at(id));
+    return map;
+}
+
+} // namespace
+
+void RunComparison::align(const CounterStore& base, const CounterStore& other, QThreadPool* pool) {
+    if (!pool)
+        pool = QThreadPool::globalInstance();
+    // 各列与索引和 base 隐式共享，只有 values 是新的
+    aligned = base;
+    aligned.values.fill(qQNaN(), base.rowCount());
+    const QVector<int> moduleMap = mapNames(base.modules, other.modules);
+    const QVector<int> counterMap = mapNames(base.counters, other.counters);
+
+    QVector<RowChunk> chunks;
+    for (int b = 0; b < other.rowCount(); b += kRowsPerChunk)
+        chunks.append({b, qMin(other.rowCount(), b + kRowsPerChunk)});
+    double* values = aligned.values.data();
+    QtConcurrent::blockingMap(pool, chunks, [&](RowChunk& c) {
+        for (int r = c.begin; r < c.end; ++r) {
+            const int module = moduleMap[other.rowModule[r]];
+            const int counter = counterMap[other.rowCounter[r]];
+            if (module < 0 || counter < 0)
+                continue;
+            const int row = base.findRow(module, counter, other.rowIndex0[r], other.rowIndex1[r]);
+            if (row < 0)
+                continue;
+            values[row] = other.values[r];
+            ++c.matched;
+        }
+    });
+    matchedRows = 0;
+    for (const RowChunk& c : chunks)
+        matchedRows += c.matched;
+    onlyInBase = base.rowCount() - matchedRows;
+    onlyInOther = other.rowCount() - matchedRows;
+    metrics.reset(&aligned);
+}
+
+double RunComparison::otherValue(int row) const {
+    return row < aligned.rowCount() ? aligned.values[row] : qQNaN();
+}
+
+double RunComparison::relativeChange(double before, double after) {
+    if (qIsNaN(before) || qIsNaN(after))
+        return qQNaN();
+    if (before == 0)
+        return after == 0 ? 0 : qQNaN();
+    return (after - before) / qAbs(before);
+}
@@ -0,0 +1,38 @@
+// runcomparison.h
+#ifndef RUNCOMPARISON_H
+#define RUNCOMPARISON_H
+#include <QVector>
+#include "counterstore.h"
+#include "derivedmetrics.h"
+
+class QThreadPool;
+
+// 同一拓扑下两次运行的对比：把 other 的计数器对齐到 base 的行号上
+// 两份存储各自驻留名称，ID 不同：先按名称建一次模块/计数器 ID 对照表（只与名称数有关），
+// 之后逐行用 (模块, 计数器, 下标) 在 base 的哈希索引中查行号，热路径上没有字符串比较。
+// 对齐在线程池上按行分块进行，每行写入的位置互不相同，不需要加锁。
+// aligned 与 base 结构相同（各ID与行号一致），可以直接交给 StatsView/DerivedMetrics 使用。
+class RunComparison {
+public:
+    CounterStore aligned;        // base 的结构，values 为 other 中对应行的值，other 中没有为 NaN
+    DerivedMetrics metrics;      // aligned 上的派生指标
+    int matchedRows = 0;
+    int onlyInBase = 0;          // base 有而 other 没有的行
+    int onlyInOther = 0;         // other 有而 base 没有的行（不显示）
+
+    // 对象创建后不要再移动：metrics 引用着 aligned
+    RunComparison() = default;
+    RunComparison(const RunComparison&) = delete;
+    RunComparison& operator=(const RunComparison&) = delete;
+
+    // pool 为空时使用 QThreadPool::globalInstance()
+    void align(const CounterStore& base, const CounterStore& other, QThreadPool* pool = nullptr);
+
+    // base 第 row 行在 other 中的值，没有为 NaN（base 在对齐之后追加的行也算没有）
+    double otherValue(int row) const;
+
+    // 相对变化 (after - before) / |before|；任一方缺失为 NaN，before 为 0 时只有 after 也为 0 才有定义
+    static double relativeChange(double before, double after);
+};
+
+#endif // RUNCOMPARISON_H
@@ -0,0 +1,1198 @@
+// scenebuilder.cpp
+#include "scenebuilder.h"
+#include "moduleitem.h"
+#include "edgelayer.h"
+#include "counterstore.h"
+#include "layoutengine.h"
+#include "runcomparison.h"
+#include "latencybars.h"
+#include "searchindex.h"
+#include <QGraphicsScene>
+#include <QHash>
+#include <QGraphicsTextItem>
+#include <QGraphicsSimpleTextItem>
+#include <QGraphicsPathItem>
+#include <QPainterPath>
+#include <QPen>
+#include <QFont>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QtMath>
+#include <algorithm>
+
+const QColor SceneBuilder::cpuColor(211, 211, 211);      // CPU灰色
+const QColor SceneBuilder::l1Color(255, 215, 0);         // L1黄金色
+const QColor SceneBuilder::l2Color(30, 144, 255);        // L2道奇蓝
+const QColor SceneBuilder::l3Color(50, 205, 50);         // L3酸橙绿
+const QColor SceneBuilder::memColor(255, 99, 71);        // 内存番茄红
+const QColor SceneBuilder::routerColor(240, 248, 255);   // 路由器爱丽丝蓝
+const QColor SceneBuilder::busyPathColor(220, 20, 60);   // 高负载路径深红
+const QColor SceneBuilder::flowPathColor(106, 90, 205);  // 流量路径紫罗兰色
+const QColor SceneBuilder::increaseColor(215, 48, 39);   // 对比：增加为红
+const QColor SceneBuilder::decreaseColor(69, 117, 180);  // 对比：减少为蓝
+const QColor SceneBuilder::noChangeColor(245, 245, 245); // 对比：变化不足阈值
+const QColor SceneBuilder::noChangeDataColor(200, 200, 200); // 对比：缺少一方的数据
+
+namespace {
+
+// 对比着色的相对变化阈值：小于 kChangeNeutral 视为没有变化，到 kChangeFull 时颜色最深
+const double kChangeNeutral = 0.02;
+const double kChangeStrong = 0.10;
+const double kChangeFull = 0.50;
+const int kChangeSteps = 6;
+
+QString name(const Topology& t, int m) {
+    return QString::fromLatin1(t.modules[m].name);
+}
+
+// 两个模块之间按相对方位选择端口
+void pickSides(const ModuleItem* a, const ModuleItem* b,
+               ModuleItem::PortPosition& fromSide, ModuleItem::PortPosition& toSide) {
+    const QPointF d = b->sceneBoundingRect().center() - a->sceneBoundingRect().center();
+    if (qAbs(d.x()) >= qAbs(d.y())) {
+        fromSide = d.x() >= 0 ? ModuleItem::Right : ModuleItem::Left;
+        toSide = d.x() >= 0 ? ModuleItem::Left : ModuleItem::Right;
+    } else {
+        fromSide = d.y() >= 0 ? ModuleItem::Bottom : ModuleItem::Top;
+        toSide = d.y() >= 0 ? ModuleItem::Top : ModuleItem::Bottom;
+    }
+}
+
+QPointF portPos(const ModuleItem* item, ModuleItem::PortPosition side) {
+    const int port = item->portIndex(side);
+    return port >= 0 ? item->getPortPos(port) : item->sceneBoundingRect().center();
+}
+
+// parent 为图层时挂到图层下，否则直接加入场景；图层位于原点，坐标不变
+void addToScene(QGraphicsScene* scene, QGraphicsItem* item, QGraphicsItem* parent) {
+    if (parent)
+        item->setParentItem(parent);
+    else
+        scene->addItem(item);
+}
+
+// 不绘制任何内容的图层，只用来整体切换子图元的可见性
+QGraphicsItem* addLayer(QGraphicsScene* scene) {
+    QGraphicsRectItem* layer = new QGraphicsRectItem();
+    layer->setPen(Qt::NoPen);
+    layer->setFlag(QGraphicsItem::ItemHasNoContents);
+    scene->addItem(layer);
+    return layer;
+}
+
+// 连线两端登记到各自模块的端口上，模块拖动时随之更新；offset 为两端共同的错开距离
+int addLink(EdgeLayer* layer, ModuleItem* a, ModuleItem::PortPosition sa,
+            ModuleItem* b, ModuleItem::PortPosition sb, const QPen& pen,
+            const QPointF& offset = QPointF()) {
+    const int edge = layer->addEdge(QLineF(portPos(a, sa) + offset, portPos(b, sb) + offset),
+                                    layer->addStyle(pen));
+    a->attachEdge(layer, edge, a->portIndex(sa), true, offset);
+    b->attachEdge(layer, edge, b->portIndex(sb), false, offset);
+    return edge;
+}
+
+QString percent(double r, int precision = 1) {
+    return r < 0 ? QString("-") : QString("%1%").arg(r * 100, 0, 'f', precision);
+}
+
+// 模块旁的统计标签：CPU 的指令数/周期与 IPC、L1命中率、平均访存周期，
+// 各级缓存命中率，内存使用率；派生指标取自 StatsView::metrics，模块没有的指标不显示
+QString moduleStatText(const Topology& t, const StatsView& view, int m) {
+    QStringList lines;
+    auto addMetric = [&](int metric) {
+        const double v = view.metric(m, metric);
+        if (!qIsNaN(v))
+            lines << QString("%1: %2").arg(view.metrics.label(metric), view.metricText(metric, v));
+    };
+    switch (t.modules[m].kind) {
+    case ModuleKind::Cpu: {
+        const double insts = view.value(m, "finished_inst_count");
+        const double ticks = view.value(m, "total_tick_processed");
+        if (insts < 0 || ticks < 0)
+            return QString();
+        lines << QString("指令数: %1").arg(qint64(insts)) << QString("周期: %1").arg(qint64(ticks));
+        addMetric(DerivedMetrics::Ipc);
+        addMetric(DerivedMetrics::CpuL1HitRate);
+        addMetric(DerivedMetrics::Amat);
+        break;
+    }
+    case ModuleKind::L2Cache:
+        addMetric(DerivedMetrics::L2HitRate);
+        addMetric(DerivedMetrics::L1iHitRate);
+        addMetric(DerivedMetrics::L1dHitRate);
+        break;
+    case ModuleKind::L3Cache:
+        addMetric(DerivedMetrics::LlcHitRate);
+        break;
+    case ModuleKind::Memory: {
+        const double busy = view.value(m, "busy_rate");
+        if (busy >= 0)
+            lines << QString("内存使用率: %1").arg(percent(busy));
+        break;
+    }
+    default:
+        break;
+    }
+    return lines.join('\n');
+}
+
+// 统计标签用 QGraphicsSimpleTextItem：没有 QTextDocument，逐帧改文字也足够便宜
+void setLabelText(QGraphicsSimpleTextItem* label, const QString& text) {
+    if (label->text() != text)
+        label->setText(text);
+}
+
+// 对比模式下连线两次运行的使用率：first 为当前运行，second 为对比运行，没有为 NaN
+QPair<double, double> comparedUsage(const BuiltScene& built, const Topology& t, int edge) {
+    const StatsView& view = built.view;
+    const int row = view.isValid() && view.busModule >= 0 && view.edgeCounter >= 0
+                        ? view.store->findRow(view.busModule, view.edgeCounter,
+                                              t.edges[edge].from, t.edges[edge].to)
+                        : -1;
+    if (row < 0)
+        return {qQNaN(), qQNaN()};
+    return {view.store->values[row], built.comparison->otherValue(row)};
+}
+
+// 路由器连线的颜色、线宽与使用率标签 "实测 / 预测"（都没有时不显示）
+// 没有实测值的连线按预测使用率着色；对比模式下按使用率的相对变化着色，标签为变化幅度
+void styleEdge(BuiltScene& built, const Topology& t, int edge) {
+    const int link = built.busEdgeLink[edge];
+    if (built.comparison) {
+        const QPair<double, double> usage = comparedUsage(built, t, edge);
+        const double change = RunComparison::relativeChange(usage.first, usage.second);
+        built.edgeUsage[edge] = qIsNaN(usage.first) ? -1 : usage.first;
+        built.links->setStyle(link, built.links->addStyle(SceneBuilder::changePen(change)));
+        built.links->setLabel(link, qAbs(change) >= kChangeNeutral ? SceneBuilder::changeText(change)
+                                                                   : QString(),
+                              SceneBuilder::changeColor(change).darker(150));
+        return;
+    }
+    const RouteLoad& routes = built.view.routes;
+    const double usage = routes.isEmpty() ? -1 : routes.measuredBusy[edge];
+    const double predicted = routes.isEmpty() ? -1 : routes.predictedBusy[edge];
+    built.edgeUsage[edge] = usage;
+    const double shown = usage >= 0 ? usage : predicted;
+    built.links->setStyle(link, built.links->addStyle(SceneBuilder::edgePen(shown)));
+    QString text;
+    if (usage > 0 || predicted > 0) {
+        text = (usage >= 0 ? percent(usage, 2) : QString("-")) + " / "
+               + (predicted >= 0 ? percent(predicted, 2) : QString("-"));
+    }
+    built.links->setLabel(link, text, shown > 0.01 ? Qt::red : Qt::darkBlue);
+}
+
+// 模块按类型的本色
+QColor kindColor(ModuleKind kind) {
+    switch (kind) {
+    case ModuleKind::L2Cache: return SceneBuilder::l2Color;
+    case ModuleKind::L3Cache: return SceneBuilder::l3Color;
+    case ModuleKind::Memory: return SceneBuilder::memColor;
+    default: return SceneBuilder::cpuColor;
+    }
+}
+
+// 对比着色用的代表值：CPU 为 IPC，L2/L3 为命中率，内存为使用率；L1 取 L1d 命中率
+double keyValue(const Topology& t, const StatsView& view, const CounterStore& store,
+                const DerivedMetrics& metrics, int m, bool l1) {
+    const int id = view.storeModule.value(m, -1);
+    if (id < 0)
+        return qQNaN();
+    if (l1)
+        return metrics.value(DerivedMetrics::L1dHitRate, id);
+    switch (t.modules[m].kind) {
+    case ModuleKind::Cpu: return metrics.value(DerivedMetrics::Ipc, id);
+    case ModuleKind::L2Cache: return metrics.value(DerivedMetrics::L2HitRate, id);
+    case ModuleKind::L3Cache: return metrics.value(DerivedMetrics::LlcHitRate, id);
+    case ModuleKind::Memory: {
+        const int counter = store.findCounter("busy_rate");
+        const int row = counter >= 0 ? store.findRow(id, counter) : -1;
+        return row >= 0 ? store.values[row] : qQNaN();
+    }
+    default: return qQNaN();
+    }
+}
+
+// 模块（及 L2 的 L1）的填充色：平时为类型本色，对比模式下为代表值的相对变化
+void styleModule(BuiltScene& built, const Topology& t, int m) {
+    const StatsView& view = built.view;
+    const RunComparison* comparison = built.comparison;
+    auto change = [&](bool l1) {
+        return RunComparison::relativeChange(
+            keyValue(t, view, *view.store, view.metrics, m, l1),
+            keyValue(t, view, comparison->aligned, comparison->metrics, m, l1));
+    };
+    if (ModuleItem* item = built.moduleItems[m])
+        item->setBrush(comparison && view.isValid() ? SceneBuilder::changeColor(change(false))
+                                                    : kindColor(t.modules[m].kind));
+    if (ModuleItem* l1 = built.l1Items[m])
+        l1->setBrush(comparison && view.isValid() ? SceneBuilder::changeColor(change(true))
+                                                  : SceneBuilder::l1Color);
+}
+
+// 热点标记标在各热点连线的起点
+void placeHotspots(BuiltScene& built, const Topology& t) {
+    const QVector<int>& hotspots = built.view.routes.hotspots;
+    int shown = 0;
+    for (const int edge : hotspots) {
+        if (built.busEdgeLink[edge] < 0)
+            continue;
+        // 挂在连线起点所在的路由器下，拖动路由器时跟着走
+        ModuleItem* router = built.routerItems[t.edges[edge].from];
+        if (shown == built.hotspotMarkers.size()) {
+            QGraphicsRectItem* marker = new QGraphicsRectItem(-5, -5, 10, 10, router);
+            marker->setBrush(SceneBuilder::busyPathColor);
+            built.hotspotMarkers.append(marker);
+        }
+        QGraphicsRectItem* marker = built.hotspotMarkers[shown++];
+        const QPointF start = built.links->line(built.busEdgeLink[edge]).p1();
+        marker->setParentItem(router);
+        marker->setPos(router->mapFromScene(start));
+        marker->setVisible(true);
+    }
+    for (int i = shown; i < built.hotspotMarkers.size(); ++i)
+        built.hotspotMarkers[i]->setVisible(false);
+}
+
+// 端口连接的模块，没有画出来时取端口所在的路由器
+QPointF portAnchor(const BuiltScene& built, const Topology& t, int port, int node) {
+    const int m = t.moduleOfPort.value(port, -1);
+    const ModuleItem* item = m >= 0 ? built.moduleItems[m] : nullptr;
+    if (!item)
+        item = built.routerItems[node];
+    return item->sceneBoundingRect().center();
+}
+
+bool sameFlows(const QVector<RouteLoad::Flow>& a, const QVector<RouteLoad::Flow>& b) {
+    if (a.size() != b.size())
+        return false;
+    for (int i = 0; i < a.size(); ++i) {
+        if (a[i].fromPort != b[i].fromPort || a[i].toPort != b[i].toPort || a[i].packets != b[i].packets)
+            return false;
+    }
+    return true;
+}
+
+// 最大的几股跨节点流量沿路由画成虚线：源模块 → 各跳连线 → 目的模块
+// 回放总线事件时由运动的包代替，这些静态路径隐藏
+void placeFlowPaths(BuiltScene& built, const Topology& t) {
+    const StatsView& view = built.view;
+    int shown = 0;
+    QVector<QPointF> points;
+    for (const RouteLoad::Flow& flow : view.routes.topFlows) {
+        if (!SceneBuilder::packetRoute(built, t, flow.fromPort, flow.toPort, points) || points.size() < 4)
+            continue;
+        QPainterPath path(points.first());
+        for (int i = 1; i < points.size(); ++i)
+            path.lineTo(points[i]);
+
+        if (shown == built.flowPaths.size()) {
+            QGraphicsPathItem* item = new QGraphicsPathItem;
+            item->setPen(QPen(SceneBuilder::flowPathColor, 2, Qt::DotLine));
+            QGraphicsSimpleTextItem* label = new QGraphicsSimpleTextItem(item);
+            label->setBrush(SceneBuilder::flowPathColor);
+            built.links->scene()->addItem(item);
+            built.flowPaths.append(item);
+        }
+        QGraphicsPathItem* item = built.flowPaths[shown++];
+        item->setPath(path);
+        item->setVisible(!built.playback);
+        QGraphicsSimpleTextItem* label =
+            static_cast<QGraphicsSimpleTextItem*>(item->childItems().first());
+        label->setText(QString("Port%1 → Port%2: %3包")
+                           .arg(flow.fromPort).arg(flow.toPort).arg(qint64(flow.packets)));
+        label->setPos(points[1] + QPointF(0, -20));
+    }
+    for (int i = shown; i < built.flowPaths.size(); ++i)
+        built.flowPaths[i]->setVisible(false);
+}
+
+QGraphicsSimpleTextItem* addStatLabel(QGraphicsItem* layer, const QString& text, const QPointF& pos) {
+    QGraphicsSimpleTextItem* label = new QGraphicsSimpleTextItem(text, layer);
+    label->setPos(pos + QPointF(4, 4));   // 与 QGraphicsTextItem 的文档边距对齐
+    label->setFont(QFont("Arial", 8));
+    return label;
+}
+
+// 图元对应的模型对象记在图元自身的数据里，点中时直接取出，不在各列表中查找
+enum TargetData { TargetKindData, TargetIndexData };
+
+void setTarget(ModuleItem* item, SceneTarget::Kind kind, int index) {
+    item->setData(TargetKindData, int(kind));
+    item->setData(TargetIndexData, index);
+}
+
+// 行号递增地追加，与上一段相接时并入
+void appendRow(QVector<StatsView::RowRange>& ranges, qint32 r) {
+    if (!ranges.isEmpty() && ranges.last().end == r)
+        ++ranges.last().end;
+    else
+        ranges.append({r, r + 1});
+}
+
+// 取出落在 [begin, end) 内的行，两种列表都按行号递增
+void appendRowsIn(const QVector<StatsView::RowRange>& ranges, int begin, int end, QVector<qint32>& rows) {
+    auto it = std::upper_bound(ranges.cbegin(), ranges.cend(), begin,
+                               [](int row, const StatsView::RowRange& range) { return row < range.end; });
+    for (; it != ranges.cend() && it->begin < end; ++it) {
+        for (qint32 r = qMax<qint32>(it->begin, begin); r < qMin<qint32>(it->end, end); ++r)
+            rows.append(r);
+    }
+}
+
+void appendRowsIn(const QVector<qint32>& list, int begin, int end, QVector<qint32>& rows) {
+    for (auto it = std::lower_bound(list.cbegin(), list.cend(), begin); it != list.cend() && *it < end; ++it)
+        rows.append(*it);
+}
+
+ModuleItem* addModule(QGraphicsScene* scene, const QString& label, const QPointF& pos,
+                      qreal w, qreal h, const QColor& color, QGraphicsItem* parent = nullptr) {
+    ModuleItem* item = new ModuleItem(label, pos.x(), pos.y(), w, h);
+    item->setBrush(color);
+    addToScene(scene, item, parent);
+    return item;
+}
+
+} // namespace
+
+// ============== StatsView ==============
+void StatsView::reset(const Topology& t, const CounterStore* s) {
+    store = s;
+    storeModule.fill(-1);
+    storeModule.resize(t.modules.size(), -1);
+    topoModule.clear();
+    busModule = -1;
+    edgeCounter = -1;
+    flowCounter = -1;
+    moduleRows.clear();
+    nodeRows.clear();
+    nodeRows.resize(t.nodeCount);
+    moduleRanges.clear();
+    nodePairRows.clear();
+    nodePairRows.resize(t.nodeCount);
+    flowRanges.clear();
+    flowRanges.resize(t.nodeOfPort.size() + 1);
+    edgeOfPair.clear();
+    for (int i = 0; i < t.edges.size(); ++i)
+        edgeOfPair.insert(pairKey(t.edges[i].from, t.edges[i].to), i);
+    indexedModules = 0;
+    indexedRows = 0;
+    flowRows = 0;
+    metrics.reset(s);
+    routing.setTopology(t);
+    catchUp(t);
+    updateRoutes();
+}
+
+void StatsView::setStore(const CounterStore* s) {
+    store = s;
+    metrics.setStore(s);
+}
+
+void StatsView::catchUp(const Topology& t) {
+    if (!store)
+        return;
+    // 新出现的模块名：对应到拓扑中的同名模块
+    const int modules = store->modules.size();
+    topoModule.resize(modules, -1);
+    moduleRows.resize(modules);
+    moduleRanges.resize(modules);
+    for (int id = indexedModules; id < modules; ++id) {
+        const int m = t.findModule(store->modules.at(id));
+        topoModule[id] = m;
+        if (m < 0)
+            continue;
+        storeModule[m] = id;
+        if (m == t.busModule)
+            busModule = id;
+    }
+    indexedModules = modules;
+    if (edgeCounter < 0)
+        edgeCounter = store->findCounter("edge_#_to_#_busy_rate");
+    if (flowCounter < 0)
+        flowCounter = store->findCounter("transmit_package_number_from_#_to_#");
+
+    // 新增的行按模块/节点归类
+    const int rows = store->rowCount();
+    for (int r = indexedRows; r < rows; ++r) {
+        const int module = store->rowModule[r];
+        const int index0 = store->rowIndex0[r];
+        appendRow(moduleRanges[module], r);
+        if (store->rowIndex1[r] >= 0) {
+            // 流量矩阵、边使用率等单独展示，检查面板按节点或源端口列出
+            if (index0 < 0)
+                continue;
+            if (store->rowCounter[r] == flowCounter) {
+                // 路由投射用到全部流量行，端口超出拓扑的也要记下
+                appendRow(flowRanges[qMin(index0, int(flowRanges.size()) - 1)], r);
+                ++flowRows;
+            } else if (module == busModule && index0 < nodePairRows.size()) {
+                nodePairRows[index0].append(r);
+            }
+            continue;
+        }
+        if (module == busModule && index0 >= 0) {
+            if (index0 < nodeRows.size())
+                nodeRows[index0].append(r);
+            continue;
+        }
+        moduleRows[module].append(r);
+    }
+    indexedRows = rows;
+    metrics.catchUp();
+}
+
+void StatsView::updateRoutes() {
+    routes = isValid() ? routing.project(*store) : RouteLoad();
+}
+
+QVector<qint32> StatsView::displayedRows(const Topology& t) const {
+    QVector<qint32> rows;
+    if (!isValid())
+        return rows;
+    for (const int id : storeModule) {
+        if (id >= 0 && id != busModule)
+            rows += moduleRows[id];
+    }
+    for (const QVector<qint32>& node : nodeRows)
+        rows += node;
+    if (busModule >= 0 && edgeCounter >= 0) {
+        for (const BusEdge& e : t.edges) {
+            const int r = store->findRow(busModule, edgeCounter, e.from, e.to);
+            if (r >= 0)
+                rows.append(r);
+        }
+    }
+    return rows;
+}
+
+QVector<qint32> StatsView::allFlowRows() const {
+    QVector<qint32> rows;
+    rows.reserve(flowRows);
+    for (const QVector<RowRange>& ranges : flowRanges)
+        appendRowsIn(ranges, 0, indexedRows, rows);
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+QVector<qint32> StatsView::moduleRowsIn(int storeModule, int begin, int end) const {
+    QVector<qint32> rows;
+    if (storeModule >= 0 && storeModule < moduleRanges.size())
+        appendRowsIn(moduleRanges[storeModule], begin, qMin(end, indexedRows), rows);
+    return rows;
+}
+
+QVector<qint32> StatsView::routerRowsIn(const Topology& t, int node, int begin, int end) const {
+    QVector<qint32> rows;
+    if (node < 0 || node >= nodeRows.size())
+        return rows;
+    end = qMin(end, indexedRows);
+    appendRowsIn(nodeRows[node], begin, end, rows);
+    appendRowsIn(nodePairRows[node], begin, end, rows);
+    for (int p = 0; p < flowRanges.size(); ++p) {
+        if (t.nodeOfPort.value(p, -1) == node)
+            appendRowsIn(flowRanges[p], begin, end, rows);
+    }
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+bool StatsView::isValid() const {
+    return store && !store->isEmpty();
+}
+
+double StatsView::value(int topoModule, const char* counter, double defaultValue) const {
+    if (!isValid() || topoModule < 0)
+        return defaultValue;
+    return store->value(storeModule[topoModule], counter, -1, -1, defaultValue);
+}
+
+double StatsView::busValue(const char* counter, int index0, int index1, double defaultValue) const {
+    if (!isValid() || busModule < 0)
+        return defaultValue;
+    return store->value(busModule, counter, index0, index1, defaultValue);
+}
+
+double StatsView::metric(int topoModule, int metric) const {
+    if (!isValid() || topoModule < 0)
+        return qQNaN();
+    return metrics.value(metric, storeModule[topoModule]);
+}
+
+QString StatsView::metricText(int metric, double value) const {
+    if (metrics.unit(metric) == DerivedMetrics::Percent)
+        return percent(value);
+    return QString::number(value, 'f', 2);
+}
+
+// ============== SceneBuilder ==============
+QString SceneBuilder::formatValue(const CounterStore& store, int row) {
+    const double v = store.values[row];
+    if (store.counterIsReal[store.rowCounter[row]])
+        return QString::number(v, 'g', 6);
+    return QString::number(qint64(v));
+}
+
+QPen SceneBuilder::edgePen(double usage) {
+    // 设置不同颜色表示使用率
+    if (usage > 0.01)
+        return QPen(busyPathColor, 4);
+    return QPen(Qt::darkBlue, 2);
+}
+
+QColor SceneBuilder::changeColor(double relative) {
+    if (qIsNaN(relative))
+        return noChangeDataColor;
+    const double magnitude = qAbs(relative);
+    if (magnitude < kChangeNeutral)
+        return noChangeColor;
+    // 由浅到深分 kChangeSteps 级插值到增加/减少的颜色；级数有限，连线画笔也就只有十几种
+    const int step = qMin(kChangeSteps, 1 + int(kChangeSteps * (magnitude - kChangeNeutral)
+                                                / (kChangeFull - kChangeNeutral)));
+    const double f = double(step) / kChangeSteps;
+    const QColor to = relative > 0 ? increaseColor : decreaseColor;
+    return QColor(int(noChangeColor.red() + (to.red() - noChangeColor.red()) * f),
+                  int(noChangeColor.green() + (to.green() - noChangeColor.green()) * f),
+                  int(noChangeColor.blue() + (to.blue() - noChangeColor.blue()) * f));
+}
+
+QPen SceneBuilder::changePen(double relative) {
+    const double magnitude = qAbs(relative);
+    if (qIsNaN(relative) || magnitude < kChangeNeutral)
+        return QPen(Qt::darkGray, 2);
+    return QPen(changeColor(relative), magnitude >= kChangeStrong ? 4 : 3);
+}
+
+QString SceneBuilder::changeText(double relative) {
+    if (qIsNaN(relative))
+        return QString("-");
+    return QString("%1%2%").arg(relative >= 0 ? "+" : "").arg(relative * 100, 0, 'f', 1);
+}
+
+void SceneBuilder::setComparison(BuiltScene& built, const Topology& t, const RunComparison* comparison) {
+    built.comparison = comparison;
+    for (int m = 0; m < t.modules.size(); ++m)
+        styleModule(built, t, m);
+    for (int edge = 0; edge < t.edges.size(); ++edge) {
+        if (built.busEdgeLink[edge] >= 0)
+            styleEdge(built, t, edge);
+    }
+    built.restyleNext = -1;
+}
+
+bool SceneBuilder::packetRoute(const BuiltScene& built, const Topology& t, int fromPort, int toPort,
+                               QVector<QPointF>& points) {
+    points.clear();
+    const int from = t.nodeOfPort.value(fromPort, -1);
+    const int to = t.nodeOfPort.value(toPort, -1);
+    if (from < 0 || to < 0 || from >= built.routerItems.size() || to >= built.routerItems.size())
+        return false;
+    const QVector<int> hops = built.view.routing.route(from, to);
+    if (hops.isEmpty() && from != to)
+        return false;
+    points.append(portAnchor(built, t, fromPort, from));
+    for (const int edge : hops) {
+        if (built.busEdgeLink[edge] < 0)
+            continue;
+        const QLineF hop = built.links->line(built.busEdgeLink[edge]);
+        points.append(hop.p1());
+        points.append(hop.p2());
+    }
+    // 同一路由器上的两个端口：经过路由器中心
+    if (hops.isEmpty())
+        points.append(built.routerItems[from]->sceneBoundingRect().center());
+    points.append(portAnchor(built, t, toPort, to));
+    return true;
+}
+
+void SceneBuilder::setPlayback(BuiltScene& built, const Topology& t, bool active) {
+    built.playback = active;
+    placeFlowPaths(built, t);
+}
+
+void SceneBuilder::setLatency(BuiltScene& built, const Topology& t, const LatencyHistograms* h) {
+    // 所有延迟条共用一个比例尺，最长的一条为 LatencyBars::kBarWidth
+    double longest = 0;
+    if (h) {
+        longest = LatencyBars::maxTotalTicks(*h, LatencyHistograms::Core, -1);
+        for (int o = 0; o < h->cores; ++o)
+            longest = qMax(longest, LatencyBars::maxTotalTicks(*h, LatencyHistograms::Core, o));
+        for (int o = 0; o < h->slices; ++o)
+            longest = qMax(longest, LatencyBars::maxTotalTicks(*h, LatencyHistograms::Slice, o));
+    }
+    const qreal pxPerTick = longest > 0 ? LatencyBars::kBarWidth / longest : 1;
+
+    built.latencyBars.resize(t.modules.size(), nullptr);
+    for (int m = 0; m < t.modules.size(); ++m) {
+        ModuleItem* item = built.moduleItems[m];
+        const TopologyModule& mod = t.modules[m];
+        if (!item || (mod.kind != ModuleKind::L2Cache && mod.kind != ModuleKind::L3Cache))
+            continue;
+        LatencyBars*& bars = built.latencyBars[m];
+        if (!h && !bars)
+            continue;
+        if (!bars) {
+            // 不是子图元，随模块移动时由 ModuleItem 平移
+            bars = new LatencyBars(built.labelLayer);
+            bars->setPos(item->pos() + QPointF(0, item->rect().height() + 5));
+            item->addFollower(bars);
+        }
+        // L2Cachen 对应核心 n；L3 按 nuca_index 对应分片
+        if (mod.kind == ModuleKind::L2Cache)
+            bars->setData(h, LatencyHistograms::Core, mod.index, pxPerTick);
+        else
+            bars->setData(h, LatencyHistograms::Slice, int(t.param(m, "nuca_index", mod.index)), pxPerTick);
+        bars->setVisible(!bars->isEmpty());
+    }
+
+    if (!built.latencyTotals && h) {
+        built.latencyTotals = new LatencyBars();
+        built.latencyTotals->setPos(50, 305);   // 图例下方
+        built.labelLayer->scene()->addItem(built.latencyTotals);
+    }
+    if (built.latencyTotals) {
+        built.latencyTotals->setData(h, LatencyHistograms::Core, -1, pxPerTick);
+        if (h) {
+            built.latencyTotals->setTitle(QString("cache_event_trace: %1 个事件，各段平均周期")
+                                              .arg(h->records));
+        }
+        built.latencyTotals->setVisible(!built.latencyTotals->isEmpty());
+    }
+}
+
+BuiltScene SceneBuilder::build(QGraphicsScene* scene, const Topology& t, const CounterStore* stats,
+                               const Layout* layout) {
+    StatsView view;
+    view.reset(t, stats);
+    SceneBuildJob job(scene, t, view, layout ? *layout : LayoutEngine::layout(t));
+    job.run(-1);
+    return std::move(job.result());
+}
+
+// ============== SceneBuildJob ==============
+SceneBuildJob::SceneBuildJob(QGraphicsScene* scene, const Topology& topology, const StatsView& view,
+                             const Layout& layout)
+    : scene(scene), t(topology), layout(layout)
+{
+    built.moduleItems.resize(t.modules.size(), nullptr);
+    built.l1Items.resize(t.modules.size(), nullptr);
+    built.statLabels.resize(t.modules.size(), nullptr);
+    built.busEdgeLink.resize(t.edges.size(), -1);
+    built.edgeUsage.resize(t.edges.size(), -1);
+    built.view = view;
+    built.chainLayer = addLayer(scene);
+    built.tileLayer = addLayer(scene);
+    built.staticLayer = addLayer(scene);
+    built.labelLayer = addLayer(scene);
+    built.labelLayer->setZValue(1);   // 文字压在模块和连线上面
+    built.links = new EdgeLayer();
+    scene->addItem(built.links);
+    built.chainLinks = new EdgeLayer(built.chainLayer);
+    built.routerItems.reserve(t.nodeCount);
+
+    // 各路由器上映射的端口；逐个路由器扫描全部端口在大拓扑上是平方级的
+    nodePorts.resize(t.nodeCount);
+    nodeHasPort.resize(t.nodeCount, false);
+    for (int p = 0; p < t.nodeOfPort.size(); ++p) {
+        const int node = t.nodeOfPort[p];
+        if (node < 0)
+            continue;
+        nodeHasPort[node] = true;
+        if (t.moduleOfPort[p] >= 0)
+            nodePorts[node].append(p);
+    }
+    total = t.nodeCount + int(layout.chainCpu.size()) + int(t.modules.size()) + int(t.edges.size()) + 1;
+}
+
+int SceneBuildJob::progress() const {
+    return total > 0 ? int(qint64(done) * 100 / total) : 100;
+}
+
+bool SceneBuildJob::run(qint64 budgetNs) {
+    QElapsedTimer timer;
+    timer.start();
+    // 每完成一个单元（一个路由器、一条链、一个模块或一条连线）检查一次时间
+    while (phase != Done) {
+        if (budgetNs >= 0 && timer.nsecsElapsed() >= budgetNs)
+            return false;
+        switch (phase) {
+        case Routers:
+            if (next < t.nodeCount) {
+                addRouter(next++);
+                break;
+            }
+            phase = Chains;
+            next = 0;
+            continue;
+        case Chains:
+            if (next < layout.chainCpu.size()) {
+                addChain(next++);
+                break;
+            }
+            phase = Attached;
+            next = 0;
+            continue;
+        case Attached:
+            if (next < t.modules.size()) {
+                addAttached(next++);
+                break;
+            }
+            phase = BusEdges;
+            next = 0;
+            continue;
+        case BusEdges:
+            if (next < t.edges.size()) {
+                addBusEdge(next++);
+                break;
+            }
+            phase = Decorations;
+            continue;
+        case Decorations:
+            addDecorations();
+            phase = Done;
+            break;
+        case Done:
+            break;
+        }
+        ++done;
+    }
+    return true;
+}
+
+// ============== 创建路由器节点 ==============
+// 位置由 LayoutEngine 给出，每个路由器与挂在它上面的模块组成一簇
+void SceneBuildJob::addRouter(int node) {
+    QString label = QString("Router%1").arg(node);
+    if (!nodeHasPort[node]) label += " (空闲)";
+    const QPointF pos = layout.routers[node];
+    ModuleItem* router = addModule(scene, label, pos, 120, 70, SceneBuilder::routerColor,
+                                   built.staticLayer);
+    // 添加多个端口：左、右(构造时已有)、上、下
+    router->addPort(ModuleItem::Top);
+    router->addPort(ModuleItem::Bottom);
+    setTarget(router, SceneTarget::Router, int(built.routerItems.size()));
+    built.routerItems.append(router);
+
+    // 标注端口映射关系
+    QStringList mapping;
+    for (const int p : nodePorts[node])
+        mapping << QString("Port%1: %2").arg(p).arg(name(t, t.moduleOfPort[p]));
+    if (!mapping.isEmpty()) {
+        QGraphicsTextItem* portLabel = new QGraphicsTextItem(mapping.join('\n'), built.labelLayer);
+        portLabel->setPos(pos.x() + 130, pos.y() + 10);
+        portLabel->setDefaultTextColor(Qt::darkBlue);
+        router->addFollower(portLabel);
+    }
+}
+
+// ============== 创建CPU + L1 + L2缓存子系统 ==============
+// 同一编号的 CPUn 与 L2Cachen 组成一条链，L1 的几何参数来自 L2Cache 块
+void SceneBuildJob::addChain(int row) {
+    const StatsView& view = built.view;
+    const int cpuModule = layout.chainCpu[row];
+    const int l2Module = layout.chainL2[row];
+
+    ModuleItem* cpu = nullptr;
+    if (cpuModule >= 0) {
+        const QPointF pos = layout.modules[cpuModule];
+        cpu = addModule(scene, name(t, cpuModule), pos, 120, 60, SceneBuilder::cpuColor,
+                        built.chainLayer);
+        built.moduleItems[cpuModule] = cpu;
+        setTarget(cpu, SceneTarget::Module, cpuModule);
+
+        // CPU性能数据（暂无数据时标签为空，追加统计后再填上）
+        built.statLabels[cpuModule] = addStatLabel(built.labelLayer,
+                                                   moduleStatText(t, view, cpuModule),
+                                                   pos + QPointF(-50, 70));
+        cpu->addFollower(built.statLabels[cpuModule]);
+    }
+    if (l2Module < 0)
+        return;
+
+    const int index = t.modules[l2Module].index;
+    ModuleItem* l1 = addModule(scene, QString("L1%1").arg(index), layout.l1[l2Module], 100, 60,
+                               SceneBuilder::l1Color, built.chainLayer);
+    built.l1Items[l2Module] = l1;
+    setTarget(l1, SceneTarget::L1, l2Module);
+
+    ModuleItem* l2 = addModule(scene, name(t, l2Module), layout.modules[l2Module], 120, 50,
+                               SceneBuilder::l2Color, built.chainLayer);
+    built.moduleItems[l2Module] = l2;
+    setTarget(l2, SceneTarget::Module, l2Module);
+
+    // L2缓存命中率
+    QGraphicsSimpleTextItem* hitLabel = addStatLabel(built.labelLayer,
+                                                     moduleStatText(t, view, l2Module),
+                                                     l2->pos() + QPointF(130, 10));
+    hitLabel->setFont(QFont());
+    built.statLabels[l2Module] = hitLabel;
+    l2->addFollower(hitLabel);
+
+    // 缩小后代替整条链的色块，从 CPU（或 L1）左缘到 L2 右缘
+    const QRectF chainRect = QRectF(cpu ? cpu->pos() : l1->pos(), QSizeF(1, 60))
+                                 .united(l2->sceneBoundingRect());
+    QGraphicsRectItem* tile = new QGraphicsRectItem(chainRect, built.tileLayer);
+    tile->setBrush(SceneBuilder::l2Color);
+    tile->setPen(QPen(Qt::black, 0));
+
+    // 连接CPU到L1缓存
+    if (cpu) {
+        addLink(built.chainLinks, cpu, ModuleItem::Right, l1, ModuleItem::Left,
+                QPen(Qt::black, 2, Qt::SolidLine, Qt::RoundCap));
+    }
+    // 连接L1到L2缓存
+    addLink(built.chainLinks, l1, ModuleItem::Right, l2, ModuleItem::Left,
+            QPen(Qt::darkGray, 2, Qt::SolidLine, Qt::RoundCap));
+    // 连接L2缓存到其端口所在的路由器
+    const int node = t.nodeOfModule(l2Module);
+    if (node >= 0) {
+        addLink(built.links, l2, ModuleItem::Right, built.routerItems[node], ModuleItem::Left,
+                QPen(Qt::black, 2, Qt::SolidLine, Qt::RoundCap));
+    }
+}
+
+// ============== 创建L3缓存、内存等挂在总线上的模块 ==============
+void SceneBuildJob::addAttached(int m) {
+    const StatsView& view = built.view;
+    const TopologyModule& mod = t.modules[m];
+    const int node = t.nodeOfModule(m);
+    if (node < 0 || mod.kind == ModuleKind::L2Cache)
+        return;
+
+    const QPointF pos = layout.modules[m];
+
+    ModuleItem* item = nullptr;
+    QPen pen(Qt::gray, 2, Qt::SolidLine, Qt::RoundCap);
+    if (mod.kind == ModuleKind::L3Cache) {
+        item = addModule(scene, name(t, m), pos, 150, 60, SceneBuilder::l3Color, built.staticLayer);
+        pen = QPen(Qt::darkGreen, 2, Qt::SolidLine, Qt::RoundCap);
+    } else if (mod.kind == ModuleKind::Memory) {
+        item = addModule(scene, name(t, m), pos, 150, 70, SceneBuilder::memColor, built.staticLayer);
+        pen = QPen(Qt::darkRed, 3, Qt::SolidLine, Qt::RoundCap);
+    } else {
+        item = addModule(scene, name(t, m), pos, 150, 60, SceneBuilder::cpuColor, built.staticLayer);
+    }
+    item->addPort(ModuleItem::Top); // 顶部端口连接路由器
+    built.moduleItems[m] = item;
+    setTarget(item, SceneTarget::Module, m);
+
+    // L3缓存命中率 / 内存使用率
+    if (mod.kind == ModuleKind::L3Cache || mod.kind == ModuleKind::Memory) {
+        QGraphicsSimpleTextItem* label = addStatLabel(built.labelLayer,
+                                                      moduleStatText(t, view, m),
+                                                      pos + QPointF(160, 10));
+        label->setFont(QFont());
+        built.statLabels[m] = label;
+        item->addFollower(label);
+    }
+
+    addLink(built.links, item, ModuleItem::Top, built.routerItems[node], ModuleItem::Bottom, pen);
+}
+
+// ============== 连接路由器节点 ==============
+// 双向通道各画一条线，沿法线方向错开以免重叠
+void SceneBuildJob::addBusEdge(int i) {
+    const BusEdge& e = t.edges[i];
+    if (e.from == e.to)
+        return;
+    ModuleItem* a = built.routerItems[e.from];
+    ModuleItem* b = built.routerItems[e.to];
+    ModuleItem::PortPosition fromSide, toSide;
+    pickSides(a, b, fromSide, toSide);
+
+    const QLineF line(portPos(a, fromSide), portPos(b, toSide));
+    const QPointF offset = line.length() > 0
+                               ? QPointF(-line.dy(), line.dx()) / line.length() * 4
+                               : QPointF();
+    built.busEdgeLink[i] = addLink(built.links, a, fromSide, b, toSide, SceneBuilder::edgePen(-1),
+                                   offset);
+    styleEdge(built, t, i);
+}
+
+void SceneBuildJob::addDecorations() {
+    // ============== 标注热点连线与主要流量路径 ==============
+    // 由流量按最短路由投射到各连线上的负载得出，统计数据变化时随之更新
+    placeHotspots(built, t);
+    placeFlowPaths(built, t);
+
+    // ============== 添加图例 ==============
+    QGraphicsRectItem* legendBg = new QGraphicsRectItem(50, 50, 300, 245);
+    legendBg->setBrush(QBrush(QColor(240, 240, 240, 220)));
+    addToScene(scene, legendBg, built.staticLayer);
+
+    const QList<QPair<QString, QColor>> legendItems = {
+        {"CPU", SceneBuilder::cpuColor},
+        {"L1缓存", SceneBuilder::l1Color},
+        {"L2缓存", SceneBuilder::l2Color},
+        {"L3缓存", SceneBuilder::l3Color},
+        {"路由器", SceneBuilder::routerColor},
+        {"内存", SceneBuilder::memColor},
+        {"热点连线", SceneBuilder::busyPathColor},
+        {"主要流量路径", SceneBuilder::flowPathColor}
+    };
+
+    for (int i = 0; i < legendItems.size(); ++i) {
+        QGraphicsRectItem* colorIcon = new QGraphicsRectItem(70, 80 + i * 25, 20, 15);
+        colorIcon->setBrush(legendItems[i].second);
+        addToScene(scene, colorIcon, built.staticLayer);
+
+        QGraphicsTextItem* legendLabel = new QGraphicsTextItem(legendItems[i].first);
+        legendLabel->setPos(100, 80 + i * 25 - 5);
+        addToScene(scene, legendLabel, built.staticLayer);
+    }
+    QGraphicsTextItem* legendNote = new QGraphicsTextItem("连线标签: 实测 / 预测使用率");
+    legendNote->setPos(70, 80 + legendItems.size() * 25 - 5);
+    addToScene(scene, legendNote, built.staticLayer);
+
+    // ============== 添加全局标题 ==============
+    QGraphicsTextItem* title = new QGraphicsTextItem("三级缓存NUCA架构拓扑图3_2.");
+    title->setPos(650, 50);
+    title->setFont(QFont("Arial", 18, QFont::Bold));
+    addToScene(scene, title, built.staticLayer);
+
+    built.linkBusEdge.fill(-1, built.links->edgeCount());
+    for (int i = 0; i < built.busEdgeLink.size(); ++i) {
+        if (built.busEdgeLink[i] >= 0)
+            built.linkBusEdge[built.busEdgeLink[i]] = i;
+    }
+
+    built.detail = DetailLevel::Full;
+    built.tileLayer->setVisible(false);
+}
+
+void SceneBuilder::applyChanges(BuiltScene& built, const Topology& t, const CounterStore& stats,
+                                const QVector<qint32>& changedRows) {
+    StatsView& view = built.view;
+    view.setStore(&stats);
+    view.catchUp(t);
+    view.metrics.markDirty(changedRows);
+
+    // 按受影响的模块、连线归类，每个只刷新一次
+    QVector<int> modules, edges;
+    QVector<qint32> flows;
+    for (const qint32 r : changedRows) {
+        const int module = stats.rowModule[r];
+        if (stats.rowCounter[r] == view.flowCounter) {
+            flows.append(r);
+            continue;
+        }
+        if (module == view.busModule) {
+            const int index0 = stats.rowIndex0[r];
+            const int index1 = stats.rowIndex1[r];
+            if (stats.rowCounter[r] == view.edgeCounter && index1 >= 0) {
+                const int edge = view.edgeOfPair.value(StatsView::pairKey(index0, index1), -1);
+                if (edge >= 0 && built.busEdgeLink[edge] >= 0)
+                    edges.append(edge);
+            }
+            continue;
+        }
+        const int m = module < view.topoModule.size() ? view.topoModule[module] : -1;
+        if (m >= 0)
+            modules.append(m);
+    }
+    for (QVector<int>* list : {&modules, &edges, &flows}) {
+        std::sort(list->begin(), list->end());
+        list->erase(std::unique(list->begin(), list->end()), list->end());
+    }
+
+    for (const int m : modules) {
+        if (built.statLabels[m])
+            setLabelText(built.statLabels[m], moduleStatText(t, view, m));
+        if (built.comparison)
+            styleModule(built, t, m);
+    }
+
+    if (flows.isEmpty() && edges.isEmpty())
+        return;
+    // 更新前画面所依据的值，之后只改动其中变了的
+    RouteLoad& routes = view.routes;
+    const QVector<double> measured = routes.measuredBusy;
+    const QVector<double> predicted = routes.predictedBusy;
+    const double busyPerPacket = routes.busyPerPacket;
+    const QVector<int> hotspots = routes.hotspots;
+    const QVector<RouteLoad::Flow> topFlows = routes.topFlows;
+
+    // 少数流量行变化时只把差额加到各自的路由上；变化的太多或还没有投射过时重新投射全部流量
+    const bool reroute = routes.isEmpty() || flows.size() > view.flowChangeLimit();
+    if (reroute) {
+        view.updateRoutes();
+    } else {
+        for (const int edge : edges) {
+            const BusEdge& e = t.edges[edge];
+            routes.measuredBusy[edge] = view.busValue("edge_#_to_#_busy_rate", e.from, e.to);
+        }
+        if (!flows.isEmpty())
+            view.routing.applyFlowChanges(routes, stats, flows);
+        view.routing.rank(routes);
+    }
+
+    if (built.comparison) {
+        // 对比模式下连线只按实测使用率着色
+        for (const int edge : edges)
+            styleEdge(built, t, edge);
+    } else if (reroute || routes.busyPerPacket != busyPerPacket) {
+        // 拟合比例变了，每条连线的预测使用率都随之变化
+        built.restyleNext = 0;
+    } else {
+        for (int edge = 0; edge < t.edges.size(); ++edge) {
+            if (built.busEdgeLink[edge] >= 0
+                && (routes.measuredBusy[edge] != measured[edge]
+                    || routes.predictedBusy[edge] != predicted[edge]))
+                styleEdge(built, t, edge);
+        }
+    }
+    if (routes.hotspots != hotspots)
+        placeHotspots(built, t);
+    if (!sameFlows(routes.topFlows, topFlows))
+        placeFlowPaths(built, t);
+}
+
+bool SceneBuilder::restyleEdges(BuiltScene& built, const Topology& t, int count) {
+    if (built.restyleNext < 0)
+        return false;
+    const int end = qMin(int(t.edges.size()), built.restyleNext + count);
+    for (int edge = built.restyleNext; edge < end; ++edge) {
+        if (built.busEdgeLink[edge] >= 0)
+            styleEdge(built, t, edge);
+    }
+    built.restyleNext = end < t.edges.size() ? end : -1;
+    return built.restyleNext >= 0;
+}
+
+void SceneBuilder::searchTargets(const BuiltScene& built, const Topology& t, const CounterStore& stats,
+                                 const SearchResult& result, QVector<ModuleItem*>& modules,
+                                 QVector<int>& links) {
+    modules.clear();
+    links.clear();
+    const StatsView& view = built.view;
+    QVector<quint8> moduleSeen(built.moduleItems.size(), 0);
+    QVector<quint8> routerSeen(built.routerItems.size(), 0);
+    auto addRouter = [&](int node) {
+        if (node >= 0 && node < routerSeen.size() && !routerSeen[node] && built.routerItems[node]) {
+            routerSeen[node] = 1;
+            modules.append(built.routerItems[node]);
+        }
+    };
+    auto addModule = [&](int m) {
+        if (m >= 0 && m < moduleSeen.size() && !moduleSeen[m] && built.moduleItems[m]) {
+            moduleSeen[m] = 1;
+            modules.append(built.moduleItems[m]);
+        }
+    };
+    auto addPort = [&](int port) {
+        if (port < 0 || port >= t.moduleOfPort.size())
+            return;
+        const int m = t.moduleOfPort[port];
+        if (m >= 0 && m < built.moduleItems.size() && built.moduleItems[m])
+            addModule(m);
+        else
+            addRouter(t.nodeOfPort.value(port, -1));
+    };
+
+    for (const qint32 id : result.modules) {
+        if (id == view.busModule) {
+            if (result.rows.isEmpty()) {
+                for (int node = 0; node < built.routerItems.size(); ++node)
+                    addRouter(node);
+            }
+            continue;
+        }
+        addModule(id < view.topoModule.size() ? view.topoModule[id] : -1);
+    }
+    // 总线上的行按计数器落到路由器、连线或流量两端
+    for (const qint32 r : result.rows) {
+        if (stats.rowModule[r] != view.busModule)
+            continue;
+        const int index0 = stats.rowIndex0[r];
+        const int index1 = stats.rowIndex1[r];
+        if (stats.rowCounter[r] == view.flowCounter) {
+            addPort(index0);
+            addPort(index1);
+        } else if (stats.rowCounter[r] == view.edgeCounter && index1 >= 0) {
+            const int edge = view.edgeOfPair.value(StatsView::pairKey(index0, index1), -1);
+            if (edge >= 0 && built.busEdgeLink[edge] >= 0)
+                links.append(built.busEdgeLink[edge]);
+        } else if (index1 < 0) {
+            addRouter(index0);
+        }
+    }
+    std::sort(links.begin(), links.end());
+    links.erase(std::unique(links.begin(), links.end()), links.end());
+}
+
+SceneTarget SceneBuilder::targetOf(const ModuleItem* item) {
+    SceneTarget target;
+    if (!item)
+        return target;
+    const QVariant kind = item->data(TargetKindData);
+    if (kind.isValid()) {
+        target.kind = SceneTarget::Kind(kind.toInt());
+        target.index = item->data(TargetIndexData).toInt();
+    }
+    return target;
+}
+
+QString SceneBuilder::describeLink(const BuiltScene& built, const Topology& t, int link) {
+    const int edge = link >= 0 && link < built.linkBusEdge.size() ? built.linkBusEdge[link] : -1;
+    if (edge < 0)
+        return QString();
+    const BusEdge& e = t.edges[edge];
+    QString text = QString("Router%1 → Router%2").arg(e.from).arg(e.to);
+    if (built.edgeUsage[edge] >= 0)
+        text += QString("\n使用率: %1").arg(percent(built.edgeUsage[edge], 2));
+    if (built.comparison) {
+        const QPair<double, double> usage = comparedUsage(built, t, edge);
+        if (!qIsNaN(usage.second)) {
+            text += QString("\n对比运行: %1 (%2)")
+                        .arg(percent(usage.second, 2),
+                             changeText(RunComparison::relativeChange(usage.first, usage.second)));
+        }
+    }
+    const RouteLoad& routes = built.view.routes;
+    if (!routes.isEmpty()) {
+        if (routes.predictedBusy[edge] >= 0)
+            text += QString("\n预测使用率: %1").arg(percent(routes.predictedBusy[edge], 2));
+        text += QString("\n预测包数: %1").arg(qint64(routes.edgeLoad[edge]));
+        if (routes.hotspots.contains(edge))
+            text += "\n热点连线";
+    }
+    return text;
+}
+
+DetailLevel SceneBuilder::detailLevelFor(qreal scale) {
+    if (scale < kBlocksScale)
+        return DetailLevel::Overview;
+    if (scale < kFullScale)
+        return DetailLevel::Blocks;
+    return DetailLevel::Full;
+}
+
+void SceneBuilder::setDetailLevel(BuiltScene& built, DetailLevel level) {
+    if (level == built.detail || !built.labelLayer)
+        return;
+    const bool full = level == DetailLevel::Full;
+    const bool blocks = level != DetailLevel::Overview;
+    built.labelLayer->setVisible(full);
+    built.links->setLabelsVisible(full);
+    built.chainLayer->setVisible(blocks);
+    built.tileLayer->setVisible(!blocks);
+    // 端口与模块名由各模块自己绘制，逐个切换；只在跨过阈值时发生一次
+    if (full != (built.detail == DetailLevel::Full)) {
+        for (const QVector<ModuleItem*>* items : {&built.moduleItems, &built.l1Items, &built.routerItems}) {
+            for (ModuleItem* item : *items) {
+                if (item)
+                    item->setDetailVisible(full);
+            }
+        }
+    }
+    built.detail = level;
+}
+
+void SceneBuilder::setStaticCached(BuiltScene& built, bool cached) {
+    for (QGraphicsItem* layer : {built.chainLayer, built.tileLayer, built.staticLayer}) {
+        if (!layer)
+            continue;
+        for (QGraphicsItem* item : layer->childItems())
+            item->setFlag(QGraphicsItem::ItemHasNoContents, cached);
+    }
+}
@@ -0,0 +1,243 @@
+// scenebuilder.h
+#ifndef SCENEBUILDER_H
+#define SCENEBUILDER_H
+#include <QVector>
+#include <QHash>
+#include <QColor>
+#include <QPen>
+#include "topology.h"
+#include "layoutengine.h"
+#include "derivedmetrics.h"
+#include "routeengine.h"
+
+class QGraphicsScene;
+class ModuleItem;
+class EdgeLayer;
+class CounterStore;
+class QGraphicsSimpleTextItem;
+class QGraphicsRectItem;
+class QGraphicsPathItem;
+class QGraphicsItem;
+class RunComparison;
+class LatencyBars;
+class LatencyHistograms;
+struct SearchResult;
+
+// 缩放相关的细节层级，由粗到细
+// Overview：每条 CPU+L1+L2 链画成一块，不画端口和文字
+// Blocks：逐个画模块，仍不画端口和文字
+// Full：全部细节
+enum class DetailLevel { Overview, Blocks, Full };
+
+// 细节层级的缩放阈值；场景中的图元与瓦片缓存都按这一组切换，同一缩放下细节一致
+const qreal kBlocksScale = 0.12;  // 低于此比例时链聚合成块
+const qreal kFullScale = 0.35;    // 不低于此比例时显示端口和文字
+
+// 拓扑中的模块与 CounterStore 之间的对应关系，以及各模块详情里要展示的行
+// 构建场景时建立一次；之后追加的行和模块用 catchUp 增量并入，不重新扫描全部行
+class StatsView {
+public:
+    const CounterStore* store = nullptr;
+    QVector<int> storeModule;              // Topology 模块 -> CounterStore 模块ID
+    QVector<int> topoModule;               // CounterStore 模块ID -> Topology 模块
+    int busModule = -1;                    // 总线在 CounterStore 中的模块ID
+    int edgeCounter = -1;                  // "edge_#_to_#_busy_rate" 的计数器ID
+    int flowCounter = -1;                  // "transmit_package_number_from_#_to_#" 的计数器ID
+    QVector<QVector<qint32>> moduleRows;   // CounterStore 模块 -> 不带两个下标的行
+    QVector<QVector<qint32>> nodeRows;     // 总线节点 -> node_#_xxx 行
+    // 连续的一段行 [begin, end)；同一模块的行在统计文件中大多相邻，按段记录所占空间与段数而不是行数相关
+    struct RowRange { qint32 begin; qint32 end; };
+    QVector<QVector<RowRange>> moduleRanges;   // CounterStore 模块 -> 全部行
+    QVector<QVector<qint32>> nodePairRows;     // 总线节点 -> 以其为第一个下标的双下标行，如出边使用率，流量除外
+    QVector<QVector<RowRange>> flowRanges;     // 端口 -> 从该端口发出的流量行，最后一组为超出拓扑端口表的
+    QHash<qint64, int> edgeOfPair;         // (from, to) -> Topology::edges 下标
+    DerivedMetrics metrics;                // 命中率、IPC 等派生指标，按 CounterStore 模块ID
+    RouteEngine routing;
+    RouteLoad routes;                      // 流量投射到各连线上的负载与热点
+
+    void reset(const Topology& t, const CounterStore* s);
+    // 换成同源的另一份存储（各ID与行号一致），如某个 epoch 的值或移动后的同一份存储
+    void setStore(const CounterStore* s);
+    // 并入 reset 之后新增的模块与行
+    void catchUp(const Topology& t);
+    // 重新把流量投射到连线上（流量行变化之后）
+    void updateRoutes();
+    // 场景中各标签、详情和连线实测使用率读取的行，切换 epoch 时只需比较这些行；
+    // 流量行与端口数的平方相当，不在其中，由调用方按各 epoch 间变化了的流量行另行给出
+    QVector<qint32> displayedRows(const Topology& t) const;
+    // 已并入的全部流量行，按行号排列
+    QVector<qint32> allFlowRows() const;
+    int flowRowCount() const { return flowRows; }
+    // 一次变化的流量行超过这个数时重新投射全部流量，比逐行沿路由加差额更快
+    int flowChangeLimit() const { return qMax(kMinFlowChangeLimit, flowRows / 8); }
+    // 检查面板列出的行，只取已并入的 [begin, end) 内的，按行号排列：
+    // 模块的全部行；路由器为总线上本节点的 node_X_*、出边等行，以及从本节点端口发出的流量
+    QVector<qint32> moduleRowsIn(int storeModule, int begin, int end) const;
+    QVector<qint32> routerRowsIn(const Topology& t, int node, int begin, int end) const;
+    // 已按模块/节点归类的行数
+    int indexedRowCount() const { return indexedRows; }
+
+    bool isValid() const;
+    double value(int topoModule, const char* counter, double defaultValue = -1) const;
+    double busValue(const char* counter, int index0, int index1, double defaultValue = -1) const;
+    // 模块的派生指标，没有为 NaN
+    double metric(int topoModule, int metric) const;
+    QString metricText(int metric, double value) const;
+
+    static qint64 pairKey(int from, int to) { return (qint64(from) << 32) | quint32(to); }
+
+private:
+    static const int kMinFlowChangeLimit = 4096;
+
+    int indexedModules = 0;
+    int indexedRows = 0;
+    int flowRows = 0;
+};
+
+// 由 Topology 构建出的场景图元，下标与模型一一对应，便于之后按模型更新样式
+struct BuiltScene {
+    QVector<ModuleItem*> moduleItems;     // 对应 Topology::modules，不绘制的模块为 nullptr
+    QVector<ModuleItem*> l1Items;         // 对应 Topology::modules，只有 L2Cache 有 L1
+    QVector<ModuleItem*> routerItems;     // 每个总线节点一个路由器
+    QVector<QGraphicsSimpleTextItem*> statLabels; // 对应 Topology::modules，命中率等统计标签
+    EdgeLayer* links = nullptr;           // 路由器之间及挂到路由器上的连线，带使用率标签
+    EdgeLayer* chainLinks = nullptr;      // CPU/L1/L2 链内的连线，位于 chainLayer
+    QVector<int> busEdgeLink;             // Topology::edges -> links 中的连线，自环为 -1
+    QVector<int> linkBusEdge;             // links 中的连线 -> Topology::edges，其他连线为 -1
+    QVector<double> edgeUsage;            // 对应 Topology::edges，实测使用率，没有数据为 -1
+    QVector<QGraphicsRectItem*> hotspotMarkers; // 标在 view.routes.hotspots 各连线起点，多余的隐藏
+    QVector<QGraphicsPathItem*> flowPaths;      // view.routes.topFlows 的路由路径，多余的隐藏
+    StatsView view;
+    const RunComparison* comparison = nullptr;  // 不为空时模块与连线按与对比运行的相对变化着色
+    QVector<LatencyBars*> latencyBars;    // 对应 Topology::modules，L2/L3 下方的分段延迟条，首次用到时创建
+    LatencyBars* latencyTotals = nullptr; // 图例下方 cache_event_trace 的全部事件合计
+    bool playback = false;                // 正在回放总线事件，flowPaths 隐藏
+    int restyleNext = -1;                 // 分批重设连线样式时下一条 Topology::edges，没有待重设的为 -1
+
+    // 按细节层级整体显示/隐藏的图层，子图元保持自己的可见性（如没有使用率时隐藏的标签）
+    QGraphicsItem* labelLayer = nullptr;  // 统计标签、使用率标签与端口映射说明
+    QGraphicsItem* chainLayer = nullptr;  // CPU/L1/L2 模块及其间的连线
+    QGraphicsItem* tileLayer = nullptr;   // 每条链聚合成的一块
+    QGraphicsItem* staticLayer = nullptr; // 路由器、挂在总线上的模块、图例与标题
+    DetailLevel detail = DetailLevel::Full;
+};
+
+// 场景中一个模块图元对应的模型对象，检查面板据此列出参数与计数器
+struct SceneTarget {
+    enum Kind { None, Module, L1, Router };
+    Kind kind = None;
+    int index = -1;   // Module 为 Topology 模块下标，L1 为所属 L2Cache 的模块下标，Router 为总线节点
+};
+
+// 把 setup.txt 的拓扑模型转换成场景中的模块与连线
+// stats 不为空时，命中率、使用率等标签和连线样式取自 statistic.txt
+// layout 为空时现场调用 LayoutEngine 计算位置
+class SceneBuilder {
+public:
+    static BuiltScene build(QGraphicsScene* scene, const Topology& topology,
+                            const CounterStore* stats = nullptr, const Layout* layout = nullptr);
+
+    // 统计数据增量变化后只刷新受影响的图元：统计标签、连线样式和使用率标签
+    // changedRows 为 stats 中新增或值发生变化的行，可以有重复。
+    // stats 可以换成同源的另一份存储（如某个 epoch 的值），各ID与行号必须一致。
+    // 只重设实测或预测使用率变了的连线；拟合比例变化时全部连线的预测值都变，
+    // 改为标记 restyleNext，由调用方用 restyleEdges 分批重设。
+    static void applyChanges(BuiltScene& built, const Topology& topology,
+                             const CounterStore& stats, const QVector<qint32>& changedRows);
+    // 继续分批重设连线样式，本次最多 count 条；还有剩余返回 true
+    static bool restyleEdges(BuiltScene& built, const Topology& topology, int count);
+
+    // 对比模式：comparison 对齐在 view.store 上，由调用方持有；为空时恢复平时的配色
+    // 模块按代表指标（IPC、命中率、内存使用率）、路由器连线按使用率的相对变化着色
+    static void setComparison(BuiltScene& built, const Topology& topology,
+                              const RunComparison* comparison);
+
+    // 事件跟踪的分段延迟：L2 下方为该核心发起的事件，L3 下方为经过该分片的事件，
+    // 图例下方为全部事件；histograms 由调用方持有，为空时隐藏这些延迟条
+    static void setLatency(BuiltScene& built, const Topology& topology,
+                           const LatencyHistograms* histograms);
+
+    // 端口 fromPort 到 toPort 的包在场景中走过的折线：源模块中心 → 各跳连线的两端 → 目的模块中心
+    // 端口没有映射到路由器或目的不可达时返回 false
+    static bool packetRoute(const BuiltScene& built, const Topology& topology, int fromPort, int toPort,
+                            QVector<QPointF>& points);
+    // 回放总线事件期间隐藏静态的主要流量路径
+    static void setPlayback(BuiltScene& built, const Topology& topology, bool active);
+
+    // 搜索结果在场景中对应的模块图元与 links 中的连线（各自去重）：模块的行落在模块上，
+    // 总线的 node_# 行落在路由器上，边使用率落在连线上，流量落在两端端口所连的模块（没有则为路由器）上；
+    // 只按名称命中总线时为全部路由器。stats 为结果所指的存储，与 view.store 同源
+    static void searchTargets(const BuiltScene& built, const Topology& topology, const CounterStore& stats,
+                              const SearchResult& result, QVector<ModuleItem*>& modules, QVector<int>& links);
+
+    // 图元对应的模型对象，取自构建时记在图元上的数据；图例等没有对应对象的图元 kind 为 None
+    static SceneTarget targetOf(const ModuleItem* item);
+
+    // 视图缩放比例对应的细节层级；阈值按文字与端口在屏幕上大致可辨认的大小选取
+    static DetailLevel detailLevelFor(qreal scale);
+    static void setDetailLevel(BuiltScene& built, DetailLevel level);
+
+    // chainLayer、tileLayer 与 staticLayer 改由视图的瓦片缓存绘制时，这几层的图元不再逐个绘制
+    // （设为 ItemHasNoContents，仍可悬停、点击和拖动）；挂在路由器上的热点标记照常绘制
+    static void setStaticCached(BuiltScene& built, bool cached);
+
+    // links 中某条连线的悬停提示
+    static QString describeLink(const BuiltScene& built, const Topology& topology, int link);
+
+    static QString formatValue(const CounterStore& store, int row);
+    static QPen edgePen(double usage);
+    // 相对变化的发散配色：增加为红、减少为蓝，不足 2% 为浅灰白，缺数据为灰
+    static QColor changeColor(double relative);
+    static QPen changePen(double relative);
+    static QString changeText(double relative);   // "+12.3%"
+
+    // 图例与模块共用的配色
+    static const QColor cpuColor;
+    static const QColor l1Color;
+    static const QColor l2Color;
+    static const QColor l3Color;
+    static const QColor memColor;
+    static const QColor routerColor;
+    static const QColor busyPathColor;
+    static const QColor flowPathColor;
+    static const QColor increaseColor;
+    static const QColor decreaseColor;
+    static const QColor noChangeColor;
+    static const QColor noChangeDataColor;
+};
+
+// 分批构建场景：每次 run 只创建预算时间内能完成的图元，界面线程可以逐帧推进而不卡顿
+// topology 必须在构建完成前保持不变；view 与 layout 可以事先在工作线程里准备好
+class SceneBuildJob {
+public:
+    SceneBuildJob(QGraphicsScene* scene, const Topology& topology, const StatsView& view,
+                  const Layout& layout);
+
+    // 创建图元直到全部完成或用时超过 budgetNs（负数为不限时），全部完成返回 true
+    bool run(qint64 budgetNs);
+    bool isDone() const { return phase == Done; }
+    int progress() const;   // 0 - 100
+    BuiltScene& result() { return built; }
+
+private:
+    enum Phase { Routers, Chains, Attached, BusEdges, Decorations, Done };
+
+    void addRouter(int node);
+    void addChain(int row);
+    void addAttached(int module);
+    void addBusEdge(int edge);
+    void addDecorations();
+
+    QGraphicsScene* scene;
+    const Topology& t;
+    Layout layout;
+    BuiltScene built;
+    QVector<QVector<int>> nodePorts;   // 总线节点 -> 映射到该节点且连了模块的端口
+    QVector<bool> nodeHasPort;
+    Phase phase = Routers;
+    int next = 0;
+    int done = 0;
+    int total = 0;
+};
+
+#endif // SCENEBUILDER_H
@@ -1,425 +1,975 @@
-#include "scenewidget.h"
-#include "moduleitem.h"
-#include "connectionitem.h"
-#include <QGraphicsScene>
-#include <QList>
-#include <QPoint>
-#include <QBrush>
-#include <QColor>
-#include <QGraphicsTextItem>
-#include <QTimer>
-#include <QPen>
-#include <QGraphicsPathItem>
-#include <QFont>
-#include <QDebug>
-
-SceneWidget::SceneWidget(QWidget *parent) : QGraphicsView(parent)
-{
-    QGraphicsScene* scene = new QGraphicsScene(this);
-    scene->setSceneRect(0, 0, 1800, 1200);  // 扩大场景尺寸
-    setScene(scene);
-    setRenderHint(QPainter::Antialiasing);
-    setRenderHint(QPainter::SmoothPixmapTransform);
-
-    // ============== 创建关键颜色定义 ==============
-    const QColor cpuColor(211, 211, 211);    // CPU灰色
-    const QColor l1Color(255, 215, 0);       // L1黄金色
-    const QColor l2Color(30, 144, 255);      // L2道奇蓝
-    const QColor l3Color(50, 205, 50);       // L3酸橙绿
-    const QColor memColor(255, 99, 71);      // 内存番茄红
-    const QColor routerColor(240, 248, 255); // 路由器爱丽丝蓝
-    const QColor busyPathColor(220, 20, 60); // 高负载路径深红
-
-    // ============== 创建路由器节点 ==============
-    QList<ModuleItem*> routers;
-    // 优化布局：路由器按环形排列，避免遮挡
-    const QList<QPointF> routerPositions = {
-        QPointF(700, 300),   // Router0 (中心位置)
-        QPointF(900, 300),   // Router1 (右侧)
-        QPointF(900, 500),   // Router2 (右下)
-        QPointF(700, 500),   // Router3 (左下)
-        QPointF(500, 400),   // Router4 (左侧)
-        QPointF(1100, 400)   // Router5 (右侧空闲节点)
-    };
-
-    for (int i = 0; i < routerPositions.size(); ++i) {
-        QString name = QString("Router%1").arg(i);
-        if (i == 5) name += " (空闲)";
-
-        ModuleItem* router = new ModuleItem(name, routerPositions[i].x(),
-                                            routerPositions[i].y(), 120, 70);
-        router->setBrush(routerColor);
-
-        // 添加多个端口：左、右、上、下
-        router->addPort(ModuleItem::Left);
-        router->addPort(ModuleItem::Right);
-        router->addPort(ModuleItem::Top);
-        router->addPort(ModuleItem::Bottom);
-
-        scene->addItem(router);
-        routers.append(router);
-        if (i == 0) {
-            QString routerInfo = "<b>Router0 详细信息:</b><br>"
-                                 "• 类型: 中央路由器<br>"
-                                 "• 端口数: 4 (上/下/左/右)<br>"
-                                 "• 连接数: 5<br>"
-                                 "• 平均延迟: 3.2ns<br>"
-                                 "• 最大带宽: 20GB/s<br>"
-                                 "<b>端口映射:</b><br>"
-                                 "• Port1: L3Cache0<br>"
-                                 "• Port2: CPU0 子系统";
-            router->setInfoText(routerInfo);
-        }
-
-        // 标注端口映射关系 (根据文档2要求)
-        if (i == 0) {
-            // Router0: Port1 -> L3Cache0
-            QGraphicsTextItem* portLabel = new QGraphicsTextItem("Port1: L3Cache0");
-            portLabel->setPos(routerPositions[i].x() + 130, routerPositions[i].y() + 10);
-            portLabel->setDefaultTextColor(Qt::darkBlue);
-            scene->addItem(portLabel);
-        }
-    }
-
-    // ============== 创建CPU + L1 + L2缓存子系统 ==============
-    QList<ModuleItem*> cpus;
-    QList<ModuleItem*> l1Caches;
-    QList<ModuleItem*> l2Caches;
-
-    // 优化布局：CPU/L1/L2垂直排列在左侧
-    const QList<QPointF> cpuPositions = {
-        QPointF(200, 200),   // CPU0
-        QPointF(200, 400),   // CPU1
-        QPointF(200, 600),   // CPU2
-        QPointF(200, 800)    // CPU3
-    };
-
-    // L1缓存位置：位于CPU右侧
-    const QList<QPointF> l1Positions = {
-        QPointF(350, 200),   // L1d0 + L1i0
-        QPointF(350, 400),   // L1d1 + L1i1
-        QPointF(350, 600),   // L1d2 + L1i2
-        QPointF(350, 800)    // L1d3 + L1i3
-    };
-
-    // L2缓存位置：位于L1右侧
-    const QList<QPointF> l2Positions = {
-        QPointF(500, 200),   // L2Cache0
-        QPointF(500, 400),   // L2Cache1
-        QPointF(500, 600),   // L2Cache2
-        QPointF(500, 800)    // L2Cache3
-    };
-
-    for (int i = 0; i < 4; ++i) {
-        // 创建CPU模块
-        ModuleItem* cpu = new ModuleItem(QString("CPU%1").arg(i),
-                                         cpuPositions[i].x(), cpuPositions[i].y(),
-                                         120, 60);
-        cpu->setBrush(cpuColor);
-        cpu->addPort(ModuleItem::Right); // 右侧端口连接L1
-        scene->addItem(cpu);
-        cpus.append(cpu);
-        QString cpuInfo = QString("<b>CPU%1 详细信息:</b><br>").arg(i)
-                          + "• 架构: ARMv8.2<br>"
-                            "• 频率: 2.5GHz<br>"
-                            "• 核心数: 4<br>"
-                            "• 缓存:<br>"
-                            "  - L1i: 32KB<br>"
-                            "  - L1d: 32KB<br>"
-                            "• 功耗: 15W<br>"
-                            "• 指令数: " + QString::number(i * 20000 + 30000) + "/s";
-        cpu->setInfoText(cpuInfo);
-
-        // 创建L1缓存模块 (分为L1d和L1i)
-        ModuleItem* l1Cache = new ModuleItem(QString("L1%1").arg(i),
-                                             l1Positions[i].x(), l1Positions[i].y(),
-                                             100, 60);
-        l1Cache->setBrush(l1Color);
-        l1Cache->addPort(ModuleItem::Left);  // 左侧连接CPU
-        l1Cache->addPort(ModuleItem::Right); // 右侧连接L2
-        scene->addItem(l1Cache);
-        l1Caches.append(l1Cache);
-        QString l1Info = QString("<b>L1%1 缓存:</b><br>").arg(i)
-                         + "• 类型: 一级缓存<br>"
-                           "• 大小: 64KB (32KB指令+32KB数据)<br>"
-                           "• 延迟: 0.8ns<br>"
-                           "• 关联性: 4路<br>"
-                           "• 命中率: " + QString::number(96.0 + i) + "%";
-        l1Cache->setInfoText(l1Info);
-
-        // 创建L2缓存模块 (显式标注)
-        ModuleItem* l2Cache = new ModuleItem(QString("L2Cache%1").arg(i),
-                                             l2Positions[i].x(), l2Positions[i].y(),
-                                             120, 50);
-        l2Cache->setBrush(l2Color);
-        l2Cache->addPort(ModuleItem::Left);  // 左侧连接L1
-        l2Cache->addPort(ModuleItem::Right); // 右侧连接路由器
-        scene->addItem(l2Cache);
-        l2Caches.append(l2Cache);
-        QString l2Info = QString("<b>L2%1 缓存:</b><br>").arg(i)
-                         + "• 类型: 二级缓存<br>"
-                           "• 总线端口: %2<br>"
-                           "• L2路数: 8<br>"
-                           "• L2组数: 128<br>"
-                           "• MSHR数: 8<br>"
-                           "• 索引延迟: 4周期<br>"
-                           "• 命中率: " + QString::number(96.0 + i) + "%";
-        l2Cache->setInfoText(l2Info);
-
-        // 连接CPU到L1缓存
-        scene->addItem(new ConnectionItem(
-            cpu->getPortPos(0),
-            l1Cache->getPortPos(0),
-            QPen(Qt::black, 2, Qt::SolidLine, Qt::RoundCap)
-            ));
-
-        // 连接L1到L2缓存
-        scene->addItem(new ConnectionItem(
-            l1Cache->getPortPos(1),
-            l2Cache->getPortPos(0),
-            QPen(Qt::darkGray, 2, Qt::SolidLine, Qt::RoundCap)
-            ));
-
-        // 连接L2缓存到路由器 (根据文档2的端口映射)
-        int routerIndex = i; // 默认映射
-        if (i == 2) routerIndex = 3; // CPU2 -> Router3
-        if (i == 3) routerIndex = 4; // CPU3 -> Router4
-
-        scene->addItem(new ConnectionItem(
-            l2Cache->getPortPos(1),
-            routers[routerIndex]->getPortPos(ModuleItem::Left), // 使用Left端口连接
-            QPen(Qt::black, 2, Qt::SolidLine, Qt::RoundCap)
-            ));
-    }
-
-    // ============== 创建L3缓存模块 ==============
-    QList<ModuleItem*> l3Caches;
-    // L3缓存位置：位于路由器下方
-    const QList<QPointF> l3Positions = {
-        QPointF(700, 600),   // L3Cache0 (Router0下方)
-        QPointF(900, 600),   // L3Cache1 (Router1下方)
-        QPointF(900, 700),   // L3Cache2 (Router2下方)
-        QPointF(700, 700)    // L3Cache3 (Router3下方)
-    };
-
-    for (int i = 0; i < 4; ++i) {
-        ModuleItem* l3Cache = new ModuleItem(QString("L3Cache%1").arg(i),
-                                             l3Positions[i].x(), l3Positions[i].y(),
-                                             150, 60);
-        l3Cache->setBrush(l3Color);
-        l3Cache->addPort(ModuleItem::Top); // 顶部端口连接路由器
-        scene->addItem(l3Cache);
-        l3Caches.append(l3Cache);
-        QString l3Info = QString("<b>L3%1 缓存:</b><br>").arg(i)
-                         +      "• 类型: 共享三级缓存<br>"
-                                "• 总线端口: %2<br>"
-                                "• 路数: 8<br>"
-                                "• 组数: 512<br>"
-                                "• MSHR数: 8<br>"
-                                "• 索引延迟: 10周期<br>"
-                                "• NUCA索引: %3/4<br>"
-                                "• 命中率: " + QString::number(96.0 + i) + "%";
-        l3Cache->setInfoText(l3Info);
-
-
-        // 连接到路由器 (根据文档2的端口映射)
-        int routerIndex = i; // 默认映射
-        if (i == 2) routerIndex = 2; // L3Cache2 -> Router2
-        if (i == 3) routerIndex = 3; // L3Cache3 -> Router3
-
-        scene->addItem(new ConnectionItem(
-            l3Cache->getPortPos(0),
-            routers[routerIndex]->getPortPos(ModuleItem::Bottom), // 使用Bottom端口连接
-            QPen(Qt::darkGreen, 2, Qt::SolidLine, Qt::RoundCap)
-            ));
-    }
-
-    // ============== 创建内存模块 ==============
-    ModuleItem* memory = new ModuleItem("Memory", 500, 700, 200, 80);
-    memory->setBrush(memColor);
-    memory->addPort(ModuleItem::Top); // 顶部端口连接路由器
-    scene->addItem(memory);
-    QString memInfo = "<b>内存子系统:</b><br>"
-                      "• 容量: 16GB DDR4<br>"
-                      "• 频率: 3200MHz<br>"
-                      "• 通道数: 2<br>"
-                      "• 最大带宽: 45GB/s<br>"
-                      "• 平均延迟: 85ns<br>"
-                      "• 当前使用率: 68%";
-    memory->setInfoText(memInfo);
-
-    // 连接到Router2 (根据文档2要求)
-    scene->addItem(new ConnectionItem(
-        memory->getPortPos(0),
-        routers[2]->getPortPos(ModuleItem::Bottom), // 使用Bottom端口连接
-        QPen(Qt::darkRed, 3, Qt::SolidLine, Qt::RoundCap)
-        ));
-
-    // ============== 连接路由器节点 (修复拓扑) ==============
-    struct RouterConnection {
-        int from;
-        int to;
-        double usage;
-        ModuleItem::PortPosition fromPort;
-        ModuleItem::PortPosition toPort;
-    };
-
-    // 根据文档2要求修复拓扑连接
-    const QList<RouterConnection> routerLinks = {
-        {0, 1, 0.0181, ModuleItem::Right, ModuleItem::Left},   // Router0->Router1
-        {0, 5, 0.0052, ModuleItem::Top, ModuleItem::Bottom},   // Router0->Router5 (新增)
-        {1, 0, 0.0154, ModuleItem::Left, ModuleItem::Right},   // Router1->Router0
-        {1, 2, 0.0161, ModuleItem::Bottom, ModuleItem::Top},   // Router1->Router2
-        {2, 1, 0.0163, ModuleItem::Top, ModuleItem::Bottom},   // Router2->Router1
-        {2, 3, 0.0145, ModuleItem::Left, ModuleItem::Right},   // Router2->Router3
-        {3, 2, 0.0066, ModuleItem::Right, ModuleItem::Left},   // Router3->Router2
-        {3, 4, 0.0082, ModuleItem::Bottom, ModuleItem::Top},   // Router3->Router4
-        {4, 3, 0.0034, ModuleItem::Top, ModuleItem::Bottom},   // Router4->Router3
-        {4, 5, 0.0071, ModuleItem::Right, ModuleItem::Left},   // Router4->Router5
-        {5, 0, 0.0071, ModuleItem::Bottom, ModuleItem::Top},   // Router5->Router0 (修复缺失连接)
-        {5, 4, 0.0052, ModuleItem::Left, ModuleItem::Right}    // Router5->Router4
-    };
-
-    for (const auto& link : routerLinks) {
-        QPointF fromPos = routers[link.from]->getPortPos(link.fromPort);
-        QPointF toPos = routers[link.to]->getPortPos(link.toPort);
-
-        // 设置不同颜色表示使用率
-        QPen pen(Qt::darkBlue, 2);
-        if (link.usage > 0.01) {
-            pen = QPen(busyPathColor, 4);
-        }
-
-        scene->addItem(new ConnectionItem(fromPos, toPos, pen));
-
-        // 添加使用率标签
-        if (link.usage > 0) {
-            QGraphicsTextItem* usageLabel = new QGraphicsTextItem(
-                QString("%1%").arg(link.usage * 100, 0, 'f', 2)
-                );
-            QPointF midPoint = (fromPos + toPos) / 2;
-            usageLabel->setPos(midPoint.x() - 20, midPoint.y() - 15);
-            usageLabel->setDefaultTextColor(link.usage > 0.01 ? Qt::red : Qt::darkBlue);
-            QFont labelFont("Arial", 8, QFont::Bold);
-            usageLabel->setFont(labelFont);
-            scene->addItem(usageLabel);
-        }
-    }
-
-    // ============== 标注关键瓶颈路径 ==============
-    // Router0->Router1 (高负载路径)
-    QGraphicsRectItem* busyPathMarker = new QGraphicsRectItem(
-        routers[0]->getPortPos(ModuleItem::Right).x() - 5,
-        routers[0]->getPortPos(ModuleItem::Right).y() - 5,
-        10, 10
-        );
-    busyPathMarker->setBrush(busyPathColor);
-    scene->addItem(busyPathMarker);
-
-
-
-    // ============== 添加NUCA访问路径 ==============
-    // CPU0 → Router0 → Router1 → L3Cache1
-    QPolygonF numaPath;
-    numaPath << cpus[0]->getPortPos(0)
-             << l1Caches[0]->getPortPos(0)
-             << l2Caches[0]->getPortPos(1)
-             << routers[0]->getPortPos(ModuleItem::Right)
-             << routers[1]->getPortPos(ModuleItem::Left)
-             << l3Caches[1]->getPortPos(0);
-
-    QGraphicsPathItem* numaPathIndicator = new QGraphicsPathItem();
-    QPainterPath numaPathPainter;
-    numaPathPainter.moveTo(numaPath[0]);
-    for (int i = 1; i < numaPath.size(); ++i) {
-        numaPathPainter.lineTo(numaPath[i]);
-    }
-    numaPathIndicator->setPath(numaPathPainter);
-    numaPathIndicator->setPen(QPen(QColor(106, 90, 205), 2, Qt::DotLine)); // 紫罗兰色
-    scene->addItem(numaPathIndicator);
-
-    QGraphicsTextItem* numaLabel = new QGraphicsTextItem("跨节点NUCA访问");
-    numaLabel->setPos(numaPath[3].x(), numaPath[3].y() - 20);
-    numaLabel->setDefaultTextColor(QColor(106, 90, 205));
-    scene->addItem(numaLabel);
-
-    // ============== 添加性能数据标签 ==============
-    // CPU性能数据
-    QList<QString> cpuPerf = {
-        "指令数: 31189\n周期: 85339\nL1命中率: 97.5%",
-        "指令数: 34298\n周期: 87306\nL1命中率: 95.0%",
-        "指令数: 10333\n周期: 28999\nL1命中率: 98.7%",
-        "指令数: 9921\n周期: 27904\nL1命中率: 98.8%"
-    };
-
-    for (int i = 0; i < 4; ++i) {
-        QGraphicsTextItem* perfLabel = new QGraphicsTextItem(cpuPerf[i]);
-        perfLabel->setPos(cpuPositions[i].x() - 50, cpuPositions[i].y() + 70);
-        perfLabel->setFont(QFont("Arial", 8));
-        scene->addItem(perfLabel);
-    }
-
-    // L2缓存命中率
-    QList<double> l2HitRates = {0.165, 0.092, 0.056, 0.058}; // 根据文档1计算
-    for (int i = 0; i < 4; ++i) {
-        QGraphicsTextItem* hitLabel = new QGraphicsTextItem(
-            QString("L2命中率: %1%").arg(l2HitRates[i] * 100, 0, 'f', 1)
-            );
-        hitLabel->setPos(l2Positions[i].x() + 130, l2Positions[i].y() + 10);
-        scene->addItem(hitLabel);
-    }
-
-    // L3缓存命中率
-    QList<double> l3HitRates = {0.362, 0.385, 0.400, 0.395}; // 根据文档1计算
-    for (int i = 0; i < 4; ++i) {
-        QGraphicsTextItem* hitLabel = new QGraphicsTextItem(
-            QString("L3命中率: %1%").arg(l3HitRates[i] * 100, 0, 'f', 1)
-            );
-        hitLabel->setPos(l3Positions[i].x() + 160, l3Positions[i].y() + 10);
-        scene->addItem(hitLabel);
-    }
-
-    // 内存使用率
-    QGraphicsTextItem* memUsage = new QGraphicsTextItem("内存使用率: 0.8%");
-    memUsage->setPos(500, 790);
-    scene->addItem(memUsage);
-
-    // ============== 添加图例 ==============
-    QGraphicsRectItem* legendBg = new QGraphicsRectItem(50, 50, 300, 200);
-    legendBg->setBrush(QBrush(QColor(240, 240, 240, 220)));
-    scene->addItem(legendBg);
-
-    QList<QPair<QString, QColor>> legendItems = {
-        {"CPU", cpuColor},
-        {"L1缓存", l1Color},
-        {"L2缓存", l2Color},
-        {"L3缓存", l3Color},
-        {"路由器", routerColor},
-        {"内存", memColor},
-        {"高负载路径", busyPathColor},
-        {"NUCA访问", QColor(106, 90, 205)}
-    };
-
-    for (int i = 0; i < legendItems.size(); ++i) {
-        QGraphicsRectItem* colorIcon = new QGraphicsRectItem(70, 80 + i * 25, 20, 15);
-        colorIcon->setBrush(legendItems[i].second);
-        scene->addItem(colorIcon);
-
-        QGraphicsTextItem* legendLabel = new QGraphicsTextItem(legendItems[i].first);
-        legendLabel->setPos(100, 80 + i * 25 - 5);
-        scene->addItem(legendLabel);
-    }
-
-    // ============== 添加全局标题 ==============
-    QGraphicsTextItem* title = new QGraphicsTextItem("三级缓存NUCA架构拓扑图3_2.");
-    title->setPos(650, 50);
-    QFont titleFont("Arial", 18, QFont::Bold);
-    title->setFont(titleFont);
-    scene->addItem(title);
-
-    // 确保正确缩放视图
-    QTimer::singleShot(100, [this]() {
-        fitInView(sceneRect(), Qt::KeepAspectRatio);
-        scale(2.8, 2.8);  // 适当缩放确保可见性
-    });
-}
+#include "scenewidget.h"
+#include "setupparser.h"
+#include "parallelstatparser.h"
+#include "snapshotcache.h"
+#include "stattailer.h"
+#include "statingest.h"
+#include "timeseriesstore.h"
+#include "edgelayer.h"
+#include "moduleitem.h"
+#include "runcomparison.h"
+#include "cachetrace.h"
+#include "busevents.h"
+#include "packetlayer.h"
+#include "highlightlayer.h"
+#include <QGraphicsScene>
+#include <QWheelEvent>
+#include <QMouseEvent>
+#include <QApplication>
+#include <QTimer>
+#include <QtMath>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QDir>
+#include <QPromise>
+#include <QPaintEvent>
+#include <QFontDatabase>
+#include <QFontMetrics>
+#include <QJsonArray>
+#include <algorithm>
+
+// 工作线程加载好的一组运行结果，交给界面线程分批建场景
+struct LoadedRun {
+    int generation = 0;
+    QString setupPath;
+    QString statPath;
+    qint64 statBytes = 0;        // 已解析的 statistic.txt 字节数
+    bool ok = false;
+    QString error;
+    Topology topology;
+    CounterStore stats;
+    std::unique_ptr<TimeSeriesStore> series;
+    EpochSplitter splitter;
+    Layout layout;
+    StatsView view;
+};
+
+// 工作线程对齐好的对比运行
+struct LoadedComparison {
+    int generation = 0;
+    int loadGeneration = 0;      // 开始时的运行代号，运行换了就不再适用
+    QString statPath;
+    QString error;
+    std::shared_ptr<RunComparison> comparison;   // 失败时为空
+};
+
+// 工作线程归约好的事件跟踪
+struct LoadedTrace {
+    int generation = 0;
+    int loadGeneration = 0;
+    QString path;
+    QString error;
+    std::shared_ptr<LatencyHistograms> histograms; // 失败时为空
+};
+
+namespace {
+
+// 各阶段结束时的进度；之后的部分按建场景的进度推进
+const int kSetupDoneProgress = 10;
+const int kStatsDoneProgress = 60;
+const int kLayoutDoneProgress = 70;
+// 界面线程每帧用于建场景和删除旧场景的时间，留出绘制和响应输入的余量
+const qint64 kBatchBudgetNs = 8 * 1000 * 1000;
+// 分批重设连线样式时每批的条数，批间检查是否超出预算
+const int kRestyleBatch = 4096;
+// 回放的帧间隔与每帧最多注入的包数；注入不完的留到下一帧，画面落后于时间但不卡住
+const int kPlaybackIntervalMs = 16;
+const int kMaxArrivalsPerFrame = 1 << 17;
+// HUD 的刷新间隔与在视口中的边距
+const int kHudIntervalMs = 500;
+const int kHudMargin = 8;
+const int kHudPadding = 6;
+
+// 在工作线程上依次读取快照或解析文本、计算布局；每个阶段之间检查是否已取消
+void loadPipeline(QPromise<std::shared_ptr<LoadedRun>>& promise, const QString& setupPath,
+                  const QString& statPath, const Layout& previous, int generation)
+{
+    std::shared_ptr<LoadedRun> run = std::make_shared<LoadedRun>();
+    run->generation = generation;
+    run->setupPath = setupPath;
+    run->statPath = statPath;
+    run->series.reset(new TimeSeriesStore);
+    promise.setProgressRange(0, 100);
+
+    // 源文件没变时直接读快照，跳过文本解析
+    const SourceStamp setupStamp = SnapshotCache::stampFile(setupPath);
+    const SourceStamp statStamp = SnapshotCache::stampFile(statPath);
+    const QString cachePath = SnapshotCache::cachePathFor(setupPath, statPath);
+    bool saveCache = false;
+    if (SnapshotCache::load(cachePath, setupStamp, statStamp, run->topology, run->stats)) {
+        // 只有单个 epoch 的运行才会写快照，所有模块都属于最后一个 epoch
+        for (int m = 0; m < run->stats.modules.size(); ++m)
+            run->splitter.markSeen(run->stats.modules.at(m));
+        promise.setProgressValue(kStatsDoneProgress);
+    } else {
+        if (!SetupParser::parseFile(setupPath, run->topology, &run->error)) {
+            promise.addResult(run);
+            return;
+        }
+        if (promise.isCanceled())
+            return;
+        promise.setProgressValue(kSetupDoneProgress);
+        if (!statPath.isEmpty()
+            && !TimeSeriesStore::parseFile(statPath, run->stats, *run->series, run->splitter,
+                                           &run->error)) {
+            promise.addResult(run);
+            return;
+        }
+        // 快照里没有各 epoch 的值，多个 epoch 的运行每次重新解析
+        saveCache = setupStamp.size >= 0 && run->series->epochCount() == 0;
+        promise.setProgressValue(kStatsDoneProgress);
+    }
+    run->statBytes = qMax<qint64>(0, statStamp.size);
+    if (promise.isCanceled())
+        return;
+
+    run->layout = LayoutEngine::layout(run->topology, previous.isEmpty() ? nullptr : &previous);
+    run->view.reset(run->topology, &run->stats);
+    if (promise.isCanceled())
+        return;
+    promise.setProgressValue(kLayoutDoneProgress);
+
+    // 界面线程拿到结果后会把数据移走，写快照用隐式共享的副本
+    const Topology topology = run->topology;
+    const CounterStore stats = run->stats;
+    run->ok = true;
+    promise.addResult(run);
+    if (saveCache)
+        SnapshotCache::save(cachePath, setupStamp, statStamp, topology, stats);
+}
+
+} // namespace
+
+SceneWidget::SceneWidget(QWidget *parent) : QGraphicsView(parent), m_series(new TimeSeriesStore)
+{
+    QGraphicsScene* scene = new QGraphicsScene(this);
+    scene->setSceneRect(0, 0, 1800, 1200);
+    setScene(scene);
+    setRenderHint(QPainter::Antialiasing);
+    setRenderHint(QPainter::SmoothPixmapTransform);
+    // 滚轮以鼠标位置为中心缩放，拖动平移
+    setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
+    setDragMode(QGraphicsView::ScrollHandDrag);
+
+    m_tailer = new StatTailer(this);
+    connect(m_tailer, &StatTailer::rowsChanged, this, &SceneWidget::applyStatChanges);
+    connect(m_tailer, &StatTailer::epochCompleted, this, &SceneWidget::completeEpoch);
+    connect(m_tailer, &StatTailer::parseError, this, &SceneWidget::liveTailError);
+    connect(m_tailer, &StatTailer::fileReset, this, [this]() {
+        // 模拟重新开始写入：整体重新加载
+        loadRun(m_setupPath, m_statPath);
+    });
+
+    m_ingest = new StatIngestServer(this);
+    connect(m_ingest, &StatIngestServer::rowsChanged, this, &SceneWidget::applyStatChanges);
+    connect(m_ingest, &StatIngestServer::epochCompleted, this, &SceneWidget::completeEpoch);
+
+    m_loadWatcher = new QFutureWatcher<std::shared_ptr<LoadedRun>>(this);
+    connect(m_loadWatcher, &QFutureWatcherBase::resultReadyAt, this, [this](int index) {
+        runLoaded(m_loadWatcher->resultAt(index));
+    });
+    connect(m_loadWatcher, &QFutureWatcherBase::progressValueChanged, this, [this](int value) {
+        if (m_loading && !m_buildJob)
+            emit loadProgress(value);
+    });
+    m_compareWatcher = new QFutureWatcher<std::shared_ptr<LoadedComparison>>(this);
+    connect(m_compareWatcher, &QFutureWatcherBase::finished, this, [this]() {
+        if (!m_compareWatcher->isCanceled())
+            comparisonLoaded(m_compareWatcher->result());
+    });
+    m_traceWatcher = new QFutureWatcher<std::shared_ptr<LoadedTrace>>(this);
+    connect(m_traceWatcher, &QFutureWatcherBase::finished, this, [this]() {
+        if (!m_traceWatcher->isCanceled())
+            traceLoaded(m_traceWatcher->result());
+    });
+    m_batchTimer = new QTimer(this);
+    m_batchTimer->setInterval(0);
+    connect(m_batchTimer, &QTimer::timeout, this, &SceneWidget::runBatch);
+    m_playTimer = new QTimer(this);
+    m_playTimer->setTimerType(Qt::PreciseTimer);
+    m_playTimer->setInterval(kPlaybackIntervalMs);
+    connect(m_playTimer, &QTimer::timeout, this, &SceneWidget::playbackFrame);
+    m_hudTimer = new QTimer(this);
+    m_hudTimer->setInterval(kHudIntervalMs);
+    connect(m_hudTimer, &QTimer::timeout, this, &SceneWidget::refreshHud);
+    // 后台画好的块回到界面线程放进缓存，只重画这些块所在的范围
+    m_tiles.setReadyHandler([this]() {
+        QMetaObject::invokeMethod(this, [this]() { tilesReady(); }, Qt::QueuedConnection);
+    });
+}
+
+SceneWidget::~SceneWidget()
+{
+    // 仍在进行的加载由工作线程自行结束，结果随 watcher 一起丢弃
+    abortLoad();
+}
+
+void SceneWidget::loadRun(const QString& setupPath, const QString& statPath)
+{
+    abortLoad();
+    m_loading = true;
+    // 重新加载同一运行时从上次的布局热启动
+    const Layout previous = setupPath == m_setupPath ? m_layout : Layout();
+    m_loadWatcher->setFuture(QtConcurrent::run(loadPipeline, setupPath, statPath, previous,
+                                               ++m_loadGeneration));
+    emit loadProgress(0);
+}
+
+void SceneWidget::cancelLoad()
+{
+    if (!m_loading)
+        return;
+    abortLoad();
+    emit loadFinished(false, QString());
+}
+
+void SceneWidget::abortLoad()
+{
+    if (!m_loading)
+        return;
+    m_loading = false;
+    // 工作线程在阶段之间检查取消标记；已经送出的结果按代号丢弃
+    m_loadWatcher->cancel();
+    ++m_loadGeneration;
+    m_buildJob.reset();
+    m_pending.reset();
+    if (m_pendingScene) {
+        retireScene(m_pendingScene);
+        m_pendingScene = nullptr;
+    }
+}
+
+void SceneWidget::runLoaded(const std::shared_ptr<LoadedRun>& run)
+{
+    if (!m_loading || run->generation != m_loadGeneration)
+        return;
+    if (!run->ok) {
+        m_loading = false;
+        emit loadFinished(false, run->error.isEmpty() ? QString("无法加载 %1").arg(run->setupPath)
+                                                      : run->error);
+        return;
+    }
+    // 图元在不显示的场景里分批创建，完成后整体换上；期间旧场景照常可用
+    m_pending = run;
+    m_pendingScene = new QGraphicsScene(this);
+    m_buildJob.reset(new SceneBuildJob(m_pendingScene, run->topology, run->view, run->layout));
+    m_batchTimer->start();
+}
+
+void SceneWidget::runBatch()
+{
+    QElapsedTimer timer;
+    timer.start();
+    if (m_buildJob) {
+        if (m_buildJob->run(kBatchBudgetNs))
+            finishLoad();
+        else
+            emit loadProgress(kLayoutDoneProgress
+                              + m_buildJob->progress() * (100 - kLayoutDoneProgress) / 100);
+    }
+    // 拟合比例变化之后的连线样式
+    while (m_built.restyleNext >= 0 && timer.nsecsElapsed() < kBatchBudgetNs)
+        SceneBuilder::restyleEdges(m_built, m_topology, kRestyleBatch);
+    // 剩余的时间删除换下来的旧场景
+    while (!m_retiredItems.isEmpty() && timer.nsecsElapsed() < kBatchBudgetNs)
+        delete m_retiredItems.takeLast();
+    if (m_retiredItems.isEmpty()) {
+        qDeleteAll(m_retiredScenes);
+        m_retiredScenes.clear();
+    }
+    if (!m_buildJob && m_retiredScenes.isEmpty() && m_built.restyleNext < 0)
+        m_batchTimer->stop();
+}
+
+void SceneWidget::finishLoad()
+{
+    LoadedRun& run = *m_pending;
+    m_tailer->stop();
+    // 包的折线属于旧场景
+    stopPlayback();
+    m_packets = nullptr;
+    m_highlight = nullptr;
+    m_frameStats.clear();
+    m_topology = std::move(run.topology);
+    m_stats = std::move(run.stats);
+    m_series = std::move(run.series);
+    m_splitter = run.splitter;
+    m_layout = run.layout;
+    // 对比是对齐在旧的统计数据上的，换了运行就不再适用
+    ++m_compareGeneration;
+    m_comparison.reset();
+    m_comparisonPath.clear();
+    ++m_traceGeneration;
+    m_latency.reset();
+    m_tracePath.clear();
+    m_built = std::move(m_buildJob->result());
+    m_built.view.setStore(&m_stats);
+    m_built.links->setDescriber([this](int link) {
+        return SceneBuilder::describeLink(m_built, m_topology, link);
+    });
+    m_epoch = -1;
+    m_epochStats = CounterStore();
+    m_displayedRows.clear();
+    m_flowChanges.clear();
+    m_epochFlows = -1;
+    m_setupPath = run.setupPath;
+    m_statPath = run.statPath;
+    m_statBytes = run.statBytes;
+    m_buildJob.reset();
+    m_pending.reset();
+    m_loading = false;
+
+    QGraphicsScene* old = scene();
+    m_pendingScene->setSceneRect(m_pendingScene->itemsBoundingRect().adjusted(-50, -50, 50, 50));
+    setScene(m_pendingScene);
+    m_pendingScene = nullptr;
+    retireScene(old);
+    // 新场景的图元都还是逐个绘制的；重新加载同一运行时没有移动的部分沿用已缓存的块
+    m_tilesShown = false;
+    m_moduleDrag = false;
+    refreshTiles();
+    fitScene();
+
+    restartTailer();
+    // 存储换了内容，推送方的编号重新对应
+    if (m_ingest->isListening())
+        m_ingest->setStore(&m_stats);
+    emit epochsChanged(epochCount());
+    emit loadFinished(true, QString());
+
+    const QString trace = QFileInfo(m_setupPath).dir().filePath(CacheTrace::kFileName);
+    if (QFileInfo::exists(trace))
+        loadTrace(trace);
+}
+
+void SceneWidget::loadComparison(const QString& statPath)
+{
+    const int generation = ++m_compareGeneration;
+    const int loadGeneration = m_loadGeneration;
+    // 工作线程拿一份 m_stats 的副本（隐式共享，不拷贝数据），跟踪追加的行不影响对齐
+    const CounterStore base = m_stats;
+    m_compareWatcher->setFuture(QtConcurrent::run([=]() {
+        std::shared_ptr<LoadedComparison> loaded = std::make_shared<LoadedComparison>();
+        loaded->generation = generation;
+        loaded->loadGeneration = loadGeneration;
+        loaded->statPath = statPath;
+        CounterStore other;
+        if (!ParallelStatParser::parseFile(statPath, other, &loaded->error)) {
+            if (loaded->error.isEmpty())
+                loaded->error = QString("无法读取 %1").arg(statPath);
+            return loaded;
+        }
+        loaded->comparison = std::make_shared<RunComparison>();
+        loaded->comparison->align(base, other);
+        return loaded;
+    }));
+}
+
+void SceneWidget::clearComparison()
+{
+    ++m_compareGeneration;
+    if (!m_comparison)
+        return;
+    SceneBuilder::setComparison(m_built, m_topology, nullptr);
+    m_comparison.reset();
+    m_comparisonPath.clear();
+    refreshTiles();
+    emit comparisonFinished(false, QString());
+}
+
+void SceneWidget::comparisonLoaded(const std::shared_ptr<LoadedComparison>& loaded)
+{
+    if (loaded->generation != m_compareGeneration || loaded->loadGeneration != m_loadGeneration)
+        return;
+    if (!loaded->comparison) {
+        emit comparisonFinished(false, loaded->error);
+        return;
+    }
+    m_comparison = loaded->comparison;
+    m_comparisonPath = loaded->statPath;
+    SceneBuilder::setComparison(m_built, m_topology, m_comparison.get());
+    refreshTiles();
+    emit comparisonFinished(true, QString());
+}
+
+void SceneWidget::loadTrace(const QString& path)
+{
+    const int generation = ++m_traceGeneration;
+    const int loadGeneration = m_loadGeneration;
+    m_traceWatcher->setFuture(QtConcurrent::run([=]() {
+        std::shared_ptr<LoadedTrace> loaded = std::make_shared<LoadedTrace>();
+        loaded->generation = generation;
+        loaded->loadGeneration = loadGeneration;
+        loaded->path = path;
+        std::shared_ptr<LatencyHistograms> histograms = std::make_shared<LatencyHistograms>();
+        if (CacheTraceReader::reduce(path, *histograms, &loaded->error))
+            loaded->histograms = histograms;
+        return loaded;
+    }));
+}
+
+void SceneWidget::clearTrace()
+{
+    ++m_traceGeneration;
+    if (!m_latency)
+        return;
+    SceneBuilder::setLatency(m_built, m_topology, nullptr);
+    m_latency.reset();
+    m_tracePath.clear();
+    emit traceFinished(false, QString());
+}
+
+void SceneWidget::traceLoaded(const std::shared_ptr<LoadedTrace>& loaded)
+{
+    if (loaded->generation != m_traceGeneration || loaded->loadGeneration != m_loadGeneration)
+        return;
+    if (!loaded->histograms) {
+        emit traceFinished(false, loaded->error);
+        return;
+    }
+    // 先画新的再释放旧的，延迟条不会指向已释放的直方图
+    SceneBuilder::setLatency(m_built, m_topology, loaded->histograms.get());
+    m_latency = loaded->histograms;
+    m_tracePath = loaded->path;
+    emit traceFinished(true, QString());
+}
+
+bool SceneWidget::startPlayback(const QString& path, QString* errorMessage)
+{
+    if (!scene() || !m_built.links) {
+        if (errorMessage)
+            *errorMessage = "没有打开的运行";
+        return false;
+    }
+    if (m_stream)
+        endPlayback();
+    std::unique_ptr<BusEventStream> stream(new BusEventStream());
+    if (!stream->open(path, errorMessage))
+        return false;
+    m_stream = std::move(stream);
+    if (!m_packets) {
+        m_packets = new PacketLayer();
+        m_packets->setZValue(2);   // 压在连线与文字上面
+        m_packets->setColor(SceneBuilder::flowPathColor);
+        scene()->addItem(m_packets);
+    }
+    m_packets->setBounds(scene()->sceneRect());
+    m_packets->setRouteFunction([this](int fromPort, int toPort, QVector<QPointF>& points) {
+        return SceneBuilder::packetRoute(m_built, m_topology, fromPort, toPort, points);
+    });
+    m_packets->setVisible(true);
+    SceneBuilder::setPlayback(m_built, m_topology, true);
+    m_playTick = 0;
+    m_playClock.start();
+    m_playTimer->start();
+    return true;
+}
+
+void SceneWidget::stopPlayback()
+{
+    if (!m_stream)
+        return;
+    endPlayback();
+    emit playbackFinished(QString());
+}
+
+void SceneWidget::endPlayback()
+{
+    m_playTimer->stop();
+    m_stream.reset();   // 停止读取线程
+    if (m_packets) {
+        m_packets->clear();
+        m_packets->setVisible(false);
+        SceneBuilder::setPlayback(m_built, m_topology, false);
+    }
+    m_arrivals = QVector<BusEvent>();
+}
+
+void SceneWidget::setPlaybackPaused(bool paused)
+{
+    m_playPaused = paused;
+}
+
+void SceneWidget::setPlaybackSpeed(double ticksPerSecond)
+{
+    m_playSpeed = qMax(0.0, ticksPerSecond);
+}
+
+void SceneWidget::playbackFrame()
+{
+    const double seconds = m_playClock.nsecsElapsed() / 1e9;
+    m_playClock.restart();
+    BusEventRing& ring = m_stream->ring();
+    if (!m_playPaused) {
+        m_playTick += seconds * m_playSpeed;
+        // 没有在途的包时跳过空闲的一段，直接到下一个事件
+        quint64 next = 0;
+        if (m_packets->inFlight() == 0 && ring.nextTick(next) && double(next) > m_playTick)
+            m_playTick = double(next);
+    }
+    const quint64 tick = quint64(m_playTick);
+    m_arrivals.clear();
+    ring.popUntil(tick, m_arrivals, kMaxArrivalsPerFrame);
+    for (const BusEvent& event : m_arrivals)
+        m_packets->add(event);
+    m_packets->advance(tick);
+    emit playbackProgress(tick, m_packets->inFlight());
+
+    if (ring.atEnd() && m_packets->inFlight() == 0) {
+        const QString error = m_stream->error();
+        endPlayback();
+        emit playbackFinished(error);
+    }
+}
+
+void SceneWidget::setHighlight(const SearchResult& result, const CounterStore& stats)
+{
+    if (!m_built.links)
+        return;
+    QVector<ModuleItem*> modules;
+    QVector<int> links;
+    SceneBuilder::searchTargets(m_built, m_topology, stats, result, modules, links);
+    if (!m_highlight) {
+        m_highlight = new HighlightLayer();
+        m_highlight->setZValue(3);   // 压在包与文字上面
+        scene()->addItem(m_highlight);
+    }
+    m_highlight->setBounds(scene()->sceneRect());
+    m_highlight->setTargets(modules, m_built.links, links);
+    m_highlight->setVisible(true);
+}
+
+void SceneWidget::clearHighlight()
+{
+    if (m_highlight) {
+        m_highlight->clear();
+        m_highlight->setVisible(false);
+    }
+}
+
+void SceneWidget::retireScene(QGraphicsScene* scene)
+{
+    // 不再显示的场景不需要空间索引，删除图元时也就不用逐个维护
+    scene->setItemIndexMethod(QGraphicsScene::NoIndex);
+    // 子图元总是叠在父图元之上，按从上到下的顺序删除不会碰到已随父图元删掉的指针；
+    // 同层的后加图元在前，从父图元的子列表末尾移除不需要搬动
+    const QList<QGraphicsItem*> items = scene->items(Qt::DescendingOrder);
+    for (qsizetype i = items.size() - 1; i >= 0; --i)
+        m_retiredItems.append(items[i]);
+    m_retiredScenes.append(scene);
+    m_batchTimer->start();
+}
+
+void SceneWidget::fitScene()
+{
+    // 还没显示时视口大小不对，等 showEvent 再适配
+    if (!isVisible()) {
+        m_fitPending = true;
+        return;
+    }
+    m_fitPending = false;
+    resetTransform();
+    fitInView(sceneRect(), Qt::KeepAspectRatio);
+    updateDetailLevel();
+}
+
+void SceneWidget::showEvent(QShowEvent* event)
+{
+    QGraphicsView::showEvent(event);
+    if (m_fitPending)
+        fitScene();
+}
+
+void SceneWidget::setLiveTail(bool enabled)
+{
+    m_liveTail = enabled;
+    restartTailer();
+}
+
+bool SceneWidget::startIngest(const QString& name, QString* errorMessage)
+{
+    if (!m_built.links) {
+        if (errorMessage)
+            *errorMessage = "没有打开的运行";
+        return false;
+    }
+    return m_ingest->listen(name, &m_stats, errorMessage);
+}
+
+void SceneWidget::stopIngest()
+{
+    m_ingest->close();
+}
+
+void SceneWidget::restartTailer()
+{
+    if (m_liveTail && !m_statPath.isEmpty())
+        m_tailer->start(m_statPath, m_statBytes, &m_stats, m_splitter);
+    else
+        m_tailer->stop();
+}
+
+void SceneWidget::applyStatChanges(const QVector<qint32>& rows)
+{
+    // 正在查看较早的 epoch 时不动画面，回到最后一个 epoch 时再一并刷新
+    if (m_epoch < 0) {
+        applySceneChanges(m_stats, rows);
+        emit statsShown();
+    }
+    // 记入最后一个 epoch 变化了的流量行；还没有比较过的留到用到时一并比较
+    const int live = m_series->epochCount();
+    if (m_flowChanges.size() == live + 1 && m_flowChanges[live].known && !m_flowChanges[live].all) {
+        FlowChanges& changes = m_flowChanges[live];
+        const int flowCounter = m_stats.findCounter("transmit_package_number_from_#_to_#");
+        for (const qint32 r : rows) {
+            if (flowCounter >= 0 && m_stats.rowCounter[r] == flowCounter)
+                changes.rows.append(r);
+        }
+        if (changes.rows.size() > m_built.view.flowChangeLimit()) {
+            std::sort(changes.rows.begin(), changes.rows.end());
+            changes.rows.erase(std::unique(changes.rows.begin(), changes.rows.end()), changes.rows.end());
+            if (changes.rows.size() > m_built.view.flowChangeLimit()) {
+                changes.all = true;
+                changes.rows.clear();
+            }
+        }
+    }
+    emit statsUpdated(int(rows.size()));
+}
+
+void SceneWidget::applySceneChanges(const CounterStore& stats, const QVector<qint32>& rows)
+{
+    SceneBuilder::applyChanges(m_built, m_topology, stats, rows);
+    // 拟合比例变了时全部连线的样式分批重设
+    if (m_built.restyleNext >= 0)
+        m_batchTimer->start();
+}
+
+void SceneWidget::completeEpoch()
+{
+    // m_stats 此时还是刚结束的 epoch 的值
+    const int finished = m_series->epochCount();
+    if (!m_series->appendEpoch(m_stats)) {
+        emit liveTailError(QString("无法写入时序文件"));
+        return;
+    }
+    // 副本是在这个 epoch 中途跟上 m_stats 的，其中的流量行不属于任何一列，下次切换时全部重写
+    if (m_epochFlows == finished)
+        m_epochFlows = -1;
+    // 新的最后一个 epoch 与刚结束的这一列还没有差别
+    m_flowChanges.resize(m_series->epochCount() + 1);
+    m_flowChanges.last().known = true;
+    emit epochsChanged(epochCount());
+}
+
+int SceneWidget::epochCount() const
+{
+    return m_stats.isEmpty() ? 0 : m_series->epochCount() + 1;
+}
+
+void SceneWidget::showEpoch(int epoch)
+{
+    if (epoch < 0 || epoch >= m_series->epochCount())
+        epoch = -1;
+    if (epoch == m_epoch || m_stats.isEmpty())
+        return;
+
+    // 画面上现在的值：最后一个 epoch 取自 m_stats，较早的 epoch 取自时序存储，都不复制整列；
+    // 当时还没有的行视为变化
+    const int shownEpoch = m_epoch;
+    const qsizetype shownRows = shownEpoch < 0 ? m_stats.rowCount() : m_epochStats.rowCount();
+    auto shownValue = [&](qint32 r) {
+        return shownEpoch < 0 ? m_stats.values.at(r) : m_series->value(shownEpoch, r);
+    };
+    // 跟踪期间新增了行：副本跟上 m_stats 的结构，重新取画面用到的行
+    const int live = m_series->epochCount();
+    if (m_epochStats.rowCount() != m_stats.rowCount()) {
+        m_epochStats = m_stats;
+        m_epochFlows = live;
+        m_built.view.setStore(&m_stats);
+        m_built.view.catchUp(m_topology);
+        m_displayedRows = m_built.view.displayedRows(m_topology);
+    }
+
+    // 流量行只取两个 epoch 之间变化过的，路由负载按这些行的差额更新；
+    // 副本中流量行的值不是画面上那个 epoch 的时，还要补上与副本所属 epoch 之间变化过的
+    m_flowChanges.resize(live + 1);
+    const int from = shownEpoch < 0 ? live : shownEpoch;
+    const int to = epoch < 0 ? live : epoch;
+    QVector<qint32> flows;
+    bool allFlows = !flowCandidates(from, to, flows);
+    if (epoch >= 0 && m_epochFlows != from)
+        allFlows = m_epochFlows < 0 || !flowCandidates(m_epochFlows, to, flows) || allFlows;
+    if (allFlows) {
+        flows = m_built.view.allFlowRows();
+    } else {
+        std::sort(flows.begin(), flows.end());
+        flows.erase(std::unique(flows.begin(), flows.end()), flows.end());
+    }
+
+    // 只比较画面用到的行，切换一次的代价与模块数而不是计数器总数相关
+    QVector<qint32> changed;
+    if (epoch < 0) {
+        const double* values = m_stats.values.constData();
+        for (const qint32 r : m_displayedRows) {
+            if (r >= shownRows || shownValue(r) != values[r])
+                changed.append(r);
+        }
+        changed += flows;
+        m_epoch = -1;
+        applySceneChanges(m_stats, changed);
+    } else {
+        // m_epochStats 只在跟上 m_stats 之后与其共享一次，平时写入不会复制整列
+        double* values = m_epochStats.values.data();
+        for (const qint32 r : m_displayedRows) {
+            const double v = m_series->value(epoch, r);
+            if (r >= shownRows || shownValue(r) != v)
+                changed.append(r);
+            values[r] = v;
+        }
+        for (const qint32 r : flows)
+            values[r] = m_series->value(epoch, r);
+        changed += flows;
+        m_epoch = epoch;
+        m_epochFlows = epoch;
+        applySceneChanges(m_epochStats, changed);
+    }
+    emit statsShown();
+}
+
+const SceneWidget::FlowChanges& SceneWidget::flowChanges(int epoch)
+{
+    FlowChanges& changes = m_flowChanges[epoch];
+    if (changes.known)
+        return changes;
+    changes.known = true;
+    const int live = m_series->epochCount();
+    const int limit = m_built.view.flowChangeLimit();
+    for (const qint32 r : m_built.view.allFlowRows()) {
+        const double before = epoch > 0 ? m_series->value(epoch - 1, r) : 0;
+        const double after = epoch < live ? m_series->value(epoch, r) : m_stats.values.at(r);
+        if (before == after)
+            continue;
+        if (changes.rows.size() == limit) {
+            changes.all = true;
+            changes.rows.clear();
+            break;
+        }
+        changes.rows.append(r);
+    }
+    return changes;
+}
+
+bool SceneWidget::flowCandidates(int from, int to, QVector<qint32>& rows)
+{
+    for (int epoch = qMin(from, to) + 1; epoch <= qMax(from, to); ++epoch) {
+        const FlowChanges& changes = flowChanges(epoch);
+        if (changes.all)
+            return false;
+        rows += changes.rows;
+        // 超过上限时反正要重新投射全部流量，不必再比较其余的 epoch
+        if (rows.size() > m_built.view.flowChangeLimit())
+            return false;
+    }
+    return true;
+}
+
+void SceneWidget::mousePressEvent(QMouseEvent* event)
+{
+    m_pressPos = event->position().toPoint();
+    // 按下模块可能开始拖动：缓存的块里还是原来的位置，改回逐个绘制直到松开
+    if (m_tilesShown && event->button() == Qt::LeftButton) {
+        for (QGraphicsItem* item = itemAt(m_pressPos); item; item = item->parentItem()) {
+            if (qgraphicsitem_cast<ModuleItem*>(item)) {
+                m_moduleDrag = true;
+                refreshTiles();
+                break;
+            }
+        }
+    }
+    QGraphicsView::mousePressEvent(event);
+}
+
+// 没有拖动的左键单击：交出点中的模块，由检查面板显示详情
+void SceneWidget::mouseReleaseEvent(QMouseEvent* event)
+{
+    QGraphicsView::mouseReleaseEvent(event);
+    if (m_moduleDrag && event->button() == Qt::LeftButton) {
+        // 重新抄写静态图层，只有模块移动过的范围需要重画
+        m_moduleDrag = false;
+        refreshTiles();
+    }
+    if (event->button() != Qt::LeftButton
+        || (event->position().toPoint() - m_pressPos).manhattanLength() >= QApplication::startDragDistance())
+        return;
+    for (QGraphicsItem* item = itemAt(event->position().toPoint()); item; item = item->parentItem()) {
+        if (ModuleItem* module = qgraphicsitem_cast<ModuleItem*>(item)) {
+            const SceneTarget target = SceneBuilder::targetOf(module);
+            if (target.kind != SceneTarget::None)
+                emit targetClicked(target);
+            return;
+        }
+    }
+}
+
+void SceneWidget::wheelEvent(QWheelEvent* event)
+{
+    const qreal factor = qPow(1.15, event->angleDelta().y() / 120.0);
+    const qreal current = transform().m11();
+    // 限制在能看全大型拓扑到看清端口之间
+    if ((factor < 1 && current < 1e-3) || (factor > 1 && current > 8))
+        return;
+    scale(factor, factor);
+    updateDetailLevel();
+    event->accept();
+}
+
+void SceneWidget::updateDetailLevel()
+{
+    const DetailLevel level = SceneBuilder::detailLevelFor(transform().m11());
+    SceneBuilder::setDetailLevel(m_built, level);
+    // 概览时图元只有几个像素大，抗锯齿看不出区别
+    setRenderHint(QPainter::Antialiasing, level != DetailLevel::Overview);
+}
+
+void SceneWidget::refreshTiles()
+{
+    const bool cached = m_built.staticLayer && !m_built.comparison && !m_moduleDrag;
+    if (cached)
+        m_tiles.setLayer(StaticLayer::capture(m_built));
+    else if (!m_moduleDrag)
+        m_tiles.clear();   // 拖动期间保留，松开后只重画变化的部分
+    if (cached != m_tilesShown) {
+        SceneBuilder::setStaticCached(m_built, cached);
+        m_tilesShown = cached;
+    }
+    viewport()->update();
+}
+
+void SceneWidget::tilesReady()
+{
+    const QRegion dirty = m_tiles.collect();
+    if (m_tilesShown && !dirty.isEmpty())
+        viewport()->update(dirty);
+}
+
+void SceneWidget::drawBackground(QPainter* painter, const QRectF& rect)
+{
+    QGraphicsView::drawBackground(painter, rect);
+    if (!m_tilesShown)
+        return;
+    FrameStats::Timer timer(FrameStats::Tiles);
+    const QTransform transform = viewportTransform();
+    const QRect exposed = transform.mapRect(rect).toAlignedRect() & viewport()->rect();
+    painter->save();
+    painter->resetTransform();
+    m_tiles.draw(painter, transform, exposed, viewport()->devicePixelRatioF(), m_built.detail);
+    painter->restore();
+}
+
+void SceneWidget::paintEvent(QPaintEvent* event)
+{
+    // 只重画 HUD 的那几帧不是场景的帧
+    if (!m_frameTiming || (m_hudVisible && m_hudRect.contains(event->rect()))) {
+        QGraphicsView::paintEvent(event);
+        return;
+    }
+    m_frameStats.beginFrame();
+    FrameStats::current = &m_frameStats;
+    QGraphicsView::paintEvent(event);
+    FrameStats::current = nullptr;
+    m_frameStats.endFrame();
+}
+
+void SceneWidget::scrollContentsBy(int dx, int dy)
+{
+    QGraphicsView::scrollContentsBy(dx, dy);
+    // 视口按像素平移时 HUD 也被移走，原位置与移到的位置都要重画
+    if (m_hudVisible)
+        viewport()->update(m_hudRect | m_hudRect.translated(dx, dy));
+}
+
+void SceneWidget::drawForeground(QPainter* painter, const QRectF& rect)
+{
+    QGraphicsView::drawForeground(painter, rect);
+    if (!m_hudVisible || m_hudText.isEmpty())
+        return;
+    painter->save();
+    painter->resetTransform();
+    painter->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    painter->fillRect(m_hudRect, QColor(0, 0, 0, 170));
+    painter->setPen(Qt::white);
+    painter->drawText(m_hudRect.adjusted(kHudPadding, kHudPadding, -kHudPadding, -kHudPadding),
+                      Qt::AlignLeft | Qt::AlignTop, m_hudText);
+    painter->restore();
+}
+
+void SceneWidget::setFrameTiming(bool enabled)
+{
+    if (enabled == m_frameTiming)
+        return;
+    m_frameTiming = enabled;
+    m_frameStats.clear();
+}
+
+void SceneWidget::setHudVisible(bool visible)
+{
+    if (visible == m_hudVisible)
+        return;
+    m_hudVisible = visible;
+    if (visible) {
+        refreshHud();
+        m_hudTimer->start();
+    } else {
+        m_hudTimer->stop();
+        viewport()->update(m_hudRect);
+        m_hudRect = QRect();
+        m_hudText.clear();
+    }
+}
+
+void SceneWidget::refreshHud()
+{
+    updateFrameCounts();
+    m_hudText = m_frameTiming ? m_frameStats.summary() : QString("帧时间统计未开启");
+    const QFontMetrics metrics(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    const QRect text = metrics.boundingRect(QRect(0, 0, 4096, 4096), Qt::AlignLeft | Qt::AlignTop, m_hudText);
+    const QRect old = m_hudRect;
+    m_hudRect = text.adjusted(0, 0, 2 * kHudPadding, 2 * kHudPadding).translated(kHudMargin, kHudMargin);
+    viewport()->update(old | m_hudRect);
+}
+
+void SceneWidget::updateFrameCounts()
+{
+    auto present = [](const auto& items) {
+        qint64 count = 0;
+        for (const auto* item : items)
+            count += item != nullptr;
+        return count;
+    };
+    m_frameStats.setCount("modules", present(m_built.moduleItems));
+    m_frameStats.setCount("l1", present(m_built.l1Items));
+    m_frameStats.setCount("routers", m_built.routerItems.size());
+    m_frameStats.setCount("labels", present(m_built.statLabels));
+    m_frameStats.setCount("links", m_built.links ? m_built.links->edgeCount() : 0);
+    m_frameStats.setCount("chain_links", m_built.chainLinks ? m_built.chainLinks->edgeCount() : 0);
+    m_frameStats.setCount("latency_bars", present(m_built.latencyBars));
+    m_frameStats.setCount("packets", m_packets ? m_packets->inFlight() : 0);
+    m_frameStats.setCount("tiles", m_tilesShown ? m_tiles.tileCount() : 0);
+    m_frameStats.setCount("tiles_pending", m_tilesShown ? m_tiles.pendingCount() : 0);
+    m_frameStats.setCount("highlighted",
+                          m_highlight ? m_highlight->moduleCount() + m_highlight->linkCount() : 0);
+}
+
+bool SceneWidget::exportFrameStats(const QString& path, QString* errorMessage)
+{
+    updateFrameCounts();
+    QJsonObject object = m_frameStats.toJson();
+    object["setup"] = m_setupPath;
+    object["viewport"] = QJsonArray{viewport()->width(), viewport()->height()};
+    object["scale"] = transform().m11();
+    object["detail"] = int(m_built.detail);
+    object["tiles_cached"] = m_tilesShown;
+    return FrameStats::writeJson(path, object, errorMessage);
+}
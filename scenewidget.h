@@ -1,10 +1,231 @@
-// scenewidget.h
-#ifndef SCENEWIDGET_H
-#define SCENEWIDGET_H
-#include <QGraphicsView>
-class SceneWidget : public QGraphicsView {
-    Q_OBJECT
-public:
-    explicit SceneWidget(QWidget *parent = nullptr);
-};
-#endif // SCENEWIDGET_H
+// scenewidget.h
+#ifndef SCENEWIDGET_H
+#define SCENEWIDGET_H
+#include <QGraphicsView>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
+#include <memory>
+#include "topology.h"
+#include "counterstore.h"
+#include "scenebuilder.h"
+#include "layoutengine.h"
+#include "statparser.h"
+#include "tilecache.h"
+#include "framestats.h"
+class StatTailer;
+class StatIngestServer;
+class TimeSeriesStore;
+class BusEventStream;
+class PacketLayer;
+class HighlightLayer;
+struct SearchResult;
+struct BusEvent;
+class QTimer;
+struct LoadedRun;
+struct LoadedComparison;
+struct LoadedTrace;
+class RunComparison;
+class LatencyHistograms;
+class SceneWidget : public QGraphicsView {
+    Q_OBJECT
+public:
+    explicit SceneWidget(QWidget *parent = nullptr);
+    ~SceneWidget();
+
+    // 读取 setup.txt（以及可选的 statistic.txt）并按其拓扑重建场景
+    // 解析与布局在工作线程上进行，图元再分批在界面线程上创建，结果由 loadFinished 通知；
+    // 加载期间仍显示原来的场景，再次调用会取消前一次加载
+    void loadRun(const QString& setupPath, const QString& statPath = QString());
+    void cancelLoad();
+    bool isLoading() const { return m_loading; }
+    const QString& setupPath() const { return m_setupPath; }
+    const Topology& topology() const { return m_topology; }
+    const CounterStore& stats() const { return m_stats; }
+    // 画面当前所用的统计视图（跟随显示的 epoch），换场景时地址不变
+    const StatsView& statsView() const { return m_built.view; }
+
+    // 实时跟踪：statistic.txt 追加新段时只刷新受影响的图元，不重建场景
+    void setLiveTail(bool enabled);
+    bool liveTail() const { return m_liveTail; }
+
+    // 接收模拟器经本地套接字推送的统计数据：在 name 上监听，更新写入 stats() 后同样只刷新受影响的图元，
+    // epoch 结束帧与跟踪到的 epoch 边界一样记入时序。需要先打开一个运行，换运行后继续接收
+    bool startIngest(const QString& name, QString* errorMessage = nullptr);
+    void stopIngest();
+    StatIngestServer* ingest() const { return m_ingest; }
+
+    // statistic.txt 中的 epoch 数，最后一个就是 stats() 本身；没有统计数据时为 0
+    int epochCount() const;
+    // 当前显示的 epoch，-1 表示跟随最后一个
+    int currentEpoch() const { return m_epoch; }
+    // 切换到某个 epoch 的值；超出范围视为最后一个
+    void showEpoch(int epoch);
+
+    // 与同一拓扑的另一份 statistic.txt 对比：解析与对齐在工作线程上进行，完成后按变化着色，
+    // 结果由 comparisonFinished 通知；重新加载运行或清除对比时放弃
+    void loadComparison(const QString& statPath);
+    void clearComparison();
+    const RunComparison* comparison() const { return m_comparison.get(); }
+    const QString& comparisonPath() const { return m_comparisonPath; }
+
+    // 事件跟踪（.qtrace）：在工作线程上归约成各段延迟的直方图，完成后在 L2/L3 下方画出延迟条，
+    // 结果由 traceFinished 通知。运行目录下有 CacheTrace::kFileName 时加载运行后自动读取
+    void loadTrace(const QString& path);
+    void clearTrace();
+    const LatencyHistograms* latency() const { return m_latency.get(); }
+    const QString& tracePath() const { return m_tracePath; }
+
+    // 回放总线事件（.qbus）：读取线程把事件流进有界的环形缓冲，界面每帧按播放速度取出到时的包，
+    // 沿路由在连线上移动，期间隐藏静态的主要流量路径。换运行或停止时结束，由 playbackFinished 通知
+    bool startPlayback(const QString& path, QString* errorMessage = nullptr);
+    void stopPlayback();
+    void setPlaybackPaused(bool paused);
+    bool playbackPaused() const { return m_playPaused; }
+    // 每秒推进的 tick 数
+    void setPlaybackSpeed(double ticksPerSecond);
+    bool isPlaying() const { return m_stream != nullptr; }
+
+    // 突出显示搜索命中的模块、路由器与连线，其余部分变淡；stats 为 result 所指的存储，与 stats() 同源
+    void setHighlight(const SearchResult& result, const CounterStore& stats);
+    void clearHighlight();
+
+    // 帧时间统计：开启后记录每帧绘制的耗时及其中各类图元的耗时，换场景时清空
+    void setFrameTiming(bool enabled);
+    bool frameTiming() const { return m_frameTiming; }
+    // 在视口左上角显示帧时间与图元数量，每半秒刷新；只显示，是否统计由 setFrameTiming 决定
+    void setHudVisible(bool visible);
+    bool hudVisible() const { return m_hudVisible; }
+    FrameStats& frameStats() { return m_frameStats; }
+    // 把当前场景各类图元的数量记入 frameStats()
+    void updateFrameCounts();
+    // 帧时间统计连同运行、视口与缩放写成 JSON
+    bool exportFrameStats(const QString& path, QString* errorMessage = nullptr);
+
+signals:
+    void statsUpdated(int changedRows);
+    // 画面上的统计值已更新（追加、变化或切换了 epoch）
+    void statsShown();
+    // 单击了场景中的模块或路由器
+    void targetClicked(const SceneTarget& target);
+    void liveTailError(const QString& message);
+    void epochsChanged(int count);
+    void loadProgress(int percent);
+    // 取消时 ok 为 false 且 errorMessage 为空
+    void loadFinished(bool ok, const QString& errorMessage);
+    // 对比运行已对齐并着色（ok）或加载失败；清除对比时 ok 为 false 且 errorMessage 为空
+    void comparisonFinished(bool ok, const QString& errorMessage);
+    // 事件跟踪已归约并画出（ok）或读取失败；清除时 ok 为 false 且 errorMessage 为空
+    void traceFinished(bool ok, const QString& errorMessage);
+    // 每帧一次：当前 tick 与在途的包数
+    void playbackProgress(quint64 tick, int inFlight);
+    // 回放结束；正常结束或停止时 errorMessage 为空
+    void playbackFinished(const QString& errorMessage);
+
+protected:
+    void wheelEvent(QWheelEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
+    void showEvent(QShowEvent* event) override;
+    void paintEvent(QPaintEvent* event) override;
+    void scrollContentsBy(int dx, int dy) override;
+    // 静态图层由瓦片缓存绘制时先把缓存的块贴上，其余图元画在上面
+    void drawBackground(QPainter* painter, const QRectF& rect) override;
+    // HUD 画在视口坐标中，不随场景缩放
+    void drawForeground(QPainter* painter, const QRectF& rect) override;
+
+private:
+    void abortLoad();
+    void runLoaded(const std::shared_ptr<LoadedRun>& run);
+    void runBatch();
+    void finishLoad();
+    void retireScene(QGraphicsScene* scene);
+    void fitScene();
+    void updateDetailLevel();
+    void refreshTiles();
+    void tilesReady();
+    void restartTailer();
+    void applyStatChanges(const QVector<qint32>& rows);
+    void applySceneChanges(const CounterStore& stats, const QVector<qint32>& rows);
+    void completeEpoch();
+    void comparisonLoaded(const std::shared_ptr<LoadedComparison>& loaded);
+    void traceLoaded(const std::shared_ptr<LoadedTrace>& loaded);
+    void playbackFrame();
+    void endPlayback();
+    void refreshHud();
+
+    // 切换 epoch 时流量行只改两个 epoch 之间变化过的
+    struct FlowChanges {
+        bool known = false;       // 用到时才与前一个 epoch 比较
+        bool all = false;         // 变化的太多，按全部流量行处理
+        QVector<qint32> rows;     // 可能有重复
+    };
+    const FlowChanges& flowChanges(int epoch);
+    // epoch from 与 to 之间（不含较早的一个）变化过的流量行并入 rows；需要全部流量行时返回 false
+    bool flowCandidates(int from, int to, QVector<qint32>& rows);
+
+    Topology m_topology;
+    CounterStore m_stats;
+    BuiltScene m_built;
+    Layout m_layout;              // 重新加载同一运行时作为热启动的起点，布局不会整体跳动
+    std::unique_ptr<TimeSeriesStore> m_series;  // 已结束的各 epoch
+    EpochSplitter m_splitter;     // 加载结束时的 epoch 切分状态，交给 StatTailer 续用
+    int m_epoch = -1;
+    CounterStore m_epochStats;    // 与 m_stats 同结构，values 换成当前 epoch 的值
+    QVector<qint32> m_displayedRows;
+    QVector<FlowChanges> m_flowChanges;   // 各 epoch 相对前一个 epoch 变化了的流量行，最后一项为正在写入的 epoch
+    int m_epochFlows = -1;        // m_epochStats 中流量行的值属于哪个 epoch（最后一个为跟上 m_stats 时的值）
+    QPoint m_pressPos;            // 区分单击与拖动
+
+    // 模块框、链内连线、图例与标题几乎不变，抄成绘图列表后按缩放级分块缓存；
+    // 拖动模块期间与对比模式下（模块按指标着色）这几层照常逐个绘制
+    TileCache m_tiles;
+    bool m_tilesShown = false;    // 静态图层当前由 m_tiles 绘制
+    bool m_moduleDrag = false;    // 按下了模块，可能正在拖动
+
+    QFutureWatcher<std::shared_ptr<LoadedRun>>* m_loadWatcher;
+    int m_loadGeneration = 0;     // 每次开始或取消加载时递增，旧加载送来的结果直接丢弃
+    bool m_loading = false;
+    std::shared_ptr<LoadedRun> m_pending;        // 已加载完、场景正在分批创建的运行
+    QGraphicsScene* m_pendingScene = nullptr;
+    std::unique_ptr<SceneBuildJob> m_buildJob;
+    QTimer* m_batchTimer;         // 空闲时推进建场景和删除旧场景，每次不超过一帧的预算
+    QVector<QGraphicsItem*> m_retiredItems;      // 换下的场景中待删除的图元，末尾先删
+    QVector<QGraphicsScene*> m_retiredScenes;
+    bool m_fitPending = false;    // 场景换上时窗口还没显示，显示后再适配视图
+
+    QFutureWatcher<std::shared_ptr<LoadedComparison>>* m_compareWatcher;
+    int m_compareGeneration = 0;  // 每次开始或清除对比时递增，旧结果直接丢弃
+    std::shared_ptr<RunComparison> m_comparison;  // 对齐在 m_stats 上，m_built.comparison 指向它
+    QString m_comparisonPath;
+
+    QFutureWatcher<std::shared_ptr<LoadedTrace>>* m_traceWatcher;
+    int m_traceGeneration = 0;    // 每次开始或清除跟踪时递增，旧结果直接丢弃
+    std::shared_ptr<LatencyHistograms> m_latency;  // m_built 的延迟条指向它
+    QString m_tracePath;
+
+    std::unique_ptr<BusEventStream> m_stream;   // 回放中的事件流，停止时为空
+    PacketLayer* m_packets = nullptr;           // 属于当前场景，换场景时随旧场景删除
+    QTimer* m_playTimer;
+    QElapsedTimer m_playClock;    // 上一帧的时刻，按实际经过的时间推进 tick
+    double m_playTick = 0;
+    double m_playSpeed = 1000;
+    bool m_playPaused = false;
+    QVector<BusEvent> m_arrivals; // 本帧到时的事件，每帧重用
+
+    HighlightLayer* m_highlight = nullptr;      // 属于当前场景，换场景时随旧场景删除
+
+    FrameStats m_frameStats;
+    bool m_frameTiming = false;
+    bool m_hudVisible = false;
+    QTimer* m_hudTimer;
+    QString m_hudText;
+    QRect m_hudRect;              // 视口坐标；只重画这块的帧不计入统计
+
+    QString m_setupPath;
+    QString m_statPath;
+    qint64 m_statBytes = 0;       // 加载时已解析的 statistic.txt 字节数
+    bool m_liveTail = false;
+    StatTailer* m_tailer;
+    StatIngestServer* m_ingest;
+};
+#endif // SCENEWIDGET_H
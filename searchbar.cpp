@@ -0,0 +1,137 @@
+// searchbar.cpp
+#include "searchbar.h"
+#include "scenebuilder.h"
+#include <QLabel>
+#include <QLineEdit>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrentRun>
+
+SearchBar::SearchBar(QWidget* parent)
+    : QToolBar("搜索", parent)
+{
+    setObjectName("searchBar");
+    m_edit = new QLineEdit(this);
+    m_edit->setPlaceholderText("搜索：L2Cache l2_miss_count > 1000、busy_rate > 2%、L3Cache");
+    m_edit->setClearButtonEnabled(true);
+    m_edit->setMinimumWidth(360);
+    m_status = new QLabel(this);
+    m_status->setMinimumWidth(280);
+    addWidget(m_edit);
+    addWidget(m_status);
+
+    m_queryTimer = new QTimer(this);
+    m_queryTimer->setSingleShot(true);
+    m_queryTimer->setInterval(150);
+    connect(m_queryTimer, &QTimer::timeout, this, &SearchBar::runQuery);
+    connect(m_edit, &QLineEdit::textChanged, m_queryTimer, qOverload<>(&QTimer::start));
+    connect(m_edit, &QLineEdit::returnPressed, this, &SearchBar::runQuery);
+
+    m_rebuildTimer = new QTimer(this);
+    m_rebuildTimer->setSingleShot(true);
+    m_rebuildTimer->setInterval(500);
+    connect(m_rebuildTimer, &QTimer::timeout, this, [this]() {
+        // 没有在查时不必跟着每次变化重建，等下次查询
+        m_stale = true;
+        if (!m_edit->text().trimmed().isEmpty())
+            rebuild();
+    });
+
+    m_watcher = new QFutureWatcher<std::shared_ptr<SearchIndex>>(this);
+    connect(m_watcher, &QFutureWatcherBase::finished, this, &SearchBar::indexBuilt);
+}
+
+void SearchBar::setView(const StatsView* view)
+{
+    m_view = view;
+    ++m_generation;
+    m_index.clear();
+    m_rebuildTimer->stop();
+    emit cleared();
+    rebuild();
+}
+
+void SearchBar::statsChanged()
+{
+    m_rebuildTimer->start();
+}
+
+void SearchBar::focusSearch()
+{
+    show();
+    m_edit->setFocus();
+    m_edit->selectAll();
+}
+
+void SearchBar::rebuild()
+{
+    m_stale = true;
+    if (!m_view || !m_view->isValid()) {
+        m_status->setText("没有统计数据");
+        return;
+    }
+    if (m_index.isEmpty())
+        m_status->setText("正在建立索引...");
+    // 同一时间只建一份；正在建的建好之后再来一次
+    if (m_watcher->isRunning())
+        return;
+    m_stale = false;
+    m_buildGeneration = m_generation;
+    m_buildClock.start();
+    const CounterStore store = *m_view->store;   // 各列隐式共享，不复制
+    m_watcher->setFuture(QtConcurrent::run([store]() {
+        auto index = std::make_shared<SearchIndex>();
+        index->build(store);
+        return index;
+    }));
+}
+
+void SearchBar::indexBuilt()
+{
+    if (m_buildGeneration == m_generation) {
+        m_index = std::move(*m_watcher->result());
+        m_buildMs = m_buildClock.nsecsElapsed() / 1e6;
+        runQuery();
+    }
+    if (m_stale)
+        rebuild();
+}
+
+void SearchBar::runQuery()
+{
+    m_queryTimer->stop();
+    const QString text = m_edit->text().trimmed();
+    if (text.isEmpty()) {
+        m_status->setText(m_index.isEmpty() ? QString()
+                                            : QString("%1 项已索引（%2 ms）")
+                                                  .arg(m_index.store().rowCount())
+                                                  .arg(m_buildMs, 0, 'f', 0));
+        emit cleared();
+        return;
+    }
+    if (m_stale)
+        rebuild();
+    if (m_index.isEmpty()) {
+        if (!m_watcher->isRunning())
+            m_status->setText("没有统计数据");
+        emit cleared();
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    SearchResult result;
+    QString error;
+    if (!m_index.search(text, result, &error)) {
+        m_status->setText(error);
+        emit cleared();
+        return;
+    }
+    emit resultReady(result, m_index.store());
+    const double ms = timer.nsecsElapsed() / 1e6;
+    if (result.counters.isEmpty() && result.rows.isEmpty())
+        m_status->setText(QString("%1 个模块，%2 ms").arg(result.modules.size()).arg(ms, 0, 'f', 2));
+    else
+        m_status->setText(QString("%1 个计数器 %2 项，涉及 %3 个模块，%4 ms")
+                              .arg(result.counters.size()).arg(result.rows.size())
+                              .arg(result.modules.size()).arg(ms, 0, 'f', 2));
+}
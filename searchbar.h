@@ -0,0 +1,55 @@
+// searchbar.h
+#ifndef SEARCHBAR_H
+#define SEARCHBAR_H
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QToolBar>
+#include <memory>
+#include "searchindex.h"
+
+class QLabel;
+class QLineEdit;
+class QTimer;
+class StatsView;
+
+// 搜索栏：输入停下片刻后按 SearchIndex 的语法查询，结果交给场景突出显示
+// 索引在线程池上建立，换运行时作废重建；统计值变化后隔一会儿重建（没有在查时等到下次查询再建），
+// 重建期间仍用旧索引查询，建好后按当前条件重查一次
+class SearchBar : public QToolBar {
+    Q_OBJECT
+public:
+    explicit SearchBar(QWidget* parent = nullptr);
+
+    // view 由调用方持有，索引取自 view->store；换运行时调用
+    void setView(const StatsView* view);
+    // 统计值变化（跟踪、推送或切换了 epoch）后调用
+    void statsChanged();
+    // 显示并聚焦输入框
+    void focusSearch();
+
+signals:
+    // stats 为结果所指的存储（索引的副本），只在信号处理期间有效
+    void resultReady(const SearchResult& result, const CounterStore& stats);
+    // 条件为空、有误或没有可查的数据，去掉突出显示
+    void cleared();
+
+private:
+    void rebuild();
+    void indexBuilt();
+    void runQuery();
+
+    QLineEdit* m_edit;
+    QLabel* m_status;
+    QTimer* m_queryTimer;         // 输入停下后再查
+    QTimer* m_rebuildTimer;       // 统计值连续变化时合并成一次重建
+    const StatsView* m_view = nullptr;
+    SearchIndex m_index;
+    QFutureWatcher<std::shared_ptr<SearchIndex>>* m_watcher;
+    QElapsedTimer m_buildClock;
+    double m_buildMs = 0;
+    int m_generation = 0;         // 每次换运行时递增，旧运行的索引直接丢弃
+    int m_buildGeneration = 0;    // 正在建立的索引属于哪一次
+    bool m_stale = false;         // 统计值变化之后还没有重建
+};
+
+#endif // SEARCHBAR_H
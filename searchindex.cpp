@@ -0,0 +1,274 @@
+// searchindex.cpp
+#include "searchindex.h"
+#include <QThreadPool>
+#include <QtMath>
+#include <QtConcurrent/QtConcurrentMap>
+#include <algorithm>
+
+namespace {
+
+bool fail(QString* errorMessage, const QString& message) {
+    if (errorMessage)
+        *errorMessage = message;
+    return false;
+}
+
+bool isDigits(const QByteArray& s) {
+    if (s.isEmpty())
+        return false;
+    for (const char c : s) {
+        if (c < '0' || c > '9')
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+void SearchIndex::build(const CounterStore& store, QThreadPool* pool) {
+    if (!pool)
+        pool = QThreadPool::globalInstance();
+    clear();
+    snapshot = store;
+
+    for (int id = 0; id < snapshot.modules.size(); ++id)
+        moduleKeys.append({snapshot.modules.at(id).toLower(), id});
+    std::sort(moduleKeys.begin(), moduleKeys.end());
+    // 计数器名从每个词开始的后缀都登记一次，前缀查找就能从名称中间的词起匹配
+    const int counters = snapshot.counters.size();
+    for (int c = 0; c < counters; ++c) {
+        const QByteArray name = snapshot.counters.at(c).toLower();
+        counterKeys.append({name, c});
+        for (qsizetype i = 0; i + 1 < name.size(); ++i) {
+            if (name[i] == '_')
+                counterKeys.append({name.mid(i + 1), c});
+        }
+    }
+    std::sort(counterKeys.begin(), counterKeys.end());
+
+    // 行按计数器分桶（计数排序），桶内仍是行号升序
+    const int rows = snapshot.rowCount();
+    const qint32* rowCounter = snapshot.rowCounter.constData();
+    counterBegin.fill(0, counters + 1);
+    for (int r = 0; r < rows; ++r)
+        ++counterBegin[rowCounter[r] + 1];
+    for (int c = 0; c < counters; ++c)
+        counterBegin[c + 1] += counterBegin[c];
+    QVector<qint32> next = counterBegin;
+    sortedRows.resize(rows);
+    for (int r = 0; r < rows; ++r)
+        sortedRows[next[rowCounter[r]]++] = r;
+
+    // 各桶按值排序，大的桶先排，线程之间更均衡
+    QVector<qint32> order;
+    for (int c = 0; c < counters; ++c) {
+        if (counterBegin[c + 1] - counterBegin[c] > 1)
+            order.append(c);
+    }
+    std::sort(order.begin(), order.end(), [this](qint32 a, qint32 b) {
+        return counterBegin[a + 1] - counterBegin[a] > counterBegin[b + 1] - counterBegin[b];
+    });
+    const double* values = snapshot.values.constData();
+    qint32* sorted = sortedRows.data();
+    QtConcurrent::blockingMap(pool, order, [&](const qint32& c) {
+        struct Entry {
+            double value;
+            qint32 row;
+        };
+        const qint32 begin = counterBegin[c];
+        const qint32 end = counterBegin[c + 1];
+        QVector<Entry> entries;
+        entries.reserve(end - begin);
+        for (qint32 i = begin; i < end; ++i)
+            entries.append({values[sorted[i]], sorted[i]});
+        // NaN 排在最后；同值按行号，结果与线程数无关
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            const bool aNaN = qIsNaN(a.value);
+            const bool bNaN = qIsNaN(b.value);
+            if (aNaN != bNaN)
+                return bNaN;
+            if (!aNaN && a.value != b.value)
+                return a.value < b.value;
+            return a.row < b.row;
+        });
+        for (qint32 i = begin; i < end; ++i)
+            sorted[i] = entries[i - begin].row;
+    });
+}
+
+void SearchIndex::clear() {
+    snapshot = CounterStore();
+    moduleKeys.clear();
+    counterKeys.clear();
+    counterBegin.clear();
+    sortedRows.clear();
+}
+
+QVector<qint32> SearchIndex::idsWithPrefix(const QVector<Key>& keys, const QByteArray& prefix) {
+    QVector<qint32> ids;
+    auto it = std::lower_bound(keys.begin(), keys.end(), prefix,
+                               [](const Key& key, const QByteArray& p) { return key.text < p; });
+    for (; it != keys.end() && it->text.startsWith(prefix); ++it)
+        ids.append(it->id);
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return ids;
+}
+
+QVector<qint32> SearchIndex::modulesWithPrefix(const QByteArray& prefix) const {
+    return idsWithPrefix(moduleKeys, prefix);
+}
+
+QVector<qint32> SearchIndex::countersMatching(const QByteArray& prefix) const {
+    return idsWithPrefix(counterKeys, prefix);
+}
+
+bool SearchIndex::parse(const QString& text, SearchQuery& query, QString* errorMessage) const {
+    query = SearchQuery();
+    const QByteArray s = text.trimmed().toUtf8().toLower();
+
+    // 比较符把条件分成名称与数值两半
+    qsizetype op = -1;
+    for (qsizetype i = 0; i < s.size() && op < 0; ++i) {
+        if (s[i] == '<' || s[i] == '>' || s[i] == '=')
+            op = i;
+    }
+    if (op >= 0) {
+        qsizetype i = op + 1;
+        const bool orEqual = i < s.size() && s[i] == '=';
+        if (orEqual)
+            ++i;
+        if (s[op] == '<')
+            query.compare = orEqual ? SearchQuery::LessEqual : SearchQuery::Less;
+        else if (s[op] == '>')
+            query.compare = orEqual ? SearchQuery::GreaterEqual : SearchQuery::Greater;
+        else
+            query.compare = SearchQuery::Equal;   // "=" 与 "=="
+        QByteArray number = s.mid(i).trimmed();
+        const bool percent = number.endsWith('%');
+        if (percent)
+            number.chop(1);
+        bool ok = false;
+        const double value = number.trimmed().toDouble(&ok);
+        if (!ok || qIsNaN(value))
+            return fail(errorMessage, QString("无法识别的数值：%1").arg(QString::fromUtf8(s.mid(i).trimmed())));
+        query.value = percent ? value / 100 : value;
+    }
+
+    const QByteArray names = (op < 0 ? s : s.left(op)).simplified();
+    const QList<QByteArray> words = names.isEmpty() ? QList<QByteArray>() : names.split(' ');
+    if (words.isEmpty())
+        return fail(errorMessage, op < 0 ? QString("请输入模块名或计数器名") : QString("比较之前缺少计数器名"));
+    if (words.size() > 2)
+        return fail(errorMessage, "最多一个模块名前缀和一个计数器名");
+    QByteArray counter;
+    if (words.size() == 2) {
+        query.module = words[0];
+        counter = words[1];
+    } else if (op < 0 && !modulesWithPrefix(words[0]).isEmpty()) {
+        query.module = words[0];
+        return true;
+    } else {
+        counter = words[0];
+    }
+
+    // 与存储一样把纯数字的段换成 '#'，数字作为下标条件
+    QList<QByteArray> parts = counter.split('_');
+    int indices = 0;
+    for (QByteArray& part : parts) {
+        if (!isDigits(part))
+            continue;
+        if (indices == 2)
+            return fail(errorMessage, "计数器名中最多两个下标");
+        (indices == 0 ? query.index0 : query.index1) = part.toInt();
+        ++indices;
+        part = "#";
+    }
+    query.counter = parts.join('_');
+    return true;
+}
+
+SearchResult SearchIndex::run(const SearchQuery& query) const {
+    SearchResult result;
+    const QVector<qint32> modules = query.module.isEmpty() ? QVector<qint32>()
+                                                           : modulesWithPrefix(query.module);
+    if (query.counter.isEmpty()) {
+        result.modules = modules;
+        return result;
+    }
+    if (!query.module.isEmpty() && modules.isEmpty())
+        return result;
+    QVector<quint8> moduleMask;   // 为空表示不限模块
+    if (!query.module.isEmpty()) {
+        moduleMask.fill(0, snapshot.modules.size());
+        for (const qint32 m : modules)
+            moduleMask[m] = 1;
+    }
+
+    result.counters = countersMatching(query.counter);
+    const double* values = snapshot.values.constData();
+    const qint32* rowModule = snapshot.rowModule.constData();
+    const qint32* rowIndex0 = snapshot.rowIndex0.constData();
+    const qint32* rowIndex1 = snapshot.rowIndex1.constData();
+    const double v = query.value;
+    auto below = [values, v](qint32 r) { return values[r] < v; };
+    auto notAbove = [values, v](qint32 r) { return values[r] <= v; };
+    for (const qint32 c : result.counters) {
+        const qint32* begin = sortedRows.constData() + counterBegin[c];
+        const qint32* end = sortedRows.constData() + counterBegin[c + 1];
+        // NaN 在各桶的最后，只在不比较数值时算作命中
+        const qint32* finite = query.compare == SearchQuery::Any
+                                   ? end
+                                   : std::partition_point(begin, end, [values](qint32 r) {
+                                         return !qIsNaN(values[r]);
+                                     });
+        switch (query.compare) {
+        case SearchQuery::Any:
+            break;
+        case SearchQuery::Less:
+            end = std::partition_point(begin, finite, below);
+            break;
+        case SearchQuery::LessEqual:
+            end = std::partition_point(begin, finite, notAbove);
+            break;
+        case SearchQuery::Equal:
+            begin = std::partition_point(begin, finite, below);
+            end = std::partition_point(begin, finite, notAbove);
+            break;
+        case SearchQuery::GreaterEqual:
+            begin = std::partition_point(begin, finite, below);
+            end = finite;
+            break;
+        case SearchQuery::Greater:
+            begin = std::partition_point(begin, finite, notAbove);
+            end = finite;
+            break;
+        }
+        for (const qint32* p = begin; p < end; ++p) {
+            const qint32 r = *p;
+            if ((!moduleMask.isEmpty() && !moduleMask[rowModule[r]])
+                || (query.index0 >= 0 && rowIndex0[r] != query.index0)
+                || (query.index1 >= 0 && rowIndex1[r] != query.index1))
+                continue;
+            result.rows.append(r);
+        }
+    }
+
+    // 命中的行所属的模块
+    QVector<quint8> seen(snapshot.modules.size(), 0);
+    for (const qint32 r : result.rows)
+        seen[rowModule[r]] = 1;
+    for (int m = 0; m < seen.size(); ++m) {
+        if (seen[m])
+            result.modules.append(m);
+    }
+    return result;
+}
+
+bool SearchIndex::search(const QString& text, SearchResult& result, QString* errorMessage) const {
+    SearchQuery query;
+    if (!parse(text, query, errorMessage))
+        return false;
+    result = run(query);
+    return true;
+}
@@ -0,0 +1,69 @@
+// searchindex.h
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include "counterstore.h"
+
+class QThreadPool;
+
+// 一条搜索条件：[模块名前缀] [计数器名 [比较 数值]]
+// 名称都不区分大小写。计数器名从任意一个词（'_' 分隔）开始按前缀匹配，
+// 如 "busy_rate" 匹配 edge_#_to_#_busy_rate；写出的数字段与存储中一样换成 '#'，数字作为下标条件。
+struct SearchQuery {
+    enum Compare { Any, Less, LessEqual, Equal, GreaterEqual, Greater };
+    QByteArray module;      // 模块名前缀（小写），空为不限
+    QByteArray counter;     // 计数器名前缀（小写），空为只按模块名查
+    int index0 = -1;        // 计数器名中写出的下标，-1 为不限
+    int index1 = -1;
+    Compare compare = Any;
+    double value = 0;       // 写成百分数时已除以 100
+};
+
+struct SearchResult {
+    QVector<qint32> modules;    // 命中的模块ID，升序
+    QVector<qint32> counters;   // 名称匹配的计数器ID，升序
+    QVector<qint32> rows;       // 满足条件的行，同一计数器内按值升序；只按模块名查时为空
+};
+
+// 模块名、计数器名与各计数器数值的索引
+// 名称按小写排序后二分查前缀；各计数器的行按值排序，数值条件在其中二分出一段，
+// 查询的耗时与命中的行数相关，与存储的总行数无关。
+// 建索引时取存储的一份副本（各列隐式共享），之后存储的值再变化需要重新 build。
+class SearchIndex {
+public:
+    // 各计数器的行在 pool（为空时使用 QThreadPool::globalInstance()）上并行排序
+    void build(const CounterStore& store, QThreadPool* pool = nullptr);
+    void clear();
+    bool isEmpty() const { return moduleKeys.isEmpty(); }
+    // 建索引时的存储，结果中的ID与行号都指向它（与原存储一致）
+    const CounterStore& store() const { return snapshot; }
+
+    // 名称以 prefix（小写）开头的模块，升序
+    QVector<qint32> modulesWithPrefix(const QByteArray& prefix) const;
+    // 名称中某个词以 prefix（小写）开头的计数器，升序
+    QVector<qint32> countersMatching(const QByteArray& prefix) const;
+
+    // 解析如 "L2Cache l2_miss_count > 1000"、"busy_rate > 2%"、"L3Cache"；
+    // 只有一个词且没有比较时，有模块名以它开头就按模块查，否则按计数器查
+    bool parse(const QString& text, SearchQuery& query, QString* errorMessage = nullptr) const;
+    SearchResult run(const SearchQuery& query) const;
+    bool search(const QString& text, SearchResult& result, QString* errorMessage = nullptr) const;
+
+private:
+    struct Key {
+        QByteArray text;
+        qint32 id;
+        bool operator<(const Key& other) const { return text < other.text; }
+    };
+    static QVector<qint32> idsWithPrefix(const QVector<Key>& keys, const QByteArray& prefix);
+
+    CounterStore snapshot;
+    QVector<Key> moduleKeys;        // 小写模块名，按名称排序
+    QVector<Key> counterKeys;       // 小写计数器名从每个词开始的后缀，按名称排序
+    QVector<qint32> counterBegin;   // 计数器 c 的行为 sortedRows[counterBegin[c], counterBegin[c + 1])
+    QVector<qint32> sortedRows;     // 按（计数器, 值）排序的行号，NaN 排在各计数器的最后
+};
+
+#endif // SEARCHINDEX_H
@@ -0,0 +1,170 @@
+// setupparser.cpp
+#include "setupparser.h"
+#include "textscan.h"
+#include <QFile>
+#include <QtAlgorithms>
+#include <limits>
+
+using TextScan::Span;
+
+namespace {
+
+bool fail(QString* errorMessage, int line, const QString& what) {
+    if (errorMessage)
+        *errorMessage = QString("setup.txt 第%1行: %2").arg(line).arg(what);
+    return false;
+}
+
+void growTo(QVector<qint32>& v, qint64 size) {
+    if (v.size() < size)
+        v.resize(qsizetype(size), -1);
+}
+
+} // namespace
+
+bool SetupParser::parseFile(const QString& path, Topology& out, QString* errorMessage) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorMessage)
+            *errorMessage = QString("无法打开 %1: %2").arg(path, file.errorString());
+        return false;
+    }
+    const qint64 size = file.size();
+    if (size == 0) {
+        out.clear();
+        return true;
+    }
+    // 映射整个文件，解析时不再复制
+    const uchar* data = file.map(0, size);
+    if (!data) {
+        const QByteArray all = file.readAll();
+        return parse(all.constData(), all.size(), out, errorMessage);
+    }
+    const bool ok = parse(reinterpret_cast<const char*>(data), qsizetype(size), out, errorMessage);
+    file.unmap(const_cast<uchar*>(data));
+    return ok;
+}
+
+bool SetupParser::parse(const char* data, qsizetype size, Topology& out, QString* errorMessage) {
+    out.clear();
+
+    static const char kNodeOfPort[] = "node_id_of_port_";
+    static const qsizetype kNodeOfPortLen = sizeof(kNodeOfPort) - 1;
+
+    const char* p = data;
+    const char* end = data + size;
+    int lineNo = 0;
+    int current = -1;   // 当前块对应的模块下标
+
+    while (p < end) {
+        ++lineNo;
+        const Span line = TextScan::stripComment(TextScan::nextLine(p, end));
+        if (line.isEmpty())
+            continue;
+
+        // 块头："Name @1tick"
+        if (const char* at = TextScan::find(line, '@')) {
+            const Span name = TextScan::trimmed(Span{line.begin, at});
+            if (name.isEmpty())
+                return fail(errorMessage, lineNo, "模块名为空");
+
+            TopologyModule m;
+            m.name = QByteArray(name.begin, name.size());
+            m.kind = Topology::kindFromName(name.begin, name.size());
+            m.index = TextScan::trailingIndex(name);
+            qint64 tick = 1;
+            Span tickText{at + 1, line.end};
+            if (tickText.size() > 4 && memcmp(tickText.end - 4, "tick", 4) == 0)
+                tickText.end -= 4;
+            if (TextScan::toInt(tickText, tick) && tick > 0 && tick <= std::numeric_limits<qint32>::max())
+                m.tick = qint32(tick);
+            m.paramBegin = qint32(out.params.size());
+
+            if (out.moduleIndex.contains(m.name))
+                return fail(errorMessage, lineNo, QString("模块 %1 重复定义").arg(QString::fromLatin1(m.name)));
+            current = int(out.modules.size());
+            out.moduleIndex.insert(m.name, current);
+            if (m.kind == ModuleKind::Bus && out.busModule < 0)
+                out.busModule = current;
+            out.modules.append(m);
+            continue;
+        }
+
+        const char* colon = TextScan::find(line, ':');
+        if (!colon)
+            return fail(errorMessage, lineNo, "缺少 ':'");
+        if (current < 0)
+            return fail(errorMessage, lineNo, "参数出现在任何模块之前");
+
+        const Span key = TextScan::trimmed(Span{line.begin, colon});
+        const Span value = TextScan::trimmed(Span{colon + 1, line.end});
+
+        // edge: a to b
+        if (key.equals("edge", 4)) {
+            const char* sep = nullptr;
+            for (const char* c = value.begin; c + 3 < value.end; ++c) {
+                if (c[0] == ' ' && c[1] == 't' && c[2] == 'o' && c[3] == ' ') {
+                    sep = c;
+                    break;
+                }
+            }
+            qint64 a = 0, b = 0;
+            if (!sep || !TextScan::toInt(Span{value.begin, sep}, a)
+                || !TextScan::toInt(Span{sep + 4, value.end}, b) || a < 0 || b < 0)
+                return fail(errorMessage, lineNo, "edge 格式应为 'a to b'");
+            if (a >= Topology::kMaxPorts || b >= Topology::kMaxPorts)
+                return fail(errorMessage, lineNo, QString("节点编号超出上限 %1").arg(Topology::kMaxPorts));
+            out.edges.append({qint32(a), qint32(b)});
+            out.nodeCount = qMax(out.nodeCount, qint32(qMax(a, b) + 1));
+            continue;
+        }
+
+        qint64 v = 0;
+        if (!TextScan::toInt(value, v))
+            return fail(errorMessage, lineNo, "参数值不是整数");
+
+        // node_id_of_port_N: node
+        if (key.startsWith(kNodeOfPort, kNodeOfPortLen)) {
+            qint64 port = 0;
+            if (!TextScan::toInt(Span{key.begin + kNodeOfPortLen, key.end}, port) || port < 0 || v < 0)
+                return fail(errorMessage, lineNo, "端口映射格式错误");
+            if (port >= Topology::kMaxPorts || v >= Topology::kMaxPorts)
+                return fail(errorMessage, lineNo, QString("端口或节点编号超出上限 %1").arg(Topology::kMaxPorts));
+            growTo(out.nodeOfPort, port + 1);
+            out.nodeOfPort[qsizetype(port)] = qint32(v);
+            out.nodeCount = qMax(out.nodeCount, qint32(v + 1));
+            continue;
+        }
+
+        TopologyModule& m = out.modules[current];
+        if (key.equals("port_id", 7)) {
+            if (v >= Topology::kMaxPorts)
+                return fail(errorMessage, lineNo, QString("端口编号超出上限 %1").arg(Topology::kMaxPorts));
+            // 负数表示未连接
+            m.portId = v >= 0 ? qint32(v) : -1;
+            if (v >= 0) {
+                growTo(out.moduleOfPort, v + 1);
+                out.moduleOfPort[qsizetype(v)] = current;
+            }
+        } else if (key.equals("node_number", 11)) {
+            // 文件中的 node_number 实为端口数
+            if (v > Topology::kMaxPorts)
+                return fail(errorMessage, lineNo, QString("端口数超出上限 %1").arg(Topology::kMaxPorts));
+            growTo(out.nodeOfPort, v);
+        }
+
+        // 其余参数统一按 key 表存放；查表用 fromRawData，不复制 key
+        const QByteArray rawKey = QByteArray::fromRawData(key.begin, key.size());
+        int keyId = out.keyIndex.value(rawKey, -1);
+        if (keyId < 0) {
+            keyId = int(out.paramKeys.size());
+            out.paramKeys.append(QByteArray(key.begin, key.size()));
+            out.keyIndex.insert(out.paramKeys.last(), keyId);
+        }
+        out.params.append({keyId, v});
+        ++m.paramCount;
+    }
+
+    growTo(out.moduleOfPort, out.nodeOfPort.size());
+    return true;
+}
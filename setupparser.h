@@ -0,0 +1,18 @@
+// setupparser.h
+#ifndef SETUPPARSER_H
+#define SETUPPARSER_H
+#include <QString>
+#include "topology.h"
+
+// setup.txt 的单遍流式解析器
+// 格式：若干 "Name @1tick" 块，块内为 "key: value" 行，"//" 之后为注释。
+// Bus 块额外包含 node_id_of_port_N 与 "edge: a to b"。
+// 解析直接在文件映射上进行，只有新出现的模块名和参数名会分配内存。
+class SetupParser {
+public:
+    static bool parseFile(const QString& path, Topology& out, QString* errorMessage = nullptr);
+    static bool parse(const char* data, qsizetype size, Topology& out,
+                      QString* errorMessage = nullptr);
+};
+
+#endif // SETUPPARSER_H
@@ -0,0 +1,519 @@
+// snapshotcache.cpp
+#include "snapshotcache.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QSaveFile>
+#include <QtConcurrent/QtConcurrentMap>
+#include <atomic>
+#include <functional>
+#include <numeric>
+#include <cstring>
+
+namespace {
+
+const char kMagic[8] = {'Q', 'T', 'V', 'C', 'A', 'C', 'H', 'E'};
+const quint32 kByteOrderMark = 0x01020304;
+// 并行哈希的块大小，结果与线程数无关
+const qint64 kHashBlock = 64 << 20;
+
+struct Header {
+    char magic[8];
+    quint32 version;
+    quint32 byteOrder;
+    qint64 setupSize;
+    quint64 setupHash;
+    qint64 statSize;
+    quint64 statHash;
+};
+
+// ============== 内容哈希 ==============
+inline quint64 rotl(quint64 x, int r) { return (x << r) | (x >> (64 - r)); }
+
+const quint64 kPrime1 = 0x9E3779B185EBCA87ull;
+const quint64 kPrime2 = 0xC2B2AE3D27D4EB4Full;
+const quint64 kPrime3 = 0x165667B19E3779F9ull;
+
+inline quint64 mixLane(quint64 acc, quint64 v) {
+    return rotl(acc + v * kPrime2, 31) * kPrime1;
+}
+
+inline quint64 finalize(quint64 h) {
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+// 四路并行累加，每次处理32字节
+quint64 hashBytes(const uchar* p, qint64 n, quint64 seed) {
+    quint64 a = seed + kPrime1 + kPrime2, b = seed + kPrime2, c = seed, d = seed - kPrime1;
+    const uchar* end = p + n;
+    while (end - p >= 32) {
+        quint64 v[4];
+        memcpy(v, p, 32);
+        a = mixLane(a, v[0]);
+        b = mixLane(b, v[1]);
+        c = mixLane(c, v[2]);
+        d = mixLane(d, v[3]);
+        p += 32;
+    }
+    quint64 h = rotl(a, 1) + rotl(b, 7) + rotl(c, 12) + rotl(d, 18) + quint64(n);
+    while (end - p >= 8) {
+        quint64 v;
+        memcpy(&v, p, 8);
+        h = rotl(h ^ mixLane(0, v), 27) * kPrime1 + kPrime3;
+        p += 8;
+    }
+    while (p < end)
+        h = rotl(h ^ (*p++ * kPrime3), 11) * kPrime1;
+    return finalize(h);
+}
+
+// ============== 写入 ==============
+class Writer {
+public:
+    explicit Writer(QIODevice* device) : device(device) {}
+
+    bool ok() const { return good; }
+
+    void raw(const void* data, qint64 size) {
+        if (!good || size == 0) return;
+        good = device->write(static_cast<const char*>(data), size) == size;
+        pos += size;
+    }
+    template <typename T> void value(const T& v) { raw(&v, sizeof(T)); }
+    template <typename T> void array(const QVector<T>& v) {
+        value(qint64(v.size()));
+        raw(v.constData(), qint64(v.size()) * qint64(sizeof(T)));
+        align();
+    }
+    void strings(const QVector<QByteArray>& names) {
+        QVector<qint64> offsets;
+        offsets.reserve(names.size() + 1);
+        qint64 total = 0;
+        for (const QByteArray& n : names) {
+            offsets.append(total);
+            total += n.size();
+        }
+        offsets.append(total);
+        array(offsets);
+        value(total);
+        for (const QByteArray& n : names)
+            raw(n.constData(), n.size());
+        align();
+    }
+    void align() {
+        static const char zeros[8] = {};
+        if (pos % 8)
+            raw(zeros, 8 - pos % 8);
+    }
+
+private:
+    QIODevice* device;
+    qint64 pos = 0;
+    bool good = true;
+};
+
+// ============== 读取 ==============
+// 所有读取都做越界检查，损坏的缓存只会导致加载失败
+class Reader {
+public:
+    Reader(const uchar* data, qint64 size) : p(data), begin(data), end(data + size) {}
+
+    bool ok() const { return good; }
+
+    const uchar* take(qint64 size) {
+        if (!good || size < 0 || end - p < size) {
+            good = false;
+            return nullptr;
+        }
+        const uchar* at = p;
+        p += size;
+        return at;
+    }
+    template <typename T> T value() {
+        T v{};
+        if (const uchar* at = take(sizeof(T)))
+            memcpy(&v, at, sizeof(T));
+        return v;
+    }
+    template <typename T> bool array(QVector<T>& out) {
+        const qint64 count = value<qint64>();
+        if (count < 0 || count > (end - p) / qint64(sizeof(T))) {
+            good = false;
+            return false;
+        }
+        const uchar* at = take(count * qint64(sizeof(T)));
+        if (!at) return false;
+        out.resize(count);
+        memcpy(out.data(), at, size_t(count) * sizeof(T));
+        align();
+        return good;
+    }
+    // 大列只做校验并登记拷贝任务，由调用方并行执行
+    template <typename T> bool column(QVector<T>& out, QVector<std::function<void()>>& copies) {
+        const qint64 count = value<qint64>();
+        if (count < 0 || count > (end - p) / qint64(sizeof(T))) {
+            good = false;
+            return false;
+        }
+        const uchar* at = take(count * qint64(sizeof(T)));
+        if (!at) return false;
+        copies.append([&out, at, count]() {
+            const T* first = reinterpret_cast<const T*>(at);
+            out = QVector<T>(first, first + count);
+        });
+        align();
+        return good;
+    }
+    bool strings(QVector<QByteArray>& out) {
+        QVector<qint64> offsets;
+        if (!array(offsets) || offsets.isEmpty())
+            return good = false;
+        const qint64 total = value<qint64>();
+        const uchar* blob = take(total);
+        if (!blob) return false;
+        out.clear();
+        out.reserve(offsets.size() - 1);
+        for (int i = 0; i + 1 < offsets.size(); ++i) {
+            if (offsets[i] < 0 || offsets[i] > offsets[i + 1] || offsets[i + 1] > total)
+                return good = false;
+            out.append(QByteArray(reinterpret_cast<const char*>(blob) + offsets[i],
+                                  offsets[i + 1] - offsets[i]));
+        }
+        align();
+        return good;
+    }
+    void align() {
+        const qint64 offset = p - begin;
+        if (offset % 8)
+            take(8 - offset % 8);
+    }
+
+private:
+    const uchar* p;
+    const uchar* begin;
+    const uchar* end;
+    bool good = true;
+};
+
+// 每个值都在 [low, high) 内
+template <typename T> bool allInRange(const QVector<T>& v, qint64 low, qint64 high) {
+    for (const T& x : v) {
+        if (qint64(x) < low || qint64(x) >= high)
+            return false;
+    }
+    return true;
+}
+
+QVector<QByteArray> tableNames(const StringTable& table) {
+    QVector<QByteArray> names;
+    names.reserve(table.size());
+    for (int i = 0; i < table.size(); ++i)
+        names.append(table.at(i));
+    return names;
+}
+
+// 拓扑中模块的定长字段
+struct ModuleRecord {
+    qint32 kind;
+    qint32 index;
+    qint32 tick;
+    qint32 portId;
+    qint32 paramBegin;
+    qint32 paramCount;
+};
+
+void writeTopology(Writer& w, const Topology& t) {
+    QVector<QByteArray> names;
+    QVector<ModuleRecord> records;
+    names.reserve(t.modules.size());
+    records.reserve(t.modules.size());
+    for (const TopologyModule& m : t.modules) {
+        names.append(m.name);
+        records.append({qint32(m.kind), m.index, m.tick, m.portId, m.paramBegin, m.paramCount});
+    }
+    QVector<qint32> paramKeys;
+    QVector<qint64> paramValues;
+    paramKeys.reserve(t.params.size());
+    paramValues.reserve(t.params.size());
+    for (const TopologyParam& p : t.params) {
+        paramKeys.append(p.key);
+        paramValues.append(p.value);
+    }
+    w.strings(names);
+    w.array(records);
+    w.strings(t.paramKeys);
+    w.array(paramKeys);
+    w.array(paramValues);
+    w.array(t.nodeOfPort);
+    w.array(t.moduleOfPort);
+    w.array(t.edges);
+    w.value(t.nodeCount);
+    w.value(t.busModule);
+    w.align();
+}
+
+bool readTopology(Reader& r, Topology& t) {
+    QVector<QByteArray> names;
+    QVector<ModuleRecord> records;
+    QVector<qint32> paramKeys;
+    QVector<qint64> paramValues;
+    t.clear();
+    if (!r.strings(names) || !r.array(records) || names.size() != records.size()
+        || !r.strings(t.paramKeys) || !r.array(paramKeys) || !r.array(paramValues)
+        || paramKeys.size() != paramValues.size()
+        || !r.array(t.nodeOfPort) || !r.array(t.moduleOfPort) || !r.array(t.edges))
+        return false;
+    t.nodeCount = r.value<qint32>();
+    t.busModule = r.value<qint32>();
+    r.align();
+    if (!r.ok())
+        return false;
+
+    // 各编号与区间都要落在表内，否则查参数、按端口找节点与建场景时会越界
+    const qint64 modules = names.size();
+    if (t.nodeCount < 0 || t.nodeCount > Topology::kMaxPorts
+        || t.nodeOfPort.size() > Topology::kMaxPorts || t.moduleOfPort.size() > Topology::kMaxPorts
+        || t.busModule < -1 || t.busModule >= modules
+        || !allInRange(paramKeys, 0, t.paramKeys.size())
+        || !allInRange(t.nodeOfPort, -1, t.nodeCount)
+        || !allInRange(t.moduleOfPort, -1, modules))
+        return false;
+    for (const BusEdge& e : t.edges) {
+        if (e.from < 0 || e.from >= t.nodeCount || e.to < 0 || e.to >= t.nodeCount)
+            return false;
+    }
+    for (const ModuleRecord& m : records) {
+        if (m.kind < 0 || m.kind > qint32(ModuleKind::Other)
+            || m.paramBegin < 0 || m.paramCount < 0
+            || qint64(m.paramBegin) + m.paramCount > paramKeys.size()
+            || m.portId < -1 || m.portId >= Topology::kMaxPorts)
+            return false;
+    }
+
+    t.modules.reserve(names.size());
+    for (int i = 0; i < names.size(); ++i) {
+        TopologyModule m;
+        m.name = names[i];
+        m.kind = ModuleKind(records[i].kind);
+        m.index = records[i].index;
+        m.tick = records[i].tick;
+        m.portId = records[i].portId;
+        m.paramBegin = records[i].paramBegin;
+        m.paramCount = records[i].paramCount;
+        t.modules.append(m);
+    }
+    t.params.reserve(paramKeys.size());
+    for (int i = 0; i < paramKeys.size(); ++i)
+        t.params.append({paramKeys[i], paramValues[i]});
+    t.rebuildLookup();
+    return r.ok();
+}
+
+} // namespace
+
+// 存储的读写需要访问索引分片，放在类内实现
+class SnapshotCacheAccess {
+public:
+    static void write(Writer& w, const CounterStore& s) {
+        w.strings(tableNames(s.modules));
+        w.strings(tableNames(s.counters));
+        w.array(s.moduleLatency);
+        w.array(s.counterIsReal);
+        w.array(s.rowModule);
+        w.array(s.rowCounter);
+        w.array(s.rowIndex0);
+        w.array(s.rowIndex1);
+        w.array(s.values);
+        for (int i = 0; i < CounterStore::kIndexShards; ++i) {
+            w.value(qint64(s.shardRows[i]));
+            w.array(s.hashSlots[i]);
+        }
+    }
+
+    static bool read(Reader& r, CounterStore& s) {
+        QVector<QByteArray> modules, counters;
+        s.clear();
+        if (!r.strings(modules) || !r.strings(counters))
+            return false;
+        for (const QByteArray& m : modules)
+            s.modules.intern(m);
+        for (const QByteArray& c : counters)
+            s.counters.intern(c);
+        // 名称重复时驻留表会变短，之后的编号就对不上了
+        if (s.modules.size() != modules.size() || s.counters.size() != counters.size())
+            return false;
+        if (!r.array(s.moduleLatency) || !r.array(s.counterIsReal))
+            return false;
+
+        // 各行列与索引分片占了文件的绝大部分，按列并行拷贝
+        QVector<std::function<void()>> copies;
+        QVector<qint64> shardRows(CounterStore::kIndexShards);
+        if (!r.column(s.rowModule, copies) || !r.column(s.rowCounter, copies)
+            || !r.column(s.rowIndex0, copies) || !r.column(s.rowIndex1, copies)
+            || !r.column(s.values, copies))
+            return false;
+        for (int i = 0; i < CounterStore::kIndexShards; ++i) {
+            shardRows[i] = r.value<qint64>();
+            if (!r.column(s.hashSlots[i], copies))
+                return false;
+        }
+        QtConcurrent::blockingMap(copies, [](std::function<void()>& copy) { copy(); });
+
+        const qsizetype rows = s.values.size();
+        if (s.moduleLatency.size() != modules.size() || s.counterIsReal.size() != counters.size()
+            || s.rowModule.size() != rows || s.rowCounter.size() != rows
+            || s.rowIndex0.size() != rows || s.rowIndex1.size() != rows)
+            return false;
+        for (int i = 0; i < CounterStore::kIndexShards; ++i) {
+            // 分片容量必须是2的幂，否则按掩码寻址会越界；至少留一个空槽，否则查找不到时不会停
+            const qsizetype capacity = s.hashSlots[i].size();
+            if (capacity != 0 && (capacity & (capacity - 1)) != 0)
+                return false;
+            if (shardRows[i] < 0 || (capacity == 0 ? shardRows[i] != 0 : shardRows[i] >= capacity))
+                return false;
+            s.shardRows[i] = int(shardRows[i]);
+        }
+        if (!r.ok())
+            return false;
+
+        // 各列的编号与索引槽中的行号也要在范围内，与拷贝一样按列并行检查
+        const qint64 moduleCount = modules.size();
+        const qint64 counterCount = counters.size();
+        std::atomic<bool> valid(true);
+        QVector<std::function<void()>> checks;
+        checks.append([&]() {
+            if (!allInRange(s.rowModule, 0, moduleCount))
+                valid = false;
+        });
+        checks.append([&]() {
+            if (!allInRange(s.rowCounter, 0, counterCount))
+                valid = false;
+        });
+        checks.append([&]() {
+            if (!allInRange(s.rowIndex0, -1, qint64(1) << 31)
+                || !allInRange(s.rowIndex1, -1, qint64(1) << 31))
+                valid = false;
+        });
+        for (int i = 0; i < CounterStore::kIndexShards; ++i) {
+            checks.append([&, i]() {
+                // 槽内为 行号+1，0 为空槽；非空槽的个数即分片的行数
+                qint64 used = 0;
+                for (const qint32 slot : s.hashSlots[i]) {
+                    if (slot < 0 || slot > rows) {
+                        valid = false;
+                        return;
+                    }
+                    used += slot != 0;
+                }
+                if (used != shardRows[i])
+                    valid = false;
+            });
+        }
+        QtConcurrent::blockingMap(checks, [](std::function<void()>& check) { check(); });
+        return valid;
+    }
+};
+
+QString SnapshotCache::cachePathFor(const QString& setupPath, const QString& statPath) {
+    const QFileInfo source(statPath.isEmpty() ? setupPath : statPath);
+    return source.dir().filePath(source.completeBaseName() + ".qtcache");
+}
+
+SourceStamp SnapshotCache::stampFile(const QString& path) {
+    SourceStamp stamp;
+    if (path.isEmpty())
+        return stamp;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return stamp;
+    stamp.size = file.size();
+    if (stamp.size == 0)
+        return stamp;
+
+    const uchar* data = file.map(0, stamp.size);
+    QByteArray fallback;
+    if (!data) {
+        fallback = file.readAll();
+        data = reinterpret_cast<const uchar*>(fallback.constData());
+    }
+    // 每块独立哈希后再对块哈希数组做一次哈希
+    const qint64 blocks = (stamp.size + kHashBlock - 1) / kHashBlock;
+    QVector<quint64> blockHashes(blocks);
+    QVector<qint64> blockIds(blocks);
+    std::iota(blockIds.begin(), blockIds.end(), 0);
+    quint64* hashes = blockHashes.data();
+    const qint64 size = stamp.size;
+    QtConcurrent::blockingMap(blockIds, [&](qint64& b) {
+        const qint64 offset = b * kHashBlock;
+        hashes[b] = hashBytes(data + offset, qMin(kHashBlock, size - offset), quint64(b));
+    });
+    stamp.hash = hashBytes(reinterpret_cast<const uchar*>(blockHashes.constData()),
+                           blocks * qint64(sizeof(quint64)), quint64(size));
+    if (fallback.isEmpty())
+        file.unmap(const_cast<uchar*>(data));
+    return stamp;
+}
+
+bool SnapshotCache::load(const QString& cachePath, const SourceStamp& setupStamp,
+                         const SourceStamp& statStamp, Topology& topology, CounterStore& stats) {
+    QFile file(cachePath);
+    if (!file.open(QIODevice::ReadOnly) || file.size() < qint64(sizeof(Header)))
+        return false;
+    const uchar* data = file.map(0, file.size());
+    if (!data)
+        return false;
+
+    Reader reader(data, file.size());
+    const Header header = reader.value<Header>();
+    reader.align();
+    bool ok = memcmp(header.magic, kMagic, sizeof(kMagic)) == 0
+              && header.version == kVersion && header.byteOrder == kByteOrderMark
+              && SourceStamp{header.setupSize, header.setupHash} == setupStamp
+              && SourceStamp{header.statSize, header.statHash} == statStamp;
+
+    Topology t;
+    CounterStore s;
+    ok = ok && readTopology(reader, t) && SnapshotCacheAccess::read(reader, s);
+    file.unmap(const_cast<uchar*>(data));
+    if (!ok)
+        return false;
+    topology = std::move(t);
+    stats = std::move(s);
+    return true;
+}
+
+bool SnapshotCache::save(const QString& cachePath, const SourceStamp& setupStamp,
+                         const SourceStamp& statStamp, const Topology& topology,
+                         const CounterStore& stats, QString* errorMessage) {
+    QSaveFile file(cachePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (errorMessage)
+            *errorMessage = QString("无法写入 %1: %2").arg(cachePath, file.errorString());
+        return false;
+    }
+    Header header;
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byteOrder = kByteOrderMark;
+    header.setupSize = setupStamp.size;
+    header.setupHash = setupStamp.hash;
+    header.statSize = statStamp.size;
+    header.statHash = statStamp.hash;
+
+    Writer writer(&file);
+    writer.value(header);
+    writer.align();
+    writeTopology(writer, topology);
+    SnapshotCacheAccess::write(writer, stats);
+    if (!writer.ok() || !file.commit()) {
+        if (errorMessage)
+            *errorMessage = QString("写入 %1 失败: %2").arg(cachePath, file.errorString());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,38 @@
+// snapshotcache.h
+#ifndef SNAPSHOTCACHE_H
+#define SNAPSHOTCACHE_H
+#include <QString>
+#include "topology.h"
+#include "counterstore.h"
+
+// 源文件的指纹：大小 + 内容哈希，任一变化都会使缓存失效
+struct SourceStamp {
+    qint64 size = -1;      // -1 表示没有该文件
+    quint64 hash = 0;
+    bool operator==(const SourceStamp& o) const { return size == o.size && hash == o.hash; }
+    bool operator!=(const SourceStamp& o) const { return !(*this == o); }
+};
+
+// 一对 setup.txt / statistic.txt 解析结果的二进制快照（.qtcache）
+// 文件头之后是8字节对齐的若干段：拓扑、名称表、计数器各列和索引分片，
+// 均按内存布局原样存放，打开时映射文件后整块拷贝，不做任何文本解析。
+class SnapshotCache {
+public:
+    static const quint32 kVersion = 1;
+
+    // 缓存放在 statistic.txt（没有时为 setup.txt）旁边，如 statistic.qtcache
+    static QString cachePathFor(const QString& setupPath, const QString& statPath);
+
+    // 计算文件指纹；文件映射后按块并行哈希
+    static SourceStamp stampFile(const QString& path);
+
+    // 指纹一致且版本匹配时读入缓存，否则返回 false（不修改输出）
+    static bool load(const QString& cachePath, const SourceStamp& setupStamp,
+                     const SourceStamp& statStamp, Topology& topology, CounterStore& stats);
+    // 先写临时文件再原子替换
+    static bool save(const QString& cachePath, const SourceStamp& setupStamp,
+                     const SourceStamp& statStamp, const Topology& topology,
+                     const CounterStore& stats, QString* errorMessage = nullptr);
+};
+
+#endif // SNAPSHOTCACHE_H
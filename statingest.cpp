@@ -0,0 +1,500 @@
+// statingest.cpp
+#include "statingest.h"
+#include "counterstore.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QLockFile>
+#include <QMutexLocker>
+#include <QThread>
+#include <QTimer>
+#include <QtMath>
+#include <atomic>
+#include <cstring>
+
+namespace {
+
+const int kReadBuffer = 4 << 20;       // 读取缓冲，帧更长时按需放大
+const int kWaitMs = 50;                // 等待数据的间隔，期间检查是否要求停止
+const int kBatchUpdates = 1 << 16;     // 一批最多合并的不同计数器数
+const qint64 kHandoffMs = 8;           // 数据不断到来时，至少每隔这么久交出一批
+const int kDrainIntervalMs = 16;
+const qint64 kDrainBudgetNs = 8 * 1000 * 1000;   // 界面线程每帧写入存储的时间
+const int kProbeTimeoutMs = 200;       // 判断已有的套接字是否还有进程在监听
+
+struct UpdateKey {
+    quint32 module;
+    quint32 counter;
+    qint32 index0;
+    qint32 index1;
+    bool operator==(const UpdateKey& o) const {
+        return module == o.module && counter == o.counter && index0 == o.index0 && index1 == o.index1;
+    }
+};
+
+size_t qHash(const UpdateKey& k, size_t seed = 0) {
+    return qHashMulti(seed, k.module, k.counter, k.index0, k.index1);
+}
+
+template <typename T>
+void appendRaw(QByteArray& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+T readRaw(const char* p) {
+    T value;
+    memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+} // namespace
+
+// ============== IngestFrame ==============
+void IngestFrame::appendDefineModule(QByteArray& out, quint32 id, const QByteArray& name, qint32 latency) {
+    appendRaw<quint32>(out, quint32(1 + 4 + 4 + 2 + name.size()));
+    appendRaw<quint8>(out, DefineModule);
+    appendRaw<quint32>(out, id);
+    appendRaw<qint32>(out, latency);
+    appendRaw<quint16>(out, quint16(name.size()));
+    out.append(name);
+}
+
+void IngestFrame::appendDefineCounter(QByteArray& out, quint32 id, const QByteArray& name) {
+    appendRaw<quint32>(out, quint32(1 + 4 + 2 + name.size()));
+    appendRaw<quint8>(out, DefineCounter);
+    appendRaw<quint32>(out, id);
+    appendRaw<quint16>(out, quint16(name.size()));
+    out.append(name);
+}
+
+void IngestFrame::appendUpdates(QByteArray& out, const Update* updates, quint32 count) {
+    appendRaw<quint32>(out, quint32(1 + 4 + count * sizeof(Update)));
+    appendRaw<quint8>(out, Updates);
+    appendRaw<quint32>(out, count);
+    out.append(reinterpret_cast<const char*>(updates), qsizetype(count) * qsizetype(sizeof(Update)));
+}
+
+void IngestFrame::appendEndEpoch(QByteArray& out) {
+    appendRaw<quint32>(out, 1);
+    appendRaw<quint8>(out, EndEpoch);
+}
+
+// ============== IngestQueue ==============
+IngestQueue::IngestQueue(qint64 maxPendingUpdates) : maxPending(maxPendingUpdates)
+{
+}
+
+bool IngestQueue::push(IngestBatch&& batch) {
+    QMutexLocker lock(&mutex);
+    if (pending >= maxPending && !closed)
+        ++stallCount;
+    while (pending >= maxPending && !closed)
+        notFull.wait(&mutex);
+    if (closed)
+        return false;
+    pending += batch.updates.size();
+    batches.append(std::move(batch));
+    return true;
+}
+
+bool IngestQueue::take(IngestBatch& batch) {
+    QMutexLocker lock(&mutex);
+    if (first == batches.size())
+        return false;
+    batch = std::move(batches[first++]);
+    pending -= batch.updates.size();
+    if (first == batches.size()) {
+        batches.clear();
+        first = 0;
+    }
+    notFull.wakeAll();
+    return true;
+}
+
+void IngestQueue::close() {
+    QMutexLocker lock(&mutex);
+    closed = true;
+    notFull.wakeAll();
+}
+
+void IngestQueue::reopen() {
+    QMutexLocker lock(&mutex);
+    batches.clear();
+    first = 0;
+    pending = 0;
+    closed = false;
+}
+
+qint64 IngestQueue::pendingUpdates() const {
+    QMutexLocker lock(&mutex);
+    return pending;
+}
+
+// ============== 读取线程 ==============
+// 读入一块缓冲后就地解出其中完整的帧，不为每帧分配内存；不完整的尾部挪到缓冲区开头等下次补齐
+class StatIngestServer::Reader {
+public:
+    Reader(quintptr descriptor, IngestQueue* queue) : descriptor(descriptor), queue(queue) {}
+
+    void run();
+    void stop() { stopping = true; }
+    QString error;   // 线程结束后才读取
+
+private:
+    bool decode(const char* frame, quint32 length);
+    void handOff();
+
+    quintptr descriptor;
+    IngestQueue* queue;
+    std::atomic<bool> stopping{false};
+    IngestBatch batch;
+    QHash<UpdateKey, int> slotOf;    // 本批中计数器 -> batch.updates 下标
+    QElapsedTimer sinceHandoff;
+};
+
+void StatIngestServer::Reader::run() {
+    QLocalSocket socket;
+    if (!socket.setSocketDescriptor(descriptor)) {
+        error = socket.errorString();
+        return;
+    }
+    QByteArray buffer(kReadBuffer, Qt::Uninitialized);
+    qsizetype filled = 0;
+    sinceHandoff.start();
+    while (!stopping) {
+        if (socket.bytesAvailable() == 0) {
+            // 暂时没有数据：先把已收到的交出去，界面不必等到下一批
+            handOff();
+            if (!socket.waitForReadyRead(kWaitMs)) {
+                if (socket.state() != QLocalSocket::ConnectedState)
+                    break;
+                continue;
+            }
+        }
+        const qint64 n = socket.read(buffer.data() + filled, buffer.size() - filled);
+        if (n < 0)
+            break;
+        filled += n;
+
+        qsizetype pos = 0;
+        qsizetype needed = 0;
+        while (filled - pos >= 4) {
+            const quint32 length = readRaw<quint32>(buffer.constData() + pos);
+            if (length == 0 || length > IngestFrame::kMaxFrameBytes) {
+                error = QString("帧长度 %1 无效").arg(length);
+                return;
+            }
+            if (quint64(filled - pos - 4) < length) {
+                needed = 4 + qsizetype(length);
+                break;
+            }
+            if (!decode(buffer.constData() + pos + 4, length))
+                return;
+            pos += 4 + qsizetype(length);
+        }
+        memmove(buffer.data(), buffer.constData() + pos, size_t(filled - pos));
+        filled -= pos;
+        if (needed > buffer.size())
+            buffer.resize(needed);
+        if (sinceHandoff.elapsed() >= kHandoffMs)
+            handOff();
+    }
+    handOff();
+}
+
+bool StatIngestServer::Reader::decode(const char* p, quint32 length) {
+    const char* end = p + length;
+    const quint8 type = quint8(*p++);
+    switch (type) {
+    case IngestFrame::DefineModule:
+    case IngestFrame::DefineCounter: {
+        const bool isModule = type == IngestFrame::DefineModule;
+        const qsizetype fixed = isModule ? 4 + 4 + 2 : 4 + 2;
+        if (end - p < fixed)
+            break;
+        const quint32 id = readRaw<quint32>(p);
+        const qint32 latency = isModule ? readRaw<qint32>(p + 4) : 0;
+        const quint16 n = readRaw<quint16>(p + fixed - 2);
+        if (end - p != fixed + n || id >= IngestFrame::kMaxId || n == 0)
+            break;
+        const QByteArray name(p + fixed, n);
+        if (isModule) {
+            batch.modules.append({id, name});
+            batch.moduleLatency.append(latency);
+        } else {
+            batch.counters.append({id, name});
+        }
+        return true;
+    }
+    case IngestFrame::Updates: {
+        if (end - p < 4)
+            break;
+        const quint32 count = readRaw<quint32>(p);
+        p += 4;
+        if (quint64(end - p) != quint64(count) * sizeof(IngestFrame::Update))
+            break;
+        // 同一计数器在本批中只留最后一个值
+        for (quint32 i = 0; i < count; ++i, p += sizeof(IngestFrame::Update)) {
+            IngestFrame::Update u;
+            memcpy(&u, p, sizeof(u));
+            if (u.module >= IngestFrame::kMaxId || u.counter >= IngestFrame::kMaxId) {
+                error = QString("模块号或计数器号超出范围");
+                return false;
+            }
+            const UpdateKey key = {u.module, u.counter, u.index0, u.index1};
+            auto it = slotOf.find(key);
+            if (it != slotOf.end()) {
+                batch.updates[it.value()].value = u.value;
+            } else {
+                slotOf.insert(key, int(batch.updates.size()));
+                batch.updates.append(u);
+            }
+        }
+        batch.received += count;
+        if (batch.updates.size() >= kBatchUpdates)
+            handOff();
+        return true;
+    }
+    case IngestFrame::EndEpoch:
+        if (p != end)
+            break;
+        batch.epochEnd = true;
+        handOff();
+        return true;
+    default:
+        error = QString("未知的帧类型 %1").arg(type);
+        return false;
+    }
+    error = QString("类型 %1 的帧内容不完整").arg(type);
+    return false;
+}
+
+// 交出当前一批；队列积压时在这里等待，不再读取套接字
+void StatIngestServer::Reader::handOff() {
+    sinceHandoff.restart();
+    if (batch.isEmpty())
+        return;
+    queue->push(std::move(batch));
+    batch = IngestBatch();
+    slotOf.clear();
+}
+
+// ============== StatIngestServer ==============
+class StatIngestServer::Server : public QLocalServer {
+public:
+    explicit Server(StatIngestServer* owner) : QLocalServer(owner), owner(owner) {}
+
+protected:
+    // 连接交给读取线程，在那里用描述符创建套接字
+    void incomingConnection(quintptr descriptor) override { owner->accept(descriptor); }
+
+private:
+    StatIngestServer* owner;
+};
+
+StatIngestServer::StatIngestServer(QObject* parent)
+    : QObject(parent), queue(kMaxPendingUpdates)
+{
+    server = new Server(this);
+    drainTimer = new QTimer(this);
+    drainTimer->setInterval(kDrainIntervalMs);
+    connect(drainTimer, &QTimer::timeout, this, &StatIngestServer::drain);
+}
+
+StatIngestServer::~StatIngestServer() {
+    stopReader();
+}
+
+bool StatIngestServer::listen(const QString& name, CounterStore* target, QString* errorMessage) {
+    close();
+    store = target;
+    // 另一个实例正在监听时不去探测它：探测的连接会替换掉它与模拟器之间的连接
+    std::unique_ptr<QLockFile> lock(new QLockFile(QDir::temp().filePath(name + ".lock")));
+    lock->setStaleLockTime(0);   // 只在持有的进程已退出时视为过期
+    if (!lock->tryLock()) {
+        if (errorMessage)
+            *errorMessage = QString("%1 已被另一个实例监听").arg(name);
+        return false;
+    }
+    bool ok = server->listen(name);
+    if (!ok && server->serverError() == QAbstractSocket::AddressInUseError) {
+        // 有进程应答时名称确实被占用；没有应答才是上次异常退出留下的套接字文件
+        QLocalSocket probe;
+        probe.connectToServer(name);
+        if (probe.waitForConnected(kProbeTimeoutMs)) {
+            probe.disconnectFromServer();
+            if (errorMessage)
+                *errorMessage = QString("%1 已被其他进程使用").arg(name);
+            return false;
+        }
+        QLocalServer::removeServer(name);
+        ok = server->listen(name);
+    }
+    if (!ok) {
+        if (errorMessage)
+            *errorMessage = QString("无法监听 %1：%2").arg(name, server->errorString());
+        return false;
+    }
+    nameLock = std::move(lock);
+    drainTimer->start();
+    return true;
+}
+
+void StatIngestServer::close() {
+    stopReader();
+    server->close();
+    nameLock.reset();
+    drainTimer->stop();
+}
+
+bool StatIngestServer::isListening() const {
+    return server->isListening();
+}
+
+QString StatIngestServer::serverName() const {
+    return server->fullServerName();
+}
+
+void StatIngestServer::setStore(CounterStore* target) {
+    store = target;
+    moduleIds.fill(-1);
+    counterIds.fill(-1);
+}
+
+void StatIngestServer::accept(quintptr descriptor) {
+    // 新连接替换旧连接，发送方的编号从头开始
+    if (reader) {
+        stopReader();
+        emit clientDisconnected(QString());
+    }
+    queue.reopen();
+    moduleNames.clear();
+    moduleLatency.clear();
+    moduleIds.clear();
+    counterNames.clear();
+    counterIds.clear();
+
+    Reader* r = new Reader(descriptor, &queue);
+    QThread* thread = QThread::create([r]() { r->run(); });
+    reader = r;
+    readerThread = thread;
+    connect(thread, &QThread::finished, this, [this, thread]() {
+        if (thread != readerThread)
+            return;
+        // 断开前收到的数据照常写入
+        drainAll();
+        const QString error = reader->error;
+        delete reader;
+        reader = nullptr;
+        readerThread = nullptr;
+        thread->deleteLater();
+        emit clientDisconnected(error);
+    });
+    thread->start();
+    emit clientConnected();
+}
+
+void StatIngestServer::stopReader() {
+    if (!reader)
+        return;
+    reader->stop();
+    queue.close();          // 唤醒在 push 中等待的读取线程
+    readerThread->wait();
+    disconnect(readerThread, nullptr, this, nullptr);
+    delete readerThread;
+    delete reader;
+    reader = nullptr;
+    readerThread = nullptr;
+    queue.reopen();         // 丢弃没处理的批次
+}
+
+void StatIngestServer::drain() {
+    drainFor(kDrainBudgetNs);
+}
+
+void StatIngestServer::drainAll() {
+    drainFor(-1);
+}
+
+// 在预算时间内处理队列中的批次；变化的行合并成一次 rowsChanged，
+// 遇到 epoch 结束时先报告这之前的变化，再报告 epoch 结束
+void StatIngestServer::drainFor(qint64 budgetNs) {
+    QElapsedTimer timer;
+    timer.start();
+    QVector<qint32> rows;
+    IngestBatch batch;
+    while ((budgetNs < 0 || timer.nsecsElapsed() < budgetNs) && queue.take(batch)) {
+        if (!apply(batch, rows))
+            continue;
+        if (batch.epochEnd) {
+            if (!rows.isEmpty())
+                emit rowsChanged(rows);
+            rows.clear();
+            emit epochCompleted();
+        }
+    }
+    if (!rows.isEmpty())
+        emit rowsChanged(rows);
+}
+
+bool StatIngestServer::apply(const IngestBatch& batch, QVector<qint32>& rows) {
+    received += batch.received;
+    for (int i = 0; i < batch.modules.size(); ++i) {
+        const quint32 id = batch.modules[i].first;
+        if (id >= quint32(moduleNames.size())) {
+            moduleNames.resize(id + 1);
+            moduleLatency.resize(id + 1);
+            moduleIds.resize(id + 1, -1);
+        }
+        moduleNames[id] = batch.modules[i].second;
+        moduleLatency[id] = batch.moduleLatency[i];
+        moduleIds[id] = -1;
+    }
+    for (const auto& def : batch.counters) {
+        if (def.first >= quint32(counterNames.size())) {
+            counterNames.resize(def.first + 1);
+            counterIds.resize(def.first + 1, -1);
+        }
+        counterNames[def.first] = def.second;
+        counterIds[def.first] = -1;
+    }
+    // 没有可写入的存储（还没有打开运行）时丢弃，只为了不让发送方一直阻塞
+    if (!store)
+        return false;
+    for (const IngestFrame::Update& u : batch.updates) {
+        const int module = storeModule(u.module);
+        const int counter = storeCounter(u.counter);
+        if (module < 0 || counter < 0)
+            continue;   // 未定义的编号
+        if (u.value != qFloor(u.value))
+            store->counterIsReal[counter] = 1;
+        bool changed = false;
+        const int row = store->setValue(module, counter, u.index0, u.index1, u.value, &changed);
+        if (changed)
+            rows.append(row);
+        ++applied;
+    }
+    return true;
+}
+
+int StatIngestServer::storeModule(quint32 id) {
+    if (id >= quint32(moduleIds.size()) || moduleNames[id].isEmpty())
+        return -1;
+    if (moduleIds[id] < 0) {
+        const QByteArray& name = moduleNames[id];
+        moduleIds[id] = store->addModule(name.constData(), name.size(), moduleLatency[id]);
+    }
+    return moduleIds[id];
+}
+
+int StatIngestServer::storeCounter(quint32 id) {
+    if (id >= quint32(counterIds.size()) || counterNames[id].isEmpty())
+        return -1;
+    if (counterIds[id] < 0) {
+        const QByteArray& name = counterNames[id];
+        counterIds[id] = store->addCounter(name.constData(), name.size());
+    }
+    return counterIds[id];
+}
@@ -0,0 +1,155 @@
+// statingest.h
+#ifndef STATINGEST_H
+#define STATINGEST_H
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QVector>
+#include <QWaitCondition>
+#include <memory>
+
+class CounterStore;
+class QLocalServer;
+class QLockFile;
+class QThread;
+class QTimer;
+
+// 模拟器经本地套接字推送统计数据，不再写出和重新解析 statistic.txt
+// 字节流由若干帧组成，字段按小端存放：
+//   u32 长度（不含这 4 字节） + u8 类型 + 内容
+//   1 定义模块   u32 模块号, i32 Latency, u16 名称长度, 名称
+//   2 定义计数器 u32 计数器号, u16 名称长度, 名称（数字下标段写成 '#'，如 "edge_#_to_#_busy_rate"）
+//   3 更新       u32 条数, 每条 {u32 模块号, u32 计数器号, i32 下标0, i32 下标1, f64 值}
+//   4 epoch 结束 无内容
+// 模块号与计数器号由发送方自行编号，使用前先定义；更新只需发送值有变化的计数器，值为新值而不是增量。
+namespace IngestFrame {
+enum Type : quint8 { DefineModule = 1, DefineCounter = 2, Updates = 3, EndEpoch = 4 };
+
+struct Update {
+    quint32 module;
+    quint32 counter;
+    qint32 index0;        // 没有下标为 -1
+    qint32 index1;
+    double value;
+};
+static_assert(sizeof(Update) == 24, "Update 必须为 24 字节");
+
+static const quint32 kMaxFrameBytes = 64u << 20;
+static const quint32 kMaxId = 1u << 20;      // 模块号与计数器号的上限
+
+// 编码各种帧，追加到 out 末尾（供模拟器一侧或测试程序使用）
+void appendDefineModule(QByteArray& out, quint32 id, const QByteArray& name, qint32 latency);
+void appendDefineCounter(QByteArray& out, quint32 id, const QByteArray& name);
+void appendUpdates(QByteArray& out, const Update* updates, quint32 count);
+void appendEndEpoch(QByteArray& out);
+}
+
+// 读取线程交给界面线程的一批数据：这一段时间内收到的定义与合并后的更新
+// 同一计数器在一批里只留最后一个值；epochEnd 表示这一批以 epoch 结束帧收尾
+struct IngestBatch {
+    QVector<QPair<quint32, QByteArray>> modules;
+    QVector<qint32> moduleLatency;        // 对应 modules
+    QVector<QPair<quint32, QByteArray>> counters;
+    QVector<IngestFrame::Update> updates;
+    quint64 received = 0;                 // 合并前的更新条数
+    bool epochEnd = false;
+
+    bool isEmpty() const { return modules.isEmpty() && counters.isEmpty() && updates.isEmpty() && !epochEnd; }
+};
+
+// 读取线程与界面线程之间的有界队列
+// 积压的更新超过上限时读取线程在 push 中等待，不再读套接字，发送方随之在写入时阻塞（反压）
+class IngestQueue {
+public:
+    explicit IngestQueue(qint64 maxPendingUpdates);
+
+    // 读取线程：队列积压过多时等待；close 之后返回 false
+    bool push(IngestBatch&& batch);
+    // 界面线程：取出最早的一批，没有返回 false
+    bool take(IngestBatch& batch);
+    void close();
+    void reopen();
+    qint64 pendingUpdates() const;
+    quint64 stalls() const { return stallCount; }   // push 因积压而等待的次数
+
+private:
+    mutable QMutex mutex;
+    QWaitCondition notFull;
+    QVector<IngestBatch> batches;
+    int first = 0;                 // batches 中下一个取出的位置
+    qint64 pending = 0;
+    qint64 maxPending;
+    bool closed = false;
+    quint64 stallCount = 0;
+};
+
+// 在本地套接字（Unix 域套接字 / Windows 命名管道）上接收推送
+// 每个连接一个读取线程：读入一块缓冲后就地解帧，更新按计数器合并成批交给队列；
+// 界面线程每帧（16 ms）从队列取批，在时间预算内写入 CounterStore 并报告变化的行，
+// 与 StatTailer 的信号一致，视图可以用同一套刷新逻辑。同一时间只服务一个连接，新连接替换旧连接。
+class StatIngestServer : public QObject {
+    Q_OBJECT
+public:
+    static const qint64 kMaxPendingUpdates = 1 << 20;   // 队列积压上限（约 24 MB）
+    static const char* defaultServerName() { return "qtvis-stats"; }
+
+    explicit StatIngestServer(QObject* parent = nullptr);
+    ~StatIngestServer();
+
+    // store 由调用方持有。同一名称只能由一个实例监听（监听期间持有临时目录下的锁文件）；
+    // name 已存在且没有进程应答时是上次异常退出留下的套接字文件，先移除再监听
+    bool listen(const QString& name, CounterStore* store, QString* errorMessage = nullptr);
+    void close();
+    bool isListening() const;
+    QString serverName() const;
+    bool hasClient() const { return reader != nullptr; }
+    // 换了一份存储（重新加载运行）：发送方的编号按已定义的名称重新对应
+    void setStore(CounterStore* store);
+
+    quint64 receivedUpdates() const { return received; }
+    quint64 appliedUpdates() const { return applied; }
+    quint64 backpressureStalls() const { return queue.stalls(); }
+
+    // 立即处理队列中的全部批次（不限时间），供测试与基准使用
+    void drainAll();
+
+signals:
+    // rows 为本次新增或值发生变化的行
+    void rowsChanged(const QVector<qint32>& rows);
+    // 收到 epoch 结束帧：store 中是刚结束的 epoch 的值
+    void epochCompleted();
+    void clientConnected();
+    // 连接断开；协议错误时 errorMessage 不为空
+    void clientDisconnected(const QString& errorMessage);
+
+private:
+    class Server;
+    class Reader;
+
+    void accept(quintptr descriptor);
+    void stopReader();
+    void drain();
+    void drainFor(qint64 budgetNs);
+    bool apply(const IngestBatch& batch, QVector<qint32>& rows);
+    int storeModule(quint32 id);
+    int storeCounter(quint32 id);
+
+    Server* server = nullptr;
+    Reader* reader = nullptr;
+    QThread* readerThread = nullptr;
+    IngestQueue queue;
+    QTimer* drainTimer;
+    std::unique_ptr<QLockFile> nameLock;   // 监听期间持有
+    CounterStore* store = nullptr;
+    // 发送方编号 -> 名称与 CounterStore 中的ID（-1 为尚未对应）
+    QVector<QByteArray> moduleNames;
+    QVector<qint32> moduleLatency;
+    QVector<qint32> moduleIds;
+    QVector<QByteArray> counterNames;
+    QVector<qint32> counterIds;
+    quint64 received = 0;
+    quint64 applied = 0;
+};
+
+#endif // STATINGEST_H
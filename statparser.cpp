@@ -0,0 +1,229 @@
+// statparser.cpp
+#include "statparser.h"
+#include "textscan.h"
+#include <QFile>
+
+using TextScan::Span;
+
+namespace {
+
+const char kLatency[] = "Latency";
+const qsizetype kLatencyLen = sizeof(kLatency) - 1;
+const int kMaxKeyLength = 256;
+
+bool fail(QString* errorMessage, qint64 line, const QString& what) {
+    if (errorMessage)
+        *errorMessage = QString("statistic.txt 第%1行: %2").arg(line).arg(what);
+    return false;
+}
+
+// 把计数器名中纯数字的段替换为 '#'，最多提取两个下标
+// 返回模板长度；名字过长时原样返回，不提取下标
+qsizetype makeTemplate(Span key, char* buffer, qint32& index0, qint32& index1) {
+    index0 = index1 = -1;
+    if (key.size() > kMaxKeyLength) return -1;
+
+    qsizetype out = 0;
+    int found = 0;
+    const char* p = key.begin;
+    while (p < key.end) {
+        const char* tokenEnd = p;
+        bool digits = true;
+        while (tokenEnd < key.end && *tokenEnd != '_') {
+            digits = digits && TextScan::isDigit(*tokenEnd);
+            ++tokenEnd;
+        }
+        if (digits && tokenEnd > p && found < 2 && tokenEnd - p <= 9) {
+            qint32 v = 0;
+            for (const char* c = p; c < tokenEnd; ++c)
+                v = v * 10 + (*c - '0');
+            (found == 0 ? index0 : index1) = v;
+            ++found;
+            buffer[out++] = '#';
+        } else {
+            memcpy(buffer + out, p, size_t(tokenEnd - p));
+            out += tokenEnd - p;
+        }
+        if (tokenEnd < key.end)
+            buffer[out++] = '_';
+        p = tokenEnd + 1;
+    }
+    return out;
+}
+
+// key 形如 "Name Latency" 时取出 Name
+bool sectionName(Span key, Span& name) {
+    if (key.size() <= kLatencyLen || memcmp(key.end - kLatencyLen, kLatency, kLatencyLen) != 0
+        || !TextScan::isSpace(key.end[-kLatencyLen - 1]))
+        return false;
+    name = TextScan::trimmed(Span{key.begin, key.end - kLatencyLen});
+    return true;
+}
+
+// 计数器值：绝大多数是非负整数，先走整数快速路径，失败再交给 from_chars
+bool parseValue(Span value, double& out, bool& isReal) {
+    if (value.isEmpty()) return false;
+    // 整数（可带符号）直接累加，不经过 toDouble
+    const char* digits = value.begin;
+    const bool negative = *digits == '-';
+    if (negative || *digits == '+')
+        ++digits;
+    if (digits < value.end && value.end - digits <= 18) {
+        qint64 v = 0;
+        const char* c = digits;
+        while (c < value.end && TextScan::isDigit(*c))
+            v = v * 10 + (*c++ - '0');
+        if (c == value.end) {
+            out = negative ? -double(v) : double(v);
+            isReal = false;
+            return true;
+        }
+    }
+    // 只有小数点、指数或 inf/nan 才算实数，超长的整数仍按整数显示
+    isReal = false;
+    for (const char* c = digits; c < value.end; ++c) {
+        if (!TextScan::isDigit(*c)) {
+            isReal = true;
+            break;
+        }
+    }
+    return TextScan::toDouble(value, out);
+}
+
+} // namespace
+
+bool StatParser::parseFile(const QString& path, CounterStore& out, QString* errorMessage) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorMessage)
+            *errorMessage = QString("无法打开 %1: %2").arg(path, file.errorString());
+        return false;
+    }
+    out.clear();
+    const qint64 size = file.size();
+    if (size == 0)
+        return true;
+    // 大致按每行 40 字节预留，避免解析过程中反复扩容
+    out.reserveRows(int(qMin<qint64>(size / 40, 1 << 28)));
+
+    const uchar* data = file.map(0, size);
+    if (!data) {
+        const QByteArray all = file.readAll();
+        return parse(all.constData(), all.size(), out, errorMessage);
+    }
+    const bool ok = parse(reinterpret_cast<const char*>(data), qsizetype(size), out, errorMessage);
+    file.unmap(const_cast<uchar*>(data));
+    return ok;
+}
+
+bool StatParser::parse(const char* data, qsizetype size, CounterStore& out,
+                       QString* errorMessage, int* currentModule, QVector<qint32>* changedRows) {
+    const char* p = data;
+    const char* end = data + size;
+    qint64 lineNo = 0;
+    int module = currentModule ? *currentModule : -1;
+
+    char keyBuffer[kMaxKeyLength + 1];
+    // 相邻行的计数器模板通常相同（如整片的流量矩阵），缓存上一次的查表结果
+    char lastTemplate[kMaxKeyLength + 1];
+    qsizetype lastTemplateLen = -1;
+    int lastCounter = -1;
+
+    while (p < end) {
+        ++lineNo;
+        const Span line = TextScan::stripComment(TextScan::nextLine(p, end));
+        if (line.isEmpty())
+            continue;
+
+        const char* colon = TextScan::find(line, ':');
+        if (!colon)
+            return fail(errorMessage, lineNo, "缺少 ':'");
+        const Span key = TextScan::trimmed(Span{line.begin, colon});
+        const Span value = TextScan::trimmed(Span{colon + 1, line.end});
+
+        // 段头："Name Latency:N"
+        Span name;
+        if (sectionName(key, name)) {
+            qint64 latency = 0;
+            if (name.isEmpty() || !TextScan::toInt(value, latency))
+                return fail(errorMessage, lineNo, "模块段头格式应为 'Name Latency:N'");
+            module = out.addModule(name.begin, name.size(), qint32(latency));
+            continue;
+        }
+
+        if (module < 0)
+            return fail(errorMessage, lineNo, "计数器出现在任何模块段之前");
+
+        double v = 0;
+        bool isReal = false;
+        if (!parseValue(value, v, isReal))
+            return fail(errorMessage, lineNo, "计数器值不是数字");
+
+        qint32 index0, index1;
+        const char* counterName = keyBuffer;
+        qsizetype nameLen = makeTemplate(key, keyBuffer, index0, index1);
+        if (nameLen < 0) {
+            counterName = key.begin;
+            nameLen = key.size();
+        }
+
+        int counter;
+        if (nameLen == lastTemplateLen && memcmp(counterName, lastTemplate, size_t(nameLen)) == 0) {
+            counter = lastCounter;
+        } else {
+            counter = out.addCounter(counterName, nameLen);
+            if (nameLen <= kMaxKeyLength) {
+                memcpy(lastTemplate, counterName, size_t(nameLen));
+                lastTemplateLen = nameLen;
+                lastCounter = counter;
+            }
+        }
+        if (isReal)
+            out.counterIsReal[counter] = 1;
+
+        if (changedRows) {
+            bool changed = false;
+            const int row = out.setValue(module, counter, index0, index1, v, &changed);
+            if (changed)
+                changedRows->append(row);
+        } else {
+            out.setValue(module, counter, index0, index1, v);
+        }
+    }
+
+    if (currentModule)
+        *currentModule = module;
+    return true;
+}
+
+bool StatParser::isSectionHeader(const char* line, qsizetype size, QByteArray* name) {
+    const Span text = TextScan::stripComment(Span{line, line + size});
+    const char* colon = TextScan::find(text, ':');
+    Span module;
+    if (!colon || !sectionName(TextScan::trimmed(Span{text.begin, colon}), module) || module.isEmpty())
+        return false;
+    if (name)
+        *name = QByteArray(module.begin, module.size());
+    return true;
+}
+
+QVector<qsizetype> EpochSplitter::split(const char* data, qsizetype size) {
+    QVector<qsizetype> boundaries;
+    const char* p = data;
+    const char* end = data + size;
+    QByteArray module;
+    while (p < end) {
+        const char* lineStart = p;
+        const Span line = TextScan::nextLine(p, end);
+        const bool blank = TextScan::trimmed(line).isEmpty();
+        if (previousBlank && !blank && StatParser::isSectionHeader(line.begin, line.size(), &module)) {
+            if (seen.contains(module)) {
+                boundaries.append(lineStart - data);
+                seen.clear();
+            }
+            seen.insert(module);
+        }
+        previousBlank = blank;
+    }
+    return boundaries;
+}
@@ -0,0 +1,45 @@
+// statparser.h
+#ifndef STATPARSER_H
+#define STATPARSER_H
+#include <QString>
+#include <QSet>
+#include "counterstore.h"
+
+// statistic.txt 的流式解析器
+// 格式："Name Latency:N" 开始一个模块段，段内为 "counter: value" 行，"//" 之后为注释。
+// 直接在映射的文件内容上逐行扫描，不为每行创建 QString/QByteArray；
+// 计数器名先在栈上缓冲区里归一化成模板，再到驻留表中查ID。
+class StatParser {
+public:
+    static bool parseFile(const QString& path, CounterStore& out, QString* errorMessage = nullptr);
+
+    // 解析 [data, data+size) 并合并进 out（不清空 out，已有的计数器被覆盖）
+    // 可传入 currentModule 以便从段中间继续解析，返回时更新为最后所在的模块
+    // changedRows 不为空时追加新增或值发生变化的行号（同一行可能出现多次）
+    static bool parse(const char* data, qsizetype size, CounterStore& out,
+                      QString* errorMessage = nullptr, int* currentModule = nullptr,
+                      QVector<qint32>* changedRows = nullptr);
+
+    // 判断一行（可含注释）是否为 "Name Latency:N" 段头，name 不为空时取出模块名
+    static bool isSectionHeader(const char* line, qsizetype size, QByteArray* name = nullptr);
+};
+
+// 把多个快照（epoch）依次追加而成的 statistic.txt 切开
+// 模拟器每 N 个周期输出一遍所有模块的段；某个模块的段在当前 epoch 中再次出现，
+// 就说明上一个 epoch 已经结束。只检查文件开头和空行之后的段头。
+class EpochSplitter {
+public:
+    // 扫描 [data, data+size)，返回其中每个新 epoch 第一个段头的行首偏移
+    // 状态跨调用保留，可以按行边界分块送入
+    QVector<qsizetype> split(const char* data, qsizetype size);
+
+    // 当前 epoch 已出现的模块，如整体加载后把所有模块都视为已出现
+    void markSeen(const QByteArray& module) { seen.insert(module); }
+    void reset() { seen.clear(); previousBlank = true; }
+
+private:
+    QSet<QByteArray> seen;
+    bool previousBlank = true;   // 文件开头视同空行之后
+};
+
+#endif // STATPARSER_H
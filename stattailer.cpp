@@ -0,0 +1,191 @@
+// stattailer.cpp
+#include "stattailer.h"
+#include "statparser.h"
+#include "counterstore.h"
+#include "textscan.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QTimer>
+
+using TextScan::Span;
+
+namespace {
+
+// 文件系统通知之外的兜底轮询间隔
+const int kPollInterval = 1000;
+// 续接时向前找段头的最大距离
+const qint64 kResumeWindow = 1 << 20;
+// 判断文件是否被替换时比较的开头长度
+const qint64 kHeadBytes = 4096;
+
+// 最后一个 '\n' 之后的位置，即完整行的前缀长度
+qsizetype completeLines(const char* data, qsizetype size) {
+    qsizetype p = size;
+    while (p > 0 && data[p - 1] != '\n')
+        --p;
+    return p;
+}
+
+} // namespace
+
+StatTailer::StatTailer(QObject* parent) : QObject(parent)
+{
+    watcher = new QFileSystemWatcher(this);
+    connect(watcher, &QFileSystemWatcher::fileChanged, this, &StatTailer::poll);
+    pollTimer = new QTimer(this);
+    pollTimer->setInterval(kPollInterval);
+    connect(pollTimer, &QTimer::timeout, this, &StatTailer::poll);
+}
+
+void StatTailer::start(const QString& path, qint64 offset, CounterStore* target,
+                       const EpochSplitter& epochs) {
+    stop();
+    filePath = path;
+    parsedBytes = offset;
+    lastSize = -1;
+    store = target;
+    splitter = epochs;
+    head.clear();
+    resume();
+    QFile file(filePath);
+    if (file.open(QIODevice::ReadOnly))
+        rememberHead(file);
+    watcher->addPath(filePath);
+    pollTimer->start();
+}
+
+void StatTailer::stop() {
+    if (!watcher->files().isEmpty())
+        watcher->removePaths(watcher->files());
+    pollTimer->stop();
+    store = nullptr;
+    currentModule = -1;
+}
+
+// 已解析部分可能停在段中间甚至行中间（加载时模拟器正在写）：
+// 退回到最后一个完整行之后，并找出该处所在的模块，之后的计数器归到它名下
+void StatTailer::resume() {
+    currentModule = -1;
+    if (parsedBytes <= 0)
+        return;
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+    const qint64 windowStart = qMax<qint64>(0, parsedBytes - kResumeWindow);
+    file.seek(windowStart);
+    const QByteArray window = file.read(parsedBytes - windowStart);
+    const char* data = window.constData();
+    const qsizetype complete = completeLines(data, window.size());
+    parsedBytes = windowStart + complete;
+
+    // 窗口中间开始的第一行不完整，跳过
+    const char* p = data;
+    const char* end = data + complete;
+    if (windowStart > 0) {
+        const char* nl = static_cast<const char*>(memchr(p, '\n', size_t(end - p)));
+        p = nl ? nl + 1 : end;
+    }
+    Span header{nullptr, nullptr};
+    while (p < end) {
+        const Span line = TextScan::nextLine(p, end);
+        if (StatParser::isSectionHeader(line.begin, line.size()))
+            header = line;
+    }
+    if (!header.isEmpty())
+        StatParser::parse(header.begin, header.size(), *store, nullptr, &currentModule);
+    else if (!store->isEmpty())
+        currentModule = store->rowModule.last();
+}
+
+void StatTailer::rememberHead(QFile& file) {
+    const qint64 length = qMin(parsedBytes, kHeadBytes);
+    if (head.size() == length)
+        return;
+    birthTime = QFileInfo(file).birthTime();
+    file.seek(0);
+    head = file.read(length);
+}
+
+// 模拟重新开始时文件可能被原地重写，写得比已解析的部分还长，只看大小分辨不出来
+bool StatTailer::isReplaced(QFile& file) const {
+    if (QFileInfo(file).birthTime() != birthTime)
+        return true;
+    file.seek(0);
+    return file.read(head.size()) != head;
+}
+
+// 停止跟踪再报告，重新加载期间的轮询不会再次触发
+void StatTailer::reset() {
+    stop();
+    emit fileReset();
+}
+
+qsizetype StatTailer::completeLength(const char* data, qsizetype size) {
+    // 从末尾往前逐行找，遇到以 '\n' 结尾的空行即为段边界
+    qsizetype lineEnd = completeLines(data, size);
+    while (lineEnd > 0) {
+        const qsizetype newline = lineEnd - 1;
+        qsizetype lineStart = newline;
+        while (lineStart > 0 && data[lineStart - 1] != '\n')
+            --lineStart;
+        if (TextScan::trimmed(Span{data + lineStart, data + newline}).isEmpty())
+            return lineEnd;
+        lineEnd = lineStart;
+    }
+    return 0;
+}
+
+void StatTailer::poll() {
+    if (!store)
+        return;
+    // 文件被替换后监视会失效，重新加上
+    if (!watcher->files().contains(filePath))
+        watcher->addPath(filePath);
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return;   // 可能正被替换，下次再试
+    const qint64 size = file.size();
+    if (size < parsedBytes || isReplaced(file)) {
+        reset();
+        return;
+    }
+    const bool idle = size == lastSize;
+    lastSize = size;
+    if (size == parsedBytes)
+        return;
+
+    file.seek(parsedBytes);
+    const QByteArray appended = file.read(size - parsedBytes);
+    qsizetype length = completeLength(appended.constData(), appended.size());
+    // 写入已停下来时，最后一段后面可能不再有空行，把完整的行都收进来
+    if (length == 0 && idle)
+        length = completeLines(appended.constData(), appended.size());
+    if (length == 0)
+        return;
+
+    // 按 epoch 边界分段解析，进入新的 epoch 之前先通知，便于记下上一个 epoch 的值
+    const char* data = appended.constData();
+    const QVector<qsizetype> cuts = splitter.split(data, length);
+    qsizetype begin = 0;
+    for (int i = 0; i <= cuts.size(); ++i) {
+        const qsizetype end = i < cuts.size() ? cuts[i] : length;
+        if (i > 0)
+            emit epochCompleted();
+        QVector<qint32> rows;
+        QString error;
+        if (!StatParser::parse(data + begin, end - begin, *store, &error, &currentModule, &rows)) {
+            // 出错的段已有一部分并入 store，之后的 epoch 也无法可靠地接上，只算到出错之前，整体重新加载
+            parsedBytes += begin;
+            emit parseError(error);
+            reset();
+            return;
+        }
+        if (!rows.isEmpty())
+            emit rowsChanged(rows);
+        begin = end;
+    }
+    parsedBytes += length;
+    rememberHead(file);
+}
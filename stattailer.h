@@ -0,0 +1,69 @@
+// stattailer.h
+#ifndef STATTAILER_H
+#define STATTAILER_H
+#include <QByteArray>
+#include <QDateTime>
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include "statparser.h"
+
+class QFile;
+class QFileSystemWatcher;
+class QTimer;
+
+// 跟踪模拟器仍在追加写入的 statistic.txt
+// 记住已解析到的字节偏移，文件增长时只读入新增部分里完整的段（以空行结束），
+// 合并进调用方持有的 CounterStore，并报告新增或值发生变化的行。
+// 新增内容按 EpochSplitter 在 epoch 边界处分开解析，跨过边界之前先报告上一个 epoch 结束。
+// 文件变化通知来自 QFileSystemWatcher，另有定时轮询兜底（部分文件系统不发通知）。
+// 文件变短、开头的内容或创建时间变了（模拟重新开始写入）、或新内容解析出错时停止跟踪并报告 fileReset。
+class StatTailer : public QObject {
+    Q_OBJECT
+public:
+    explicit StatTailer(QObject* parent = nullptr);
+
+    // offset 为 store 中已解析的字节数（通常是加载时的文件大小），
+    // splitter 为解析到 offset 时的 epoch 切分状态
+    void start(const QString& path, qint64 offset, CounterStore* store,
+               const EpochSplitter& splitter);
+    void stop();
+    bool isActive() const { return store != nullptr; }
+    const QString& path() const { return filePath; }
+    qint64 offset() const { return parsedBytes; }
+
+    // 立即检查一次文件是否有新内容
+    void poll();
+
+    // [data, data+size) 中到最后一个空行为止的前缀长度，即可以安全解析的完整段
+    static qsizetype completeLength(const char* data, qsizetype size);
+
+signals:
+    // rows 为本次新增或值发生变化的行，同一行可能出现多次
+    void rowsChanged(const QVector<qint32>& rows);
+    // 新内容开始了下一个 epoch：此时 store 中还是上一个 epoch 结束时的值
+    void epochCompleted();
+    // 文件被截断或替换（模拟重新开始），或新内容无法解析，需要整体重新加载；此时跟踪已停止
+    void fileReset();
+    void parseError(const QString& message);
+
+private:
+    void resume();
+    // 记下文件开头的内容与创建时间，之后每次轮询与之比较
+    void rememberHead(QFile& file);
+    bool isReplaced(QFile& file) const;
+    void reset();
+
+    QFileSystemWatcher* watcher;
+    QTimer* pollTimer;
+    QString filePath;
+    CounterStore* store = nullptr;
+    qint64 parsedBytes = 0;
+    qint64 lastSize = -1;       // 上一次轮询时的文件大小，用于判断写入是否已停止
+    int currentModule = -1;     // 已解析部分最后所在的模块，续接段中间时使用
+    EpochSplitter splitter;
+    QByteArray head;            // 文件开头至多 kHeadBytes 字节，不超过已解析的部分
+    QDateTime birthTime;        // 文件系统不支持时无效
+};
+
+#endif // STATTAILER_H
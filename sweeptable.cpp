@@ -0,0 +1,138 @@
+// sweeptable.cpp
+#include "sweeptable.h"
+#include "counterstore.h"
+#include "derivedmetrics.h"
+#include "setupparser.h"
+#include "snapshotcache.h"
+#include "statparser.h"
+#include "topology.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QtMath>
+#include <algorithm>
+
+namespace {
+
+// 有值的各项的平均，一项都没有为 NaN
+struct Mean {
+    double sum = 0;
+    int count = 0;
+    void add(double v) {
+        if (qIsNaN(v))
+            return;
+        sum += v;
+        ++count;
+    }
+    double value() const { return count > 0 ? sum / count : qQNaN(); }
+};
+
+double paramValue(const QByteArray& name, const Topology& t) {
+    // "L3Cache.way_count"：点之前为模块名前缀
+    const int dot = name.indexOf('.');
+    const QByteArray prefix = dot >= 0 ? name.left(dot) : QByteArray();
+    const int key = t.paramKey(dot >= 0 ? name.mid(dot + 1) : name);
+    if (key < 0)
+        return qQNaN();
+    for (int m = 0; m < t.modules.size(); ++m) {
+        if (!prefix.isEmpty() && !t.modules[m].name.startsWith(prefix))
+            continue;
+        const qint64 v = t.param(m, key, -1);
+        if (v >= 0)
+            return double(v);
+    }
+    return qQNaN();
+}
+
+} // namespace
+
+QVector<SweepColumn> SweepTable::defaultColumns() {
+    return {
+        {SweepColumn::Param, "way_count", "way_count"},
+        {SweepColumn::Param, "set_count", "set_count"},
+        {SweepColumn::Param, "mshr_count", "mshr_count"},
+        {SweepColumn::Param, "nuca_num", "nuca_num"},
+        {SweepColumn::Metric, "ipc", "IPC"},
+        {SweepColumn::Metric, "llc_hit_rate", "L3命中率"},
+        {SweepColumn::Counter, "avg_transmit_latency", "平均传输延迟"},
+        {SweepColumn::Counter, "busy_rate", "内存使用率"},
+    };
+}
+
+QVector<SweepRun> SweepTable::discover(const QString& root) {
+    QStringList setups;
+    QDirIterator it(root, QStringList() << "setup.txt", QDir::Files,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext())
+        setups << it.next();
+    std::sort(setups.begin(), setups.end());
+
+    QVector<SweepRun> runs;
+    runs.reserve(setups.size());
+    for (const QString& path : setups) {
+        const QFileInfo info(path);
+        SweepRun run;
+        run.setupPath = path;
+        const QString stat = info.dir().filePath("statistic.txt");
+        if (QFileInfo::exists(stat))
+            run.statPath = stat;
+        // 子目录用相对路径区分同名的各级目录，root 本身用目录名
+        run.name = QDir(root).relativeFilePath(info.path());
+        if (run.name == ".")
+            run.name = info.dir().dirName();
+        runs.append(run);
+    }
+    return runs;
+}
+
+void SweepTable::loadRun(SweepRun& run, const QVector<SweepColumn>& columns) {
+    run.loaded = true;
+    run.values.fill(qQNaN(), columns.size());
+
+    // 与界面加载相同：源文件没变时读快照；不写快照，扫描不在运行目录里留下文件
+    Topology topology;
+    CounterStore stats;
+    const SourceStamp setupStamp = SnapshotCache::stampFile(run.setupPath);
+    const SourceStamp statStamp = SnapshotCache::stampFile(run.statPath);
+    const QString cachePath = SnapshotCache::cachePathFor(run.setupPath, run.statPath);
+    if (!SnapshotCache::load(cachePath, setupStamp, statStamp, topology, stats)) {
+        if (!SetupParser::parseFile(run.setupPath, topology, &run.error))
+            return;
+        if (!run.statPath.isEmpty() && !StatParser::parseFile(run.statPath, stats, &run.error))
+            return;
+    }
+    DerivedMetrics metrics;
+    metrics.reset(&stats);
+    for (int c = 0; c < columns.size(); ++c)
+        run.values[c] = columnValue(columns[c], topology, stats, metrics);
+    run.ok = true;
+}
+
+double SweepTable::columnValue(const SweepColumn& column, const Topology& topology,
+                               const CounterStore& stats, const DerivedMetrics& metrics) {
+    Mean mean;
+    switch (column.kind) {
+    case SweepColumn::Param:
+        return paramValue(column.name, topology);
+    case SweepColumn::Metric: {
+        const int metric = metrics.findMetric(column.name);
+        if (metric < 0)
+            return qQNaN();
+        for (int m = 0; m < stats.modules.size(); ++m)
+            mean.add(metrics.value(metric, m));
+        break;
+    }
+    case SweepColumn::Counter: {
+        const int counter = stats.findCounter(column.name.constData());
+        if (counter < 0)
+            return qQNaN();
+        for (int m = 0; m < stats.modules.size(); ++m) {
+            const int row = stats.findRow(m, counter);
+            if (row >= 0)
+                mean.add(stats.values[row]);
+        }
+        break;
+    }
+    }
+    return mean.value();
+}
@@ -0,0 +1,55 @@
+// sweeptable.h
+#ifndef SWEEPTABLE_H
+#define SWEEPTABLE_H
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+class Topology;
+class CounterStore;
+class DerivedMetrics;
+
+// 参数扫描表中的一列：取自 setup.txt 的配置参数，或 statistic.txt 的派生指标/计数器
+struct SweepColumn {
+    enum Kind { Param, Metric, Counter };
+    Kind kind;
+    QByteArray name;
+    QString label;
+};
+
+// 扫描中的一次运行；加载后只留下各列的值，拓扑与统计数据随即释放
+struct SweepRun {
+    QString setupPath;
+    QString statPath;            // 为空表示没有统计数据
+    QString name;                // 运行目录名
+    bool loaded = false;
+    bool ok = false;
+    QString error;
+    QVector<double> values;      // 对应 SweepTable::columns，没有为 NaN
+};
+
+// 参数扫描：成百上千个运行目录各取几列汇成一张表
+// Param 列的 name 为参数键，如 "way_count" 取第一个有该参数的模块；
+// "L3Cache.way_count" 只看名称以 "L3Cache" 开头的模块。
+// Metric 列为 DerivedMetrics 的指标名，Counter 列为不带下标的计数器名，
+// 都取所有有值的模块的平均（多个 CPU 的 IPC、各 L3 的命中率、各内存节点的使用率）。
+class SweepTable {
+public:
+    QVector<SweepColumn> columns;
+    QVector<SweepRun> runs;
+
+    // way_count、set_count、mshr_count、nuca_num 与 IPC、LLC 命中率、平均传输延迟、内存使用率
+    static QVector<SweepColumn> defaultColumns();
+
+    // root 及其下各级目录中的 setup.txt（统计数据取同目录的 statistic.txt），按路径排序
+    static QVector<SweepRun> discover(const QString& root);
+
+    // 读取一个运行（源文件没变时读快照）并取出各列；各运行互不相关，可以在多个线程上同时调用
+    static void loadRun(SweepRun& run, const QVector<SweepColumn>& columns);
+
+    // metrics 已 reset 到 stats
+    static double columnValue(const SweepColumn& column, const Topology& topology,
+                              const CounterStore& stats, const DerivedMetrics& metrics);
+};
+
+#endif // SWEEPTABLE_H
@@ -0,0 +1,417 @@
+// sweepview.cpp
+#include "sweepview.h"
+#include <QComboBox>
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QSortFilterProxyModel>
+#include <QSplitter>
+#include <QThread>
+#include <QTableView>
+#include <QToolTip>
+#include <QVBoxLayout>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtMath>
+
+namespace {
+
+const qreal kPointRadius = 4;
+const qreal kHitRadius = 8;       // 悬停与单击时离点多近算选中
+
+QString valueText(double v) {
+    return qIsNaN(v) ? QString("-") : QString::number(v, 'g', 6);
+}
+
+} // namespace
+
+// ============== SweepModel ==============
+SweepModel::SweepModel(QObject* parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+void SweepModel::reset(const QVector<SweepColumn>& columns, const QVector<SweepRun>& runs)
+{
+    beginResetModel();
+    m_table.columns = columns;
+    m_table.runs = runs;
+    m_loaded = 0;
+    endResetModel();
+}
+
+void SweepModel::setResult(int run, const SweepRun& result)
+{
+    if (run < 0 || run >= m_table.runs.size())
+        return;
+    if (!m_table.runs[run].loaded)
+        ++m_loaded;
+    m_table.runs[run] = result;
+    emit dataChanged(index(run, 0), index(run, columnCount() - 1));
+}
+
+int SweepModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : int(m_table.runs.size());
+}
+
+int SweepModel::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : int(m_table.columns.size()) + 1;
+}
+
+QVariant SweepModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid())
+        return QVariant();
+    const SweepRun& run = m_table.runs[index.row()];
+    const int column = index.column() - 1;
+    switch (role) {
+    case Qt::DisplayRole:
+        if (column < 0)
+            return run.name;
+        if (!run.loaded)
+            return QString("...");
+        return run.ok ? valueText(run.values[column]) : QString("-");
+    case SortRole:
+        if (column < 0)
+            return run.name;
+        // 没有值的行排在最后
+        return run.ok && !qIsNaN(run.values[column]) ? run.values[column] : qInf();
+    case Qt::ToolTipRole:
+        return run.ok || !run.loaded ? run.setupPath : run.error;
+    case Qt::ForegroundRole:
+        if (run.loaded && !run.ok)
+            return QColor(Qt::darkRed);
+        return QVariant();
+    case Qt::TextAlignmentRole:
+        return column < 0 ? QVariant() : QVariant(Qt::AlignRight | Qt::AlignVCenter);
+    default:
+        return QVariant();
+    }
+}
+
+QVariant SweepModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QVariant();
+    return section == 0 ? QString("运行") : m_table.columns.value(section - 1).label;
+}
+
+// ============== SweepPlot ==============
+SweepPlot::SweepPlot(QWidget* parent)
+    : QWidget(parent)
+{
+    setMouseTracking(true);
+    setMinimumSize(240, 180);
+}
+
+void SweepPlot::setTable(const SweepTable* table)
+{
+    m_table = table;
+    m_highlighted = -1;
+    update();
+}
+
+void SweepPlot::setAxes(int xColumn, int yColumn)
+{
+    m_x = xColumn;
+    m_y = yColumn;
+    update();
+}
+
+void SweepPlot::setHighlighted(int run)
+{
+    m_highlighted = run;
+    update();
+}
+
+QRectF SweepPlot::plotRect() const
+{
+    // 左边留出纵轴刻度，下边留出横轴刻度
+    return QRectF(70, 12, qMax(10, width() - 90), qMax(10, height() - 44));
+}
+
+// 已加载运行在两列上的取值范围；没有点时返回 false
+bool SweepPlot::ranges(QPointF& low, QPointF& high) const
+{
+    bool any = false;
+    if (!m_table || m_x < 0 || m_y < 0 || m_x >= m_table->columns.size()
+        || m_y >= m_table->columns.size())
+        return false;
+    for (const SweepRun& run : m_table->runs) {
+        if (!run.ok || qIsNaN(run.values[m_x]) || qIsNaN(run.values[m_y]))
+            continue;
+        const QPointF p(run.values[m_x], run.values[m_y]);
+        if (!any) {
+            low = high = p;
+            any = true;
+        }
+        low = QPointF(qMin(low.x(), p.x()), qMin(low.y(), p.y()));
+        high = QPointF(qMax(high.x(), p.x()), qMax(high.y(), p.y()));
+    }
+    if (!any)
+        return false;
+    // 只有一个取值时向两边各留一点，点画在中间
+    if (high.x() == low.x()) {
+        low.rx() -= 0.5;
+        high.rx() += 0.5;
+    }
+    if (high.y() == low.y()) {
+        low.ry() -= 0.5;
+        high.ry() += 0.5;
+    }
+    return true;
+}
+
+QPointF SweepPlot::mapPoint(const SweepRun& run, const QRectF& area, const QPointF& low,
+                            const QPointF& high) const
+{
+    return QPointF(area.left() + area.width() * (run.values[m_x] - low.x()) / (high.x() - low.x()),
+                   area.bottom() - area.height() * (run.values[m_y] - low.y()) / (high.y() - low.y()));
+}
+
+void SweepPlot::paintEvent(QPaintEvent*)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::white);
+    const QRectF area = plotRect();
+    painter.setPen(QPen(Qt::darkGray, 1));
+    painter.drawRect(area);
+    QPointF low, high;
+    if (!ranges(low, high)) {
+        painter.drawText(area, Qt::AlignCenter, "没有可显示的运行");
+        return;
+    }
+
+    // 两轴各标三个刻度：最小、中间、最大
+    const QFontMetrics metrics = painter.fontMetrics();
+    for (int i = 0; i <= 2; ++i) {
+        const qreal f = i / 2.0;
+        const double xv = low.x() + (high.x() - low.x()) * f;
+        const double yv = low.y() + (high.y() - low.y()) * f;
+        const qreal x = area.left() + area.width() * f;
+        const qreal y = area.bottom() - area.height() * f;
+        painter.setPen(QPen(QColor(230, 230, 230), 1));
+        painter.drawLine(QPointF(x, area.top()), QPointF(x, area.bottom()));
+        painter.drawLine(QPointF(area.left(), y), QPointF(area.right(), y));
+        painter.setPen(Qt::black);
+        const QString xs = valueText(xv);
+        const QString ys = valueText(yv);
+        painter.drawText(QPointF(x - metrics.horizontalAdvance(xs) / 2.0,
+                                 area.bottom() + metrics.ascent() + 4), xs);
+        painter.drawText(QPointF(area.left() - metrics.horizontalAdvance(ys) - 6,
+                                 y + metrics.ascent() / 2.0), ys);
+    }
+    painter.drawText(QPointF(area.right() - metrics.horizontalAdvance(m_table->columns[m_x].label),
+                             height() - 4), m_table->columns[m_x].label);
+    painter.drawText(QPointF(4, metrics.ascent()), m_table->columns[m_y].label);
+
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QPen(QColor(30, 80, 160), 1));
+    painter.setBrush(QColor(30, 144, 255, 160));
+    QPointF highlighted(-1, -1);
+    for (int r = 0; r < m_table->runs.size(); ++r) {
+        const SweepRun& run = m_table->runs[r];
+        if (!run.ok || qIsNaN(run.values[m_x]) || qIsNaN(run.values[m_y]))
+            continue;
+        const QPointF p = mapPoint(run, area, low, high);
+        if (r == m_highlighted)
+            highlighted = p;
+        else
+            painter.drawEllipse(p, kPointRadius, kPointRadius);
+    }
+    if (highlighted.x() >= 0) {
+        painter.setPen(QPen(Qt::black, 2));
+        painter.setBrush(QColor(220, 20, 60));
+        painter.drawEllipse(highlighted, kPointRadius + 2, kPointRadius + 2);
+    }
+}
+
+int SweepPlot::runAt(const QPointF& pos) const
+{
+    QPointF low, high;
+    if (!ranges(low, high))
+        return -1;
+    const QRectF area = plotRect();
+    int best = -1;
+    qreal bestDistance = kHitRadius * kHitRadius;
+    for (int r = 0; r < m_table->runs.size(); ++r) {
+        const SweepRun& run = m_table->runs[r];
+        if (!run.ok || qIsNaN(run.values[m_x]) || qIsNaN(run.values[m_y]))
+            continue;
+        const QPointF d = mapPoint(run, area, low, high) - pos;
+        const qreal dx = d.x();
+        const qreal dy = d.y();
+        if (dx * dx + dy * dy < bestDistance) {
+            bestDistance = dx * dx + dy * dy;
+            best = r;
+        }
+    }
+    return best;
+}
+
+void SweepPlot::mouseMoveEvent(QMouseEvent* event)
+{
+    const int r = runAt(event->position());
+    if (r < 0) {
+        QToolTip::hideText();
+        return;
+    }
+    const SweepRun& run = m_table->runs[r];
+    QToolTip::showText(event->globalPosition().toPoint(),
+                       QString("%1\n%2: %3\n%4: %5").arg(run.name)
+                           .arg(m_table->columns[m_x].label, valueText(run.values[m_x]))
+                           .arg(m_table->columns[m_y].label, valueText(run.values[m_y])),
+                       this);
+}
+
+void SweepPlot::mousePressEvent(QMouseEvent* event)
+{
+    const int r = runAt(event->position());
+    if (r >= 0)
+        emit runClicked(r);
+}
+
+// ============== SweepDock ==============
+SweepDock::SweepDock(QWidget* parent)
+    : QDockWidget("参数扫描", parent)
+{
+    setObjectName("sweepDock");
+    QWidget* body = new QWidget(this);
+    QVBoxLayout* layout = new QVBoxLayout(body);
+    layout->setContentsMargins(4, 4, 4, 4);
+    QHBoxLayout* bar = new QHBoxLayout();
+    m_status = new QLabel(body);
+    m_xBox = new QComboBox(body);
+    m_yBox = new QComboBox(body);
+    bar->addWidget(m_status, 1);
+    bar->addWidget(new QLabel("横轴", body));
+    bar->addWidget(m_xBox);
+    bar->addWidget(new QLabel("纵轴", body));
+    bar->addWidget(m_yBox);
+    layout->addLayout(bar);
+
+    m_model = new SweepModel(this);
+    m_proxy = new QSortFilterProxyModel(this);
+    m_proxy->setSourceModel(m_model);
+    m_proxy->setSortRole(SweepModel::SortRole);
+    m_plot = new SweepPlot(body);
+    m_plot->setTable(&m_model->table());
+    m_table = new QTableView(body);
+    m_table->setModel(m_proxy);
+    m_table->setSortingEnabled(true);
+    m_table->setWordWrap(false);
+    m_table->setAlternatingRowColors(true);
+    m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_table->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->verticalHeader()->hide();
+    m_table->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    m_table->verticalHeader()->setDefaultSectionSize(m_table->fontMetrics().height() + 6);
+    QSplitter* splitter = new QSplitter(Qt::Vertical, body);
+    splitter->addWidget(m_plot);
+    splitter->addWidget(m_table);
+    layout->addWidget(splitter, 1);
+    setWidget(body);
+
+    m_pool.setMaxThreadCount(QThread::idealThreadCount());
+    m_watcher = new QFutureWatcher<SweepRun>(this);
+    connect(m_watcher, &QFutureWatcherBase::resultReadyAt, this, &SweepDock::runLoaded);
+    connect(m_watcher, &QFutureWatcherBase::finished, this, &SweepDock::updateStatus);
+    connect(m_xBox, &QComboBox::currentIndexChanged, this, &SweepDock::updateAxes);
+    connect(m_yBox, &QComboBox::currentIndexChanged, this, &SweepDock::updateAxes);
+    connect(m_plot, &SweepPlot::runClicked, this, &SweepDock::selectRun);
+    connect(m_table->selectionModel(), &QItemSelectionModel::currentRowChanged, this,
+            [this](const QModelIndex& current) {
+                m_plot->setHighlighted(current.isValid() ? m_proxy->mapToSource(current).row() : -1);
+            });
+    connect(m_table, &QTableView::doubleClicked, this, [this](const QModelIndex& index) {
+        emit openRun(m_model->table().runs[m_proxy->mapToSource(index).row()].setupPath);
+    });
+    updateStatus();
+}
+
+SweepDock::~SweepDock()
+{
+    // 还没开始的运行不再加载；m_pool 析构时等正在加载的几个结束
+    m_watcher->cancel();
+}
+
+void SweepDock::loadDirectory(const QString& root)
+{
+    // 上一次扫描中正在加载的几个运行自行结束，换了 future 之后它们的结果不再送来
+    m_watcher->cancel();
+    m_root = root;
+    const QVector<SweepColumn> columns = SweepTable::defaultColumns();
+    const QVector<SweepRun> runs = SweepTable::discover(root);
+    m_model->reset(columns, runs);
+    m_plot->setTable(&m_model->table());
+
+    // 默认横轴为第一个配置参数，纵轴为第一个指标
+    const QSignalBlocker xBlocker(m_xBox);
+    const QSignalBlocker yBlocker(m_yBox);
+    m_xBox->clear();
+    m_yBox->clear();
+    int x = -1, y = -1;
+    for (int c = 0; c < columns.size(); ++c) {
+        m_xBox->addItem(columns[c].label);
+        m_yBox->addItem(columns[c].label);
+        if (x < 0 && columns[c].kind == SweepColumn::Param)
+            x = c;
+        if (y < 0 && columns[c].kind != SweepColumn::Param)
+            y = c;
+    }
+    m_xBox->setCurrentIndex(qMax(0, x));
+    m_yBox->setCurrentIndex(qMax(0, y));
+    updateAxes();
+
+    // 每个运行一个任务，空闲的线程依次领取下一个，大小不一的运行也能把各线程排满；
+    // 结果按完成的先后到达，不等前面的运行
+    m_watcher->setFuture(QtConcurrent::mapped(&m_pool, runs, [columns](const SweepRun& run) {
+        SweepRun result = run;
+        SweepTable::loadRun(result, columns);
+        return result;
+    }));
+    updateStatus();
+}
+
+void SweepDock::runLoaded(int run)
+{
+    m_model->setResult(run, m_watcher->resultAt(run));
+    m_plot->update();
+    updateStatus();
+}
+
+void SweepDock::updateStatus()
+{
+    const SweepTable& table = m_model->table();
+    if (m_root.isEmpty()) {
+        m_status->setText("文件 > 参数扫描... 选择包含多个运行目录的文件夹");
+        return;
+    }
+    int failed = 0;
+    for (const SweepRun& run : table.runs) {
+        if (run.loaded && !run.ok)
+            ++failed;
+    }
+    QString text = QString("%1：已加载 %2 / %3").arg(QFileInfo(m_root).fileName())
+                       .arg(m_model->loadedCount()).arg(table.runs.size());
+    if (failed > 0)
+        text += QString("，%1 个失败").arg(failed);
+    m_status->setText(text);
+}
+
+void SweepDock::updateAxes()
+{
+    m_plot->setAxes(m_xBox->currentIndex(), m_yBox->currentIndex());
+}
+
+void SweepDock::selectRun(int run)
+{
+    const QModelIndex index = m_proxy->mapFromSource(m_model->index(run, 0));
+    m_table->selectRow(index.row());
+    m_table->scrollTo(index);
+}
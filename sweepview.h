@@ -0,0 +1,106 @@
+// sweepview.h
+#ifndef SWEEPVIEW_H
+#define SWEEPVIEW_H
+#include <QAbstractTableModel>
+#include <QDockWidget>
+#include <QFutureWatcher>
+#include <QThreadPool>
+#include <QWidget>
+#include "sweeptable.h"
+
+class QComboBox;
+class QLabel;
+class QSortFilterProxyModel;
+class QTableView;
+
+// 参数扫描表：每个运行一行，第一列为运行名，其后为 SweepTable::columns
+// 运行加载完一个填一行；SortRole 为数值本身，排序时按数值而不是文字比较
+class SweepModel : public QAbstractTableModel {
+    Q_OBJECT
+public:
+    static const int SortRole = Qt::UserRole;
+
+    explicit SweepModel(QObject* parent = nullptr);
+
+    void reset(const QVector<SweepColumn>& columns, const QVector<SweepRun>& runs);
+    void setResult(int run, const SweepRun& result);
+    const SweepTable& table() const { return m_table; }
+    int loadedCount() const { return m_loaded; }
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+private:
+    SweepTable m_table;
+    int m_loaded = 0;
+};
+
+// 参数-指标散点图：横轴、纵轴各取表中一列，每个已加载的运行一个点
+// 悬停显示运行名与数值，单击选中运行
+class SweepPlot : public QWidget {
+    Q_OBJECT
+public:
+    explicit SweepPlot(QWidget* parent = nullptr);
+
+    // table 由调用方持有；内容变化后调用 update()
+    void setTable(const SweepTable* table);
+    void setAxes(int xColumn, int yColumn);
+    void setHighlighted(int run);
+
+signals:
+    void runClicked(int run);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+
+private:
+    QRectF plotRect() const;
+    bool ranges(QPointF& low, QPointF& high) const;
+    QPointF mapPoint(const SweepRun& run, const QRectF& area, const QPointF& low,
+                     const QPointF& high) const;
+    int runAt(const QPointF& pos) const;
+
+    const SweepTable* m_table = nullptr;
+    int m_x = 0;
+    int m_y = 0;
+    int m_highlighted = -1;
+};
+
+// 停靠窗：选一个目录，其下所有运行在线程池上并行加载，结果陆续填进表格和散点图
+// 每个任务读完一个运行只留下表中几列的值，同时驻留的完整统计数据不超过线程数份
+class SweepDock : public QDockWidget {
+    Q_OBJECT
+public:
+    explicit SweepDock(QWidget* parent = nullptr);
+    ~SweepDock();
+
+    void loadDirectory(const QString& root);
+
+signals:
+    // 双击表格中的运行
+    void openRun(const QString& setupPath);
+
+private:
+    void runLoaded(int run);
+    void updateStatus();
+    void updateAxes();
+    void selectRun(int run);
+
+    SweepModel* m_model;
+    QSortFilterProxyModel* m_proxy;
+    SweepPlot* m_plot;
+    QTableView* m_table;
+    QComboBox* m_xBox;
+    QComboBox* m_yBox;
+    QLabel* m_status;
+    QString m_root;
+    QThreadPool m_pool;           // 与界面加载所用的全局线程池分开，扫描期间不拖慢打开运行
+    QFutureWatcher<SweepRun>* m_watcher;
+};
+
+#endif // SWEEPVIEW_H
@@ -0,0 +1,289 @@
+// syntheticrun.cpp
+#include "syntheticrun.h"
+#include <QByteArray>
+#include <QFile>
+#include <QRandomGenerator>
+
+namespace {
+
+const qsizetype kChunkBytes = qsizetype(4) << 20;   // 攒够 4 MB 写一次
+
+// 带缓冲的文本输出，出错之后的写入都忽略，close 时报告
+class TextWriter {
+public:
+    bool open(const QString& path, QString* errorMessage) {
+        file.setFileName(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            if (errorMessage)
+                *errorMessage = QString("无法写入 %1：%2").arg(path, file.errorString());
+            return false;
+        }
+        buffer.reserve(kChunkBytes + 4096);
+        return true;
+    }
+    TextWriter& operator<<(const char* s) {
+        buffer.append(s);
+        return *this;
+    }
+    TextWriter& operator<<(const QByteArray& s) {
+        buffer.append(s);
+        return *this;
+    }
+    TextWriter& operator<<(qint64 v) {
+        buffer.append(QByteArray::number(v));
+        return *this;
+    }
+    TextWriter& operator<<(double v) {
+        buffer.append(QByteArray::number(v, 'f', 6));
+        return *this;
+    }
+    // 一行写完之后调用
+    void endLine() {
+        buffer.append('\n');
+        if (buffer.size() >= kChunkBytes)
+            flush();
+    }
+    bool close(QString* errorMessage) {
+        flush();
+        file.close();
+        if (!good && errorMessage)
+            *errorMessage = QString("写入 %1 失败").arg(file.fileName());
+        return good;
+    }
+
+private:
+    void flush() {
+        if (good && file.write(buffer) != buffer.size())
+            good = false;
+        buffer.clear();
+    }
+
+    QFile file;
+    QByteArray buffer;
+    bool good = true;
+};
+
+int l2Port(const SyntheticSpec& spec, int core) {
+    return core / spec.coresPerNode * (spec.coresPerNode + 1) + core % spec.coresPerNode;
+}
+
+int l3Port(const SyntheticSpec& spec, int node) {
+    return node * (spec.coresPerNode + 1) + spec.coresPerNode;
+}
+
+int memoryPort(const SyntheticSpec& spec, int memory) {
+    return spec.nodeCount() * (spec.coresPerNode + 1) + memory;
+}
+
+// 内存节点均匀分布在网格上
+int memoryNode(const SyntheticSpec& spec, int memory) {
+    return int(qint64(2 * memory + 1) * spec.nodeCount() / (2 * spec.memoryNodes));
+}
+
+int nodeOfPort(const SyntheticSpec& spec, int port) {
+    const int local = port - spec.nodeCount() * (spec.coresPerNode + 1);
+    return local >= 0 ? memoryNode(spec, local) : port / (spec.coresPerNode + 1);
+}
+
+bool writeSetup(const SyntheticSpec& spec, const QString& path, QString* errorMessage) {
+    TextWriter w;
+    if (!w.open(path, errorMessage))
+        return false;
+    const int ports = spec.portCount();
+    w << "Bus @1tick";
+    w.endLine();
+    w << "node_number: " << qint64(ports);
+    w.endLine();
+    for (int port = ports - 1; port >= 0; --port) {
+        w << "node_id_of_port_" << qint64(port) << ": " << qint64(nodeOfPort(spec, port));
+        w.endLine();
+    }
+    for (int r = 0; r < spec.rows; ++r) {
+        for (int c = 0; c < spec.cols; ++c) {
+            const int node = r * spec.cols + c;
+            QVector<int> neighbours;
+            if (r > 0)
+                neighbours.append(node - spec.cols);
+            if (c > 0)
+                neighbours.append(node - 1);
+            if (c + 1 < spec.cols)
+                neighbours.append(node + 1);
+            if (r + 1 < spec.rows)
+                neighbours.append(node + spec.cols);
+            for (const int to : neighbours) {
+                w << "edge: " << qint64(node) << " to " << qint64(to);
+                w.endLine();
+            }
+        }
+    }
+    w.endLine();
+    w << "cache_event_trace @1tick";
+    w.endLine();
+    w.endLine();
+
+    for (int m = 0; m < spec.memoryNodes; ++m) {
+        w << "MemoryNode" << qint64(m) << " @1tick";
+        w.endLine();
+        w << "port_id: " << qint64(memoryPort(spec, m));
+        w.endLine();
+        w << "data_width: 32";
+        w.endLine();
+        w.endLine();
+    }
+    const int nodes = spec.nodeCount();
+    for (int n = 0; n < nodes; ++n) {
+        w << "L3Cache" << qint64(n) << " @1tick";
+        w.endLine();
+        w << "port_id: " << qint64(l3Port(spec, n));
+        w.endLine();
+        for (const char* line : {"way_count: 8", "set_count: 512", "mshr_count: 8", "index_width: 1",
+                                 "index_latency: 10"}) {
+            w << line;
+            w.endLine();
+        }
+        w << "nuca_index: " << qint64(n);
+        w.endLine();
+        w << "nuca_num: " << qint64(nodes);
+        w.endLine();
+        w.endLine();
+    }
+    const int cores = spec.coreCount();
+    for (int c = 0; c < cores; ++c) {
+        w << "L2Cache" << qint64(c) << " @1tick";
+        w.endLine();
+        w << "port_id: " << qint64(l2Port(spec, c));
+        w.endLine();
+        for (const char* line : {"l1i_way_count: 8", "l1i_set_count: 16", "l1d_way_count: 8",
+                                 "l1d_set_count: 32", "l2_way_count: 8", "l2_set_count: 128",
+                                 "l2_mshr_count: 8", "l2_index_width: 1", "l2_index_latency: 4"}) {
+            w << line;
+            w.endLine();
+        }
+        w.endLine();
+    }
+    for (int c = 0; c < cores; ++c) {
+        w << "CPU" << qint64(c) << " @1tick";
+        w.endLine();
+        w.endLine();
+    }
+    return w.close(errorMessage);
+}
+
+bool writeStatistic(const SyntheticSpec& spec, const QString& path, QString* errorMessage) {
+    TextWriter w;
+    if (!w.open(path, errorMessage))
+        return false;
+    QRandomGenerator random(spec.seed);
+    auto counter = [&](const char* name, qint64 value) {
+        w << name << ": " << value;
+        w.endLine();
+    };
+    auto rate = [&](const QByteArray& name, double value) {
+        w << name << ": " << value;
+        w.endLine();
+    };
+
+    const int nodes = spec.nodeCount();
+    const int ports = spec.portCount();
+    w << "Bus Latency:1";
+    w.endLine();
+    counter("transmit_package_number", qint64(ports) * ports * 500);
+    counter("avg_transmit_latency", 2 + spec.rows / 2 + spec.cols / 2);
+    for (int n = 0; n < nodes; ++n) {
+        const QByteArray prefix = "node_" + QByteArray::number(n) + "_";
+        counter((prefix + "transmit_package_number").constData(), random.bounded(1000, 100000));
+        rate(prefix + "busy_rate", random.generateDouble() * 0.05);
+    }
+    for (int r = 0; r < spec.rows; ++r) {
+        for (int c = 0; c < spec.cols; ++c) {
+            const int node = r * spec.cols + c;
+            for (const int to : {node - spec.cols, node - 1, node + 1, node + spec.cols}) {
+                const bool neighbour = (to == node - spec.cols && r > 0) || (to == node - 1 && c > 0)
+                                       || (to == node + 1 && c + 1 < spec.cols)
+                                       || (to == node + spec.cols && r + 1 < spec.rows);
+                if (!neighbour)
+                    continue;
+                // 少数几条边明显更忙，画面上有热点可看
+                const double usage = random.bounded(50) == 0 ? 0.05 + random.generateDouble() * 0.2
+                                                             : random.generateDouble() * 0.05;
+                rate("edge_" + QByteArray::number(node) + "_to_" + QByteArray::number(to) + "_busy_rate",
+                     usage);
+            }
+        }
+    }
+    // 流量矩阵，行数为端口数的平方量级，逐行写出
+    for (int from = 0; from < ports; ++from) {
+        const QByteArray prefix = "transmit_package_number_from_" + QByteArray::number(from) + "_to_";
+        for (int to = 0; to < ports; ++to) {
+            if (to == from || (spec.fill < 1 && random.generateDouble() >= spec.fill))
+                continue;
+            w << prefix << qint64(to) << ": " << qint64(random.bounded(1, 1000));
+            w.endLine();
+        }
+    }
+    w.endLine();
+
+    w << "cache_event_trace Latency:1";
+    w.endLine();
+    w.endLine();
+
+    for (int m = 0; m < spec.memoryNodes; ++m) {
+        w << "MemoryNode" << qint64(m) << " Latency:1";
+        w.endLine();
+        counter("message_precossed", random.bounded(1000, 100000));
+        rate("busy_rate", random.generateDouble() * 0.1);
+        w.endLine();
+    }
+    for (int n = 0; n < nodes; ++n) {
+        w << "L3Cache" << qint64(n) << " Latency:1";
+        w.endLine();
+        counter("llc_hit_count", random.bounded(100, 10000));
+        counter("llc_miss_count", random.bounded(100, 10000));
+        w.endLine();
+    }
+    const int cores = spec.coreCount();
+    for (int c = 0; c < cores; ++c) {
+        w << "L2Cache" << qint64(c) << " Latency:1";
+        w.endLine();
+        counter("l1i_hit_count", random.bounded(10000, 100000));
+        counter("l1i_miss_count", random.bounded(100, 1000));
+        counter("l1d_hit_count", random.bounded(1000, 10000));
+        counter("l1d_miss_count", random.bounded(100, 1000));
+        counter("l2_hit_count", random.bounded(10, 500));
+        counter("l2_miss_count", random.bounded(100, 1000));
+        w.endLine();
+    }
+    for (int c = 0; c < cores; ++c) {
+        w << "CPU" << qint64(c) << " Latency:1";
+        w.endLine();
+        const qint64 loads = random.bounded(1000, 10000);
+        const qint64 stores = random.bounded(1000, 10000);
+        const qint64 loadMisses = random.bounded(10, 500);
+        const qint64 storeMisses = random.bounded(10, 500);
+        counter("total_tick_processed", random.bounded(20000, 100000));
+        counter("finished_inst_count", random.bounded(10000, 40000));
+        counter("ld_cache_miss_count", loadMisses);
+        counter("ld_cache_hit_count", loads - loadMisses);
+        counter("ld_inst_cnt", loads);
+        counter("ld_mem_tick_sum", loads * random.bounded(2, 4));
+        counter("st_cache_miss_count", storeMisses);
+        counter("st_cache_hit_count", stores - storeMisses);
+        counter("st_inst_cnt", stores);
+        counter("st_mem_tick_sum", stores * random.bounded(2, 4));
+        w.endLine();
+    }
+    return w.close(errorMessage);
+}
+
+} // namespace
+
+bool SyntheticRun::write(const SyntheticSpec& spec, const QString& setupPath, const QString& statPath,
+                         QString* errorMessage) {
+    if (spec.rows < 1 || spec.cols < 1 || spec.coresPerNode < 1 || spec.memoryNodes < 1
+        || spec.memoryNodes > spec.nodeCount()) {
+        if (errorMessage)
+            *errorMessage = QString("合成运行的规模无效");
+        return false;
+    }
+    return writeSetup(spec, setupPath, errorMessage) && writeStatistic(spec, statPath, errorMessage);
+}
@@ -0,0 +1,31 @@
+// syntheticrun.h
+#ifndef SYNTHETICRUN_H
+#define SYNTHETICRUN_H
+#include <QString>
+
+// 合成运行的规模
+// rows×cols 的路由器网格，相邻节点之间双向各一条边；每个节点挂 coresPerNode 个核心（CPUn + L2Cachen，
+// L2 占一个端口）和一个 L3 分片，另有 memoryNodes 个内存节点均匀分布在网格上。
+// fill 为有流量的端口对比例，1 为完整的流量矩阵（端口数的平方行，规模大时 statistic.txt 以 GB 计）
+struct SyntheticSpec {
+    int rows = 8;
+    int cols = 8;
+    int coresPerNode = 1;
+    int memoryNodes = 4;
+    double fill = 1.0;
+    quint32 seed = 1;
+
+    int nodeCount() const { return rows * cols; }
+    int coreCount() const { return nodeCount() * coresPerNode; }
+    int portCount() const { return nodeCount() * (coresPerNode + 1) + memoryNodes; }
+};
+
+// 按 SyntheticSpec 写一对格式与模拟器输出一致的 setup.txt / statistic.txt，用于性能基准
+// 数值由 seed 决定，同样的参数总是生成同样的文件；statistic.txt 边生成边写出，内存占用与规模无关
+class SyntheticRun {
+public:
+    static bool write(const SyntheticSpec& spec, const QString& setupPath, const QString& statPath,
+                      QString* errorMessage = nullptr);
+};
+
+#endif // SYNTHETICRUN_H
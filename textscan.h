@@ -0,0 +1,91 @@
+// textscan.h
+#ifndef TEXTSCAN_H
+#define TEXTSCAN_H
+#include <QtGlobal>
+#include <charconv>
+#include <cstring>
+
+// setup.txt / statistic.txt 共用的扫描工具
+// 全部直接工作在只读缓冲区（通常是 QFile::map 的映射区）上，逐行切分时不做任何分配
+namespace TextScan {
+
+// 缓冲区中的一段 [begin, end)，不拥有数据
+struct Span {
+    const char* begin = nullptr;
+    const char* end = nullptr;
+
+    qsizetype size() const { return end - begin; }
+    bool isEmpty() const { return begin == end; }
+    bool startsWith(const char* s, qsizetype n) const {
+        return size() >= n && memcmp(begin, s, size_t(n)) == 0;
+    }
+    bool equals(const char* s, qsizetype n) const {
+        return size() == n && memcmp(begin, s, size_t(n)) == 0;
+    }
+};
+
+inline bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+inline Span trimmed(Span s) {
+    while (s.begin < s.end && isSpace(*s.begin)) ++s.begin;
+    while (s.end > s.begin && isSpace(s.end[-1])) --s.end;
+    return s;
+}
+
+// 取出 p 开始的一行（不含换行符），p 前进到下一行开头
+inline Span nextLine(const char*& p, const char* end) {
+    const char* nl = static_cast<const char*>(memchr(p, '\n', size_t(end - p)));
+    Span line{p, nl ? nl : end};
+    p = nl ? nl + 1 : end;
+    return line;
+}
+
+// 去掉行尾 "//" 注释以及首尾空白
+inline Span stripComment(Span s) {
+    const char* c = s.begin;
+    while (c < s.end) {
+        c = static_cast<const char*>(memchr(c, '/', size_t(s.end - c)));
+        if (!c || c + 1 >= s.end) break;
+        if (c[1] == '/') {
+            s.end = c;
+            break;
+        }
+        ++c;
+    }
+    return trimmed(s);
+}
+
+// 在 s 中查找字符，找不到返回 nullptr
+inline const char* find(Span s, char ch) {
+    return static_cast<const char*>(memchr(s.begin, ch, size_t(s.size())));
+}
+
+// 解析整数，要求整段都是数字（允许前导负号）
+inline bool toInt(Span s, qint64& out) {
+    s = trimmed(s);
+    if (s.isEmpty()) return false;
+    auto r = std::from_chars(s.begin, s.end, out);
+    return r.ec == std::errc() && r.ptr == s.end;
+}
+
+inline bool toDouble(Span s, double& out) {
+    s = trimmed(s);
+    if (s.isEmpty()) return false;
+    auto r = std::from_chars(s.begin, s.end, out);
+    return r.ec == std::errc() && r.ptr == s.end;
+}
+
+// 名称尾部的数字，如 "L2Cache12" -> 12；没有数字返回 -1
+inline qint32 trailingIndex(Span s) {
+    const char* p = s.end;
+    while (p > s.begin && isDigit(p[-1])) --p;
+    if (p == s.end) return -1;
+    qint64 v = 0;
+    std::from_chars(p, s.end, v);
+    return qint32(v);
+}
+
+} // namespace TextScan
+
+#endif // TEXTSCAN_H
@@ -0,0 +1,451 @@
+// tilecache.cpp
+#include "tilecache.h"
+#include "edgelayer.h"
+#include "moduleitem.h"
+#include <QFontMetricsF>
+#include <QGraphicsRectItem>
+#include <QGraphicsTextItem>
+#include <QMutex>
+#include <QPainter>
+#include <QTextDocument>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <QtMath>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace {
+
+const qreal kCellSize = 512;          // 网格单元边长（场景坐标）
+const int kZoomSteps = 65536;         // 每个倍频程的级数
+const int kZoomOffset = 1 << 21;      // 级别在键中占 22 位
+const int kTileOffset = 1 << 19;      // 块坐标在键中各占 20 位
+const qreal kPadPixels = 2;           // 画块时多取的设备像素，抗锯齿与 0 宽画笔不会在块边上被截断
+const quint64 kLevelMask = ~quint64(0) << 40;   // 键中的级别与细节层级
+const int kFallbackOctaves = 2;       // 代替用的一级最多比当前细几个倍频程，再细时一块要贴的块太多
+
+qint32 cellOf(qreal v) {
+    return qint32(qFloor(v / kCellSize));
+}
+
+quint64 cellKey(qint32 x, qint32 y) {
+    return (quint64(quint32(x)) << 32) | quint32(y);
+}
+
+quint8 levelBit(DetailLevel level) {
+    return quint8(1 << int(level));
+}
+
+quint64 tileKey(int zoom, DetailLevel level, int tx, int ty) {
+    return (quint64(zoom + kZoomOffset) << 42) | (quint64(level) << 40)
+           | (quint64(ty + kTileOffset) << 20) | quint64(tx + kTileOffset);
+}
+
+qreal zoomScale(int zoom) {
+    return std::exp2(zoom / qreal(kZoomSteps));
+}
+
+struct TileJob {
+    quint64 key;
+    int tx;
+    int ty;
+    int generation;
+    QImage image;     // 开始画之前已不再需要时为空
+};
+
+void renderTile(const StaticLayer& source, TileJob& job, qreal scale, qreal dpr, DetailLevel level) {
+    job.image = QImage(TileCache::kTileSize, TileCache::kTileSize, QImage::Format_ARGB32_Premultiplied);
+    job.image.fill(Qt::transparent);
+    QPainter painter(&job.image);
+    // 与 SceneWidget::updateDetailLevel 一致：概览时不抗锯齿
+    painter.setRenderHint(QPainter::Antialiasing, level != DetailLevel::Overview);
+    painter.translate(-job.tx * TileCache::kTileSize, -job.ty * TileCache::kTileSize);
+    painter.scale(scale, scale);
+    source.render(&painter,
+                  QRectF(QPointF(job.tx, job.ty) * TileCache::kTileSize / scale,
+                         QSizeF(TileCache::kTileSize, TileCache::kTileSize) / scale),
+                  level);
+    painter.end();
+    job.image.setDevicePixelRatio(dpr);
+}
+
+} // namespace
+
+// ============== StaticLayer ==============
+StaticLayer StaticLayer::capture(const BuiltScene& built) {
+    StaticLayer layer;
+    const quint8 blocks = levelBit(DetailLevel::Blocks) | levelBit(DetailLevel::Full);
+    const quint8 all = blocks | levelBit(DetailLevel::Overview);
+    // 三个图层依次创建，同为 z = 0，按这个次序叠放
+    const QPair<const QGraphicsItem*, quint8> groups[] = {
+        {built.chainLayer, blocks},
+        {built.tileLayer, levelBit(DetailLevel::Overview)},
+        {built.staticLayer, all}
+    };
+    for (const auto& group : groups) {
+        if (!group.first)
+            continue;
+        // childItems() 已按叠放次序排好
+        for (const QGraphicsItem* item : group.first->childItems())
+            layer.addItem(item, group.second);
+    }
+    return layer;
+}
+
+void StaticLayer::addItem(const QGraphicsItem* item, quint8 levels) {
+    if (!item->isVisibleTo(item->parentItem()))
+        return;
+    const quint8 full = levels & levelBit(DetailLevel::Full);
+    if (const ModuleItem* module = qgraphicsitem_cast<const ModuleItem*>(item)) {
+        // 与 ModuleItem::paint 相同：主体、端口与模块名，后两者只在 Full 层级画
+        add(Rect, module->mapRectToScene(module->rect()), {module->pen(), module->brush(), QFont()}, levels);
+        if (!full)
+            return;
+        const Style port = {module->pen(), QBrush(Qt::yellow), QFont()};
+        const qreal r = ModuleItem::kPortRadius;
+        for (int i = 0; i < module->getPortsCount(); ++i)
+            add(Ellipse, QRectF(module->getPortPos(i) - QPointF(r, r), QSizeF(2 * r, 2 * r)), port, full);
+        const QFont font;
+        const QSizeF size = QFontMetricsF(font).size(0, module->name());
+        add(Text, QRectF(module->mapToScene(ModuleItem::kLabelPos), size), {QPen(Qt::black), Qt::NoBrush, font},
+            full, module->name());
+    } else if (const EdgeLayer* edges = dynamic_cast<const EdgeLayer*>(item)) {
+        // 链内连线没有标签，只抄线段
+        const QTransform transform = edges->sceneTransform();
+        for (int e = 0; e < edges->edgeCount(); ++e) {
+            const QLineF line = transform.map(edges->line(e));
+            add(Line, QRectF(line.p1(), line.p2()), {edges->stylePen(edges->style(e)), Qt::NoBrush, QFont()},
+                levels);
+        }
+    } else if (const QGraphicsRectItem* rect = qgraphicsitem_cast<const QGraphicsRectItem*>(item)) {
+        add(Rect, rect->mapRectToScene(rect->rect()), {rect->pen(), rect->brush(), QFont()}, levels);
+    } else if (const QGraphicsTextItem* text = qgraphicsitem_cast<const QGraphicsTextItem*>(item)) {
+        // 图例与标题都是单行纯文本，按文档边距内的左上角对齐画出
+        const qreal margin = text->document()->documentMargin();
+        const QRectF area = text->boundingRect().adjusted(margin, margin, -margin, -margin);
+        add(Text, text->mapRectToScene(area), {QPen(text->defaultTextColor()), Qt::NoBrush, text->font()},
+            levels, text->toPlainText());
+    }
+}
+
+int StaticLayer::addStyle(const Style& style) {
+    // 同类图形连续出现，先看最后一种
+    if (!styles.isEmpty() && styles.last() == style)
+        return int(styles.size()) - 1;
+    for (int i = 0; i < styles.size(); ++i) {
+        if (styles[i] == style)
+            return i;
+    }
+    styles.append(style);
+    return int(styles.size()) - 1;
+}
+
+void StaticLayer::add(Kind kind, const QRectF& rect, const Style& style, quint8 levels, const QString& text) {
+    Shape shape;
+    shape.rect = rect;
+    shape.style = addStyle(style);
+    shape.text = -1;
+    shape.kind = kind;
+    shape.levels = levels;
+    const qreal half = style.pen.style() == Qt::NoPen || kind == Text ? 0 : style.pen.widthF() / 2;
+    shape.bounds = (kind == Line ? QRectF(rect.topLeft(), rect.bottomRight()).normalized() : rect)
+                       .adjusted(-half, -half, half, half);
+    if (kind == Text) {
+        shape.text = int(texts.size());
+        texts.append(text);
+    }
+    const int index = int(shapes.size());
+    shapes.append(shape);
+    extent = index == 0 ? shape.bounds : extent.united(shape.bounds);
+
+    const qint32 x0 = cellOf(shape.bounds.left()), x1 = cellOf(shape.bounds.right());
+    const qint32 y0 = cellOf(shape.bounds.top()), y1 = cellOf(shape.bounds.bottom());
+    for (qint32 y = y0; y <= y1; ++y) {
+        for (qint32 x = x0; x <= x1; ++x)
+            grid[cellKey(x, y)].append(index);
+    }
+}
+
+void StaticLayer::render(QPainter* painter, const QRectF& sceneRect, DetailLevel level) const {
+    const qreal pad = kPadPixels / painter->worldTransform().m11();
+    const QRectF area = sceneRect.adjusted(-pad, -pad, pad, pad);
+    const qint32 x0 = cellOf(area.left()), x1 = cellOf(area.right());
+    const qint32 y0 = cellOf(area.top()), y1 = cellOf(area.bottom());
+    QVector<int> found;
+    for (qint32 y = y0; y <= y1; ++y) {
+        for (qint32 x = x0; x <= x1; ++x) {
+            auto it = grid.constFind(cellKey(x, y));
+            if (it != grid.constEnd())
+                found += it.value();
+        }
+    }
+    // 跨单元的图形会被找到多次；按下标排序即恢复叠放次序
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+
+    const quint8 bit = levelBit(level);
+    int current = -1;
+    for (const int i : found) {
+        const Shape& shape = shapes[i];
+        if (!(shape.levels & bit) || !shape.bounds.intersects(area))
+            continue;
+        if (shape.style != current) {
+            const Style& style = styles[shape.style];
+            painter->setPen(style.pen);
+            painter->setBrush(style.brush);
+            painter->setFont(style.font);
+            current = shape.style;
+        }
+        switch (Kind(shape.kind)) {
+        case Rect:
+            painter->drawRect(shape.rect);
+            break;
+        case Ellipse:
+            painter->drawEllipse(shape.rect);
+            break;
+        case Line:
+            painter->drawLine(shape.rect.topLeft(), shape.rect.bottomRight());
+            break;
+        case Text:
+            painter->drawText(shape.rect, Qt::AlignLeft | Qt::AlignTop | Qt::TextDontClip, texts[shape.text]);
+            break;
+        }
+    }
+}
+
+bool StaticLayer::changedRect(const StaticLayer& before, QRectF& changed) const {
+    changed = QRectF();
+    if (shapes.size() != before.shapes.size())
+        return false;
+    for (int i = 0; i < shapes.size(); ++i) {
+        const Shape& a = shapes[i];
+        const Shape& b = before.shapes[i];
+        if (a.kind == b.kind && a.levels == b.levels && a.rect == b.rect
+            && styles[a.style] == before.styles[b.style]
+            && (a.text < 0 || texts[a.text] == before.texts[b.text]))
+            continue;
+        changed = changed.united(a.bounds).united(b.bounds);
+    }
+    return true;
+}
+
+// ============== TileCache ==============
+// 界面线程与后台画块任务之间的交接，任务持有一份，TileCache 先析构也不影响还在画的块
+struct TileCache::Shared {
+    QMutex mutex;
+    QWaitCondition idle;
+    QVector<TileJob> done;      // 画好或放弃的块，等界面线程取走
+    int running = 0;            // 已交出还没结束的任务
+    std::function<void()> ready;
+    std::atomic<int> generation{0};
+    std::atomic<quint64> wanted{0};   // 上一次 draw 的一级（键的高位），开始画时已换了级的块放弃
+};
+
+TileCache::TileCache() : shared(std::make_shared<Shared>()) {
+    setMaxBytes(kDefaultMaxBytes);
+}
+
+TileCache::~TileCache() {
+    // 还在排队的任务不再画，画完的也不再通知
+    QMutexLocker lock(&shared->mutex);
+    shared->ready = nullptr;
+    shared->generation = generation + 1;
+}
+
+void TileCache::setMaxBytes(qint64 bytes) {
+    tiles.setMaxCost(qMax<qint64>(1, bytes >> 10));
+}
+
+void TileCache::setReadyHandler(std::function<void()> ready) {
+    QMutexLocker lock(&shared->mutex);
+    shared->ready = std::move(ready);
+}
+
+void TileCache::discardPending() {
+    shared->generation = ++generation;
+    pending.clear();
+}
+
+void TileCache::clear() {
+    tiles.clear();
+    layer.reset();
+    discardPending();
+    hasFallback = false;
+    drawn = false;
+}
+
+QRectF TileCache::tileSceneRect(quint64 key) const {
+    const int tx = int(key & 0xfffff) - kTileOffset;
+    const int ty = int((key >> 20) & 0xfffff) - kTileOffset;
+    const qreal scale = zoomScale(int(key >> 42) - kZoomOffset);
+    const qreal pad = kPadPixels / scale;
+    return QRectF(tx * kTileSize / scale, ty * kTileSize / scale, kTileSize / scale, kTileSize / scale)
+        .adjusted(-pad, -pad, pad, pad);
+}
+
+void TileCache::setLayer(StaticLayer next) {
+    QRectF changed;
+    if (isEmpty() || !next.changedRect(*layer, changed)) {
+        tiles.clear();
+        hasFallback = false;
+    } else if (!changed.isEmpty()) {
+        // 只丢弃画到了变化范围的块（如拖动过的模块与接在它上面的连线）
+        const QList<quint64> keys = tiles.keys();
+        for (const quint64 key : keys) {
+            if (tileSceneRect(key).intersects(changed))
+                tiles.remove(key);
+        }
+    }
+    discardPending();
+    layer = std::make_shared<const StaticLayer>(std::move(next));
+}
+
+// 用候补一级中缓存的块盖住缺的块 (tx, ty)，只画在这一块的范围内
+void TileCache::drawFallback(QPainter* painter, const QPointF& origin, qreal scale, qreal dpr,
+                             int tx, int ty) const {
+    const qreal ratio = zoomScale(fallbackZoom) / scale;
+    const QRectF target(origin / dpr + QPointF(tx, ty) * kTileSize / dpr, QSizeF(kTileSize, kTileSize) / dpr);
+    const int fx0 = qMax(-kTileOffset, qFloor(tx * ratio));
+    const int fy0 = qMax(-kTileOffset, qFloor(ty * ratio));
+    const int fx1 = qMin(kTileOffset - 1, qCeil((tx + 1) * ratio) - 1);
+    const int fy1 = qMin(kTileOffset - 1, qCeil((ty + 1) * ratio) - 1);
+    bool clipped = false;
+    for (int fy = fy0; fy <= fy1; ++fy) {
+        for (int fx = fx0; fx <= fx1; ++fx) {
+            const QImage* tile = tiles.object(tileKey(fallbackZoom, fallbackLevel, fx, fy));
+            if (!tile)
+                continue;
+            if (!clipped) {
+                painter->save();
+                painter->setClipRect(target, Qt::IntersectClip);
+                clipped = true;
+            }
+            const qreal size = kTileSize / ratio / dpr;
+            painter->drawImage(QRectF(origin / dpr + QPointF(fx, fy) * size, QSizeF(size, size)), *tile);
+        }
+    }
+    if (clipped)
+        painter->restore();
+}
+
+int TileCache::draw(QPainter* painter, const QTransform& sceneToView, const QRect& exposed, qreal dpr,
+                    DetailLevel level) {
+    if (isEmpty() || exposed.isEmpty())
+        return 0;
+    if (dpr != tileDpr) {
+        tiles.clear();
+        discardPending();
+        hasFallback = false;
+        tileDpr = dpr;
+    }
+    // 已画好的块先放进缓存；本帧会画到它们，不必另外重画
+    collect();
+    const qreal deviceScale = sceneToView.m11() * dpr;
+    if (deviceScale <= 0)
+        return 0;
+    const int zoom = qRound(std::log2(deviceScale) * kZoomSteps);
+    if (qAbs(zoom) >= kZoomOffset)
+        return 0;
+    const qreal scale = zoomScale(zoom);
+
+    // 场景原点在视口中的位置取整到设备像素，各块首尾相接没有缝；块内的像素相对这个原点
+    const QPointF origin(qRound(sceneToView.dx() * dpr), qRound(sceneToView.dy() * dpr));
+    drawnZoom = zoom;
+    drawnLevel = level;
+    drawnOrigin = origin;
+    drawn = true;
+    shared->wanted = tileKey(zoom, level, 0, 0) & kLevelMask;
+
+    const QRectF area(QPointF(exposed.topLeft()) * dpr - origin, QSizeF(exposed.size()) * dpr);
+    // 静态图层范围以外的块是空的，不画也不占缓存
+    const QRectF extent(layer->bounds().topLeft() * scale, layer->bounds().size() * scale);
+    const QRectF covered = area.intersected(extent.adjusted(-kPadPixels, -kPadPixels, kPadPixels, kPadPixels));
+    if (covered.isEmpty())
+        return 0;
+    const int tx0 = qMax(-kTileOffset, qFloor(covered.left() / kTileSize));
+    const int ty0 = qMax(-kTileOffset, qFloor(covered.top() / kTileSize));
+    const int tx1 = qMin(kTileOffset - 1, qCeil(covered.right() / kTileSize) - 1);
+    const int ty1 = qMin(kTileOffset - 1, qCeil(covered.bottom() / kTileSize) - 1);
+
+    // 贴已缓存的块；缺的块交给后台，这一帧先用候补一级的块顶上
+    const bool useFallback = hasFallback && (fallbackZoom != zoom || fallbackLevel != level)
+                             && fallbackZoom - zoom <= kFallbackOctaves * kZoomSteps;
+    bool complete = true;
+    int started = 0;
+    for (int ty = ty0; ty <= ty1; ++ty) {
+        for (int tx = tx0; tx <= tx1; ++tx) {
+            const quint64 key = tileKey(zoom, level, tx, ty);
+            if (const QImage* tile = tiles.object(key)) {
+                painter->drawImage((origin + QPointF(tx, ty) * kTileSize) / dpr, *tile);
+                continue;
+            }
+            complete = false;
+            if (useFallback)
+                drawFallback(painter, origin, scale, dpr, tx, ty);
+            if (pending.contains(key))
+                continue;
+            pending.insert(key);
+            ++started;
+            const std::shared_ptr<const StaticLayer> source = layer;
+            const std::shared_ptr<Shared> state = shared;
+            {
+                QMutexLocker lock(&state->mutex);
+                ++state->running;
+            }
+            QThreadPool::globalInstance()->start([source, state, key, tx, ty, scale, dpr, level,
+                                                  ticket = generation]() {
+                TileJob job = {key, tx, ty, ticket, QImage()};
+                // 排队期间换了图层或缩放到了别的级，这块已经用不上
+                if (state->generation == ticket && (key & kLevelMask) == state->wanted)
+                    renderTile(*source, job, scale, dpr, level);
+                QMutexLocker lock(&state->mutex);
+                const bool first = state->done.isEmpty();
+                state->done.append(std::move(job));
+                if (--state->running == 0)
+                    state->idle.wakeAll();
+                if (first && state->ready)
+                    state->ready();
+            });
+        }
+    }
+    if (complete) {
+        fallbackZoom = zoom;
+        fallbackLevel = level;
+        hasFallback = true;
+    }
+    return started;
+}
+
+QRegion TileCache::collect() {
+    QVector<TileJob> done;
+    {
+        QMutexLocker lock(&shared->mutex);
+        done.swap(shared->done);
+    }
+    QRegion dirty;
+    const quint64 drawnLevelKey = tileKey(drawnZoom, drawnLevel, 0, 0) & kLevelMask;
+    for (TileJob& job : done) {
+        if (job.generation != generation)
+            continue;
+        pending.remove(job.key);
+        if (job.image.isNull())
+            continue;
+        const int cost = int(job.image.sizeInBytes() >> 10);
+        tiles.insert(job.key, new QImage(std::move(job.image)), cost);
+        if (drawn && (job.key & kLevelMask) == drawnLevelKey) {
+            dirty += QRectF((drawnOrigin + QPointF(job.tx, job.ty) * kTileSize) / tileDpr,
+                            QSizeF(kTileSize, kTileSize) / tileDpr).toAlignedRect();
+        }
+    }
+    return dirty;
+}
+
+QRegion TileCache::finish() {
+    {
+        QMutexLocker lock(&shared->mutex);
+        while (shared->running > 0)
+            shared->idle.wait(&shared->mutex);
+    }
+    return collect();
+}
@@ -0,0 +1,136 @@
+// tilecache.h
+#ifndef TILECACHE_H
+#define TILECACHE_H
+#include <QBrush>
+#include <QCache>
+#include <QFont>
+#include <QHash>
+#include <QImage>
+#include <QPen>
+#include <QRectF>
+#include <QRegion>
+#include <QSet>
+#include <QString>
+#include <QVector>
+#include <functional>
+#include <memory>
+#include "scenebuilder.h"
+
+class QPainter;
+
+// 场景中不随统计数据变化的部分（BuiltScene 的 chainLayer、tileLayer 与 staticLayer）
+// 在界面线程上抄成一份只读的绘图列表：模块框、端口、模块名、链内连线、图例与标题。
+// 列表不引用任何图元，可以同时在多个工作线程上画进各自的 QImage。
+// 各图形按原来的叠放次序存放，另记可见的细节层级，与 SceneBuilder::setDetailLevel 的切换一致。
+class StaticLayer {
+public:
+    // built 中已创建的静态图层；对比模式下模块按指标着色，不应抄写（见 SceneWidget）
+    static StaticLayer capture(const BuiltScene& built);
+
+    bool isEmpty() const { return shapes.isEmpty(); }
+    int shapeCount() const { return int(shapes.size()); }
+    QRectF bounds() const { return extent; }
+
+    // 把与 sceneRect 相交、在 level 下可见的图形画到 painter 上（painter 为场景坐标）
+    void render(QPainter* painter, const QRectF& sceneRect, DetailLevel level) const;
+
+    // 与 before 相比变了的图形所占的范围（两者的并，没有变化时为空矩形）；
+    // 图形数不同时无法逐个对应，返回 false 表示全部变了
+    bool changedRect(const StaticLayer& before, QRectF& changed) const;
+
+private:
+    enum Kind : quint8 { Rect, Ellipse, Line, Text };
+    struct Style {
+        QPen pen;
+        QBrush brush;
+        QFont font;
+        bool operator==(const Style& other) const {
+            return pen == other.pen && brush == other.brush && font == other.font;
+        }
+    };
+    struct Shape {
+        QRectF rect;      // Rect、Ellipse 为外框；Line 从 topLeft 到 bottomRight；Text 为排版区域
+        QRectF bounds;    // 含画笔宽度，用于网格与变化范围
+        qint32 style;
+        qint32 text;      // texts 下标，其他为 -1
+        quint8 kind;
+        quint8 levels;    // 可见的细节层级，按 1 << int(DetailLevel)
+    };
+
+    void add(Kind kind, const QRectF& rect, const Style& style, quint8 levels,
+             const QString& text = QString());
+    void addItem(const QGraphicsItem* item, quint8 levels);
+    int addStyle(const Style& style);
+
+    QVector<Shape> shapes;
+    QVector<Style> styles;
+    QVector<QString> texts;
+    QHash<quint64, QVector<int>> grid;   // 网格单元 -> 图形，按下标升序
+    QRectF extent;
+};
+
+// 静态图层的分块缓存：按视图的设备像素比例分级（1/65536 个倍频程一级，与实际比例的差别远小于一个像素），
+// 每级切成 256×256 的块。缺的块交给线程池在后台画，draw 不等待：在它们画好之前，
+// 用最近一次画全了的那一级中缓存的块缩放后代替，没有时留空。画好的块由 ready 通知（在工作线程上调用），
+// 界面线程再用 collect 放进缓存并重画对应的范围。平移只需把缓存的块贴到视口上。
+// 缓存按字节数设上限，超出时丢弃最久没有用到的块（QCache）。
+class TileCache {
+public:
+    static const int kTileSize = 256;
+    static const qint64 kDefaultMaxBytes = qint64(256) << 20;
+
+    TileCache();
+    ~TileCache();
+    TileCache(const TileCache&) = delete;
+    TileCache& operator=(const TileCache&) = delete;
+
+    // 换上新的静态图层：与原来的逐个图形比较，只丢弃变化范围内的块；结构不同时全部丢弃。
+    // 还在画的块属于原来的图层，画好后丢弃
+    void setLayer(StaticLayer layer);
+    void clear();
+    bool isEmpty() const { return !layer || layer->isEmpty(); }
+
+    void setMaxBytes(qint64 bytes);
+    qint64 maxBytes() const { return qint64(tiles.maxCost()) << 10; }
+    qint64 usedBytes() const { return qint64(tiles.totalCost()) << 10; }
+    int tileCount() const { return int(tiles.count()); }
+    int pendingCount() const { return int(pending.size()); }
+
+    // 后台有块画好时调用，来自工作线程；上一批还没被 collect 取走时不再重复通知
+    void setReadyHandler(std::function<void()> ready);
+
+    // 把视口中 exposed 范围内的块画到 painter 上，缺的块开始在后台画，返回本次开始画的块数
+    // painter 为视口坐标；sceneToView 为场景到视口的变换，只含缩放与平移；dpr 为视口的设备像素比
+    int draw(QPainter* painter, const QTransform& sceneToView, const QRect& exposed, qreal dpr,
+             DetailLevel level);
+    // 把画好的块放进缓存，返回其中属于上一次 draw 的那一级、需要重画的视口范围
+    QRegion collect();
+    // 等后台的块全部画完再 collect（无窗口出图与测量用）
+    QRegion finish();
+
+private:
+    struct Shared;
+
+    QRectF tileSceneRect(quint64 key) const;
+    void discardPending();
+    void drawFallback(QPainter* painter, const QPointF& origin, qreal scale, qreal dpr, int tx, int ty) const;
+
+    std::shared_ptr<const StaticLayer> layer;   // 与后台的画块任务共享，换图层时任务仍画完原来的
+    std::shared_ptr<Shared> shared;             // 与后台任务共享的结果队列
+    QCache<quint64, QImage> tiles;   // 费用以 KB 计
+    QSet<quint64> pending;           // 已交给后台、还没取回的块
+    int generation = 0;              // 图层或设备像素比变化后，之前开始的块作废
+    qreal tileDpr = 0;               // 缓存的块所用的设备像素比，变了全部丢弃
+
+    // 上一次 draw 所用的一级及视口原点，collect 据此算出重画范围
+    int drawnZoom = 0;
+    DetailLevel drawnLevel = DetailLevel::Full;
+    QPointF drawnOrigin;
+    bool drawn = false;
+    // 最近一次没有缺块的一级，缺块时用它的块代替
+    int fallbackZoom = 0;
+    DetailLevel fallbackLevel = DetailLevel::Full;
+    bool hasFallback = false;
+};
+
+#endif // TILECACHE_H
@@ -0,0 +1,106 @@
+// timeseriesstore.cpp
+#include "timeseriesstore.h"
+#include "statparser.h"
+#include "parallelstatparser.h"
+#include <QFile>
+#include <QDir>
+#include <QTemporaryFile>
+
+TimeSeriesStore::TimeSeriesStore() = default;
+
+TimeSeriesStore::~TimeSeriesStore()
+{
+    delete file;   // 关闭时自动解除映射并删除后备文件
+}
+
+bool TimeSeriesStore::reset(QString* errorMessage)
+{
+    columns.clear();
+    delete file;
+    fileSize = 0;
+    file = new QTemporaryFile(QDir(QDir::tempPath()).filePath("qtvis_epochs_XXXXXX.bin"));
+    if (!file->open()) {
+        if (errorMessage)
+            *errorMessage = QString("无法创建时序文件: %1").arg(file->errorString());
+        delete file;
+        file = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool TimeSeriesStore::appendEpoch(const CounterStore& store)
+{
+    if (!file && !reset())
+        return false;
+    Column column;
+    column.rows = store.rowCount();
+    if (column.rows > 0) {
+        const qint64 bytes = qint64(column.rows) * qint64(sizeof(double));
+        if (!file->seek(fileSize)
+            || file->write(reinterpret_cast<const char*>(store.values.constData()), bytes) != bytes
+            || !file->flush())
+            return false;
+        // 偏移总是 8 的倍数，映射出的指针按 double 对齐
+        const uchar* mapped = file->map(fileSize, bytes);
+        if (!mapped)
+            return false;
+        column.data = reinterpret_cast<const double*>(mapped);
+        fileSize += bytes;
+    }
+    columns.append(column);
+    return true;
+}
+
+bool TimeSeriesStore::parseFile(const QString& path, CounterStore& out, TimeSeriesStore& series,
+                                EpochSplitter& splitter, QString* errorMessage)
+{
+    QFile input(path);
+    if (!input.open(QIODevice::ReadOnly)) {
+        if (errorMessage)
+            *errorMessage = QString("无法打开 %1: %2").arg(path, input.errorString());
+        return false;
+    }
+    out.clear();
+    if (!series.reset(errorMessage))
+        return false;
+    const qint64 size = input.size();
+    if (size == 0)
+        return true;
+
+    const uchar* mapped = input.map(0, size);
+    QByteArray fallback;
+    if (!mapped) {
+        fallback = input.readAll();
+        mapped = reinterpret_cast<const uchar*>(fallback.constData());
+    }
+    const char* data = reinterpret_cast<const char*>(mapped);
+
+    bool ok = true;
+    const QVector<qsizetype> boundaries = splitter.split(data, size);
+    if (boundaries.isEmpty()) {
+        // 单个快照：整体并行解析
+        ok = ParallelStatParser::parse(data, size, out, errorMessage);
+    } else {
+        // 多个 epoch 依次解析到同一个存储里，每跨过一个边界记下一列
+        out.reserveRows(int(qMin<qint64>(size / 40 / (boundaries.size() + 1), 1 << 28)));
+        int module = -1;
+        qsizetype begin = 0;
+        for (int i = 0; i <= boundaries.size() && ok; ++i) {
+            const qsizetype end = i < boundaries.size() ? boundaries[i] : size;
+            if (i > 0)
+                ok = series.appendEpoch(out);
+            ok = ok && StatParser::parse(data + begin, end - begin, out, nullptr, &module);
+            begin = end;
+        }
+        if (!ok) {
+            // 顺序重解析一遍以得到准确的行号
+            out.clear();
+            if (StatParser::parse(data, size, out, errorMessage) && errorMessage)
+                *errorMessage = QString("写入时序文件失败");
+        }
+    }
+    if (fallback.isEmpty())
+        input.unmap(const_cast<uchar*>(mapped));
+    return ok;
+}
@@ -0,0 +1,55 @@
+// timeseriesstore.h
+#ifndef TIMESERIESSTORE_H
+#define TIMESERIESSTORE_H
+#include <QString>
+#include <QVector>
+#include "counterstore.h"
+
+class QTemporaryFile;
+class EpochSplitter;
+
+// 按 epoch 保存计数器值的只追加时序存储
+// 每个已结束的 epoch 是一列：该 epoch 结束时 CounterStore 各行（按行号）的值。
+// 最后一个（可能仍在写入的）epoch 不在这里，就是 CounterStore 本身。
+// 列依次追加到临时目录下的后备文件并各自映射，数千个 epoch 只占页缓存而不占堆内存。
+// 后出现的行在较早的 epoch 里没有值，按 0 处理（计数器都从 0 开始累加）。
+class TimeSeriesStore {
+public:
+    TimeSeriesStore();
+    ~TimeSeriesStore();
+
+    // 丢弃所有 epoch 并新建后备文件
+    bool reset(QString* errorMessage = nullptr);
+
+    int epochCount() const { return int(columns.size()); }
+    int rowCount(int epoch) const { return columns[epoch].rows; }
+    const double* column(int epoch) const { return columns[epoch].data; }
+    double value(int epoch, int row) const {
+        const Column& c = columns[epoch];
+        return row < c.rows ? c.data[row] : 0;
+    }
+
+    // 把 store 当前的值追加为新的一列
+    bool appendEpoch(const CounterStore& store);
+
+    // 解析可能由多个 epoch 依次追加而成的 statistic.txt
+    // out 得到最后一个 epoch 的值，之前每个 epoch 结束时的值追加为一列；
+    // 只有一个 epoch 时不产生任何列，直接用 ParallelStatParser 解析。
+    // splitter 返回时处于文件末尾的状态，可交给 StatTailer 继续切分。
+    static bool parseFile(const QString& path, CounterStore& out, TimeSeriesStore& series,
+                          EpochSplitter& splitter, QString* errorMessage = nullptr);
+
+private:
+    Q_DISABLE_COPY(TimeSeriesStore)
+
+    struct Column {
+        int rows = 0;
+        const double* data = nullptr;
+    };
+
+    QTemporaryFile* file = nullptr;
+    qint64 fileSize = 0;
+    QVector<Column> columns;
+};
+
+#endif // TIMESERIESSTORE_H
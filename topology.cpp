@@ -0,0 +1,78 @@
+// topology.cpp
+#include "topology.h"
+#include <cstring>
+
+void Topology::clear() {
+    modules.clear();
+    params.clear();
+    paramKeys.clear();
+    nodeOfPort.clear();
+    moduleOfPort.clear();
+    edges.clear();
+    nodeCount = 0;
+    busModule = -1;
+    moduleIndex.clear();
+    keyIndex.clear();
+}
+
+void Topology::rebuildLookup() {
+    moduleIndex.clear();
+    keyIndex.clear();
+    for (int i = 0; i < modules.size(); ++i)
+        moduleIndex.insert(modules[i].name, i);
+    for (int i = 0; i < paramKeys.size(); ++i)
+        keyIndex.insert(paramKeys[i], i);
+}
+
+int Topology::findModule(ModuleKind kind, int index) const {
+    for (int i = 0; i < modules.size(); ++i) {
+        if (modules[i].kind == kind && modules[i].index == index)
+            return i;
+    }
+    return -1;
+}
+
+qint64 Topology::param(int module, int key, qint64 defaultValue) const {
+    if (module < 0 || module >= modules.size() || key < 0)
+        return defaultValue;
+    const TopologyModule& m = modules[module];
+    for (int i = m.paramBegin; i < m.paramBegin + m.paramCount; ++i) {
+        if (params[i].key == key)
+            return params[i].value;
+    }
+    return defaultValue;
+}
+
+qint64 Topology::param(int module, const char* key, qint64 defaultValue) const {
+    // fromRawData 不复制字符串，查表不产生分配
+    return param(module, paramKey(QByteArray::fromRawData(key, qsizetype(strlen(key)))),
+                 defaultValue);
+}
+
+int Topology::nodeOfModule(int module) const {
+    if (module < 0 || module >= modules.size())
+        return -1;
+    const int port = modules[module].portId;
+    if (port < 0 || port >= nodeOfPort.size())
+        return -1;
+    return nodeOfPort[port];
+}
+
+ModuleKind Topology::kindFromName(const char* name, qsizetype size) {
+    struct Prefix { const char* text; ModuleKind kind; };
+    static const Prefix prefixes[] = {
+        {"Bus", ModuleKind::Bus},
+        {"CPU", ModuleKind::Cpu},
+        {"L2Cache", ModuleKind::L2Cache},
+        {"L3Cache", ModuleKind::L3Cache},
+        {"MemoryNode", ModuleKind::Memory},
+        {"cache_event_trace", ModuleKind::Trace},
+        {"DMA", ModuleKind::Dma},
+    };
+    for (const Prefix& p : prefixes) {
+        const qsizetype n = qsizetype(strlen(p.text));
+        if (size >= n && memcmp(name, p.text, size_t(n)) == 0)
+            return p.kind;
+    }
+    return ModuleKind::Other;
+}
@@ -0,0 +1,79 @@
+// topology.h
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+#include <QByteArray>
+#include <QHash>
+#include <QVector>
+
+// 模块类型，由 setup.txt 中块名的前缀决定
+enum class ModuleKind : quint8 {
+    Bus,
+    Cpu,
+    L2Cache,   // L2Cache 块同时描述了该核心私有的 L1i/L1d
+    L3Cache,
+    Memory,
+    Trace,     // cache_event_trace
+    Dma,
+    Other
+};
+
+// 总线上的一条有向数据通道 a to b（节点ID）
+struct BusEdge {
+    qint32 from;
+    qint32 to;
+};
+
+// 模块的一个数值参数，key 为 Topology::paramKeys 的下标
+struct TopologyParam {
+    qint32 key;
+    qint64 value;
+};
+
+struct TopologyModule {
+    QByteArray name;          // 块名，如 "L2Cache0"
+    ModuleKind kind = ModuleKind::Other;
+    qint32 index = -1;        // 名称尾部数字，L2Cache0 -> 0
+    qint32 tick = 1;          // "@1tick"
+    qint32 portId = -1;       // 连接的总线端口，未配置为 -1
+    qint32 paramBegin = 0;    // 参数在 Topology::params 中的区间
+    qint32 paramCount = 0;
+};
+
+// setup.txt 描述的硬件组成
+class Topology {
+public:
+    // 端口与总线节点编号的上限，超出的视为文件有误，不按其分配各端口表
+    static const qint32 kMaxPorts = 1 << 22;
+
+    QVector<TopologyModule> modules;   // 按文件中出现的顺序
+    QVector<TopologyParam> params;     // 所有模块的参数连续存放
+    QVector<QByteArray> paramKeys;     // 参数名表，按首次出现顺序
+    QVector<qint32> nodeOfPort;        // 端口 -> 总线节点，未映射为 -1
+    QVector<qint32> moduleOfPort;      // 端口 -> 模块下标，未连接为 -1
+    QVector<BusEdge> edges;            // 总线互连表
+    qint32 nodeCount = 0;
+    qint32 busModule = -1;
+
+    void clear();
+    bool isEmpty() const { return modules.isEmpty(); }
+    // 直接填充各列（如从快照缓存读入）之后重建名称查找表
+    void rebuildLookup();
+
+    int findModule(const QByteArray& name) const { return moduleIndex.value(name, -1); }
+    int findModule(ModuleKind kind, int index) const;
+    int paramKey(const QByteArray& key) const { return keyIndex.value(key, -1); }
+    qint64 param(int module, int key, qint64 defaultValue = -1) const;
+    qint64 param(int module, const char* key, qint64 defaultValue = -1) const;
+
+    // 模块连接的总线节点，没有连接总线返回 -1
+    int nodeOfModule(int module) const;
+
+    static ModuleKind kindFromName(const char* name, qsizetype size);
+
+private:
+    friend class SetupParser;
+    QHash<QByteArray, int> moduleIndex;
+    QHash<QByteArray, int> keyIndex;
+};
+
+#endif // TOPOLOGY_H
@@ -0,0 +1,232 @@
+// trafficmatrix.cpp
+#include "trafficmatrix.h"
+#include "counterstore.h"
+#include <QtMath>
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace {
+
+// 显示顺序：按总流量从大到小，相同时按端口号
+QVector<int> orderBy(const QVector<double>& totals, bool sorted) {
+    QVector<int> order(totals.size());
+    std::iota(order.begin(), order.end(), 0);
+    if (sorted) {
+        std::stable_sort(order.begin(), order.end(),
+                         [&](int a, int b) { return totals[a] > totals[b]; });
+    }
+    return order;
+}
+
+} // namespace
+
+void TrafficMatrix::clear() {
+    store = nullptr;
+    busModule = -1;
+    counter = -1;
+    ports = 0;
+    nonZero = 0;
+    maxCell = 0;
+    cellFrom.clear();
+    cellTo.clear();
+    cellLevel.clear();
+    rowTotals.clear();
+    columnTotals.clear();
+    rowOrder.clear();
+    columnOrder.clear();
+    columnRank.clear();
+    levels.clear();
+    rowStart.clear();
+    sparseColumn.clear();
+    sparseLevel.clear();
+}
+
+bool TrafficMatrix::build(const CounterStore& source, int portCount) {
+    clear();
+    counter = source.findCounter("transmit_package_number_from_#_to_#");
+    if (counter < 0)
+        return false;
+    store = &source;
+
+    // 整列扫描计数器ID；矩阵的行只占总行数的一部分，先找出来再逐行处理
+    const int rows = source.rowCount();
+    const qint32* rowCounter = source.rowCounter.constData();
+    QVector<qint32> matrixRows;
+    for (int r = 0; r < rows; ++r) {
+        if (rowCounter[r] == counter)
+            matrixRows.append(r);
+    }
+
+    int maxPort = portCount - 1;
+    for (const qint32 r : matrixRows) {
+        const int from = source.rowIndex0[r];
+        const int to = source.rowIndex1[r];
+        const double v = source.values[r];
+        if (from < 0 || to < 0 || !(v > 0))
+            continue;
+        if (busModule < 0)
+            busModule = source.rowModule[r];
+        maxPort = qMax(maxPort, qMax(from, to));
+        maxCell = qMax(maxCell, v);
+        cellFrom.append(from);
+        cellTo.append(to);
+    }
+    ports = maxPort + 1;
+    nonZero = cellFrom.size();
+    rowTotals.fill(0, ports);
+    columnTotals.fill(0, ports);
+    if (busModule < 0)
+        busModule = matrixRows.isEmpty() ? -1 : source.rowModule[matrixRows[0]];
+
+    // 对数刻度：流量跨好几个数量级，线性刻度下绝大多数格子都是最浅的颜色
+    const double scale = maxCell > 0 ? 254 / std::log1p(maxCell) : 0;
+    cellLevel.resize(nonZero);
+    qint64 cell = 0;
+    for (const qint32 r : matrixRows) {
+        const int from = source.rowIndex0[r];
+        const int to = source.rowIndex1[r];
+        const double v = source.values[r];
+        if (from < 0 || to < 0 || !(v > 0))
+            continue;
+        rowTotals[from] += v;
+        columnTotals[to] += v;
+        cellLevel[cell++] = quint8(qMin(255, 1 + int(std::log1p(v) * scale)));
+    }
+    arrange();
+    return true;
+}
+
+double TrafficMatrix::value(int from, int to) const {
+    if (!store || counter < 0 || busModule < 0)
+        return 0;
+    const int r = store->findRow(busModule, counter, from, to);
+    return r >= 0 ? store->values[r] : 0;
+}
+
+double TrafficMatrix::levelValue(int level) const {
+    if (level <= 0 || maxCell <= 0)
+        return 0;
+    return std::expm1((level - 1) / 254.0 * std::log1p(maxCell));
+}
+
+void TrafficMatrix::setSortByTotal(bool sort) {
+    if (sort == sorted)
+        return;
+    sorted = sort;
+    arrange();
+}
+
+// 按当前顺序把格子填进稠密数组或按行压缩的数组
+void TrafficMatrix::arrange() {
+    rowOrder = orderBy(rowTotals, sorted);
+    columnOrder = orderBy(columnTotals, sorted);
+    QVector<int> rowRank(ports);
+    columnRank.resize(ports);
+    for (int i = 0; i < ports; ++i) {
+        rowRank[rowOrder[i]] = i;
+        columnRank[columnOrder[i]] = i;
+    }
+
+    dense = ports <= kMaxDensePorts;
+    if (dense) {
+        levels.fill(0, qsizetype(ports) * ports);
+        for (qint64 i = 0; i < nonZero; ++i)
+            levels[qsizetype(rowRank[cellFrom[i]]) * ports + columnRank[cellTo[i]]] = cellLevel[i];
+        return;
+    }
+
+    // 计数排序到各显示行，行内再按显示列排序；列号与色阶打包在一起排
+    rowStart.fill(0, ports + 1);
+    for (qint64 i = 0; i < nonZero; ++i)
+        ++rowStart[rowRank[cellFrom[i]] + 1];
+    for (int row = 0; row < ports; ++row)
+        rowStart[row + 1] += rowStart[row];
+    QVector<qint64> next(rowStart.begin(), rowStart.end() - 1);
+    QVector<quint64> packed(nonZero);
+    for (qint64 i = 0; i < nonZero; ++i)
+        packed[next[rowRank[cellFrom[i]]]++] = (quint64(columnRank[cellTo[i]]) << 8) | cellLevel[i];
+    sparseColumn.resize(nonZero);
+    sparseLevel.resize(nonZero);
+    for (int row = 0; row < ports; ++row) {
+        std::sort(packed.begin() + rowStart[row], packed.begin() + rowStart[row + 1]);
+        for (qint64 i = rowStart[row]; i < rowStart[row + 1]; ++i) {
+            sparseColumn[i] = qint32(packed[i] >> 8);
+            sparseLevel[i] = quint8(packed[i]);
+        }
+    }
+}
+
+// 一个显示行在 [columnBegin, columnEnd) 的色阶，每 2^shift 列并成一项取最大值，合并进 out
+void TrafficMatrix::levelsOfRow(int row, int columnBegin, int columnEnd, quint8* out, int shift) const {
+    columnEnd = qMin(columnEnd, ports);
+    if (columnBegin >= columnEnd)
+        return;
+    if (dense) {
+        const quint8* src = levels.constData() + qsizetype(row) * ports;
+        if (shift == 0) {
+            const int n = columnEnd - columnBegin;
+            src += columnBegin;
+            for (int i = 0; i < n; ++i)
+                out[i] = qMax(out[i], src[i]);
+            return;
+        }
+        // 每组 2^shift 个连续字节求最大，内层循环可以被编译器向量化
+        const int group = 1 << shift;
+        for (int c = columnBegin; c < columnEnd; c += group) {
+            const int end = qMin(c + group, columnEnd);
+            quint8 m = out[(c - columnBegin) >> shift];
+            for (int i = c; i < end; ++i)
+                m = qMax(m, src[i]);
+            out[(c - columnBegin) >> shift] = m;
+        }
+        return;
+    }
+    const qint32* begin = sparseColumn.constData() + rowStart[row];
+    const qint32* end = sparseColumn.constData() + rowStart[row + 1];
+    const quint8* level = sparseLevel.constData() + rowStart[row];
+    for (const qint32* it = std::lower_bound(begin, end, columnBegin); it != end && *it < columnEnd; ++it) {
+        quint8& slot = out[(*it - columnBegin) >> shift];
+        slot = qMax(slot, level[it - begin]);
+    }
+}
+
+void TrafficMatrix::render(quint32* pixels, qsizetype stride, int x, int y, int width, int height,
+                           int zoom, const quint32* palette) const {
+    // zoom >= 0 时先取一行格子再放大；zoom < 0 时一个像素行合并 2^-zoom 个显示行
+    const int shift = zoom >= 0 ? 0 : -zoom;
+    const int cellShift = zoom >= 0 ? zoom : 0;
+    const int firstColumn = zoom >= 0 ? (x >> zoom) : (x << shift);
+    const int columnCount = zoom >= 0 ? (((x + width - 1) >> zoom) - firstColumn + 1) : (width << shift);
+    QVector<quint8> buffer(zoom >= 0 ? columnCount : width);
+    int previousRow = -1;
+    quint32* previousLine = nullptr;
+    for (int py = 0; py < height; ++py) {
+        quint32* line = reinterpret_cast<quint32*>(reinterpret_cast<uchar*>(pixels) + py * stride);
+        const int rowBegin = zoom >= 0 ? ((y + py) >> zoom) : ((y + py) << shift);
+        if (rowBegin >= ports) {
+            std::fill(line, line + width, palette[0]);
+            continue;
+        }
+        // 放大时相邻像素行属于同一显示行，直接复制上一行
+        if (rowBegin == previousRow) {
+            std::memcpy(line, previousLine, width * sizeof(quint32));
+            continue;
+        }
+        std::fill(buffer.begin(), buffer.end(), quint8(0));
+        const int rowEnd = qMin(ports, zoom >= 0 ? rowBegin + 1 : rowBegin + (1 << shift));
+        for (int row = rowBegin; row < rowEnd; ++row)
+            levelsOfRow(row, firstColumn, firstColumn + columnCount, buffer.data(), shift);
+
+        const quint8* level = buffer.constData();
+        if (cellShift == 0) {
+            for (int px = 0; px < width; ++px)
+                line[px] = palette[level[px]];
+        } else {
+            for (int px = 0; px < width; ++px)
+                line[px] = palette[level[((x + px) >> cellShift) - firstColumn]];
+        }
+        previousRow = rowBegin;
+        previousLine = line;
+    }
+}
@@ -0,0 +1,76 @@
+// trafficmatrix.h
+#ifndef TRAFFICMATRIX_H
+#define TRAFFICMATRIX_H
+#include <QVector>
+
+class CounterStore;
+
+// 端口到端口的流量矩阵（transmit_package_number_from_X_to_Y），供热力图显示
+// 每格只保存一个 0-255 的色阶：0 为没有流量，1-255 按对数刻度；具体数值悬停时再到 CounterStore 里查。
+// 色阶按显示顺序存放（排序后行列已重排），绘制时逐行连续读取，不需要经过排列表。
+// 端口数不超过 kMaxDensePorts 时用 N×N 的稠密数组，否则按行压缩只存有流量的格子。
+class TrafficMatrix {
+public:
+    static const int kMaxDensePorts = 4096;
+
+    // 从统计数据中取出矩阵；portCount 为拓扑的端口数，矩阵至少这么大
+    // 没有流量计数器时返回 false，矩阵为空
+    bool build(const CounterStore& store, int portCount = 0);
+    void clear();
+
+    bool isEmpty() const { return ports == 0; }
+    bool isDense() const { return dense; }
+    int size() const { return ports; }
+    qint64 nonZeroCount() const { return nonZero; }
+    double maxValue() const { return maxCell; }
+
+    // 按端口号查询；value 直接读 build 时的统计数据，其后数据有追加时需重新 build
+    double value(int from, int to) const;
+    double rowTotal(int from) const { return rowTotals[from]; }
+    double columnTotal(int to) const { return columnTotals[to]; }
+    // 色阶 level 对应的最小流量，用于图例
+    double levelValue(int level) const;
+
+    // 行、列按总流量从大到小排列；关闭时按端口号
+    void setSortByTotal(bool sort);
+    bool sortByTotal() const { return sorted; }
+    int rowPort(int row) const { return rowOrder[row]; }
+    int columnPort(int column) const { return columnOrder[column]; }
+
+    // 把显示坐标中的一块画成 ARGB32 像素：zoom >= 0 时每格 2^zoom 像素，
+    // zoom < 0 时每像素代表 2^-zoom 格，取其中最大的色阶。
+    // (x, y) 为块左上角在该缩放下的像素坐标，不小于 0；矩阵以外涂 palette[0]。
+    void render(quint32* pixels, qsizetype stride, int x, int y, int width, int height, int zoom,
+                const quint32* palette) const;
+
+private:
+    void arrange();
+    void levelsOfRow(int row, int columnBegin, int columnEnd, quint8* out, int shift) const;
+
+    const CounterStore* store = nullptr;
+    int busModule = -1;
+    int counter = -1;
+    int ports = 0;
+    bool dense = true;
+    bool sorted = false;
+    qint64 nonZero = 0;
+    double maxCell = 0;
+
+    // build 时收集的有流量的格子（端口号），重排时从这里重新填充
+    QVector<qint32> cellFrom;
+    QVector<qint32> cellTo;
+    QVector<quint8> cellLevel;
+
+    QVector<double> rowTotals;      // 端口 -> 发出的总流量
+    QVector<double> columnTotals;   // 端口 -> 收到的总流量
+    QVector<int> rowOrder;          // 显示行 -> 端口
+    QVector<int> columnOrder;
+    QVector<int> columnRank;        // 端口 -> 显示列
+
+    QVector<quint8> levels;         // 稠密：显示行 * ports + 显示列
+    QVector<qint64> rowStart;       // 稀疏：显示行 -> sparseColumn 中的起点，共 ports + 1 项
+    QVector<qint32> sparseColumn;   // 稀疏：按显示行、显示列排好的格子
+    QVector<quint8> sparseLevel;
+};
+
+#endif // TRAFFICMATRIX_H